@@ -0,0 +1,206 @@
+// BatchRunner.cpp : runs many datasets on one WorkStealingPool.
+// Native only (WorkStealingPool uses <thread>); the header can be included by /clr code.
+
+#include "BatchRunner.h"
+#include "WorkStealingPool.h"
+#include "MemMappedReader.h"
+#include "UMCPipeline.h"
+#include "RunReport.h"
+#include "ProcessStats.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <exception>
+
+BatchRunner::BatchRunner(const FeatureFinderOptions &options, int numThreads)
+{
+	mobj_options = options ;
+	mint_num_threads = numThreads > 0 ? numThreads : WorkStealingPool::GetHardwareThreads() ;
+	mobj_parent_telemetry = NULL ;
+}
+
+BatchRunner::~BatchRunner(void)
+{
+}
+
+void BatchRunner::AddDataset(const char *inputFileName)
+{
+	BatchDatasetResult result ;
+	result.mstr_input_file = inputFileName ;
+	result.mlng_file_bytes = 0 ;
+	result.mbln_compressed = false ;
+	result.mbln_parallel_load = false ;
+	result.mint_num_peaks = 0 ;
+	result.mint_num_umcs = 0 ;
+	result.mdbl_seconds = 0 ;
+	result.mbln_success = false ;
+	mvect_results.push_back(result) ;
+}
+
+bool BatchRunner::LoadManifest(const char *manifestFileName)
+{
+	FILE *manifest = fopen(manifestFileName, "r") ;
+	if (manifest == NULL)
+		return false ;
+
+	char line[1024] ;
+	while (fgets(line, sizeof(line), manifest) != NULL)
+	{
+		// trim the line break and surrounding blanks
+		int length = (int) strlen(line) ;
+		while (length > 0 && (line[length-1] == '\n' || line[length-1] == '\r' || line[length-1] == ' ' || line[length-1] == '\t'))
+			line[--length] = '\0' ;
+		char *start = line ;
+		while (*start == ' ' || *start == '\t')
+			start++ ;
+
+		if (*start == '\0' || *start == '#')
+			continue ;
+		AddDataset(start) ;
+	}
+	fclose(manifest) ;
+	return true ;
+}
+
+static bool CompareBySizeDescending(const BatchDatasetResult *first, const BatchDatasetResult *second)
+{
+	return first->mlng_file_bytes > second->mlng_file_bytes ;
+}
+
+int BatchRunner::Run()
+{
+	long long totalBytes = 0 ;
+	std::vector<BatchDatasetResult*> queueOrder ;
+	for (int datasetNum = 0 ; datasetNum < (int) mvect_results.size() ; datasetNum++)
+	{
+		BatchDatasetResult &result = mvect_results[datasetNum] ;
+		MemMappedReader reader ;
+		if (reader.Load((char *) result.mstr_input_file.c_str()))
+		{
+			result.mlng_file_bytes = reader.FileLength() ;
+			result.mbln_compressed = reader.IsCompressed() ;
+			reader.Close() ;
+		}
+		totalBytes += result.mlng_file_bytes ;
+		queueOrder.push_back(&result) ;
+	}
+	// largest first; stable so that equal sizes keep the manifest order
+	std::stable_sort(queueOrder.begin(), queueOrder.end(), CompareBySizeDescending) ;
+
+	WorkStealingPool pool(mint_num_threads) ;
+	std::vector<std::function<void()> > tasks ;
+	for (int datasetNum = 0 ; datasetNum < (int) queueOrder.size() ; datasetNum++)
+	{
+		BatchDatasetResult *result = queueOrder[datasetNum] ;
+		tasks.push_back([this, &pool, result, totalBytes]()
+		{
+			ProcessDataset(pool, *result, totalBytes) ;
+		}) ;
+	}
+	pool.Run(tasks) ;
+
+	int numFailed = 0 ;
+	for (int datasetNum = 0 ; datasetNum < (int) mvect_results.size() ; datasetNum++)
+	{
+		if (!mvect_results[datasetNum].mbln_success)
+			numFailed++ ;
+	}
+	return numFailed ;
+}
+
+void BatchRunner::ProcessDataset(WorkStealingPool &pool, BatchDatasetResult &result, long long totalBytes)
+{
+	double startTime = GetWallClockSeconds() ;
+	FeatureFinderOptions options = mobj_options ;
+	strncpy(options.mstr_input_file, result.mstr_input_file.c_str(), sizeof(options.mstr_input_file) - 1) ;
+	options.mstr_input_file[sizeof(options.mstr_input_file) - 1] = '\0' ;
+
+	char baseFileName[1024] ;
+	options.GetBaseFileName(baseFileName, sizeof(baseFileName)) ;
+
+	try
+	{
+		if (result.mlng_file_bytes == 0)
+			throw "Input file not found or empty" ;
+
+		UMCCreator creator ;
+		RunReport runReport ;
+		creator.GetTelemetry().SetParent(mobj_parent_telemetry) ;
+		options.ApplyTo(creator) ;
+		runReport.SetInputFileName(options.mstr_input_file) ;
+
+		if (options.mint_memory_budget_mb > 0)
+		{
+			// every dataset runs within the budget; run files of different datasets have different names
+			char tempFilePrefix[1024] ;
+			options.GetTempFilePrefix(tempFilePrefix, sizeof(tempFilePrefix)) ;
+			result.mint_num_umcs = creator.CreateFeatureFilesOutOfCore(baseFileName, options.mint_min_umc_length, tempFilePrefix,
+				(long long) options.mint_memory_budget_mb * 1024 * 1024, result.mint_num_peaks) ;
+			runReport.AddTelemetry(creator.GetTelemetry()) ;
+		}
+		else if (options.mbln_process_chunks)
+		{
+			// the pipeline overlaps the chunks of this dataset on threads of its own
+			UMCPipeline pipeline(&creator, baseFileName, options.mint_min_umc_length, options.mint_pipeline_queue_depth, &runReport) ;
+			pipeline.SetMergeChunkFiles(options.mbln_merge_chunk_files) ;
+			result.mint_num_umcs = pipeline.Run(options.mflt_mono_mass_start, options.mflt_mono_mass_end, creator.GetSegmentSize()) ;
+
+			std::vector<MassBucketResult> &chunkResults = pipeline.GetResults() ;
+			for (int chunkNum = 0 ; chunkNum < (int) chunkResults.size() ; chunkNum++)
+				result.mint_num_peaks += chunkResults[chunkNum].mint_num_peaks ;
+		}
+		else
+		{
+			// a file bigger than its share of the batch would leave the other workers idle at the end, so
+			// it is parsed in blocks that any idle worker can pick up (unless compressed, which decodes front to back)
+			if (mint_num_threads > 1 && !result.mbln_compressed && result.mlng_file_bytes > totalBytes / mint_num_threads)
+			{
+				result.mbln_parallel_load = true ;
+				result.mint_num_peaks = creator.ReadCSVFileParallel(pool, mint_num_threads) ;
+			}
+			else
+				result.mint_num_peaks = creator.ReadCSVFile() ;
+			creator.CreateUMCsSinglyLinkedWithAll(pool) ;
+			creator.RemoveShortUMCs(options.mint_min_umc_length) ;
+			creator.CalculateUMCs() ;
+			result.mint_num_umcs = creator.GetNumUmcs() ;
+
+			if (!creator.CreateFeatureFiles(baseFileName))
+				throw "Unable to write the feature files" ;
+			runReport.AddTelemetry(creator.GetTelemetry()) ;
+		}
+
+		char reportFileName[1100] ;
+		sprintf(reportFileName, "%s_FeatureFinder_Stats.json", baseFileName) ;
+		runReport.SetNumFeatures(result.mint_num_umcs) ;
+		runReport.WriteJsonFile(reportFileName) ;
+		result.mbln_success = true ;
+	}
+	catch (std::exception &e)
+	{
+		result.mstr_error = e.what() ;
+	}
+	catch (const char *message)
+	{
+		result.mstr_error = message ;
+	}
+
+	result.mdbl_seconds = GetWallClockSeconds() - startTime ;
+}
+
+bool BatchRunner::WriteSummaryFile(const char *fileName)
+{
+	FILE *summary = fopen(fileName, "w") ;
+	if (summary == NULL)
+		return false ;
+
+	fprintf(summary, "InputFile\tBytes\tParallelLoad\tPeaks\tFeatures\tSeconds\tStatus\n") ;
+	for (int datasetNum = 0 ; datasetNum < (int) mvect_results.size() ; datasetNum++)
+	{
+		BatchDatasetResult &result = mvect_results[datasetNum] ;
+		fprintf(summary, "%s\t%lld\t%s\t%d\t%d\t%.3f\t%s\n", result.mstr_input_file.c_str(), result.mlng_file_bytes, result.mbln_parallel_load ? "Yes" : "No",
+			result.mint_num_peaks, result.mint_num_umcs, result.mdbl_seconds, result.mbln_success ? "OK" : result.mstr_error.c_str()) ;
+	}
+	fclose(summary) ;
+	return true ;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "FeatureFinderOptions.h"
+#include <string>
+#include <vector>
+
+class WorkStealingPool ;
+class ProgressTelemetry ;
+
+// Outcome of one dataset of a batch
+struct BatchDatasetResult
+{
+	std::string mstr_input_file ;
+	long long mlng_file_bytes ;		// on disk, compressed or not
+	bool mbln_compressed ;
+	bool mbln_parallel_load ;		// parsed in blocks by several workers
+	int mint_num_peaks ;
+	int mint_num_umcs ;
+	double mdbl_seconds ;
+	bool mbln_success ;
+	std::string mstr_error ;
+} ;
+
+/*
+ * Finds features in many isos files with one set of options and one WorkStealingPool.
+ * The settings file is parsed once; every dataset gets a copy of the options with its own input file
+ * and writes the usual _LCMSFeatures.txt, _LCMSFeatureToPeakMap.txt and _FeatureFinder_Stats.json.
+ *
+ * Datasets are queued largest first so that the long ones start early and the small ones fill the gaps
+ * at the end. A file larger than its fair share of the batch (total bytes / threads) is loaded with
+ * UMCCreator::ReadCSVFileParallel, letting idle workers help with it; smaller files run one per worker.
+ * A failing dataset is recorded in its result and does not stop the others.
+ */
+class BatchRunner
+{
+	FeatureFinderOptions mobj_options ;
+	int mint_num_threads ;
+	std::vector<BatchDatasetResult> mvect_results ;
+	ProgressTelemetry *mobj_parent_telemetry ;
+
+	void ProcessDataset(WorkStealingPool &pool, BatchDatasetResult &result, long long totalBytes) ;
+
+public:
+	// numThreads <= 0 uses one thread per hardware thread
+	BatchRunner(const FeatureFinderOptions &options, int numThreads) ;
+	~BatchRunner(void) ;
+
+	void AddDataset(const char *inputFileName) ;
+	// One isos file per line; blank lines and lines starting with # are skipped. False if the file cannot be read.
+	bool LoadManifest(const char *manifestFileName) ;
+	int GetNumDatasets() { return (int) mvect_results.size() ; } ;
+	// The counters of every dataset are added to telemetry as well (see ProgressTelemetry::SetParent)
+	void SetParentTelemetry(ProgressTelemetry *telemetry) { mobj_parent_telemetry = telemetry ; } ;
+
+	// Processes every dataset; returns the number that failed
+	int Run() ;
+	// Tab separated table of the results, one row per dataset
+	bool WriteSummaryFile(const char *fileName) ;
+
+	std::vector<BatchDatasetResult> & GetResults() { return mvect_results ; } ;
+};
@@ -0,0 +1,540 @@
+// EngineChecks.cpp : equivalence checks of the accelerated engine paths, run by UMCCreationBenchmarks -check NAME.
+
+#include "EngineChecks.h"
+#include "SyntheticIsosGenerator.h"
+#include "../FeatureTable.h"
+#include "../MemMappedReader.h"
+#include "../OutputFileWriter.h"
+#include "../WorkStealingPool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <float.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define snprintf _snprintf
+#endif
+
+void SetClusteringOptions(UMCCreator &creator, bool ims, bool useCharge)
+{
+	creator.SetOptionsEx(0.01F, 10, true, 0, 10, true, 0.1F, 0.005F, 15, 0.1F, 0.1, true, ims ? 0.1F : 0, useCharge) ;
+}
+
+void ConfigureCreator(UMCCreator &creator, char *fileName, bool ims)
+{
+	creator.SetFilterOptions(1, 0, 0, INT_MAX, 0, INT_MAX, 0, FLT_MAX, false, INT_MAX, 0, 3000) ;
+	SetClusteringOptions(creator, ims, false) ;
+	creator.SetInputFileName(fileName) ;
+}
+
+// Every field a loader or SetPeaks fills in; the IMS scan and drift time are only set on IMS data
+static bool SamePeaks(const std::vector<IsotopePeak> &expected, const std::vector<IsotopePeak> &actual, bool ims)
+{
+	bool identical = expected.size() == actual.size() ;
+	for (int peakNum = 0 ; identical && peakNum < (int) expected.size() ; peakNum++)
+	{
+		identical = expected[peakNum].mint_original_index == actual[peakNum].mint_original_index
+			&& expected[peakNum].mint_lc_scan == actual[peakNum].mint_lc_scan
+			&& expected[peakNum].mshort_charge == actual[peakNum].mshort_charge
+			&& expected[peakNum].mdbl_mz == actual[peakNum].mdbl_mz
+			&& expected[peakNum].mflt_fit == actual[peakNum].mflt_fit
+			&& expected[peakNum].mdbl_average_mass == actual[peakNum].mdbl_average_mass
+			&& expected[peakNum].mdbl_mono_mass == actual[peakNum].mdbl_mono_mass
+			&& expected[peakNum].mdbl_abundance == actual[peakNum].mdbl_abundance
+			&& (!ims || (expected[peakNum].mint_ims_scan == actual[peakNum].mint_ims_scan
+				&& expected[peakNum].mflt_ims_drift_time == actual[peakNum].mflt_ims_drift_time)) ;
+	}
+	return identical ;
+}
+
+// Two clusterings of the same peaks: the same UMC number for every peak and the same members per UMC
+static bool SameClusters(UMCCreator &expected, UMCCreator &actual, const char *description)
+{
+	std::vector<IsotopePeak> &expectedPeaks = expected.mvect_isotope_peaks ;
+	std::vector<IsotopePeak> &actualPeaks = actual.mvect_isotope_peaks ;
+	if (expectedPeaks.size() != actualPeaks.size() || expected.mvect_umc_num_members != actual.mvect_umc_num_members)
+	{
+		printf("%s: %d UMCs instead of %d\n", description, (int) actual.mvect_umc_num_members.size(), (int) expected.mvect_umc_num_members.size()) ;
+		return false ;
+	}
+	for (int pkNum = 0 ; pkNum < (int) expectedPeaks.size() ; pkNum++)
+	{
+		if (expectedPeaks[pkNum].mint_umc_index != actualPeaks[pkNum].mint_umc_index)
+		{
+			printf("%s: peak %d is in UMC %d instead of %d\n", description, pkNum, actualPeaks[pkNum].mint_umc_index,
+				expectedPeaks[pkNum].mint_umc_index) ;
+			return false ;
+		}
+	}
+	return true ;
+}
+
+static bool CheckParallelLoad(UMCCreator &fixture, char *inputFile, bool ims, int numThreads)
+{
+	WorkStealingPool pool(numThreads) ;
+	UMCCreator creator ;
+	ConfigureCreator(creator, inputFile, ims) ;
+	creator.ReadCSVFileParallel(pool, pool.GetNumThreads()) ;
+
+	bool identical = SamePeaks(fixture.mvect_isotope_peaks, creator.mvect_isotope_peaks, ims)
+		&& creator.mint_lc_min_scan == fixture.mint_lc_min_scan && creator.mint_lc_max_scan == fixture.mint_lc_max_scan ;
+	for (int peakNum = 0 ; identical && peakNum < (int) creator.mvect_isotope_peaks.size() ; peakNum++)
+		identical = fixture.mvect_isotope_peaks[peakNum].mint_line_number_in_file == creator.mvect_isotope_peaks[peakNum].mint_line_number_in_file ;
+	if (!identical)
+		printf("ReadCSVFileParallel returned different peaks than ReadCSVFile\n") ;
+	return identical ;
+}
+
+// A PEK file of the fixture peaks; PEK rows have no fit, average mass or IMS columns, so those are not compared
+static bool CheckPekLoad(UMCCreator &fixture, const char *baseFileName, int numThreads)
+{
+	char pekFileName[1100] ;
+	snprintf(pekFileName, sizeof(pekFileName), "%s.pek", baseFileName) ;
+	if (!SyntheticIsosGenerator::WritePekFile(pekFileName, fixture.mvect_isotope_peaks))
+	{
+		printf("Unable to write %s\n", pekFileName) ;
+		return false ;
+	}
+
+	UMCCreator reference ;
+	reference.ReadPekFileMemoryMapped(pekFileName) ;
+	WorkStealingPool pool(numThreads) ;
+	UMCCreator creator ;
+	int numPeaks = creator.ReadPekFileParallel(pekFileName, pool, pool.GetNumThreads()) ;
+	remove(pekFileName) ;
+
+	std::vector<IsotopePeak> &expected = reference.mvect_isotope_peaks ;
+	std::vector<IsotopePeak> &actual = creator.mvect_isotope_peaks ;
+	bool identical = expected.size() == actual.size() && (size_t) numPeaks == actual.size()
+		&& expected.size() == fixture.mvect_isotope_peaks.size() ;
+	for (int peakNum = 0 ; identical && peakNum < (int) expected.size() ; peakNum++)
+	{
+		identical = expected[peakNum].mint_original_index == actual[peakNum].mint_original_index
+			&& expected[peakNum].mint_lc_scan == actual[peakNum].mint_lc_scan
+			&& expected[peakNum].mshort_charge == actual[peakNum].mshort_charge
+			&& expected[peakNum].mdbl_mz == actual[peakNum].mdbl_mz
+			&& expected[peakNum].mdbl_mono_mass == actual[peakNum].mdbl_mono_mass
+			&& expected[peakNum].mdbl_abundance == actual[peakNum].mdbl_abundance ;
+	}
+	if (!identical)
+		printf("ReadPekFileParallel returned different peaks than ReadPekFileMemoryMapped\n") ;
+	return identical ;
+}
+
+static bool CheckBulkPeaks(UMCCreator &fixture, bool ims)
+{
+	std::vector<IsotopePeak> &peaks = fixture.mvect_isotope_peaks ;
+	int numPeaks = (int) peaks.size() ;
+
+	std::vector<int> originalIndex(numPeaks), lcScan(numPeaks), charge(numPeaks), imsScan(numPeaks) ;
+	std::vector<double> abundance(numPeaks), mz(numPeaks), averageMass(numPeaks), monoMass(numPeaks), maxAbundanceMass(numPeaks), i2Abundance(numPeaks) ;
+	std::vector<float> fit(numPeaks), imsDriftTime(numPeaks) ;
+	std::vector<UMCPeakRecord> records(numPeaks) ;
+	for (int peakNum = 0 ; peakNum < numPeaks ; peakNum++)
+	{
+		IsotopePeak &pk = peaks[peakNum] ;
+		originalIndex[peakNum] = records[peakNum].original_index = pk.mint_original_index ;
+		lcScan[peakNum] = records[peakNum].lc_scan = pk.mint_lc_scan ;
+		charge[peakNum] = records[peakNum].charge = pk.mshort_charge ;
+		imsScan[peakNum] = records[peakNum].ims_scan = pk.mint_ims_scan ;
+		abundance[peakNum] = records[peakNum].abundance = pk.mdbl_abundance ;
+		mz[peakNum] = records[peakNum].mz = pk.mdbl_mz ;
+		averageMass[peakNum] = records[peakNum].average_mass = pk.mdbl_average_mass ;
+		monoMass[peakNum] = records[peakNum].mono_mass = pk.mdbl_mono_mass ;
+		maxAbundanceMass[peakNum] = records[peakNum].max_abundance_mass = pk.mdbl_max_abundance_mass ;
+		i2Abundance[peakNum] = records[peakNum].i2_abundance = pk.mdbl_i2_abundance ;
+		fit[peakNum] = records[peakNum].fit = pk.mflt_fit ;
+		imsDriftTime[peakNum] = records[peakNum].ims_drift_time = pk.mflt_ims_drift_time ;
+	}
+	if (numPeaks < 2)
+		return true ;
+
+	UMCPeakColumns columns ;
+	memset(&columns, 0, sizeof(columns)) ;
+	columns.num_peaks = numPeaks ;
+	columns.original_index = &originalIndex[0] ;
+	columns.lc_scan = &lcScan[0] ;
+	columns.charge = &charge[0] ;
+	columns.abundance = &abundance[0] ;
+	columns.mz = &mz[0] ;
+	columns.fit = &fit[0] ;
+	columns.average_mass = &averageMass[0] ;
+	columns.mono_mass = &monoMass[0] ;
+	columns.max_abundance_mass = &maxAbundanceMass[0] ;
+	columns.i2_abundance = &i2Abundance[0] ;
+	columns.ims_scan = ims ? &imsScan[0] : NULL ;
+	columns.ims_drift_time = &imsDriftTime[0] ;
+
+	std::string error ;
+	UMCCreator fromColumns ;
+	if (!fromColumns.SetPeaks(columns, error) || !SamePeaks(peaks, fromColumns.mvect_isotope_peaks, ims))
+	{
+		printf("SetPeaks (columns) did not take the loaded peaks: %s\n", error.c_str()) ;
+		return false ;
+	}
+	UMCCreator fromRecords ;
+	if (!fromRecords.SetPeaks(&records[0], numPeaks, ims, error) || !SamePeaks(peaks, fromRecords.mvect_isotope_peaks, ims))
+	{
+		printf("SetPeaks (records) did not take the loaded peaks: %s\n", error.c_str()) ;
+		return false ;
+	}
+
+	// records in reverse are put back in the order of their original indices
+	std::vector<UMCPeakRecord> reversed(records.rbegin(), records.rend()) ;
+	UMCCreator fromReversed ;
+	if (!fromReversed.SetPeaks(&reversed[0], numPeaks, ims, error) || !SamePeaks(peaks, fromReversed.mvect_isotope_peaks, ims))
+	{
+		printf("SetPeaks did not order the records by their original index: %s\n", error.c_str()) ;
+		return false ;
+	}
+
+	UMCCreator invalid ;
+	reversed[numPeaks - 1].original_index = numPeaks ;
+	if (invalid.SetPeaks(&reversed[0], numPeaks, ims, error) || !invalid.mvect_isotope_peaks.empty())
+	{
+		printf("SetPeaks took an original index past the last peak\n") ;
+		return false ;
+	}
+	originalIndex[numPeaks - 1] = originalIndex[0] ;
+	if (invalid.SetPeaks(columns, error) || !invalid.mvect_isotope_peaks.empty())
+	{
+		printf("SetPeaks took two peaks with the same original index\n") ;
+		return false ;
+	}
+	originalIndex[numPeaks - 1] = numPeaks - 1 ;
+	abundance[numPeaks / 2] = 0 ;
+	if (invalid.SetPeaks(columns, error) || !invalid.mvect_isotope_peaks.empty())
+	{
+		printf("SetPeaks took a peak without abundance\n") ;
+		return false ;
+	}
+	return true ;
+}
+
+static bool CheckImsIndex(UMCCreator &fixture)
+{
+	UMCCreator reference(fixture) ;
+	reference.SetUseImsCandidateIndex(false) ;
+	reference.CreateUMCsSinglyLinkedWithAll() ;
+
+	UMCCreator creator(fixture) ;
+	creator.SetUseImsCandidateIndex(true) ;
+	creator.CreateUMCsSinglyLinkedWithAll() ;
+	return SameClusters(reference, creator, "IMS candidate index") ;
+}
+
+// A scan gap of a twentieth of the gradient (MaxScanGap); the index is in scan order on LC-MS data
+static bool CheckScanGap(UMCCreator &fixture)
+{
+	int maxScanGap = (fixture.mint_lc_max_scan - fixture.mint_lc_min_scan) / 20 + 1 ;
+	UMCCreator reference(fixture) ;
+	reference.SetMaxGaps(maxScanGap, 0, 0) ;
+	reference.SetUseImsCandidateIndex(false) ;
+	reference.CreateUMCsSinglyLinkedWithAll() ;
+
+	UMCCreator creator(fixture) ;
+	creator.SetMaxGaps(maxScanGap, 0, 0) ;
+	creator.SetUseImsCandidateIndex(true) ;
+	creator.CreateUMCsSinglyLinkedWithAll() ;
+	return SameClusters(reference, creator, "Candidate index with a scan gap") ;
+}
+
+static bool CheckChargePartitions(UMCCreator &fixture, bool ims, int numThreads)
+{
+	UMCCreator reference(fixture) ;
+	SetClusteringOptions(reference, ims, true) ;
+	reference.CreateUMCsSinglyLinkedWithAll() ;
+
+	WorkStealingPool pool(numThreads) ;
+	UMCCreator creator(fixture) ;
+	SetClusteringOptions(creator, ims, true) ;
+	creator.CreateUMCsSinglyLinkedWithAll(pool) ;
+	return SameClusters(reference, creator, "Clustering by charge state") ;
+}
+
+// The frames are split over the tasks by the number of threads, so one thread and numThreads must give the same UMCs
+static bool CheckImsConformers(UMCCreator &fixture, int numThreads)
+{
+	WorkStealingPool singlePool(1) ;
+	UMCCreator reference(fixture) ;
+	reference.SetCollapseImsConformers(true) ;
+	reference.CreateUMCsSinglyLinkedWithAll(singlePool) ;
+
+	WorkStealingPool pool(numThreads) ;
+	UMCCreator creator(fixture) ;
+	creator.SetCollapseImsConformers(true) ;
+	creator.CreateUMCsSinglyLinkedWithAll(pool) ;
+	if (creator.GetNumConformerNodes() <= 0)
+	{
+		printf("No conformer nodes were built\n") ;
+		return false ;
+	}
+	return SameClusters(reference, creator, "Collapsing conformers on several threads") ;
+}
+
+static bool CheckFeatureTable(UMCCreator &fixture, int minLength)
+{
+	UMCCreator creator(fixture) ;
+	creator.CreateUMCsSinglyLinkedWithAll() ;
+	creator.RemoveShortUMCs(minLength) ;
+	creator.CalculateUMCs() ;
+
+	// what GetUMCs and GetUmcMapping hand to the VB host, which then sorts the map by feature and peak
+	std::vector<UMC> umcs(creator.mvect_umcs.begin(), creator.mvect_umcs.end()) ;
+	std::vector<std::pair<int, int> > mapping(creator.mmultimap_umc_2_peak_index.begin(), creator.mmultimap_umc_2_peak_index.end()) ;
+	std::sort(mapping.begin(), mapping.end()) ;
+
+	FeatureTable featureTable ;
+	featureTable.Build(creator) ;
+	const UMCFeatureTable *table = featureTable.GetTable() ;
+	bool matches = table->num_features == (int) umcs.size() && table->num_mappings == (int) mapping.size() ;
+	for (int featureNum = 0 ; matches && featureNum < table->num_features ; featureNum++)
+	{
+		UMC &umc = umcs[featureNum] ;
+		matches = table->umc_index[featureNum] == umc.mint_umc_index && table->scan[featureNum] == umc.mint_max_abundance_scan
+			&& table->start_scan[featureNum] == umc.mint_start_scan && table->end_scan[featureNum] == umc.mint_stop_scan
+			&& table->mono_mass[featureNum] == umc.mdbl_median_mono_mass && table->abundance[featureNum] == umc.mdbl_sum_abundance
+			&& table->class_rep_mz[featureNum] == umc.mdbl_class_rep_mz && table->class_rep_charge[featureNum] == umc.mshort_class_rep_charge
+			&& table->num_members[featureNum] == table->peak_start[featureNum + 1] - table->peak_start[featureNum] ;
+	}
+	for (int mappingNum = 0 ; matches && mappingNum < table->num_mappings ; mappingNum++)
+	{
+		matches = table->peak_feature[mappingNum] == mapping[mappingNum].first && table->peak_index[mappingNum] == mapping[mappingNum].second
+			&& table->peak_start[table->peak_feature[mappingNum]] <= mappingNum && mappingNum < table->peak_start[table->peak_feature[mappingNum] + 1] ;
+	}
+	if (!matches)
+		printf("FeatureTable does not match the UMCs and the peak map\n") ;
+	return matches ;
+}
+
+// Line by line through MemMappedReader, which decompresses either file if needed; line ends are not compared
+static bool FilesHaveSameLines(const char *expectedFileName, const char *actualFileName)
+{
+	MemMappedReader expected, actual ;
+	if (!expected.Load((char *) expectedFileName) || !actual.Load((char *) actualFileName))
+		return false ;
+
+	const int MAX_BUFFER_LEN = 1024 ;
+	char expectedLine[MAX_BUFFER_LEN] ;
+	char actualLine[MAX_BUFFER_LEN] ;
+	char *stopTag = "Blah" ;
+	try
+	{
+		while (true)
+		{
+			bool haveExpected = !expected.eof() && expected.GetNextLine(expectedLine, MAX_BUFFER_LEN, stopTag, (int) strlen(stopTag)) ;
+			bool haveActual = !actual.eof() && actual.GetNextLine(actualLine, MAX_BUFFER_LEN, stopTag, (int) strlen(stopTag)) ;
+			if (haveExpected != haveActual)
+				return false ;
+			if (!haveExpected)
+				return true ;
+			expectedLine[strcspn(expectedLine, "\r")] = '\0' ;
+			actualLine[strcspn(actualLine, "\r")] = '\0' ;
+			if (strcmp(expectedLine, actualLine) != 0)
+				return false ;
+		}
+	}
+	catch (const char *message)
+	{
+		// corrupt or truncated compressed output
+		printf("%s: %s\n", actualFileName, message) ;
+		return false ;
+	}
+}
+
+// Every codec of this build; a build without any only writes the plain files
+static bool CheckCompressedOutput(UMCCreator &fixture, const char *baseFileName, int minLength)
+{
+	const CompressionFormat formats[] = { COMPRESSION_NONE, COMPRESSION_GZIP, COMPRESSION_ZSTD } ;
+	const char *suffixes[] = { "_LCMSFeatures.txt", "_LCMSFeatureToPeakMap.txt" } ;
+	char outputBaseFileName[1100] ;
+	snprintf(outputBaseFileName, sizeof(outputBaseFileName), "%s_Output", baseFileName) ;
+
+	UMCCreator creator(fixture) ;
+	creator.CreateUMCsSinglyLinkedWithAll() ;
+	creator.RemoveShortUMCs(minLength) ;
+	creator.CalculateUMCs() ;
+
+	bool identical = true ;
+	for (int formatNum = 0 ; formatNum < 3 ; formatNum++)
+	{
+		CompressionFormat format = formats[formatNum] ;
+		if (!OutputFileWriter::IsSupported(format))
+			continue ;
+		creator.SetOutputCompression(format, 0, 0) ;
+		creator.CreateFeatureFiles(outputBaseFileName) ;
+
+		for (int suffixNum = 0 ; format != COMPRESSION_NONE && suffixNum < 2 ; suffixNum++)
+		{
+			char fileName[1200] ;
+			char plainFileName[1200] ;
+			snprintf(fileName, sizeof(fileName), "%s%s%s", outputBaseFileName, suffixes[suffixNum], GetCompressionExtension(format)) ;
+			snprintf(plainFileName, sizeof(plainFileName), "%s%s", outputBaseFileName, suffixes[suffixNum]) ;
+			if (!FilesHaveSameLines(plainFileName, fileName))
+			{
+				printf("%s does not read back to the lines of %s\n", fileName, plainFileName) ;
+				identical = false ;
+			}
+		}
+	}
+
+	for (int formatNum = 0 ; formatNum < 3 ; formatNum++)
+	{
+		for (int suffixNum = 0 ; suffixNum < 2 ; suffixNum++)
+		{
+			char fileName[1200] ;
+			snprintf(fileName, sizeof(fileName), "%s%s%s", outputBaseFileName, suffixes[suffixNum], GetCompressionExtension(formats[formatNum])) ;
+			remove(fileName) ;
+		}
+	}
+	return identical ;
+}
+
+// Rows of the feature file without their index, each with the sorted peaks of its map rows, in a fixed order;
+// equal for two runs that found the same features whatever their numbering
+static bool ReadFeaturesByContent(const char *baseFileName, std::vector<std::pair<std::string, std::vector<int> > > &features)
+{
+	char fileName[1200] ;
+	char line[1024] ;
+	features.clear() ;
+
+	snprintf(fileName, sizeof(fileName), "%s_LCMSFeatures.txt", baseFileName) ;
+	FILE *file = fopen(fileName, "r") ;
+	if (file == NULL)
+		return false ;
+	std::vector<int> featureIndices ;
+	fgets(line, sizeof(line), file) ;
+	while (fgets(line, sizeof(line), file) != NULL)
+	{
+		char *columns = strchr(line, '\t') ;
+		featureIndices.push_back(atoi(line)) ;
+		features.push_back(std::make_pair(std::string(columns != NULL ? columns : line), std::vector<int>())) ;
+	}
+	fclose(file) ;
+
+	std::vector<int> featureByIndex ;
+	for (int featureNum = 0 ; featureNum < (int) featureIndices.size() ; featureNum++)
+	{
+		if (featureIndices[featureNum] >= (int) featureByIndex.size())
+			featureByIndex.resize(featureIndices[featureNum] + 1, -1) ;
+		featureByIndex[featureIndices[featureNum]] = featureNum ;
+	}
+
+	snprintf(fileName, sizeof(fileName), "%s_LCMSFeatureToPeakMap.txt", baseFileName) ;
+	file = fopen(fileName, "r") ;
+	if (file == NULL)
+		return false ;
+	fgets(line, sizeof(line), file) ;
+	int featureIndex, peakIndex ;
+	while (fscanf(file, "%d\t%d", &featureIndex, &peakIndex) == 2)
+	{
+		if (featureIndex < 0 || featureIndex >= (int) featureByIndex.size() || featureByIndex[featureIndex] == -1)
+		{
+			fclose(file) ;
+			return false ;
+		}
+		features[featureByIndex[featureIndex]].second.push_back(peakIndex) ;
+	}
+	fclose(file) ;
+
+	for (int featureNum = 0 ; featureNum < (int) features.size() ; featureNum++)
+		std::sort(features[featureNum].second.begin(), features[featureNum].second.end()) ;
+	std::sort(features.begin(), features.end()) ;
+	return true ;
+}
+
+static void RemoveFeatureFiles(const char *baseFileName)
+{
+	char fileName[1200] ;
+	snprintf(fileName, sizeof(fileName), "%s_LCMSFeatures.txt", baseFileName) ;
+	remove(fileName) ;
+	snprintf(fileName, sizeof(fileName), "%s_LCMSFeatureToPeakMap.txt", baseFileName) ;
+	remove(fileName) ;
+}
+
+// A quarter of the peaks per run, so that the merge has several runs to put together
+static bool CheckOutOfCore(UMCCreator &fixture, char *inputFile, const char *baseFileName, bool ims, int minLength)
+{
+	char inMemoryBaseFileName[1100] ;
+	char outOfCoreBaseFileName[1100] ;
+	snprintf(inMemoryBaseFileName, sizeof(inMemoryBaseFileName), "%s_InMemory", baseFileName) ;
+	snprintf(outOfCoreBaseFileName, sizeof(outOfCoreBaseFileName), "%s_OutOfCore", baseFileName) ;
+
+	UMCCreator reference(fixture) ;
+	reference.CreateUMCsSinglyLinkedWithAll() ;
+	reference.RemoveShortUMCs(minLength) ;
+	reference.CalculateUMCs() ;
+	reference.CreateFeatureFiles(inMemoryBaseFileName) ;
+
+	UMCCreator creator ;
+	ConfigureCreator(creator, inputFile, ims) ;
+	int numPeaks = 0 ;
+	long long memoryBudgetBytes = (long long) (fixture.mvect_isotope_peaks.size() * sizeof(IsotopePeak) / 4) ;
+	creator.CreateFeatureFilesOutOfCore(outOfCoreBaseFileName, minLength, outOfCoreBaseFileName, memoryBudgetBytes, numPeaks) ;
+
+	std::vector<std::pair<std::string, std::vector<int> > > expected, actual ;
+	bool identical = ReadFeaturesByContent(inMemoryBaseFileName, expected) && ReadFeaturesByContent(outOfCoreBaseFileName, actual)
+		&& expected == actual ;
+	if (!identical)
+		printf("The out of core mode found different features than the in memory run\n") ;
+	RemoveFeatureFiles(inMemoryBaseFileName) ;
+	RemoveFeatureFiles(outOfCoreBaseFileName) ;
+	return identical ;
+}
+
+int EngineChecks::Run(const char *checkName, char *inputFile, const char *baseFileName, bool ims, int numThreads)
+{
+	const int MIN_UMC_LENGTH = 2 ;
+	bool imsOnly = strcmp(checkName, "ims_index") == 0 || strcmp(checkName, "ims_conformers") == 0 ;
+	if ((imsOnly && !ims) || (strcmp(checkName, "pek_load") == 0 && ims))
+	{
+		printf("Check %s does not apply to %s data\n", checkName, ims ? "IMS" : "LC-MS") ;
+		return 1 ;
+	}
+
+	UMCCreator fixture ;
+	ConfigureCreator(fixture, inputFile, ims) ;
+	fixture.ReadCSVFile() ;
+
+	bool passed ;
+	if (strcmp(checkName, "parallel_load") == 0)
+		passed = CheckParallelLoad(fixture, inputFile, ims, numThreads) ;
+	else if (strcmp(checkName, "pek_load") == 0)
+		passed = CheckPekLoad(fixture, baseFileName, numThreads) ;
+	else if (strcmp(checkName, "bulk_peaks") == 0)
+		passed = CheckBulkPeaks(fixture, ims) ;
+	else if (strcmp(checkName, "ims_index") == 0)
+		passed = CheckImsIndex(fixture) ;
+	else if (strcmp(checkName, "scan_gap") == 0)
+		passed = CheckScanGap(fixture) ;
+	else if (strcmp(checkName, "charge_partitions") == 0)
+		passed = CheckChargePartitions(fixture, ims, numThreads) ;
+	else if (strcmp(checkName, "ims_conformers") == 0)
+		passed = CheckImsConformers(fixture, numThreads) ;
+	else if (strcmp(checkName, "feature_table") == 0)
+		passed = CheckFeatureTable(fixture, MIN_UMC_LENGTH) ;
+	else if (strcmp(checkName, "compressed_output") == 0)
+		passed = CheckCompressedOutput(fixture, baseFileName, MIN_UMC_LENGTH) ;
+	else if (strcmp(checkName, "out_of_core") == 0)
+		passed = CheckOutOfCore(fixture, inputFile, baseFileName, ims, MIN_UMC_LENGTH) ;
+	else
+	{
+		printf("Unknown check %s\n", checkName) ;
+		PrintCheckNames() ;
+		return 1 ;
+	}
+
+	printf("Check %s (%d %s peaks): %s\n", checkName, (int) fixture.mvect_isotope_peaks.size(), ims ? "IMS" : "LC-MS",
+		passed ? "passed" : "FAILED") ;
+	return passed ? 0 : 2 ;
+}
+
+void EngineChecks::PrintCheckNames()
+{
+	printf("Checks: parallel_load pek_load bulk_peaks ims_index scan_gap charge_partitions ims_conformers feature_table\n") ;
+	printf("        compressed_output out_of_core\n") ;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "../UMCCreator.h"
+
+// Same settings as bin\ExampleSettings.ini, without any data filter; shared by the benchmarks and the checks
+void SetClusteringOptions(UMCCreator &creator, bool ims, bool useCharge) ;
+void ConfigureCreator(UMCCreator &creator, char *fileName, bool ims) ;
+
+// The checks always run on a synthetic file of this many peaks (other SyntheticIsosOptions at their defaults)
+// and on this many threads, so that a failure reproduces on any machine
+const int CHECK_FIXTURE_PEAKS = 20000 ;
+const int CHECK_FIXTURE_THREADS = 4 ;
+
+/*
+ * Equivalence checks of the accelerated paths of the engine against the code they replace, run by ctest
+ * through UMCCreationBenchmarks -check NAME; the benchmarks themselves only measure.
+ *		parallel_load		ReadCSVFileParallel against ReadCSVFile
+ *		pek_load			ReadPekFileParallel against ReadPekFileMemoryMapped (LC-MS only)
+ *		bulk_peaks			SetPeaks from columns and from records against the loaded peaks; invalid input refused
+ *		ims_index			clustering with the IMS candidate index against the full mass window (IMS only)
+ *		scan_gap			candidate index against the full mass window with MaxScanGap
+ *		charge_partitions	UseCharge by charge state on the pool against the single sweep
+ *		ims_conformers		conformer collapsing on CHECK_FIXTURE_THREADS threads against one (IMS only)
+ *		feature_table		FeatureTable against the UMCs and the peak map
+ *		compressed_output	compressed feature files against the plain ones
+ *		out_of_core			CreateFeatureFilesOutOfCore against the in memory run
+ */
+class EngineChecks
+{
+public:
+	// Runs one check on inputFile, writing any files next to baseFileName. Returns 0 when the results are the same,
+	// 2 when they differ (printing what differs) and 1 when the check is unknown or does not apply to the data.
+	static int Run(const char *checkName, char *inputFile, const char *baseFileName, bool ims, int numThreads) ;
+	static void PrintCheckNames() ;
+};
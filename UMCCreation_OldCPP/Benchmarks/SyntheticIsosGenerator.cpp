@@ -0,0 +1,211 @@
+#include "SyntheticIsosGenerator.h"
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+static const double PROTON_MASS = 1.00727646688 ;
+static const double C13_DELTA = 1.0033548378 ;
+
+static bool SortPeaksByScan(const IsotopePeak &a, const IsotopePeak &b)
+{
+	if (a.mint_lc_scan != b.mint_lc_scan)
+		return a.mint_lc_scan < b.mint_lc_scan ;
+	if (a.mint_ims_scan != b.mint_ims_scan)
+		return a.mint_ims_scan < b.mint_ims_scan ;
+	return a.mdbl_mono_mass < b.mdbl_mono_mass ;
+}
+
+SyntheticIsosGenerator::SyntheticIsosGenerator(unsigned int seed)
+{
+	mlng_state = seed * 0x9E3779B97F4A7C15ULL + 1 ;
+}
+
+// xorshift64*
+unsigned int SyntheticIsosGenerator::NextInt()
+{
+	mlng_state ^= mlng_state >> 12 ;
+	mlng_state ^= mlng_state << 25 ;
+	mlng_state ^= mlng_state >> 27 ;
+	return (unsigned int) ((mlng_state * 0x2545F4914F6CDD1DULL) >> 32) ;
+}
+
+double SyntheticIsosGenerator::NextDouble()
+{
+	return NextInt() / 4294967296.0 ;
+}
+
+double SyntheticIsosGenerator::NextGaussian()
+{
+	// Box-Muller; the second value is dropped to keep the sequence simple
+	double u1 = NextDouble() ;
+	double u2 = NextDouble() ;
+	if (u1 < 1e-12)
+		u1 = 1e-12 ;
+	return sqrt(-2.0 * log(u1)) * cos(2 * 3.14159265358979 * u2) ;
+}
+
+int SyntheticIsosGenerator::NextInt(int min, int max)
+{
+	if (max <= min)
+		return min ;
+	return min + (int) (NextInt() % (unsigned int) (max - min + 1)) ;
+}
+
+static void FillDerivedColumns(IsotopePeak &pk, double abundance)
+{
+	pk.mdbl_abundance = floor(abundance) + 1 ;
+	pk.mdbl_mz = (pk.mdbl_mono_mass + pk.mshort_charge * PROTON_MASS) / pk.mshort_charge ;
+	pk.mdbl_average_mass = pk.mdbl_mono_mass * 1.000613 ;
+	pk.mdbl_max_abundance_mass = pk.mdbl_mono_mass + floor(pk.mdbl_mono_mass / 1800.0) * C13_DELTA ;
+	pk.mdbl_mono_abundance = floor(pk.mdbl_abundance * 0.6) ;
+	pk.mdbl_i2_abundance = floor(pk.mdbl_abundance * 0.3) ;
+	pk.mflt_orig_intensity = (float) pk.mdbl_abundance ;
+	pk.mflt_tia_orig_intensity = (float) (pk.mdbl_abundance * 1.1) ;
+	pk.mflt_cum_drift_time = pk.mflt_ims_drift_time ;
+	pk.mint_umc_index = -1 ;
+}
+
+void SyntheticIsosGenerator::Generate(const SyntheticIsosOptions &options, std::vector<IsotopePeak> &peaks)
+{
+	peaks.clear() ;
+	peaks.reserve(options.mint_num_peaks) ;
+
+	int numFeaturePeaks = (int) (options.mint_num_peaks * options.mflt_feature_fraction) ;
+	int imsWidth = options.mbln_ims ? std::max(1, options.mint_ims_peak_width) : 1 ;
+
+	IsotopePeak pk ;
+	pk.mint_ims_scan = 0 ;
+	pk.mflt_ims_drift_time = 0 ;
+
+	// eluting features: gaussian profile in LC (and in drift time for IMS)
+	while ((int) peaks.size() < numFeaturePeaks)
+	{
+		double mass = options.mdbl_min_mono_mass + NextDouble() * (options.mdbl_max_mono_mass - options.mdbl_min_mono_mass) ;
+		short charge = (short) NextInt(options.mint_min_charge, options.mint_max_charge) ;
+		int length = (int) (options.mint_mean_feature_length * (1 + NextGaussian() / 3.0) + 0.5) ;
+		if (length < 2)
+			length = 2 ;
+		int apexScan = NextInt(0, options.mint_num_lc_scans - 1) ;
+		int startScan = std::max(0, apexScan - length / 2) ;
+		int imsApex = NextInt(imsWidth, std::max(imsWidth, options.mint_num_ims_scans - imsWidth)) ;
+		double driftApex = 5 + NextDouble() * 55 ;
+		double maxAbundance = pow(10.0, 3.5 + NextDouble() * 3.5) ;
+		float fit = (float) (0.01 + NextDouble() * 0.1) ;
+
+		for (int scanNum = startScan ; scanNum < startScan + length && scanNum < options.mint_num_lc_scans ; scanNum++)
+		{
+			double lcOffset = (scanNum - apexScan) / (length / 4.0) ;
+			double lcProfile = exp(-0.5 * lcOffset * lcOffset) ;
+			for (int imsOffset = -(imsWidth / 2) ; imsOffset < imsWidth - imsWidth / 2 ; imsOffset++)
+			{
+				if ((int) peaks.size() >= numFeaturePeaks)
+					break ;
+				double imsProfile = 1 ;
+				pk.mint_ims_scan = 0 ;
+				pk.mflt_ims_drift_time = 0 ;
+				if (options.mbln_ims)
+				{
+					double offset = imsOffset / (imsWidth / 3.0 + 0.5) ;
+					imsProfile = exp(-0.5 * offset * offset) ;
+					pk.mint_ims_scan = imsApex + imsOffset ;
+					pk.mflt_ims_drift_time = (float) (driftApex + imsOffset * 0.16) ;
+				}
+				pk.mint_lc_scan = scanNum ;
+				pk.mshort_charge = charge ;
+				pk.mdbl_mono_mass = mass * (1 + NextGaussian() * options.mflt_mass_error_ppm * 1e-6) ;
+				pk.mflt_fit = fit ;
+				FillDerivedColumns(pk, maxAbundance * lcProfile * imsProfile) ;
+				peaks.push_back(pk) ;
+			}
+		}
+	}
+
+	// isolated noise peaks
+	while ((int) peaks.size() < options.mint_num_peaks)
+	{
+		pk.mint_lc_scan = NextInt(0, options.mint_num_lc_scans - 1) ;
+		pk.mshort_charge = (short) NextInt(options.mint_min_charge, options.mint_max_charge) ;
+		pk.mdbl_mono_mass = options.mdbl_min_mono_mass + NextDouble() * (options.mdbl_max_mono_mass - options.mdbl_min_mono_mass) ;
+		pk.mflt_fit = (float) (0.05 + NextDouble() * 0.25) ;
+		pk.mint_ims_scan = 0 ;
+		pk.mflt_ims_drift_time = 0 ;
+		if (options.mbln_ims)
+		{
+			pk.mint_ims_scan = NextInt(0, options.mint_num_ims_scans - 1) ;
+			pk.mflt_ims_drift_time = (float) (pk.mint_ims_scan * 0.16) ;
+		}
+		FillDerivedColumns(pk, pow(10.0, 2.5 + NextDouble() * 1.5)) ;
+		peaks.push_back(pk) ;
+	}
+
+	std::stable_sort(peaks.begin(), peaks.end(), &SortPeaksByScan) ;
+	for (int pkNum = 0 ; pkNum < (int) peaks.size() ; pkNum++)
+	{
+		peaks[pkNum].mint_original_index = pkNum ;
+		peaks[pkNum].mint_line_number_in_file = pkNum ;
+	}
+}
+
+bool SyntheticIsosGenerator::WritePeaks(const char *fileName, const std::vector<IsotopePeak> &peaks, bool ims)
+{
+	FILE *file = fopen(fileName, "w") ;
+	if (file == NULL)
+		return false ;
+
+	if (ims)
+		fprintf(file, "frame_num,ims_scan_num,charge,abundance,mz,fit,average_mw,monoisotopic_mw,mostabundant_mw,fwhm,signal_noise,mono_abundance,mono_plus2_abundance,orig_intensity,TIA_orig_intensity,drift_time,cumulative_drift_time\n") ;
+	else
+		fprintf(file, "scan_num,charge,abundance,mz,fit,average_mw,monoisotopic_mw,mostabundant_mw,fwhm,signal_noise,mono_abundance,mono_plus2_abundance\n") ;
+
+	int numPeaks = (int) peaks.size() ;
+	for (int pkNum = 0 ; pkNum < numPeaks ; pkNum++)
+	{
+		const IsotopePeak &pk = peaks[pkNum] ;
+		if (ims)
+			fprintf(file, "%d,%d,", pk.mint_lc_scan, pk.mint_ims_scan) ;
+		else
+			fprintf(file, "%d,", pk.mint_lc_scan) ;
+		fprintf(file, "%d,%.0f,%.5f,%.4f,%.5f,%.5f,%.5f,0.02,%.2f,%.0f,%.0f", pk.mshort_charge, pk.mdbl_abundance, pk.mdbl_mz, pk.mflt_fit,
+			pk.mdbl_average_mass, pk.mdbl_mono_mass, pk.mdbl_max_abundance_mass, pk.mdbl_abundance / 100.0, pk.mdbl_mono_abundance, pk.mdbl_i2_abundance) ;
+		if (ims)
+			fprintf(file, ",%.0f,%.0f,%.4f,%.4f", pk.mflt_orig_intensity, pk.mflt_tia_orig_intensity, pk.mflt_ims_drift_time, pk.mflt_cum_drift_time) ;
+		fprintf(file, "\n") ;
+	}
+
+	fclose(file) ;
+	return true ;
+}
+
+bool SyntheticIsosGenerator::WritePekFile(const char *fileName, const std::vector<IsotopePeak> &peaks)
+{
+	FILE *file = fopen(fileName, "w") ;
+	if (file == NULL)
+		return false ;
+
+	int numPeaks = (int) peaks.size() ;
+	int pkNum = 0 ;
+	while (pkNum < numPeaks)
+	{
+		int scan = peaks[pkNum].mint_lc_scan ;
+		fprintf(file, "Filename: C:\\Data\\UMCCreationBenchmark.%05d\n", scan) ;
+		fprintf(file, "Processing start time: 1/1/2008 12:00:00 AM\n\n") ;
+		fprintf(file, "CS,  Abundance,   m/z,   Fit,    Average MW, Monoisotopic MW,    Most abundant MW\n") ;
+		for ( ; pkNum < numPeaks && peaks[pkNum].mint_lc_scan == scan ; pkNum++)
+		{
+			const IsotopePeak &pk = peaks[pkNum] ;
+			fprintf(file, "%d\t%.0f\t%.5f\t%.4f\t%.5f\t%.5f\t%.5f\n", pk.mshort_charge, pk.mdbl_abundance, pk.mdbl_mz, pk.mflt_fit,
+				pk.mdbl_average_mass, pk.mdbl_mono_mass, pk.mdbl_max_abundance_mass) ;
+		}
+		fprintf(file, "Processing stop time: 1/1/2008 12:00:01 AM\n\n") ;
+	}
+
+	fclose(file) ;
+	return true ;
+}
+
+bool SyntheticIsosGenerator::WriteFile(const char *fileName, const SyntheticIsosOptions &options)
+{
+	std::vector<IsotopePeak> peaks ;
+	Generate(options, peaks) ;
+	return WritePeaks(fileName, peaks, options.mbln_ims) ;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include "../IsotopePeak.h"
+#include <vector>
+
+// Shape of a synthetic isos file
+struct SyntheticIsosOptions
+{
+	int mint_num_peaks ;				// total number of rows written
+	float mflt_feature_fraction ;		// fraction of the rows that belong to eluting features; the rest is isolated noise
+	int mint_mean_feature_length ;		// average number of LC scans a feature elutes over
+	int mint_min_charge ;
+	int mint_max_charge ;
+	int mint_num_lc_scans ;				// LC scans (frames for IMS data)
+	bool mbln_ims ;						// write the IMS layout (frame_num, ims_scan_num, ..., drift_time)
+	int mint_num_ims_scans ;			// IMS scans per frame
+	int mint_ims_peak_width ;			// IMS scans a conformer spans inside one frame
+	double mdbl_min_mono_mass ;
+	double mdbl_max_mono_mass ;
+	float mflt_mass_error_ppm ;			// spread of the mono mass around the feature mass
+	unsigned int mint_seed ;
+
+	SyntheticIsosOptions()
+	{
+		mint_num_peaks = 100000 ;
+		mflt_feature_fraction = 0.5F ;
+		mint_mean_feature_length = 8 ;
+		mint_min_charge = 1 ;
+		mint_max_charge = 4 ;
+		mint_num_lc_scans = 10000 ;
+		mbln_ims = false ;
+		mint_num_ims_scans = 300 ;
+		mint_ims_peak_width = 4 ;
+		mdbl_min_mono_mass = 400 ;
+		mdbl_max_mono_mass = 6000 ;
+		mflt_mass_error_ppm = 2 ;
+		mint_seed = 12345 ;
+	}
+} ;
+
+/*
+ * Deterministic generator of isos files for benchmarks and tests.
+ * Uses its own random number generator so that a seed gives byte-identical files on every platform.
+ * Rows are written in scan order (frame, then IMS scan) like DeconTools does.
+ */
+class SyntheticIsosGenerator
+{
+	unsigned long long mlng_state ;
+
+	unsigned int NextInt() ;
+	double NextDouble() ;
+	double NextGaussian() ;
+	int NextInt(int min, int max) ;
+
+public:
+	SyntheticIsosGenerator(unsigned int seed) ;
+
+	void Generate(const SyntheticIsosOptions &options, std::vector<IsotopePeak> &peaks) ;
+	bool WriteFile(const char *fileName, const SyntheticIsosOptions &options) ;
+	static bool WritePeaks(const char *fileName, const std::vector<IsotopePeak> &peaks, bool ims) ;
+	// ICR2LS PEK layout: one "Filename:" ... "Processing stop time:" block per LC scan of peaks (in scan order)
+	static bool WritePekFile(const char *fileName, const std::vector<IsotopePeak> &peaks) ;
+};
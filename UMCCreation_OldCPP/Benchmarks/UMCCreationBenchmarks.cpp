@@ -0,0 +1,769 @@
+// UMCCreationBenchmarks.cpp : micro and end-to-end benchmarks for the native UMCCreator engine.
+//
+// Usage: UMCCreationBenchmarks [-peaks N] [-ims] [-density F] [-charges MIN MAX] [-scans N]
+//                              [-seed S] [-iterations N] [-threads N] [-input isos.csv] [-dir OutputFolder] [-keep]
+//        UMCCreationBenchmarks -check NAME [-ims] [-dir OutputFolder]
+//
+// Without -input a synthetic isos file is generated (deterministic for a given seed) in the output folder.
+// -check runs one of the EngineChecks on a fixed synthetic file instead of the benchmarks.
+
+#include "../UMCCreator.h"
+#include "../FeatureTable.h"
+#include "../MemMappedReader.h"
+#include "../OutputFileWriter.h"
+#include "../ProcessStats.h"
+#include "../WorkStealingPool.h"
+#include "SyntheticIsosGenerator.h"
+#include "EngineChecks.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <float.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define snprintf _snprintf
+#endif
+
+struct BenchmarkResult
+{
+	const char *mstr_name ;
+	int mint_iterations ;
+	double mdbl_best_seconds ;
+	double mdbl_mean_seconds ;
+	long long mlng_items ;
+	const char *mstr_unit ;
+} ;
+
+static std::vector<BenchmarkResult> gvect_results ;
+
+static void AddResult(const char *name, int iterations, double best, double total, long long items, const char *unit)
+{
+	BenchmarkResult result ;
+	result.mstr_name = name ;
+	result.mint_iterations = iterations ;
+	result.mdbl_best_seconds = best ;
+	result.mdbl_mean_seconds = total / iterations ;
+	result.mlng_items = items ;
+	result.mstr_unit = unit ;
+	gvect_results.push_back(result) ;
+}
+
+static bool SortIsotopesByMonoMass(const IsotopePeak &a, const IsotopePeak &b)
+{
+	return a.mdbl_mono_mass < b.mdbl_mono_mass ;
+}
+
+static void BenchmarkReadCSVFile(char *fileName, bool ims, int iterations)
+{
+	double best = DBL_MAX, total = 0 ;
+	long long numPeaks = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		UMCCreator creator ;
+		ConfigureCreator(creator, fileName, ims) ;
+		double start = GetWallClockSeconds() ;
+		numPeaks = creator.ReadCSVFile() ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("ReadCSVFile", iterations, best, total, numPeaks, "peaks") ;
+}
+
+static void BenchmarkReadCSVFileParallel(char *fileName, bool ims, int iterations, int numThreads)
+{
+	WorkStealingPool pool(numThreads) ;
+	double best = DBL_MAX, total = 0 ;
+	long long numPeaks = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		UMCCreator creator ;
+		ConfigureCreator(creator, fileName, ims) ;
+		double start = GetWallClockSeconds() ;
+		numPeaks = creator.ReadCSVFileParallel(pool, pool.GetNumThreads()) ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("ReadCSVFileParallel", iterations, best, total, numPeaks, "peaks") ;
+}
+
+// PEK file of the loaded peaks, read by ReadPekFileMemoryMapped and ReadPekFileParallel
+static void BenchmarkReadPekFile(UMCCreator &source, char *pekFileName, int iterations, int numThreads)
+{
+	if (!SyntheticIsosGenerator::WritePekFile(pekFileName, source.mvect_isotope_peaks))
+	{
+		printf("Unable to write %s\n", pekFileName) ;
+		return ;
+	}
+
+	double best = DBL_MAX, total = 0 ;
+	long long numPeaks = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		UMCCreator creator ;
+		double start = GetWallClockSeconds() ;
+		creator.ReadPekFileMemoryMapped(pekFileName) ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+		numPeaks = (long long) creator.mvect_isotope_peaks.size() ;
+	}
+	AddResult("ReadPekFileMemoryMapped", iterations, best, total, numPeaks, "peaks") ;
+
+	WorkStealingPool pool(numThreads) ;
+	best = DBL_MAX ;
+	total = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		UMCCreator creator ;
+		double start = GetWallClockSeconds() ;
+		numPeaks = creator.ReadPekFileParallel(pekFileName, pool, pool.GetNumThreads()) ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("ReadPekFileParallel", iterations, best, total, numPeaks, "peaks") ;
+}
+
+// Handing loaded peaks to a creator the way clsUMCCreator::SetIsotopePeaks did (a field by field copy into a
+// temporary vector, copied again by SetPeks) against the bulk SetPeaks from columns and from packed records
+static void BenchmarkBulkPeaks(UMCCreator &source, bool ims, int iterations)
+{
+	std::vector<IsotopePeak> &peaks = source.mvect_isotope_peaks ;
+	int numPeaks = (int) peaks.size() ;
+
+	// the arrays a host would hold
+	std::vector<int> originalIndex(numPeaks), lcScan(numPeaks), charge(numPeaks), imsScan(numPeaks) ;
+	std::vector<double> abundance(numPeaks), mz(numPeaks), averageMass(numPeaks), monoMass(numPeaks), maxAbundanceMass(numPeaks), i2Abundance(numPeaks) ;
+	std::vector<float> fit(numPeaks), imsDriftTime(numPeaks) ;
+	std::vector<UMCPeakRecord> records(numPeaks) ;
+	for (int peakNum = 0 ; peakNum < numPeaks ; peakNum++)
+	{
+		IsotopePeak &pk = peaks[peakNum] ;
+		originalIndex[peakNum] = records[peakNum].original_index = pk.mint_original_index ;
+		lcScan[peakNum] = records[peakNum].lc_scan = pk.mint_lc_scan ;
+		charge[peakNum] = records[peakNum].charge = pk.mshort_charge ;
+		imsScan[peakNum] = records[peakNum].ims_scan = pk.mint_ims_scan ;
+		abundance[peakNum] = records[peakNum].abundance = pk.mdbl_abundance ;
+		mz[peakNum] = records[peakNum].mz = pk.mdbl_mz ;
+		averageMass[peakNum] = records[peakNum].average_mass = pk.mdbl_average_mass ;
+		monoMass[peakNum] = records[peakNum].mono_mass = pk.mdbl_mono_mass ;
+		maxAbundanceMass[peakNum] = records[peakNum].max_abundance_mass = pk.mdbl_max_abundance_mass ;
+		i2Abundance[peakNum] = records[peakNum].i2_abundance = pk.mdbl_i2_abundance ;
+		fit[peakNum] = records[peakNum].fit = pk.mflt_fit ;
+		imsDriftTime[peakNum] = records[peakNum].ims_drift_time = pk.mflt_ims_drift_time ;
+	}
+
+	UMCPeakColumns columns ;
+	memset(&columns, 0, sizeof(columns)) ;
+	columns.num_peaks = numPeaks ;
+	if (numPeaks > 0)
+	{
+		columns.original_index = &originalIndex[0] ;
+		columns.lc_scan = &lcScan[0] ;
+		columns.charge = &charge[0] ;
+		columns.abundance = &abundance[0] ;
+		columns.mz = &mz[0] ;
+		columns.fit = &fit[0] ;
+		columns.average_mass = &averageMass[0] ;
+		columns.mono_mass = &monoMass[0] ;
+		columns.max_abundance_mass = &maxAbundanceMass[0] ;
+		columns.i2_abundance = &i2Abundance[0] ;
+		columns.ims_scan = ims ? &imsScan[0] : NULL ;
+		columns.ims_drift_time = &imsDriftTime[0] ;
+	}
+
+	double best = DBL_MAX, total = 0 ;
+	UMCCreator perPeak ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		double start = GetWallClockSeconds() ;
+		std::vector<IsotopePeak> vectPeaks ;
+		vectPeaks.reserve(numPeaks) ;
+		for (int peakNum = 0 ; peakNum < numPeaks ; peakNum++)
+		{
+			IsotopePeak pk = peaks[peakNum] ;
+			vectPeaks.push_back(pk) ;
+		}
+		perPeak.SetPeks(vectPeaks) ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("SetPeks (per peak copy)", iterations, best, total, numPeaks, "peaks") ;
+
+	std::string error ;
+	best = DBL_MAX ;
+	total = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		UMCCreator creator ;
+		double start = GetWallClockSeconds() ;
+		creator.SetPeaks(columns, error) ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("SetPeaks (columns)", iterations, best, total, numPeaks, "peaks") ;
+
+	best = DBL_MAX ;
+	total = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		UMCCreator creator ;
+		double start = GetWallClockSeconds() ;
+		creator.SetPeaks(numPeaks > 0 ? &records[0] : NULL, numPeaks, ims, error) ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("SetPeaks (records)", iterations, best, total, numPeaks, "peaks") ;
+}
+
+static void BenchmarkPeakDistance(UMCCreator &creator, int iterations)
+{
+	// every peak against its next 8 neighbours in mass, the pairs the clustering sweep looks at
+	const int NUM_NEIGHBOURS = 8 ;
+	std::vector<IsotopePeak> sortedPeaks(creator.mvect_isotope_peaks) ;
+	std::sort(sortedPeaks.begin(), sortedPeaks.end(), &SortIsotopesByMonoMass) ;
+	int numPeaks = (int) sortedPeaks.size() ;
+
+	double best = DBL_MAX, total = 0 ;
+	long long numEvaluations = 0 ;
+	volatile double sink = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		numEvaluations = 0 ;
+		double sum = 0 ;
+		double start = GetWallClockSeconds() ;
+		for (int pkNum = 0 ; pkNum < numPeaks ; pkNum++)
+		{
+			int lastMatch = std::min(numPeaks, pkNum + 1 + NUM_NEIGHBOURS) ;
+			for (int matchNum = pkNum + 1 ; matchNum < lastMatch ; matchNum++)
+			{
+				double distance = creator.PeakDistance(sortedPeaks[pkNum], sortedPeaks[matchNum]) ;
+				if (distance < DBL_MAX)
+					sum += distance ;
+				numEvaluations++ ;
+			}
+		}
+		double elapsed = GetWallClockSeconds() - start ;
+		sink = sink + sum ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("PeakDistance", iterations, best, total, numEvaluations, "pairs") ;
+}
+
+static void BenchmarkClustering(UMCCreator &creator, int iterations)
+{
+	double best = DBL_MAX, total = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		creator.mvect_umc_num_members.clear() ;
+		double start = GetWallClockSeconds() ;
+		creator.CreateUMCsSinglyLinkedWithAll() ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("CreateUMCsSinglyLinkedWithAll", iterations, best, total, (long long) creator.mvect_isotope_peaks.size(), "peaks") ;
+}
+
+// Clustering of IMS data without the drift time / frame candidate index, and the distance evaluations with and
+// without it
+static void BenchmarkImsCandidateIndex(UMCCreator &creator, int iterations)
+{
+	creator.SetUseImsCandidateIndex(true) ;
+	long long evaluationsBefore = creator.GetTelemetry().GetDistanceEvaluations() ;
+	creator.CreateUMCsSinglyLinkedWithAll() ;
+	long long indexEvaluations = creator.GetTelemetry().GetDistanceEvaluations() - evaluationsBefore ;
+
+	creator.SetUseImsCandidateIndex(false) ;
+	double best = DBL_MAX, total = 0 ;
+	long long scanEvaluations = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		evaluationsBefore = creator.GetTelemetry().GetDistanceEvaluations() ;
+		double start = GetWallClockSeconds() ;
+		creator.CreateUMCsSinglyLinkedWithAll() ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+		scanEvaluations = creator.GetTelemetry().GetDistanceEvaluations() - evaluationsBefore ;
+	}
+	creator.SetUseImsCandidateIndex(true) ;
+	AddResult("CreateUMCsSinglyLinkedWithAll (no IMS index)", iterations, best, total, (long long) creator.mvect_isotope_peaks.size(), "peaks") ;
+	AddResult("Distance evaluations (IMS index)", 1, 1, 1, indexEvaluations, "pairs") ;
+	AddResult("Distance evaluations (no IMS index)", 1, 1, 1, scanEvaluations, "pairs") ;
+}
+
+// Clustering with a scan gap of a twentieth of the gradient (MaxScanGap), the candidates taken from the index, which is
+// in scan order on LC-MS data, and the distance evaluations against the full mass window with the same gap
+static void BenchmarkScanGap(UMCCreator &creator, int iterations)
+{
+	creator.SetMaxGaps((creator.mint_lc_max_scan - creator.mint_lc_min_scan) / 20 + 1, 0, 0) ;
+	creator.SetUseImsCandidateIndex(false) ;
+	long long evaluationsBefore = creator.GetTelemetry().GetDistanceEvaluations() ;
+	creator.CreateUMCsSinglyLinkedWithAll() ;
+	long long windowEvaluations = creator.GetTelemetry().GetDistanceEvaluations() - evaluationsBefore ;
+
+	creator.SetUseImsCandidateIndex(true) ;
+	double best = DBL_MAX, total = 0 ;
+	long long indexEvaluations = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		evaluationsBefore = creator.GetTelemetry().GetDistanceEvaluations() ;
+		double start = GetWallClockSeconds() ;
+		creator.CreateUMCsSinglyLinkedWithAll() ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+		indexEvaluations = creator.GetTelemetry().GetDistanceEvaluations() - evaluationsBefore ;
+	}
+	creator.SetMaxGaps(0, 0, 0) ;
+	AddResult("CreateUMCsSinglyLinkedWithAll (scan gap)", iterations, best, total, (long long) creator.mvect_isotope_peaks.size(), "peaks") ;
+	AddResult("Distance evaluations (scan gap, index)", 1, 1, 1, indexEvaluations, "pairs") ;
+	AddResult("Distance evaluations (scan gap, mass window)", 1, 1, 1, windowEvaluations, "pairs") ;
+}
+
+// Clustering with the charge state constraint (UseCharge), all charge states in one sweep and one charge state per
+// pool task
+static void BenchmarkChargePartitions(UMCCreator &creator, bool ims, int iterations, int numThreads)
+{
+	SetClusteringOptions(creator, ims, true) ;
+	long long numPeaks = (long long) creator.mvect_isotope_peaks.size() ;
+	double best = DBL_MAX, total = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		double start = GetWallClockSeconds() ;
+		creator.CreateUMCsSinglyLinkedWithAll() ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("CreateUMCsSinglyLinkedWithAll (UseCharge)", iterations, best, total, numPeaks, "peaks") ;
+
+	WorkStealingPool pool(numThreads) ;
+	best = DBL_MAX ;
+	total = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		double start = GetWallClockSeconds() ;
+		creator.CreateUMCsSinglyLinkedWithAll(pool) ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("CreateUMCsSinglyLinkedWithAll (UseCharge, by charge)", iterations, best, total, numPeaks, "peaks") ;
+	SetClusteringOptions(creator, ims, false) ;
+}
+
+// Two-stage clustering of IMS data: rows collapsed into conformer nodes per frame, then the nodes clustered
+static void BenchmarkImsConformers(UMCCreator &creator, int iterations, int numThreads)
+{
+	int numPeaks = (int) creator.mvect_isotope_peaks.size() ;
+	creator.CreateUMCsSinglyLinkedWithAll() ;
+	AddResult("UMCs (peaks)", 1, 1, 1, (long long) creator.mvect_umc_num_members.size(), "UMCs") ;
+
+	creator.SetCollapseImsConformers(true) ;
+	WorkStealingPool pool(numThreads) ;
+	double best = DBL_MAX, total = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		double start = GetWallClockSeconds() ;
+		creator.CreateUMCsSinglyLinkedWithAll(pool) ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("CreateUMCsSinglyLinkedWithAll (conformers)", iterations, best, total, (long long) numPeaks, "peaks") ;
+	AddResult("Conformer nodes", 1, 1, 1, creator.GetNumConformerNodes(), "nodes") ;
+	AddResult("UMCs (conformers)", 1, 1, 1, (long long) creator.mvect_umc_num_members.size(), "UMCs") ;
+	creator.SetCollapseImsConformers(false) ;
+}
+
+static void BenchmarkRemoveShortUMCs(UMCCreator &creator, int iterations, int minLength)
+{
+	// RemoveShortUMCs filters the raw clusters kept by the clustering, so one clustering serves every iteration
+	creator.CreateUMCsSinglyLinkedWithAll() ;
+	long long numUmcs = (long long) creator.mvect_umc_num_members.size() ;
+	double best = DBL_MAX, total = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		double start = GetWallClockSeconds() ;
+		creator.RemoveShortUMCs(minLength) ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("RemoveShortUMCs", iterations, best, total, numUmcs, "clusters") ;
+}
+
+// Changing the minimum feature length after a full run: filtering plus statistics, without clustering again
+static void BenchmarkRefilter(UMCCreator &creator, int iterations, int minLength)
+{
+	double best = DBL_MAX, total = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		double start = GetWallClockSeconds() ;
+		creator.RemoveShortUMCs(minLength + 1 + iteration % 2) ;
+		creator.CalculateUMCs() ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("RefilterMinLength", iterations, best, total, (long long) (creator.mvect_raw_umc_start.size() - 1), "clusters") ;
+
+	creator.RemoveShortUMCs(minLength) ;
+	creator.CalculateUMCs() ;
+}
+
+static void BenchmarkCalculateUMCs(UMCCreator &creator, int iterations)
+{
+	double best = DBL_MAX, total = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		double start = GetWallClockSeconds() ;
+		creator.CalculateUMCs() ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("CalculateUMCs", iterations, best, total, creator.GetNumUmcs(), "features") ;
+}
+
+// The feature columns and peak map of FeatureTable against what GetUMCs and GetUmcMapping copy out of the engine:
+// the UMC objects and the multimap pairs, which the VB host then sorts by feature and peak
+static void BenchmarkFeatureTable(UMCCreator &creator, int iterations)
+{
+	std::vector<UMC> umcs ;
+	std::vector<std::pair<int, int> > mapping ;
+	double best = DBL_MAX, total = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		double start = GetWallClockSeconds() ;
+		umcs.assign(creator.mvect_umcs.begin(), creator.mvect_umcs.end()) ;
+		mapping.clear() ;
+		for (UMCPeakMultimap::iterator iter = creator.mmultimap_umc_2_peak_index.begin() ; iter != creator.mmultimap_umc_2_peak_index.end() ; iter++)
+			mapping.push_back(*iter) ;
+		std::sort(mapping.begin(), mapping.end()) ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("Feature export (objects and map)", iterations, best, total, (long long) mapping.size(), "rows") ;
+
+	FeatureTable featureTable ;
+	best = DBL_MAX ;
+	total = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		double start = GetWallClockSeconds() ;
+		featureTable.Build(creator) ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("Feature export (FeatureTable)", iterations, best, total, (long long) mapping.size(), "rows") ;
+}
+
+static void BenchmarkPrinting(UMCCreator &creator, const char *outputFileName, int iterations)
+{
+	double bestUmcs = DBL_MAX, totalUmcs = 0 ;
+	double bestMapping = DBL_MAX, totalMapping = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		OutputFileWriter file ;
+		file.Open(outputFileName) ;
+		double start = GetWallClockSeconds() ;
+		creator.PrintUMCs(file, false, 0) ;
+		file.Close() ;
+		double elapsed = GetWallClockSeconds() - start ;
+		bestUmcs = std::min(bestUmcs, elapsed) ;
+		totalUmcs += elapsed ;
+
+		file.Open(outputFileName) ;
+		start = GetWallClockSeconds() ;
+		creator.PrintMapping(file, 0) ;
+		file.Close() ;
+		elapsed = GetWallClockSeconds() - start ;
+		bestMapping = std::min(bestMapping, elapsed) ;
+		totalMapping += elapsed ;
+	}
+	remove(outputFileName) ;
+	AddResult("PrintUMCs", iterations, bestUmcs, totalUmcs, creator.GetNumUmcs(), "features") ;
+	AddResult("PrintMapping", iterations, bestMapping, totalMapping, (long long) creator.mmultimap_umc_2_peak_index.size(), "rows") ;
+}
+
+// CreateFeatureFiles plain and with every codec of this build, with the size of the output
+static void BenchmarkCompressedOutput(UMCCreator &creator, const char *baseFileName, int iterations)
+{
+	const CompressionFormat formats[] = { COMPRESSION_NONE, COMPRESSION_GZIP, COMPRESSION_ZSTD } ;
+	const char *names[] = { "CreateFeatureFiles", "CreateFeatureFiles (gzip)", "CreateFeatureFiles (zstd)" } ;
+	const char *sizeNames[] = { "CreateFeatureFiles (output)", "CreateFeatureFiles (gzip output)", "CreateFeatureFiles (zstd output)" } ;
+	const char *suffixes[] = { "_LCMSFeatures.txt", "_LCMSFeatureToPeakMap.txt" } ;
+	char outputBaseFileName[1200] ;
+	snprintf(outputBaseFileName, sizeof(outputBaseFileName), "%s_Output", baseFileName) ;
+
+	for (int formatNum = 0 ; formatNum < 3 ; formatNum++)
+	{
+		CompressionFormat format = formats[formatNum] ;
+		if (!OutputFileWriter::IsSupported(format))
+			continue ;
+
+		creator.SetOutputCompression(format, 0, 0) ;
+		double best = DBL_MAX, total = 0 ;
+		for (int iteration = 0 ; iteration < iterations ; iteration++)
+		{
+			double start = GetWallClockSeconds() ;
+			creator.CreateFeatureFiles(outputBaseFileName) ;
+			double elapsed = GetWallClockSeconds() - start ;
+			best = std::min(best, elapsed) ;
+			total += elapsed ;
+		}
+
+		long long numBytes = 0 ;
+		for (int suffixNum = 0 ; suffixNum < 2 ; suffixNum++)
+		{
+			char fileName[1300] ;
+			snprintf(fileName, sizeof(fileName), "%s%s%s", outputBaseFileName, suffixes[suffixNum], GetCompressionExtension(format)) ;
+			MemMappedReader reader ;
+			if (reader.Load(fileName))
+				numBytes += reader.FileLength() ;
+			reader.Close() ;
+		}
+		AddResult(names[formatNum], iterations, best, total, (long long) creator.mmultimap_umc_2_peak_index.size(), "rows") ;
+		AddResult(sizeNames[formatNum], iterations, best, total, numBytes, "bytes") ;
+	}
+	creator.SetOutputCompression(COMPRESSION_NONE, 0, 0) ;
+
+	for (int formatNum = 0 ; formatNum < 3 ; formatNum++)
+	{
+		for (int suffixNum = 0 ; suffixNum < 2 ; suffixNum++)
+		{
+			char fileName[1300] ;
+			snprintf(fileName, sizeof(fileName), "%s%s%s", outputBaseFileName, suffixes[suffixNum], GetCompressionExtension(formats[formatNum])) ;
+			remove(fileName) ;
+		}
+	}
+}
+
+static void BenchmarkEndToEnd(char *fileName, char *baseFileName, bool ims, int iterations, int minLength)
+{
+	double best = DBL_MAX, total = 0 ;
+	long long numPeaks = 0 ;
+	long long numBytes = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		UMCCreator creator ;
+		ConfigureCreator(creator, fileName, ims) ;
+		double start = GetWallClockSeconds() ;
+		numPeaks = creator.ReadCSVFile() ;
+		creator.CreateUMCsSinglyLinkedWithAll() ;
+		creator.RemoveShortUMCs(minLength) ;
+		creator.CalculateUMCs() ;
+		creator.CreateFeatureFiles(baseFileName) ;
+		double elapsed = GetWallClockSeconds() - start ;
+		numBytes = creator.GetTelemetry().GetBytesRead() ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("EndToEnd", iterations, best, total, numPeaks, "peaks") ;
+	AddResult("EndToEnd (input)", iterations, best, total, numBytes, "bytes") ;
+}
+
+static void BenchmarkOutOfCore(char *fileName, char *baseFileName, bool ims, int iterations, int minLength, long long memoryBudgetBytes)
+{
+	char outOfCoreBaseFileName[1200] ;
+	snprintf(outOfCoreBaseFileName, sizeof(outOfCoreBaseFileName), "%s_OutOfCore", baseFileName) ;
+
+	double best = DBL_MAX, total = 0 ;
+	int numPeaks = 0 ;
+	for (int iteration = 0 ; iteration < iterations ; iteration++)
+	{
+		UMCCreator creator ;
+		ConfigureCreator(creator, fileName, ims) ;
+		double start = GetWallClockSeconds() ;
+		creator.CreateFeatureFilesOutOfCore(outOfCoreBaseFileName, minLength, outOfCoreBaseFileName, memoryBudgetBytes, numPeaks) ;
+		double elapsed = GetWallClockSeconds() - start ;
+		best = std::min(best, elapsed) ;
+		total += elapsed ;
+	}
+	AddResult("OutOfCore", iterations, best, total, numPeaks, "peaks") ;
+
+	char outputFileName[1300] ;
+	snprintf(outputFileName, sizeof(outputFileName), "%s_LCMSFeatures.txt", outOfCoreBaseFileName) ;
+	remove(outputFileName) ;
+	snprintf(outputFileName, sizeof(outputFileName), "%s_LCMSFeatureToPeakMap.txt", outOfCoreBaseFileName) ;
+	remove(outputFileName) ;
+}
+
+static void PrintResults()
+{
+	printf("%-32s %10s %12s %12s %14s %16s\n", "Benchmark", "Iterations", "Best (s)", "Mean (s)", "Items", "Items/s (best)") ;
+	for (int resultNum = 0 ; resultNum < (int) gvect_results.size() ; resultNum++)
+	{
+		BenchmarkResult &result = gvect_results[resultNum] ;
+		double rate = result.mdbl_best_seconds > 0 ? result.mlng_items / result.mdbl_best_seconds : 0 ;
+		printf("%-32s %10d %12.6f %12.6f %14lld %12.0f %s/s\n", result.mstr_name, result.mint_iterations, result.mdbl_best_seconds,
+			result.mdbl_mean_seconds, result.mlng_items, rate, result.mstr_unit) ;
+	}
+}
+
+static void PrintUsage()
+{
+	printf("Usage: UMCCreationBenchmarks [-peaks N] [-ims] [-density F] [-charges MIN MAX] [-scans N]\n") ;
+	printf("                             [-seed S] [-iterations N] [-threads N] [-input isos.csv] [-dir OutputFolder] [-keep]\n") ;
+	printf("       UMCCreationBenchmarks -check NAME [-ims] [-dir OutputFolder]\n") ;
+	EngineChecks::PrintCheckNames() ;
+}
+
+int main(int argc, char *argv[])
+{
+	SyntheticIsosOptions options ;
+	int iterations = 3 ;
+	int minLength = 2 ;
+	int numThreads = 0 ;
+	bool keepFiles = false ;
+	char inputFile[1100] = "" ;
+	char outputDir[1024] = "." ;
+	const char *checkName = NULL ;
+
+	for (int argNum = 1 ; argNum < argc ; argNum++)
+	{
+		const char *arg = argv[argNum] ;
+		bool hasValue = argNum + 1 < argc ;
+		if (strcmp(arg, "-peaks") == 0 && hasValue)
+			options.mint_num_peaks = atoi(argv[++argNum]) ;
+		else if (strcmp(arg, "-ims") == 0)
+			options.mbln_ims = true ;
+		else if (strcmp(arg, "-density") == 0 && hasValue)
+			options.mflt_feature_fraction = (float) atof(argv[++argNum]) ;
+		else if (strcmp(arg, "-charges") == 0 && argNum + 2 < argc)
+		{
+			options.mint_min_charge = atoi(argv[++argNum]) ;
+			options.mint_max_charge = atoi(argv[++argNum]) ;
+		}
+		else if (strcmp(arg, "-scans") == 0 && hasValue)
+			options.mint_num_lc_scans = atoi(argv[++argNum]) ;
+		else if (strcmp(arg, "-seed") == 0 && hasValue)
+			options.mint_seed = (unsigned int) atoi(argv[++argNum]) ;
+		else if (strcmp(arg, "-iterations") == 0 && hasValue)
+			iterations = std::max(1, atoi(argv[++argNum])) ;
+		else if (strcmp(arg, "-threads") == 0 && hasValue)
+			numThreads = atoi(argv[++argNum]) ;
+		else if (strcmp(arg, "-input") == 0 && hasValue)
+			snprintf(inputFile, sizeof(inputFile), "%s", argv[++argNum]) ;
+		else if (strcmp(arg, "-dir") == 0 && hasValue)
+			snprintf(outputDir, sizeof(outputDir), "%s", argv[++argNum]) ;
+		else if (strcmp(arg, "-keep") == 0)
+			keepFiles = true ;
+		else if (strcmp(arg, "-check") == 0 && hasValue)
+			checkName = argv[++argNum] ;
+		else
+		{
+			PrintUsage() ;
+			return 1 ;
+		}
+	}
+
+	// each name built from another gets a larger buffer than it: the output folder 1024, the names in it 1100,
+	// the base names made from those 1200 and the files of those 1300
+	char baseFileName[1100] ;
+	char scratchFileName[1100] ;
+	snprintf(baseFileName, sizeof(baseFileName), "%s/UMCCreationBenchmark", outputDir) ;
+	snprintf(scratchFileName, sizeof(scratchFileName), "%s/UMCCreationBenchmark_scratch.txt", outputDir) ;
+
+	if (checkName != NULL)
+	{
+		// the fixture of the checks does not depend on the benchmark options
+		SyntheticIsosOptions fixtureOptions ;
+		fixtureOptions.mint_num_peaks = CHECK_FIXTURE_PEAKS ;
+		fixtureOptions.mbln_ims = options.mbln_ims ;
+		snprintf(inputFile, sizeof(inputFile), "%s/UMCCreationCheck_isos.csv", outputDir) ;
+		SyntheticIsosGenerator generator(fixtureOptions.mint_seed) ;
+		if (!generator.WriteFile(inputFile, fixtureOptions))
+		{
+			printf("Unable to write %s\n", inputFile) ;
+			return 1 ;
+		}
+		snprintf(baseFileName, sizeof(baseFileName), "%s/UMCCreationCheck", outputDir) ;
+		int checkResult = EngineChecks::Run(checkName, inputFile, baseFileName, fixtureOptions.mbln_ims, CHECK_FIXTURE_THREADS) ;
+		remove(inputFile) ;
+		return checkResult ;
+	}
+
+	bool generated = false ;
+	if (inputFile[0] == '\0')
+	{
+		snprintf(inputFile, sizeof(inputFile), "%s/UMCCreationBenchmark_isos.csv", outputDir) ;
+		printf("Generating %d %s peaks (feature fraction %.2f, charges %d-%d, seed %u)\n", options.mint_num_peaks,
+			options.mbln_ims ? "IMS" : "LC-MS", options.mflt_feature_fraction, options.mint_min_charge, options.mint_max_charge, options.mint_seed) ;
+		SyntheticIsosGenerator generator(options.mint_seed) ;
+		if (!generator.WriteFile(inputFile, options))
+		{
+			printf("Unable to write %s\n", inputFile) ;
+			return 1 ;
+		}
+		generated = true ;
+	}
+	printf("Input: %s\n\n", inputFile) ;
+
+	BenchmarkReadCSVFile(inputFile, options.mbln_ims, iterations) ;
+	BenchmarkReadCSVFileParallel(inputFile, options.mbln_ims, iterations, numThreads) ;
+
+	UMCCreator creator ;
+	ConfigureCreator(creator, inputFile, options.mbln_ims) ;
+	creator.ReadCSVFile() ;
+	// PEK files hold LC-MS peaks only
+	if (!options.mbln_ims)
+	{
+		char pekFileName[1200] ;
+		snprintf(pekFileName, sizeof(pekFileName), "%s.pek", baseFileName) ;
+		BenchmarkReadPekFile(creator, pekFileName, iterations, numThreads) ;
+		remove(pekFileName) ;
+	}
+	BenchmarkBulkPeaks(creator, options.mbln_ims, iterations) ;
+	BenchmarkPeakDistance(creator, iterations) ;
+	BenchmarkClustering(creator, iterations) ;
+	if (options.mbln_ims)
+		BenchmarkImsCandidateIndex(creator, iterations) ;
+	BenchmarkScanGap(creator, iterations) ;
+	BenchmarkChargePartitions(creator, options.mbln_ims, iterations, numThreads) ;
+	if (options.mbln_ims)
+		BenchmarkImsConformers(creator, iterations, numThreads) ;
+	// the benchmarks below work on the clusters without the charge state constraint
+	creator.CreateUMCsSinglyLinkedWithAll() ;
+	BenchmarkRemoveShortUMCs(creator, iterations, minLength) ;
+	BenchmarkCalculateUMCs(creator, iterations) ;
+	BenchmarkRefilter(creator, iterations, minLength) ;
+	BenchmarkFeatureTable(creator, iterations) ;
+	BenchmarkPrinting(creator, scratchFileName, iterations) ;
+	BenchmarkCompressedOutput(creator, baseFileName, iterations) ;
+
+	BenchmarkEndToEnd(inputFile, baseFileName, options.mbln_ims, iterations, minLength) ;
+	// a quarter of the peaks per run, so that the merge has several runs to put together
+	long long memoryBudgetBytes = (long long) (creator.mvect_isotope_peaks.size() * sizeof(IsotopePeak) / 4) ;
+	BenchmarkOutOfCore(inputFile, baseFileName, options.mbln_ims, iterations, minLength, memoryBudgetBytes) ;
+
+	PrintResults() ;
+	printf("\nPeak RSS: %lld bytes\n", GetPeakResidentBytes()) ;
+
+	if (!keepFiles)
+	{
+		char fileName[1200] ;
+		snprintf(fileName, sizeof(fileName), "%s_LCMSFeatures.txt", baseFileName) ;
+		remove(fileName) ;
+		snprintf(fileName, sizeof(fileName), "%s_LCMSFeatureToPeakMap.txt", baseFileName) ;
+		remove(fileName) ;
+		if (generated)
+			remove(inputFile) ;
+	}
+	return 0 ;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+// Fixed capacity FIFO used to hand work items between pipeline stages.
+// Push blocks while the queue is full, Pop blocks while it is empty.
+// Once Close() is called no more items are accepted and Pop drains what is left.
+// Only include this from files compiled without /clr (std::mutex is not available to managed code).
+template <class T>
+class BoundedQueue
+{
+	std::deque<T> mdeque_items ;
+	size_t mint_capacity ;
+	bool mbln_closed ;
+	std::mutex mobj_mutex ;
+	std::condition_variable mobj_not_full ;
+	std::condition_variable mobj_not_empty ;
+
+	BoundedQueue(const BoundedQueue &) ;
+	BoundedQueue & operator=(const BoundedQueue &) ;
+
+public:
+	BoundedQueue(size_t capacity)
+	{
+		mint_capacity = capacity > 0 ? capacity : 1 ;
+		mbln_closed = false ;
+	}
+
+	// Returns false if the queue was closed before the item could be added
+	bool Push(const T &item)
+	{
+		std::unique_lock<std::mutex> lock(mobj_mutex) ;
+		while (!mbln_closed && mdeque_items.size() >= mint_capacity)
+			mobj_not_full.wait(lock) ;
+		if (mbln_closed)
+			return false ;
+		mdeque_items.push_back(item) ;
+		mobj_not_empty.notify_one() ;
+		return true ;
+	}
+
+	// Returns false once the queue is closed and empty
+	bool Pop(T &item)
+	{
+		std::unique_lock<std::mutex> lock(mobj_mutex) ;
+		while (!mbln_closed && mdeque_items.empty())
+			mobj_not_empty.wait(lock) ;
+		if (mdeque_items.empty())
+			return false ;
+		item = mdeque_items.front() ;
+		mdeque_items.pop_front() ;
+		mobj_not_full.notify_one() ;
+		return true ;
+	}
+
+	void Close()
+	{
+		std::lock_guard<std::mutex> lock(mobj_mutex) ;
+		mbln_closed = true ;
+		mobj_not_full.notify_all() ;
+		mobj_not_empty.notify_all() ;
+	}
+};
@@ -0,0 +1,741 @@
+// LCMSFeatureFinderCLI.cpp : native command line front end for the UMCCreator engine.
+//
+// Usage: LCMSFeatureFinderCLI SettingsFile.ini [/I:InputFile] [/O:OutputDirectory] [/B:ManifestFile] [/S:SweepFile] [/V:Path] [/T:Threads]
+//        LCMSFeatureFinderCLI SettingsFile.ini [/I:InputFile] [/O:OutputDirectory] /M:(Shards | plan:Shards | shard:N | merge)
+//        LCMSFeatureFinderCLI /D:SocketPath [/T:Threads] [/R:Runners]
+//        LCMSFeatureFinderCLI /C:SocketPath (SettingsFile.ini [/I:InputFile] [/O:OutputDirectory] | STATUS | SHUTDOWN)
+//
+// Takes the same settings file as clsUMCCreator::LoadProgramOptions (sections Files, DataFilters and
+// UMCCreationOptions) and writes the same files: _LCMSFeatures.txt, _LCMSFeatureToPeakMap.txt (one pair
+// per chunk when ProcessDataInChunks=True and MergeChunkFiles=False), _FeatureFinder_Log.txt and _FeatureFinder_Stats.json.
+// DataFilters/MemoryBudgetMB > 0 finds the features out of core, for files larger than memory (run files go to
+// Files/TempDirectory); it takes precedence over ProcessDataInChunks.
+// With /B every isos file listed in the manifest is processed with these settings (see BatchRunner);
+// the log and a summary table go to Batch_FeatureFinder_Log.txt and Batch_FeatureFinder_Summary.txt.
+// With /S the input file is clustered once per combination of options in the [ParameterSweep] section
+// of SweepFile (see ParameterSweep), writing _Sweep<N>_LCMSFeatures.txt files and _Sweep_Summary.txt.
+// With /V the input file is clustered by the reference code and by an accelerated path (index or pool) and the
+// results are compared (see ShadowVerifier); the differences and timings go to _Verification.txt.
+// With /D the tool stays up as a daemon taking jobs on a Unix domain socket (see FeatureFinderDaemon); with /C it
+// submits a job (or STATUS / SHUTDOWN) to such a daemon and prints its replies, exiting 0 when the job is done.
+// With /M the mono mass range is split into shards that separate worker processes cluster (see UMCCreatorSharded.cpp);
+// /M:Shards plans, runs the workers on this machine and merges, writing the same files as a single run. The steps
+// can also be run one at a time, e.g. the workers on other nodes sharing OutputDirectory and TempDirectory:
+// plan:Shards writes _ShardPlan.txt, shard:N clusters shard N (1 based) into TempDirectory and logs to
+// _Shard<N>_FeatureFinder_Log.txt, and merge writes the feature files once every shard is done.
+
+#include "../FeatureFinderOptions.h"
+#include "../UMCPipeline.h"
+#include "../RunReport.h"
+#include "../BatchRunner.h"
+#include "../ParameterSweep.h"
+#include "../ShadowVerifier.h"
+#include "../FeatureFinderDaemon.h"
+#include "../WorkStealingPool.h"
+#include "../MassShardPlan.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <exception>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <limits.h>
+#endif
+
+static FILE *gfile_log = NULL ;
+
+static void Log(const char *text)
+{
+	time_t now = time(NULL) ;
+	struct tm *localTime = localtime(&now) ;
+
+	if (gfile_log != NULL)
+	{
+		fprintf(gfile_log, "%.2d/%.2d/%.2d %.2d:%.2d:%.2d\t%s\n", localTime->tm_mon+1, localTime->tm_mday, localTime->tm_year+1900,
+			localTime->tm_hour, localTime->tm_min, localTime->tm_sec, text) ;
+		fflush(gfile_log) ;
+	}
+	printf("%s\n", text) ;
+}
+
+static void Log(const char *text, int number)
+{
+	char line[1024] ;
+	sprintf(line, "%s%d", text, number) ;
+	Log(line) ;
+}
+
+static void Log(const char *text, float number)
+{
+	char line[1024] ;
+	sprintf(line, "%s%4.4f", text, number) ;
+	Log(line) ;
+}
+
+static void Log(const char *text, const char *textToAppend)
+{
+	char line[2048] ;
+	sprintf(line, "%s%s", text, textToAppend) ;
+	Log(line) ;
+}
+
+// /I:value, -I:value or /I value (case-insensitive switch letter)
+static bool GetSwitchValue(int argc, char *argv[], int &argNum, char switchName, char *value, int maxLength)
+{
+	const char *arg = argv[argNum] ;
+	if ((arg[0] != '/' && arg[0] != '-') || (arg[1] != switchName && arg[1] != switchName - 'A' + 'a'))
+		return false ;
+
+	const char *start = NULL ;
+	if (arg[2] == ':' || arg[2] == '=')
+		start = &arg[3] ;
+	else if (arg[2] == '\0' && argNum + 1 < argc)
+		start = argv[++argNum] ;
+	else
+		return false ;
+
+	strncpy(value, start, maxLength - 1) ;
+	value[maxLength - 1] = '\0' ;
+	return true ;
+}
+
+static void PrintUsage()
+{
+	printf("Native LC-MS feature finder\n\n") ;
+	printf("Usage: LCMSFeatureFinderCLI SettingsFile.ini [/I:InputFile] [/O:OutputDirectory] [/B:ManifestFile] [/S:SweepFile] [/V:Path] [/T:Threads]\n\n") ;
+	printf("SettingsFile.ini has the sections [Files], [DataFilters] and [UMCCreationOptions];\n") ;
+	printf("/I and /O override Files/InputFileName and Files/OutputDirectory.\n") ;
+	printf("/B processes every isos file listed in ManifestFile (one per line) instead of InputFileName,\n") ;
+	printf("sharing /T worker threads (default: one per hardware thread) between the datasets.\n") ;
+	printf("/S clusters InputFileName once per combination of the comma separated option lists in the\n") ;
+	printf("[ParameterSweep] section of SweepFile (MonoMassConstraint, MaxDistance, NETWeight, LogAbundanceWeight).\n") ;
+	printf("/V clusters InputFileName with the reference code and with Path, and reports where they differ:\n") ;
+	printf("index (IMS candidate index) or pool (charge states and IMS conformers on /T threads).\n") ;
+	printf("/M:Shards splits the mono mass range into that many shards, clusters each in a worker process\n") ;
+	printf("and merges the results into the files of a single run. /M:plan:Shards, /M:shard:N (1 based) and\n") ;
+	printf("/M:merge run the steps one at a time, sharing OutputDirectory and TempDirectory.\n") ;
+	printf("\nLCMSFeatureFinderCLI /D:SocketPath [/T:Threads] [/R:Runners]\n") ;
+	printf("runs as a daemon taking jobs on the Unix domain socket SocketPath until it is sent SHUTDOWN;\n") ;
+	printf("/R jobs (default 1) run at a time on /T shared worker threads.\n") ;
+	printf("LCMSFeatureFinderCLI /C:SocketPath (SettingsFile.ini [/I:InputFile] [/O:OutputDirectory] | STATUS | SHUTDOWN)\n") ;
+	printf("sends a job, or the STATUS or SHUTDOWN request, to that daemon and prints the replies.\n") ;
+}
+
+static void WriteRunReport(RunReport &runReport, const char *baseFileName, int numUmcs)
+{
+	char reportFileName[1024] ;
+	sprintf(reportFileName, "%s_FeatureFinder_Stats.json", baseFileName) ;
+	runReport.SetNumFeatures(numUmcs) ;
+	if (runReport.WriteJsonFile(reportFileName))
+		Log("Run statistics written to ", reportFileName) ;
+	else
+		Log("Unable to write run statistics to ", reportFileName) ;
+}
+
+static int FindFeatures(FeatureFinderOptions &options, char *baseFileName, int numThreads)
+{
+	UMCCreator creator ;
+	RunReport runReport ;
+	int numUmcs = 0 ;
+
+	options.ApplyTo(creator) ;
+	runReport.SetInputFileName(options.mstr_input_file) ;
+
+	if (options.mint_memory_budget_mb > 0)
+	{
+		Log("Processing out of core...") ;
+		Log(" Memory budget (MB) = ", options.mint_memory_budget_mb) ;
+
+		// Sorted runs of the peaks go to TempDirectory and are clustered in one merging pass; see CreateFeatureFilesOutOfCore
+		char tempFilePrefix[1024] ;
+		int numPeaks = 0 ;
+		options.GetTempFilePrefix(tempFilePrefix, sizeof(tempFilePrefix)) ;
+		numUmcs = creator.CreateFeatureFilesOutOfCore(baseFileName, options.mint_min_umc_length, tempFilePrefix,
+			(long long) options.mint_memory_budget_mb * 1024 * 1024, numPeaks) ;
+		Log("Total number of peaks we'll consider = ", numPeaks) ;
+
+		runReport.AddTelemetry(creator.GetTelemetry()) ;
+	}
+	else if (options.mbln_process_chunks)
+	{
+		Log("Processing with Chunks ...") ;
+		Log(" Pipeline queue depth = ", options.mint_pipeline_queue_depth) ;
+
+		// Loading, clustering, summarizing and writing of the mass chunks overlap; see UMCPipeline
+		UMCPipeline pipeline(&creator, baseFileName, options.mint_min_umc_length, options.mint_pipeline_queue_depth, &runReport) ;
+		pipeline.SetMergeChunkFiles(options.mbln_merge_chunk_files) ;
+		numUmcs = pipeline.Run(options.mflt_mono_mass_start, options.mflt_mono_mass_end, creator.GetSegmentSize()) ;
+
+		std::vector<MassBucketResult> &chunkResults = pipeline.GetResults() ;
+		for (int chunkNum = 0 ; chunkNum < (int) chunkResults.size() ; chunkNum++)
+		{
+			Log("Processed chunk ", chunkResults[chunkNum].mint_chunk_index) ;
+			Log(" Total number of peaks we'll consider = ", chunkResults[chunkNum].mint_num_peaks) ;
+			Log(" Number of UMCs = ", chunkResults[chunkNum].mint_num_umcs) ;
+		}
+		if (options.mbln_merge_chunk_files)
+			Log("Duplicate UMCs of the chunk ends = ", pipeline.GetNumDuplicateFeatures()) ;
+	}
+	else
+	{
+		Log("Processing without Chunks...") ;
+		int numPeaks = creator.ReadCSVFile() ;
+		Log("Total number of peaks we'll consider = ", numPeaks) ;
+
+		Log("Creating UMCs...") ;
+		// with UseCharge every charge state is clustered on a thread of its own
+		WorkStealingPool pool(numThreads) ;
+		creator.CreateUMCsSinglyLinkedWithAll(pool) ;
+		if (creator.GetNumConformerNodes() > 0)
+			Log("Conformer nodes clustered = ", creator.GetNumConformerNodes()) ;
+		if (creator.GetNumIsolatedPeaks() > 0)
+			Log("Isolated peaks not clustered = ", creator.GetNumIsolatedPeaks()) ;
+
+		Log("Filtering out short UMCs...") ;
+		creator.RemoveShortUMCs(options.mint_min_umc_length) ;
+
+		Log("Calculating UMC statistics...") ;
+		creator.CalculateUMCs() ;
+		numUmcs = creator.GetNumUmcs() ;
+
+		Log("Writing output files...") ;
+		if (!creator.CreateFeatureFiles(baseFileName))
+			Log("Unable to write the feature files for ", baseFileName) ;
+
+		runReport.AddTelemetry(creator.GetTelemetry()) ;
+	}
+	Log("Total number of UMCs = ", numUmcs) ;
+
+	WriteRunReport(runReport, baseFileName, numUmcs) ;
+	return 0 ;
+}
+
+static int FindFeaturesBatch(FeatureFinderOptions &options, const char *manifestFile, int numThreads)
+{
+	BatchRunner batch(options, numThreads) ;
+	if (!batch.LoadManifest(manifestFile))
+	{
+		Log("Unable to read manifest file ", manifestFile) ;
+		return 3 ;
+	}
+	Log("Number of datasets = ", batch.GetNumDatasets()) ;
+	Log("Worker threads = ", numThreads) ;
+
+	int numFailed = batch.Run() ;
+
+	std::vector<BatchDatasetResult> &results = batch.GetResults() ;
+	for (int datasetNum = 0 ; datasetNum < (int) results.size() ; datasetNum++)
+	{
+		BatchDatasetResult &result = results[datasetNum] ;
+		Log("Dataset: ", result.mstr_input_file.c_str()) ;
+		if (result.mbln_success)
+		{
+			Log(" Total number of peaks we'll consider = ", result.mint_num_peaks) ;
+			Log(" Total number of UMCs = ", result.mint_num_umcs) ;
+		}
+		else
+			Log(" Error finding features: ", result.mstr_error.c_str()) ;
+	}
+
+	char summaryFileName[1100] ;
+	options.GetOutputFileName("Batch_FeatureFinder_Summary.txt", summaryFileName, sizeof(summaryFileName)) ;
+	if (batch.WriteSummaryFile(summaryFileName))
+		Log("Batch summary written to ", summaryFileName) ;
+	else
+		Log("Unable to write batch summary to ", summaryFileName) ;
+
+	Log("Datasets that failed = ", numFailed) ;
+	return numFailed == 0 ? 0 : 5 ;
+}
+
+static int FindFeaturesSweep(FeatureFinderOptions &options, char *baseFileName, const char *sweepFile, int numThreads)
+{
+	ParameterSweep sweep(options, numThreads) ;
+	std::vector<std::string> errors ;
+	if (!sweep.LoadFromIniFile(sweepFile, errors))
+	{
+		Log("Unable to read sweep file ", sweepFile) ;
+		return 2 ;
+	}
+	for (int errorNum = 0 ; errorNum < (int) errors.size() ; errorNum++)
+		Log("Invalid setting ignored: ", errors[errorNum].c_str()) ;
+	Log("Number of settings = ", sweep.GetNumSettings()) ;
+	Log("Worker threads = ", numThreads) ;
+
+	int numFailed = sweep.Run() ;
+	Log("Total number of peaks we'll consider = ", sweep.GetNumPeaks()) ;
+
+	std::vector<SweepSetting> &settings = sweep.GetSettings() ;
+	for (int settingNum = 0 ; settingNum < (int) settings.size() ; settingNum++)
+	{
+		char line[1024] ;
+		sprintf(line, "Setting %d: MonoMassConstraint=%g MaxDistance=%g NETWeight=%g LogAbundanceWeight=%g", settingNum + 1,
+			settings[settingNum].mflt_mono_mass_constraint, settings[settingNum].mflt_max_distance, settings[settingNum].mflt_net_weight,
+			settings[settingNum].mflt_log_abundance_weight) ;
+		Log(line) ;
+		if (settings[settingNum].mbln_success)
+			Log(" Total number of UMCs = ", settings[settingNum].mint_num_umcs) ;
+		else
+			Log(" Error finding features: ", settings[settingNum].mstr_error.c_str()) ;
+	}
+
+	char summaryFileName[1100] ;
+	sprintf(summaryFileName, "%s_Sweep_Summary.txt", baseFileName) ;
+	if (sweep.WriteSummaryFile(summaryFileName))
+		Log("Sweep summary written to ", summaryFileName) ;
+	else
+		Log("Unable to write sweep summary to ", summaryFileName) ;
+
+	Log("Settings that failed = ", numFailed) ;
+	return numFailed == 0 ? 0 : 5 ;
+}
+
+static int FindFeaturesVerify(FeatureFinderOptions &options, char *baseFileName, const char *pathName, int numThreads)
+{
+	ShadowVerifier verifier(options, numThreads) ;
+	if (!verifier.SetPath(pathName))
+	{
+		Log("Unknown path to verify: ", pathName) ;
+		return 1 ;
+	}
+	Log("Verifying path ", pathName) ;
+	Log("Worker threads = ", numThreads) ;
+
+	int numDifferences = verifier.Run() ;
+	Log("Total number of peaks we'll consider = ", verifier.GetNumPeaks()) ;
+	Log(" Reference UMCs = ", verifier.GetNumReferenceUmcs()) ;
+	Log(" Reference seconds = ", (float) verifier.GetReferenceSeconds()) ;
+	Log(" Verified UMCs = ", verifier.GetNumCandidateUmcs()) ;
+	Log(" Verified seconds = ", (float) verifier.GetCandidateSeconds()) ;
+	Log("Peaks that differ = ", verifier.GetNumPeakDifferences()) ;
+	Log("UMCs that differ = ", verifier.GetNumUmcDifferences()) ;
+
+	char reportFileName[1100] ;
+	sprintf(reportFileName, "%s_Verification.txt", baseFileName) ;
+	if (verifier.WriteReportFile(reportFileName))
+		Log("Verification report written to ", reportFileName) ;
+	else
+		Log("Unable to write verification report to ", reportFileName) ;
+
+	return numDifferences == 0 ? 0 : 6 ;
+}
+
+// Steps of a sharded run, from /M
+enum ShardStep { SHARD_ALL = 0, SHARD_PLAN, SHARD_WORKER, SHARD_MERGE } ;
+
+// Shards, plan:Shards, shard:N or merge
+static bool ParseShardSwitch(const char *text, ShardStep &step, int &number)
+{
+	number = 0 ;
+	if (strcmp(text, "merge") == 0)
+	{
+		step = SHARD_MERGE ;
+		return true ;
+	}
+	if (strncmp(text, "plan:", 5) == 0)
+	{
+		step = SHARD_PLAN ;
+		text += 5 ;
+	}
+	else if (strncmp(text, "shard:", 6) == 0)
+	{
+		step = SHARD_WORKER ;
+		text += 6 ;
+	}
+	else
+		step = SHARD_ALL ;
+	number = atoi(text) ;
+	return number > 0 ;
+}
+
+static int PlanShards(FeatureFinderOptions &options, const char *planFileName, int numShards, RunReport &runReport)
+{
+	UMCCreator creator ;
+	MassShardPlan plan ;
+	options.ApplyTo(creator) ;
+
+	Log("Planning mass shards = ", numShards) ;
+	int numPeaks = creator.PlanMassShards(numShards, plan) ;
+	runReport.AddTelemetry(creator.GetTelemetry()) ;
+	Log("Total number of peaks we'll consider = ", numPeaks) ;
+	Log(" Shard overlap (Da) = ", plan.mflt_overlap) ;
+	for (int shardNum = 0 ; shardNum < plan.mint_num_shards ; shardNum++)
+	{
+		char line[1024] ;
+		sprintf(line, " Shard %d: %g to %g Da, peaks = %d", shardNum + 1, plan.mvect_boundaries[shardNum], plan.mvect_boundaries[shardNum + 1],
+			plan.mvect_shard_peaks[shardNum]) ;
+		Log(line) ;
+	}
+
+	if (!plan.WriteFile(planFileName))
+	{
+		Log("Unable to write shard plan ", planFileName) ;
+		return 4 ;
+	}
+	Log("Shard plan written to ", planFileName) ;
+	return 0 ;
+}
+
+static void LaunchShardWorker(const std::string &command, int *status)
+{
+	*status = system(command.c_str()) ;
+}
+
+// Runs one worker process per shard of the plan; returns the number that failed
+static int RunShardWorkers(const char *program, const char *settingsFile, FeatureFinderOptions &options, int numShards)
+{
+	std::vector<std::thread> workers ;
+	std::vector<int> status(numShards, 0) ;
+	for (int shardNum = 0 ; shardNum < numShards ; shardNum++)
+	{
+		// the settings overrides of this run go to the workers; their output goes to their own logs
+		char shardSwitch[32] ;
+		sprintf(shardSwitch, "/M:shard:%d", shardNum + 1) ;
+		std::string command = std::string("\"") + program + "\" \"" + settingsFile + "\" \"/I:" + options.mstr_input_file + "\" \"/O:"
+			+ options.mstr_output_directory + "\" " + shardSwitch ;
+#ifdef _WIN32
+		command = "\"" + command + " > NUL\"" ;
+#else
+		command += " > /dev/null" ;
+#endif
+		workers.push_back(std::thread(LaunchShardWorker, command, &status[shardNum])) ;
+	}
+
+	int numFailed = 0 ;
+	for (int shardNum = 0 ; shardNum < numShards ; shardNum++)
+	{
+		workers[shardNum].join() ;
+		if (status[shardNum] != 0)
+		{
+			Log("Worker failed for shard ", shardNum + 1) ;
+			numFailed++ ;
+		}
+	}
+	return numFailed ;
+}
+
+static int FindFeaturesSharded(FeatureFinderOptions &options, char *baseFileName, const char *shardText, const char *program,
+	const char *settingsFile)
+{
+	ShardStep step ;
+	int number ;
+	ParseShardSwitch(shardText, step, number) ;
+
+	char planFileName[1100] ;
+	char tempFilePrefix[1024] ;
+	sprintf(planFileName, "%s_ShardPlan.txt", baseFileName) ;
+	options.GetTempFilePrefix(tempFilePrefix, sizeof(tempFilePrefix)) ;
+	RunReport runReport ;
+	runReport.SetInputFileName(options.mstr_input_file) ;
+
+	if (step == SHARD_ALL || step == SHARD_PLAN)
+	{
+		int result = PlanShards(options, planFileName, number, runReport) ;
+		if (result != 0 || step == SHARD_PLAN)
+			return result ;
+	}
+
+	MassShardPlan plan ;
+	if (!plan.ReadFile(planFileName))
+	{
+		Log("Unable to read shard plan ", planFileName) ;
+		return 2 ;
+	}
+
+	if (step == SHARD_WORKER)
+	{
+		if (number > plan.mint_num_shards)
+		{
+			Log("No such shard: ", number) ;
+			Log("Shards in the plan = ", plan.mint_num_shards) ;
+			return 1 ;
+		}
+		UMCCreator creator ;
+		char resultFileName[1100] ;
+		options.ApplyTo(creator) ;
+		UMCCreator::GetShardResultFileName(tempFilePrefix, number - 1, resultFileName) ;
+		Log("Clustering shard ", number) ;
+		int numClusters = creator.ClusterMassShard(plan, number - 1, resultFileName) ;
+		Log("Clusters written = ", numClusters) ;
+		Log("Shard results written to ", resultFileName) ;
+		return 0 ;
+	}
+
+	if (step == SHARD_ALL)
+	{
+		Log("Worker processes = ", plan.mint_num_shards) ;
+		int numFailed = RunShardWorkers(program, settingsFile, options, plan.mint_num_shards) ;
+		if (numFailed > 0)
+			return 5 ;
+	}
+
+	Log("Merging shards = ", plan.mint_num_shards) ;
+	UMCCreator creator ;
+	options.ApplyTo(creator) ;
+	int numUmcs = creator.MergeMassShards(plan, tempFilePrefix, baseFileName, options.mint_min_umc_length) ;
+	runReport.AddTelemetry(creator.GetTelemetry()) ;
+	Log("Total number of UMCs = ", numUmcs) ;
+
+	WriteRunReport(runReport, baseFileName, numUmcs) ;
+	return 0 ;
+}
+
+static void LogDaemonEvent(const char *text)
+{
+	Log(text) ;
+	fflush(stdout) ;
+}
+
+static int RunDaemon(const char *socketPath, int numThreads, int numRunners)
+{
+	FeatureFinderDaemon daemon(socketPath, numThreads, numRunners) ;
+	std::string error ;
+	if (!daemon.Run(LogDaemonEvent, error))
+	{
+		Log("Unable to run the daemon: ", error.c_str()) ;
+		return 4 ;
+	}
+	return 0 ;
+}
+
+// The daemon resolves paths from its own working directory, so relative ones are made absolute first
+static void GetAbsolutePath(const char *path, char *absolutePath, int maxLength)
+{
+	absolutePath[0] = '\0' ;
+	if (path[0] != '\0')
+	{
+#ifdef _WIN32
+		if (_fullpath(absolutePath, path, maxLength) == NULL)
+			absolutePath[0] = '\0' ;
+#else
+		char resolved[PATH_MAX] ;
+		if (realpath(path, resolved) != NULL && (int) strlen(resolved) < maxLength)
+			strcpy(absolutePath, resolved) ;
+#endif
+	}
+	if (absolutePath[0] == '\0')
+	{
+		strncpy(absolutePath, path, maxLength - 1) ;
+		absolutePath[maxLength - 1] = '\0' ;
+	}
+}
+
+static bool gbln_job_done = false ;
+
+static void PrintDaemonReply(const char *line)
+{
+	printf("%s\n", line) ;
+	fflush(stdout) ;
+	if (strncmp(line, "DONE\t", 5) == 0 || strcmp(line, "BYE") == 0 || strncmp(line, "STATUS\t", 7) == 0)
+		gbln_job_done = true ;
+}
+
+static int SendDaemonRequest(const char *socketPath, const char *settingsFile, const char *inputFile, const char *outputDirectory)
+{
+	std::string request ;
+	if (strcmp(settingsFile, "STATUS") == 0 || strcmp(settingsFile, "SHUTDOWN") == 0)
+		request = settingsFile ;
+	else
+	{
+		char path[1024] ;
+		request = "FIND\t" ;
+		GetAbsolutePath(settingsFile, path, sizeof(path)) ;
+		request += path ;
+		request += '\t' ;
+		GetAbsolutePath(inputFile, path, sizeof(path)) ;
+		request += path ;
+		request += '\t' ;
+		GetAbsolutePath(outputDirectory, path, sizeof(path)) ;
+		request += path ;
+	}
+
+	// give a daemon started just before a few seconds to create its socket
+	std::string error ;
+	if (!FeatureFinderDaemon::SendRequest(socketPath, request.c_str(), 10.0, PrintDaemonReply, error))
+	{
+		printf("Unable to reach the daemon at %s: %s\n", socketPath, error.c_str()) ;
+		return 4 ;
+	}
+	return gbln_job_done ? 0 : 5 ;
+}
+
+int main(int argc, char *argv[])
+{
+	char settingsFile[1024] = "" ;
+	char inputFile[1024] = "" ;
+	char outputDirectory[1024] = "" ;
+	char manifestFile[1024] = "" ;
+	char sweepFile[1024] = "" ;
+	char verifyPath[32] = "" ;
+	char threadsText[32] = "" ;
+	char daemonSocket[1024] = "" ;
+	char clientSocket[1024] = "" ;
+	char runnersText[32] = "" ;
+	char shardText[32] = "" ;
+
+	for (int argNum = 1 ; argNum < argc ; argNum++)
+	{
+		if (GetSwitchValue(argc, argv, argNum, 'I', inputFile, sizeof(inputFile)))
+			continue ;
+		if (GetSwitchValue(argc, argv, argNum, 'O', outputDirectory, sizeof(outputDirectory)))
+			continue ;
+		if (GetSwitchValue(argc, argv, argNum, 'P', settingsFile, sizeof(settingsFile)))
+			continue ;
+		if (GetSwitchValue(argc, argv, argNum, 'B', manifestFile, sizeof(manifestFile)))
+			continue ;
+		if (GetSwitchValue(argc, argv, argNum, 'S', sweepFile, sizeof(sweepFile)))
+			continue ;
+		if (GetSwitchValue(argc, argv, argNum, 'V', verifyPath, sizeof(verifyPath)))
+			continue ;
+		if (GetSwitchValue(argc, argv, argNum, 'T', threadsText, sizeof(threadsText)))
+			continue ;
+		if (GetSwitchValue(argc, argv, argNum, 'D', daemonSocket, sizeof(daemonSocket)))
+			continue ;
+		if (GetSwitchValue(argc, argv, argNum, 'C', clientSocket, sizeof(clientSocket)))
+			continue ;
+		if (GetSwitchValue(argc, argv, argNum, 'R', runnersText, sizeof(runnersText)))
+			continue ;
+		if (GetSwitchValue(argc, argv, argNum, 'M', shardText, sizeof(shardText)))
+			continue ;
+		// anything else is the settings file; absolute paths on Linux start with '/' so only '-' marks an unknown switch
+		if (argv[argNum][0] != '-' && settingsFile[0] == '\0')
+		{
+			strncpy(settingsFile, argv[argNum], sizeof(settingsFile) - 1) ;
+			continue ;
+		}
+		PrintUsage() ;
+		return 1 ;
+	}
+
+	if (daemonSocket[0] != '\0')
+	{
+		if (settingsFile[0] != '\0' || clientSocket[0] != '\0')
+		{
+			PrintUsage() ;
+			return 1 ;
+		}
+		return RunDaemon(daemonSocket, threadsText[0] != '\0' ? atoi(threadsText) : 0, runnersText[0] != '\0' ? atoi(runnersText) : 1) ;
+	}
+	if (clientSocket[0] != '\0')
+	{
+		if (settingsFile[0] == '\0' || manifestFile[0] != '\0' || sweepFile[0] != '\0' || verifyPath[0] != '\0' || shardText[0] != '\0')
+		{
+			PrintUsage() ;
+			return 1 ;
+		}
+		return SendDaemonRequest(clientSocket, settingsFile, inputFile, outputDirectory) ;
+	}
+
+	ShardStep shardStep = SHARD_ALL ;
+	int shardNumber = 0 ;
+	if (settingsFile[0] == '\0' || (manifestFile[0] != '\0') + (sweepFile[0] != '\0') + (verifyPath[0] != '\0') + (shardText[0] != '\0') > 1
+		|| (shardText[0] != '\0' && !ParseShardSwitch(shardText, shardStep, shardNumber)))
+	{
+		PrintUsage() ;
+		return 1 ;
+	}
+
+	FeatureFinderOptions options ;
+	if (!options.LoadFromIniFile(settingsFile))
+	{
+		printf("Unable to read settings file %s\n", settingsFile) ;
+		return 2 ;
+	}
+	if (inputFile[0] != '\0')
+		strcpy(options.mstr_input_file, inputFile) ;
+	if (outputDirectory[0] != '\0')
+		strcpy(options.mstr_output_directory, outputDirectory) ;
+
+	int numThreads = threadsText[0] != '\0' ? atoi(threadsText) : 0 ;
+	if (numThreads <= 0)
+		numThreads = WorkStealingPool::GetHardwareThreads() ;
+
+	char baseFileName[1024] ;
+	char logFileName[1100] ;
+	if (manifestFile[0] == '\0')
+	{
+		FILE *input = fopen(options.mstr_input_file, "rb") ;
+		if (input == NULL)
+		{
+			printf("Input file not found: %s\n", options.mstr_input_file) ;
+			return 3 ;
+		}
+		fclose(input) ;
+
+		options.GetBaseFileName(baseFileName, sizeof(baseFileName)) ;
+		// the workers of a sharded run each keep a log of their own
+		if (shardText[0] != '\0' && shardStep == SHARD_WORKER)
+			sprintf(logFileName, "%s_Shard%d_FeatureFinder_Log.txt", baseFileName, shardNumber) ;
+		else
+			sprintf(logFileName, "%s_FeatureFinder_Log.txt", baseFileName) ;
+	}
+	else
+		options.GetOutputFileName("Batch_FeatureFinder_Log.txt", logFileName, sizeof(logFileName)) ;
+	gfile_log = fopen(logFileName, "w") ;
+	if (gfile_log == NULL)
+	{
+		printf("Unable to create %s; check OutputDirectory\n", logFileName) ;
+		return 4 ;
+	}
+
+	Log("Loading settings from INI file: ", settingsFile) ;
+	for (int errorNum = 0 ; errorNum < (int) options.mvect_errors.size() ; errorNum++)
+		Log("Invalid setting ignored: ", options.mvect_errors[errorNum].c_str()) ;
+	if (manifestFile[0] == '\0')
+		Log("Input file: ", options.mstr_input_file) ;
+	else
+		Log("Manifest file: ", manifestFile) ;
+	Log("Data Filters - ") ;
+	Log(" Minimum LC scan = ", options.mint_lc_min_scan) ;
+	Log(" Maximum LC scan = ", options.mint_lc_max_scan) ;
+	Log(" Minimum IMS scan = ", options.mint_ims_min_scan) ;
+	Log(" Maximum IMS scan = ", options.mint_ims_max_scan) ;
+	Log(" Maximum fit = ", options.mflt_isotopic_fit) ;
+	Log(" Minimum intensity = ", options.mint_min_intensity) ;
+	Log(" Mono mass start = ", options.mflt_mono_mass_start) ;
+	Log(" Mono mass end = ", options.mflt_mono_mass_end) ;
+	Log(" Require matching charge state = ", (int) options.mbln_use_charge) ;
+	Log(" Collapse IMS conformers = ", (int) options.mbln_collapse_ims_conformers) ;
+	Log(" Skip isolated peaks = ", (int) options.mbln_skip_isolated_peaks) ;
+	Log(" Maximum scan gap = ", options.mint_max_scan_gap) ;
+	Log(" Maximum NET gap = ", options.mflt_max_net_gap) ;
+	Log(" Maximum drift time gap = ", options.mflt_max_drift_time_gap) ;
+	if (shardText[0] != '\0' && options.mbln_collapse_ims_conformers)
+	{
+		// conformer nodes are built from whole frames, which the mass shards cut through
+		Log("Sharded runs do not collapse IMS conformers; set CollapseIMSConformers=False") ;
+		fclose(gfile_log) ;
+		return 1 ;
+	}
+
+	int result = 0 ;
+	try
+	{
+		if (manifestFile[0] != '\0')
+			result = FindFeaturesBatch(options, manifestFile, numThreads) ;
+		else if (sweepFile[0] != '\0')
+			result = FindFeaturesSweep(options, baseFileName, sweepFile, numThreads) ;
+		else if (verifyPath[0] != '\0')
+			result = FindFeaturesVerify(options, baseFileName, verifyPath, numThreads) ;
+		else if (shardText[0] != '\0')
+			result = FindFeaturesSharded(options, baseFileName, shardText, argv[0], settingsFile) ;
+		else
+			result = FindFeatures(options, baseFileName, numThreads) ;
+	}
+	catch (std::exception &e)
+	{
+		Log("Error finding features: ", e.what()) ;
+		result = 5 ;
+	}
+	catch (const char *message)
+	{
+		Log("Error finding features: ", message) ;
+		result = 5 ;
+	}
+
+	fclose(gfile_log) ;
+	return result ;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+// Compression of an input or output file; see StreamDecompressor and OutputFileWriter
+enum CompressionFormat { COMPRESSION_NONE = 0, COMPRESSION_GZIP, COMPRESSION_ZSTD } ;
+
+// File name extension of the format, including the dot; empty for COMPRESSION_NONE
+inline const char *GetCompressionExtension(CompressionFormat format)
+{
+	if (format == COMPRESSION_GZIP)
+		return ".gz" ;
+	if (format == COMPRESSION_ZSTD)
+		return ".zst" ;
+	return "" ;
+}
@@ -0,0 +1,641 @@
+// FeatureFinderDaemon.cpp : job queue of the feature finder served over a Unix domain socket.
+// Native only (threads and sockets); the header can be included by /clr code.
+
+#include "FeatureFinderDaemon.h"
+
+#ifndef _WIN32
+
+#include "FeatureFinderOptions.h"
+#include "WorkStealingPool.h"
+#include "BoundedQueue.h"
+#include "UMCPipeline.h"
+#include "RunReport.h"
+#include "ProcessStats.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef MSG_NOSIGNAL
+#define DAEMON_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define DAEMON_SEND_FLAGS 0
+#endif
+
+namespace
+{
+	enum JobState { JOB_QUEUED = 0, JOB_RUNNING, JOB_DONE, JOB_FAILED } ;
+
+	struct DaemonJob
+	{
+		int mint_id ;
+		FeatureFinderOptions mobj_options ;
+
+		// guarded by mobj_mutex; mobj_changed is signalled on every change of state
+		std::mutex mobj_mutex ;
+		std::condition_variable mobj_changed ;
+		JobState menm_state ;
+		const ProgressTelemetry *mptr_telemetry ;		// of the creator working on the job, while it runs
+		int mint_num_peaks ;
+		int mint_num_umcs ;
+		double mdbl_seconds ;
+		bool mbln_cached ;
+		std::string mstr_error ;
+	} ;
+
+	// Settings file as last parsed, with the modification time and size it had then
+	struct CachedOptions
+	{
+		long long mlng_modified ;
+		long long mlng_size ;
+		FeatureFinderOptions mobj_options ;
+	} ;
+
+	bool GetFileStamp(const char *fileName, long long &modified, long long &size)
+	{
+		struct stat status ;
+		if (stat(fileName, &status) != 0)
+			return false ;
+		modified = (long long) status.st_mtime ;
+		size = (long long) status.st_size ;
+		return true ;
+	}
+
+	bool SendText(int socketFd, const char *text)
+	{
+		size_t length = strlen(text) ;
+		while (length > 0)
+		{
+			ssize_t sent = send(socketFd, text, length, DAEMON_SEND_FLAGS) ;
+			if (sent < 0 && errno == EINTR)
+				continue ;
+			if (sent <= 0)
+				return false ;
+			text += sent ;
+			length -= (size_t) sent ;
+		}
+		return true ;
+	}
+
+	// A client has this long to send its request line; a connection that stays idle is dropped, so that it does not
+	// keep a shut down daemon from returning
+	const double REQUEST_TIMEOUT_SECONDS = 10 ;
+
+	// Receiving end of a connection; the bytes after the last line returned wait in mstr_pending
+	struct LineReceiver
+	{
+		int mint_socket ;
+		std::string mstr_pending ;
+	} ;
+
+	// Reads up to the next line break (not included), a block at a time. False if the connection closed first, the line
+	// is too long, or timeoutSeconds (< 0: no limit) went by first.
+	bool ReceiveLine(LineReceiver &receiver, std::string &line, double timeoutSeconds)
+	{
+		double deadline = GetWallClockSeconds() + timeoutSeconds ;
+		char block[4096] ;
+		while (true)
+		{
+			size_t lineEnd = receiver.mstr_pending.find('\n') ;
+			if (lineEnd != std::string::npos)
+			{
+				line.assign(receiver.mstr_pending, 0, lineEnd) ;
+				receiver.mstr_pending.erase(0, lineEnd + 1) ;
+				if (!line.empty() && line[line.size() - 1] == '\r')
+					line.erase(line.size() - 1) ;
+				return true ;
+			}
+			if (receiver.mstr_pending.size() >= 8192)
+				return false ;
+
+			if (timeoutSeconds >= 0)
+			{
+				int waitMs = (int) ((deadline - GetWallClockSeconds()) * 1000) ;
+				if (waitMs <= 0)
+					return false ;
+				struct pollfd receiving ;
+				receiving.fd = receiver.mint_socket ;
+				receiving.events = POLLIN ;
+				receiving.revents = 0 ;
+				int ready = poll(&receiving, 1, waitMs) ;
+				if (ready < 0 && errno == EINTR)
+					continue ;
+				if (ready <= 0)
+					return false ;
+			}
+			ssize_t received = recv(receiver.mint_socket, block, sizeof(block), 0) ;
+			if (received < 0 && errno == EINTR)
+				continue ;
+			if (received <= 0)
+				return false ;
+			receiver.mstr_pending.append(block, (size_t) received) ;
+		}
+	}
+
+	void SplitFields(const std::string &line, std::vector<std::string> &fields)
+	{
+		fields.clear() ;
+		size_t start = 0 ;
+		while (true)
+		{
+			size_t tab = line.find('\t', start) ;
+			fields.push_back(line.substr(start, tab == std::string::npos ? std::string::npos : tab - start)) ;
+			if (tab == std::string::npos)
+				break ;
+			start = tab + 1 ;
+		}
+	}
+
+	bool SetSocketAddress(const char *socketPath, struct sockaddr_un &address, std::string &error)
+	{
+		memset(&address, 0, sizeof(address)) ;
+		address.sun_family = AF_UNIX ;
+		if (strlen(socketPath) >= sizeof(address.sun_path))
+		{
+			error = "Socket path too long" ;
+			return false ;
+		}
+		strcpy(address.sun_path, socketPath) ;
+		return true ;
+	}
+}
+
+struct FeatureFinderDaemon::Impl
+{
+	std::string mstr_socket_path ;
+	int mint_num_threads ;
+	int mint_num_runners ;
+	WorkStealingPool *mobj_pool ;
+	BoundedQueue<std::shared_ptr<DaemonJob> > mobj_jobs ;
+
+	std::atomic<bool> mbln_stopping ;
+	std::atomic<int> mint_next_job_id ;
+	std::atomic<int> mint_num_queued ;
+	std::atomic<int> mint_num_running ;
+	std::atomic<int> mint_num_completed ;
+	std::atomic<int> mint_num_failed ;
+
+	std::mutex mobj_options_mutex ;
+	std::map<std::string, CachedOptions> mmap_options ;
+
+	std::mutex mobj_log_mutex ;
+	std::function<void(const char *)> mfunc_log ;
+
+	// connections being served; Run waits for them before returning
+	std::mutex mobj_connection_mutex ;
+	std::condition_variable mobj_connections_done ;
+	int mint_num_connections ;
+
+	Impl(int queueCapacity) : mobj_jobs(queueCapacity) {}
+
+	void Log(const char *text) ;
+	bool LoadOptions(const char *settingsFile, FeatureFinderOptions &options) ;
+	void RunJobs() ;
+	void RunJob(DaemonJob &job, std::string &cachedKey, UMCCreator &cachedPeaks) ;
+	void ServeConnection(int socketFd) ;
+	void ServeFind(int socketFd, std::vector<std::string> &fields) ;
+} ;
+
+void FeatureFinderDaemon::Impl::Log(const char *text)
+{
+	std::lock_guard<std::mutex> lock(mobj_log_mutex) ;
+	if (mfunc_log)
+		mfunc_log(text) ;
+}
+
+bool FeatureFinderDaemon::Impl::LoadOptions(const char *settingsFile, FeatureFinderOptions &options)
+{
+	long long modified, size ;
+	if (!GetFileStamp(settingsFile, modified, size))
+		return false ;
+
+	std::lock_guard<std::mutex> lock(mobj_options_mutex) ;
+	std::map<std::string, CachedOptions>::iterator iter = mmap_options.find(settingsFile) ;
+	if (iter == mmap_options.end() || iter->second.mlng_modified != modified || iter->second.mlng_size != size)
+	{
+		CachedOptions cached ;
+		if (!cached.mobj_options.LoadFromIniFile(settingsFile))
+			return false ;
+		cached.mlng_modified = modified ;
+		cached.mlng_size = size ;
+		mmap_options[settingsFile] = cached ;
+		iter = mmap_options.find(settingsFile) ;
+	}
+	options = iter->second.mobj_options ;
+	return true ;
+}
+
+void FeatureFinderDaemon::Impl::RunJobs()
+{
+	// the peaks of the last in memory job of this runner, as loaded
+	std::string cachedKey ;
+	UMCCreator cachedPeaks ;
+
+	std::shared_ptr<DaemonJob> job ;
+	while (mobj_jobs.Pop(job))
+	{
+		mint_num_queued-- ;
+		mint_num_running++ ;
+		RunJob(*job, cachedKey, cachedPeaks) ;
+		mint_num_running-- ;
+		job.reset() ;
+	}
+}
+
+void FeatureFinderDaemon::Impl::RunJob(DaemonJob &job, std::string &cachedKey, UMCCreator &cachedPeaks)
+{
+	double startTime = GetWallClockSeconds() ;
+	FeatureFinderOptions &options = job.mobj_options ;
+	char baseFileName[1024] ;
+	options.GetBaseFileName(baseFileName, sizeof(baseFileName)) ;
+
+	UMCCreator creator ;
+	RunReport runReport ;
+	options.ApplyTo(creator) ;
+	runReport.SetInputFileName(options.mstr_input_file) ;
+	{
+		std::lock_guard<std::mutex> lock(job.mobj_mutex) ;
+		job.menm_state = JOB_RUNNING ;
+		job.mptr_telemetry = &creator.GetTelemetry() ;
+		job.mobj_changed.notify_all() ;
+	}
+
+	bool success = false ;
+	std::string message ;
+	int numPeaks = 0 ;
+	int numUmcs = 0 ;
+	bool cached = false ;
+	try
+	{
+		long long modified, size ;
+		if (!GetFileStamp(options.mstr_input_file, modified, size) || size == 0)
+			throw "Input file not found or empty" ;
+
+		if (options.mint_memory_budget_mb > 0)
+		{
+			char tempFilePrefix[1024] ;
+			options.GetTempFilePrefix(tempFilePrefix, sizeof(tempFilePrefix)) ;
+			numUmcs = creator.CreateFeatureFilesOutOfCore(baseFileName, options.mint_min_umc_length, tempFilePrefix,
+				(long long) options.mint_memory_budget_mb * 1024 * 1024, numPeaks) ;
+			runReport.AddTelemetry(creator.GetTelemetry()) ;
+		}
+		else if (options.mbln_process_chunks)
+		{
+			UMCPipeline pipeline(&creator, baseFileName, options.mint_min_umc_length, options.mint_pipeline_queue_depth, &runReport) ;
+			pipeline.SetMergeChunkFiles(options.mbln_merge_chunk_files) ;
+			numUmcs = pipeline.Run(options.mflt_mono_mass_start, options.mflt_mono_mass_end, creator.GetSegmentSize()) ;
+			std::vector<MassBucketResult> &chunkResults = pipeline.GetResults() ;
+			for (int chunkNum = 0 ; chunkNum < (int) chunkResults.size() ; chunkNum++)
+				numPeaks += chunkResults[chunkNum].mint_num_peaks ;
+		}
+		else
+		{
+			// the same file, unchanged, read with the same data filters gives the same peaks
+			char key[1400] ;
+			sprintf(key, "%s\t%lld\t%lld\t%g\t%d\t%g\t%g\t%d\t%d\t%d\t%d", options.mstr_input_file, modified, size, options.mflt_isotopic_fit,
+				options.mint_min_intensity, options.mflt_mono_mass_start, options.mflt_mono_mass_end, options.mint_lc_min_scan,
+				options.mint_lc_max_scan, options.mint_ims_min_scan, options.mint_ims_max_scan) ;
+			if (cachedKey == key)
+			{
+				creator.CopyPeaks(cachedPeaks) ;
+				numPeaks = (int) creator.mvect_isotope_peaks.size() ;
+				cached = true ;
+			}
+			else
+			{
+				cachedKey.clear() ;
+				cachedPeaks.Reset() ;
+				numPeaks = creator.ReadCSVFileParallel(*mobj_pool, mobj_pool->GetNumThreads()) ;
+				cachedPeaks.CopyPeaks(creator) ;
+				cachedKey = key ;
+			}
+			creator.CreateUMCsSinglyLinkedWithAll(*mobj_pool) ;
+			creator.RemoveShortUMCs(options.mint_min_umc_length) ;
+			creator.CalculateUMCs() ;
+			numUmcs = creator.GetNumUmcs() ;
+			if (!creator.CreateFeatureFiles(baseFileName))
+				throw "Unable to write the feature files" ;
+			runReport.AddTelemetry(creator.GetTelemetry()) ;
+		}
+
+		char reportFileName[1100] ;
+		sprintf(reportFileName, "%s_FeatureFinder_Stats.json", baseFileName) ;
+		runReport.SetNumFeatures(numUmcs) ;
+		runReport.WriteJsonFile(reportFileName) ;
+		success = true ;
+	}
+	catch (std::exception &e)
+	{
+		message = e.what() ;
+	}
+	catch (const char *text)
+	{
+		message = text ;
+	}
+
+	if (success)
+		mint_num_completed++ ;
+	else
+		mint_num_failed++ ;
+
+	char line[1400] ;
+	if (success)
+		sprintf(line, "Job %d done: %s, %d peaks%s, %d features", job.mint_id, options.mstr_input_file, numPeaks, cached ? " (cached)" : "", numUmcs) ;
+	else
+		sprintf(line, "Job %d failed: %s: %.200s", job.mint_id, options.mstr_input_file, message.c_str()) ;
+	Log(line) ;
+
+	std::lock_guard<std::mutex> lock(job.mobj_mutex) ;
+	job.menm_state = success ? JOB_DONE : JOB_FAILED ;
+	job.mptr_telemetry = NULL ;
+	job.mint_num_peaks = numPeaks ;
+	job.mint_num_umcs = numUmcs ;
+	job.mdbl_seconds = GetWallClockSeconds() - startTime ;
+	job.mbln_cached = cached ;
+	job.mstr_error = message ;
+	job.mobj_changed.notify_all() ;
+}
+
+void FeatureFinderDaemon::Impl::ServeFind(int socketFd, std::vector<std::string> &fields)
+{
+	std::shared_ptr<DaemonJob> job(new DaemonJob()) ;
+	job->mint_id = ++mint_next_job_id ;
+	job->menm_state = JOB_QUEUED ;
+	job->mptr_telemetry = NULL ;
+	job->mint_num_peaks = 0 ;
+	job->mint_num_umcs = 0 ;
+	job->mdbl_seconds = 0 ;
+	job->mbln_cached = false ;
+
+	char line[1400] ;
+	if (!LoadOptions(fields[1].c_str(), job->mobj_options))
+	{
+		sprintf(line, "FAILED\t%d\tUnable to read settings file %.1024s\n", job->mint_id, fields[1].c_str()) ;
+		SendText(socketFd, line) ;
+		return ;
+	}
+	FeatureFinderOptions &options = job->mobj_options ;
+	if (fields.size() > 2 && !fields[2].empty())
+	{
+		strncpy(options.mstr_input_file, fields[2].c_str(), sizeof(options.mstr_input_file) - 1) ;
+		options.mstr_input_file[sizeof(options.mstr_input_file) - 1] = '\0' ;
+	}
+	if (fields.size() > 3 && !fields[3].empty())
+	{
+		strncpy(options.mstr_output_directory, fields[3].c_str(), sizeof(options.mstr_output_directory) - 1) ;
+		options.mstr_output_directory[sizeof(options.mstr_output_directory) - 1] = '\0' ;
+	}
+
+	int numWaiting = ++mint_num_queued ;
+	if (mbln_stopping || !mobj_jobs.Push(job))
+	{
+		mint_num_queued-- ;
+		sprintf(line, "FAILED\t%d\tThe daemon is shutting down\n", job->mint_id) ;
+		SendText(socketFd, line) ;
+		return ;
+	}
+	sprintf(line, "Job %d queued: %s", job->mint_id, options.mstr_input_file) ;
+	Log(line) ;
+	sprintf(line, "QUEUED\t%d\t%d\n", job->mint_id, numWaiting) ;
+	bool connected = SendText(socketFd, line) ;
+
+	// report every change of stage or percentage until the job is over; a client that hangs up does not stop the job
+	bool started = false ;
+	TelemetryStage lastStage = STAGE_IDLE ;
+	int lastPercent = -1 ;
+	std::unique_lock<std::mutex> lock(job->mobj_mutex) ;
+	while (connected)
+	{
+		if (job->menm_state == JOB_DONE || job->menm_state == JOB_FAILED)
+			break ;
+		if (job->menm_state == JOB_RUNNING)
+		{
+			if (!started)
+			{
+				sprintf(line, "STARTED\t%d\n", job->mint_id) ;
+				connected = SendText(socketFd, line) ;
+				started = true ;
+			}
+			TelemetryStage stage = job->mptr_telemetry->GetStage() ;
+			int percent = job->mptr_telemetry->GetPercentComplete() ;
+			if (connected && (stage != lastStage || percent != lastPercent))
+			{
+				sprintf(line, "PROGRESS\t%d\t%s\t%d\n", job->mint_id, ProgressTelemetry::GetStageName(stage), percent) ;
+				connected = SendText(socketFd, line) ;
+				lastStage = stage ;
+				lastPercent = percent ;
+			}
+		}
+		job->mobj_changed.wait_for(lock, std::chrono::milliseconds(100)) ;
+	}
+	if (!connected)
+		return ;
+
+	if (job->menm_state == JOB_DONE)
+		sprintf(line, "DONE\t%d\t%d\t%d\t%.3f\t%d\n", job->mint_id, job->mint_num_peaks, job->mint_num_umcs, job->mdbl_seconds, job->mbln_cached ? 1 : 0) ;
+	else
+		sprintf(line, "FAILED\t%d\t%.1024s\n", job->mint_id, job->mstr_error.c_str()) ;
+	lock.unlock() ;
+	SendText(socketFd, line) ;
+}
+
+void FeatureFinderDaemon::Impl::ServeConnection(int socketFd)
+{
+	LineReceiver receiver ;
+	receiver.mint_socket = socketFd ;
+	std::string request ;
+	std::vector<std::string> fields ;
+	if (ReceiveLine(receiver, request, REQUEST_TIMEOUT_SECONDS))
+	{
+		SplitFields(request, fields) ;
+		if (fields[0] == "FIND" && fields.size() >= 2 && fields.size() <= 4)
+			ServeFind(socketFd, fields) ;
+		else if (fields[0] == "STATUS")
+		{
+			char line[128] ;
+			sprintf(line, "STATUS\t%d\t%d\t%d\t%d\n", (int) mint_num_queued, (int) mint_num_running, (int) mint_num_completed, (int) mint_num_failed) ;
+			SendText(socketFd, line) ;
+		}
+		else if (fields[0] == "SHUTDOWN")
+		{
+			mbln_stopping = true ;
+			Log("Shutdown requested") ;
+			SendText(socketFd, "BYE\n") ;
+		}
+		else
+			SendText(socketFd, "ERROR\tUnknown request\n") ;
+	}
+	close(socketFd) ;
+
+	std::lock_guard<std::mutex> lock(mobj_connection_mutex) ;
+	mint_num_connections-- ;
+	mobj_connections_done.notify_all() ;
+}
+
+FeatureFinderDaemon::FeatureFinderDaemon(const char *socketPath, int numThreads, int numRunners)
+{
+	mobj_impl = new Impl(1024) ;
+	mobj_impl->mstr_socket_path = socketPath ;
+	mobj_impl->mint_num_threads = numThreads > 0 ? numThreads : WorkStealingPool::GetHardwareThreads() ;
+	mobj_impl->mint_num_runners = numRunners > 0 ? numRunners : 1 ;
+	mobj_impl->mobj_pool = NULL ;
+	mobj_impl->mbln_stopping = false ;
+	mobj_impl->mint_next_job_id = 0 ;
+	mobj_impl->mint_num_queued = 0 ;
+	mobj_impl->mint_num_running = 0 ;
+	mobj_impl->mint_num_completed = 0 ;
+	mobj_impl->mint_num_failed = 0 ;
+	mobj_impl->mint_num_connections = 0 ;
+}
+
+FeatureFinderDaemon::~FeatureFinderDaemon(void)
+{
+	delete mobj_impl ;
+}
+
+bool FeatureFinderDaemon::Run(std::function<void(const char *)> log, std::string &error)
+{
+	Impl &impl = *mobj_impl ;
+	impl.mfunc_log = log ;
+
+	struct sockaddr_un address ;
+	if (!SetSocketAddress(impl.mstr_socket_path.c_str(), address, error))
+		return false ;
+	int listenFd = socket(AF_UNIX, SOCK_STREAM, 0) ;
+	if (listenFd < 0)
+	{
+		error = strerror(errno) ;
+		return false ;
+	}
+	// a socket file left behind by a daemon that did not shut down would make bind fail
+	unlink(impl.mstr_socket_path.c_str()) ;
+	if (bind(listenFd, (struct sockaddr *) &address, sizeof(address)) != 0 || listen(listenFd, 16) != 0)
+	{
+		error = strerror(errno) ;
+		close(listenFd) ;
+		return false ;
+	}
+
+	WorkStealingPool pool(impl.mint_num_threads) ;
+	impl.mobj_pool = &pool ;
+	std::vector<std::thread> runners ;
+	for (int runnerNum = 0 ; runnerNum < impl.mint_num_runners ; runnerNum++)
+		runners.push_back(std::thread(&Impl::RunJobs, &impl)) ;
+
+	char line[1200] ;
+	sprintf(line, "Listening on %.1024s", impl.mstr_socket_path.c_str()) ;
+	impl.Log(line) ;
+
+	// wake up now and then to see whether a SHUTDOWN came in
+	while (!impl.mbln_stopping)
+	{
+		struct pollfd listening ;
+		listening.fd = listenFd ;
+		listening.events = POLLIN ;
+		listening.revents = 0 ;
+		if (poll(&listening, 1, 200) <= 0)
+			continue ;
+		int socketFd = accept(listenFd, NULL, NULL) ;
+		if (socketFd < 0)
+			continue ;
+		{
+			std::lock_guard<std::mutex> lock(impl.mobj_connection_mutex) ;
+			impl.mint_num_connections++ ;
+		}
+		std::thread(&Impl::ServeConnection, &impl, socketFd).detach() ;
+	}
+	close(listenFd) ;
+	unlink(impl.mstr_socket_path.c_str()) ;
+
+	// queued jobs still run; then every connection reports the end of its job
+	impl.mobj_jobs.Close() ;
+	for (int runnerNum = 0 ; runnerNum < (int) runners.size() ; runnerNum++)
+		runners[runnerNum].join() ;
+	std::unique_lock<std::mutex> lock(impl.mobj_connection_mutex) ;
+	while (impl.mint_num_connections > 0)
+		impl.mobj_connections_done.wait(lock) ;
+	impl.mobj_pool = NULL ;
+	return true ;
+}
+
+bool FeatureFinderDaemon::SendRequest(const char *socketPath, const char *request, double waitSeconds,
+	std::function<void(const char *)> lineHandler, std::string &error)
+{
+	struct sockaddr_un address ;
+	if (!SetSocketAddress(socketPath, address, error))
+		return false ;
+
+	int socketFd = -1 ;
+	double deadline = GetWallClockSeconds() + waitSeconds ;
+	while (true)
+	{
+		socketFd = socket(AF_UNIX, SOCK_STREAM, 0) ;
+		if (socketFd < 0)
+		{
+			error = strerror(errno) ;
+			return false ;
+		}
+		if (connect(socketFd, (struct sockaddr *) &address, sizeof(address)) == 0)
+			break ;
+		error = strerror(errno) ;
+		close(socketFd) ;
+		if (GetWallClockSeconds() >= deadline)
+			return false ;
+		std::this_thread::sleep_for(std::chrono::milliseconds(100)) ;
+	}
+
+	std::string text = request ;
+	text += '\n' ;
+	bool sent = SendText(socketFd, text.c_str()) ;
+	// a job may stay in one stage for a long time, so the client waits for its lines as long as it takes
+	LineReceiver receiver ;
+	receiver.mint_socket = socketFd ;
+	std::string line ;
+	while (sent && ReceiveLine(receiver, line, -1))
+		lineHandler(line.c_str()) ;
+	close(socketFd) ;
+	if (!sent)
+		error = "Unable to send the request" ;
+	return sent ;
+}
+
+#else
+
+struct FeatureFinderDaemon::Impl
+{
+} ;
+
+FeatureFinderDaemon::FeatureFinderDaemon(const char *socketPath, int numThreads, int numRunners)
+{
+	mobj_impl = NULL ;
+}
+
+FeatureFinderDaemon::~FeatureFinderDaemon(void)
+{
+}
+
+bool FeatureFinderDaemon::Run(std::function<void(const char *)> log, std::string &error)
+{
+	error = "The daemon needs Unix domain sockets" ;
+	return false ;
+}
+
+bool FeatureFinderDaemon::SendRequest(const char *socketPath, const char *request, double waitSeconds,
+	std::function<void(const char *)> lineHandler, std::string &error)
+{
+	error = "The daemon needs Unix domain sockets" ;
+	return false ;
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+#include <functional>
+#include <string>
+
+/*
+ * Long running feature finder that takes jobs over a Unix domain socket (LCMSFeatureFinderCLI /D:SocketPath), so that a
+ * workflow manager does not start a process, parse the settings file and warm up the threads for every dataset.
+ *
+ * A client connects, sends one request line and reads reply lines until the daemon closes the connection; a connection
+ * that sends no request line within 10 seconds is closed. Fields are separated by tabs:
+ *		FIND <SettingsFile> <InputFile> <OutputDirectory>	(empty InputFile / OutputDirectory: those of the settings file)
+ *			QUEUED <JobId> <JobsWaiting>, STARTED <JobId>, PROGRESS <JobId> <Stage> <Percent> (whenever either changes),
+ *			then DONE <JobId> <Peaks> <Features> <Seconds> <Cached> or FAILED <JobId> <Message>
+ *		STATUS	-> STATUS <Queued> <Running> <Completed> <Failed>
+ *		SHUTDOWN	-> BYE; no more jobs are accepted, and Run returns once the queued ones are done
+ *
+ * Jobs wait in a FIFO and are processed by numRunners runner threads, which share one WorkStealingPool of numThreads
+ * threads for loading and clustering, and write the same files as the CLI does for the settings (in memory, chunked or
+ * out of core). Settings files are parsed once and parsed again only when they change on disk. Each runner keeps the
+ * peaks of its last in memory dataset, so a job on the same unchanged file with the same data filters (another set of
+ * clustering options) skips the load; the <Cached> field of DONE is 1 for those.
+ *
+ * Unix only: on Windows Run fails.
+ */
+class FeatureFinderDaemon
+{
+	struct Impl ;
+	Impl *mobj_impl ;
+
+	FeatureFinderDaemon(const FeatureFinderDaemon &) ;
+	FeatureFinderDaemon & operator=(const FeatureFinderDaemon &) ;
+
+public:
+	// numThreads <= 0 uses one thread per hardware thread; numRunners < 1 is taken as 1
+	FeatureFinderDaemon(const char *socketPath, int numThreads, int numRunners) ;
+	~FeatureFinderDaemon(void) ;
+
+	// Serves requests until SHUTDOWN; log receives one line per job event. False, with the reason in error,
+	// if the socket cannot be created.
+	bool Run(std::function<void(const char *)> log, std::string &error) ;
+
+	// Client side: sends request (without the line break) and passes every reply line to lineHandler. Retries the
+	// connection for up to waitSeconds, for a daemon that is still starting. False, with the reason in error, if no
+	// connection could be made.
+	static bool SendRequest(const char *socketPath, const char *request, double waitSeconds,
+		std::function<void(const char *)> lineHandler, std::string &error) ;
+};
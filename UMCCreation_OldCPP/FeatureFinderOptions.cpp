@@ -0,0 +1,252 @@
+#include "FeatureFinderOptions.h"
+#include "IniReader.h"
+#include "OutputFileWriter.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+static const char PATH_SEPARATOR = '\\' ;
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define snprintf _snprintf
+#endif
+#else
+static const char PATH_SEPARATOR = '/' ;
+#endif
+
+FeatureFinderOptions::FeatureFinderOptions(void)
+{
+	mstr_input_file[0] = '\0' ;
+	strcpy(mstr_output_directory, ".") ;
+	mstr_temp_directory[0] = '\0' ;
+	menm_output_compression = COMPRESSION_NONE ;
+	mint_output_compression_level = 0 ;
+	mint_output_compression_threads = 0 ;
+
+	mflt_isotopic_fit = 1 ;
+	mint_min_intensity = 500 ;
+	mflt_mono_mass_start = 0 ;
+	mflt_mono_mass_end = FLT_MAX ;
+	mbln_process_chunks = false ;
+	mbln_merge_chunk_files = true ;
+	mint_pipeline_queue_depth = 2 ;
+	mint_memory_budget_mb = 0 ;
+	mint_max_data_points = INT_MAX ;
+	mint_chunk_size = 3000 ;
+	mint_mono_mass_overlap = 0 ;
+	mint_ims_min_scan = 0 ;
+	mint_ims_max_scan = 50000 ;
+	mint_lc_min_scan = 0 ;
+	mint_lc_max_scan = 50000 ;
+
+	mflt_mono_mass_weight = 0.01F ;
+	mflt_mono_mass_constraint = 50 ;
+	mbln_mono_mass_ppm = true ;
+	mflt_ims_drift_weight = 0.1F ;
+	mflt_log_abundance_weight = 0.1F ;
+	mflt_net_weight = 0.01F ;
+	mflt_fit_weight = 0.01F ;
+	mflt_avg_mass_weight = 0.01F ;
+	mflt_avg_mass_constraint = 10 ;
+	mbln_avg_mass_ppm = true ;
+	mflt_scan_weight = 0 ;
+	mflt_max_distance = 0.1F ;
+	mint_max_scan_gap = 0 ;
+	mflt_max_net_gap = 0 ;
+	mflt_max_drift_time_gap = 0 ;
+	mbln_use_generic_net = true ;
+	mint_min_umc_length = 2 ;
+	mbln_use_charge = false ;
+	mbln_collapse_ims_conformers = false ;
+	mbln_skip_isolated_peaks = false ;
+	mbln_use_weighted_euclidean = false ;
+}
+
+FeatureFinderOptions::~FeatureFinderOptions(void)
+{
+}
+
+bool FeatureFinderOptions::LoadFromIniFile(const char *iniFileName)
+{
+	// the whole file is parsed once here; every Read below is a table lookup
+	CIniReader iniReader(iniFileName);
+	if (!iniReader.IsLoaded())
+		return false ;
+
+	//first load incoming and outgoing filenames and folder options
+	const char *isos_file = iniReader.ReadString("Files", "InputFileName", "");
+	const char *output_dir = iniReader.ReadString("Files", "OutputDirectory", ".");
+	strncpy(mstr_input_file, isos_file, sizeof(mstr_input_file) - 1) ;
+	mstr_input_file[sizeof(mstr_input_file) - 1] = '\0' ;
+	strncpy(mstr_output_directory, output_dir, sizeof(mstr_output_directory) - 1) ;
+	mstr_output_directory[sizeof(mstr_output_directory) - 1] = '\0' ;
+	const char *temp_dir = iniReader.ReadString("Files", "TempDirectory", "");
+	strncpy(mstr_temp_directory, temp_dir, sizeof(mstr_temp_directory) - 1) ;
+	mstr_temp_directory[sizeof(mstr_temp_directory) - 1] = '\0' ;
+
+	// Feature and peak map files compressed as they are written, e.g. for network storage
+	std::string compressionError ;
+	std::string compression = iniReader.ReadString("Files", "OutputCompression", "none");
+	for (int charNum = 0 ; charNum < (int) compression.size() ; charNum++)
+		compression[charNum] = (char) tolower((unsigned char) compression[charNum]) ;
+	menm_output_compression = COMPRESSION_NONE ;
+	if (compression == "gzip" || compression == "gz")
+		menm_output_compression = COMPRESSION_GZIP ;
+	else if (compression == "zstd" || compression == "zst")
+		menm_output_compression = COMPRESSION_ZSTD ;
+	else if (compression != "none" && compression != "")
+		compressionError = "Files/OutputCompression: '" + compression + "' is not none, gzip or zstd; using the default" ;
+	if (!OutputFileWriter::IsSupported(menm_output_compression))
+	{
+		compressionError = "Files/OutputCompression: '" + compression + "' is not supported by this build; using the default" ;
+		menm_output_compression = COMPRESSION_NONE ;
+	}
+	mint_output_compression_level = iniReader.ReadInteger("Files", "OutputCompressionLevel", 0);
+	mint_output_compression_threads = iniReader.ReadInteger("Files", "OutputCompressionThreads", 0);
+
+	//next load data filters
+	mflt_isotopic_fit = iniReader.ReadFloat("DataFilters", "MaxIsotopicFit", 1);
+	if ( mflt_isotopic_fit == 0 ){
+		mflt_isotopic_fit = 1;
+	}
+
+	mint_min_intensity = iniReader.ReadInteger("DataFilters", "MinimumIntensity", 500);
+	mflt_mono_mass_start = iniReader.ReadFloat("DataFilters", "MonoMassStart", 0);
+	mflt_mono_mass_end = iniReader.ReadFloat("DataFilters", "MonoMassEnd", FLT_MAX);
+	mbln_process_chunks = iniReader.ReadBoolean("DataFilters", "ProcessDataInChunks", false);
+	// False keeps the _chunk<N>_ feature files of a chunked run instead of merging them
+	mbln_merge_chunk_files = iniReader.ReadBoolean("DataFilters", "MergeChunkFiles", true);
+
+	//mint_mono_mass_overlap = iniReader.ReadInteger("DataFilters", "MonoMassSegmentOverlapDa", 2);
+
+	// Number of mass chunks allowed to wait between two pipeline stages; bounds memory use when chunking
+	mint_pipeline_queue_depth = iniReader.ReadInteger("DataFilters", "PipelineQueueDepth", 2);
+	if ( mint_pipeline_queue_depth <= 0 ){
+		mint_pipeline_queue_depth = 2;
+	}
+	// Memory for peaks when the file is too large to load; 0 loads it whole as usual
+	mint_memory_budget_mb = iniReader.ReadInteger("DataFilters", "MemoryBudgetMB", 0);
+	if ( mint_memory_budget_mb < 0 ){
+		mint_memory_budget_mb = 0;
+	}
+	if ( mflt_mono_mass_end == 0){
+		if (mbln_process_chunks){
+			mflt_mono_mass_end = mflt_mono_mass_start + 250;
+		}
+	}
+
+	mint_max_data_points = iniReader.ReadInteger("DataFilters", "MaxDataPointsPerChunk", INT_MAX);
+	if ( mint_max_data_points == 0){
+		mint_max_data_points = INT_MAX;
+	}
+
+	mint_chunk_size = iniReader.ReadInteger("DataFilters", "ChunkSize", 3000);
+	if (mint_chunk_size == 0){
+		mint_chunk_size = 3000;
+	}
+
+	mint_ims_min_scan = iniReader.ReadInteger("DataFilters", "IMSMinScan", 0);
+
+	mint_ims_max_scan = iniReader.ReadInteger("DataFilters", "IMSMaxScan", 50000);
+	if (mint_ims_max_scan == 0 ){
+		mint_ims_max_scan = INT_MAX;
+	}
+
+	mint_lc_min_scan = iniReader.ReadInteger("DataFilters", "LCMinScan", 0);
+	mint_lc_max_scan = iniReader.ReadInteger("DataFilters", "LCMaxScan", 50000);
+	if (mint_lc_max_scan == 0){
+		mint_lc_max_scan = INT_MAX;
+	}
+
+	//next load the UMC creation options
+	mflt_mono_mass_weight = iniReader.ReadFloat("UMCCreationOptions", "MonoMassWeight", 0.01F);
+	mflt_mono_mass_constraint = iniReader.ReadFloat("UMCCreationOptions", "MonoMassConstraint", 50);
+	mbln_mono_mass_ppm = iniReader.ReadBoolean("UMCCreationOptions", "MonoMassConstraintIsPPM", true);
+	mflt_ims_drift_weight = iniReader.ReadFloat("UMCCreationOptions","IMSDriftTimeWeight", 0.1F);
+	mflt_log_abundance_weight = iniReader.ReadFloat("UMCCreationOptions", "LogAbundanceWeight", 0.1F);
+	mflt_net_weight = iniReader.ReadFloat("UMCCreationOptions", "NETWeight", 0.01F);
+	mflt_fit_weight = iniReader.ReadFloat("UMCCreationOptions", "FitWeight", 0.01F);
+	mflt_avg_mass_weight = iniReader.ReadFloat("UMCCreationOptions", "AvgMassWeight", 0.01F);
+	mflt_avg_mass_constraint = iniReader.ReadFloat("UMCCreationOptions", "AvgMassConstraint", 10);
+	mbln_avg_mass_ppm = iniReader.ReadBoolean("UMCCreationOptions", "AvgMassConstraintIsPPM", true);
+	mflt_scan_weight = iniReader.ReadFloat("UMCCreationOptions", "ScanWeight", 0);
+	mflt_max_distance = iniReader.ReadFloat("UMCCreationOptions", "MaxDistance", 0.1F);
+	mint_max_scan_gap = iniReader.ReadInteger("UMCCreationOptions", "MaxScanGap", 0);
+	mflt_max_net_gap = iniReader.ReadFloat("UMCCreationOptions", "MaxNETGap", 0);
+	mflt_max_drift_time_gap = iniReader.ReadFloat("UMCCreationOptions", "MaxDriftTimeGap", 0);
+	mbln_use_generic_net = iniReader.ReadBoolean("UMCCreationOptions", "UseGenericNET", true);
+	mint_min_umc_length = iniReader.ReadInteger("UMCCreationOptions", "MinFeatureLengthPoints", 2);
+	mbln_use_charge = iniReader.ReadBoolean("UMCCreationOptions", "UseCharge", false);
+	mbln_collapse_ims_conformers = iniReader.ReadBoolean("UMCCreationOptions", "CollapseIMSConformers", false);
+	mbln_skip_isolated_peaks = iniReader.ReadBoolean("UMCCreationOptions", "SkipIsolatedPeaks", false);
+
+	//this one is not sent over for now
+	mbln_use_weighted_euclidean = iniReader.ReadBoolean("UMCCreationOptions", "UseWeightedEuclidean", false);
+
+	mvect_errors = iniReader.GetErrors() ;
+	if (!compressionError.empty())
+		mvect_errors.push_back(compressionError) ;
+	return true ;
+}
+
+void FeatureFinderOptions::ApplyTo(UMCCreator &creator)
+{
+	creator.SetInputFileName(mstr_input_file);
+	creator.SetOutputDiretory(mstr_output_directory);
+	creator.SetOutputCompression(menm_output_compression, mint_output_compression_level, mint_output_compression_threads);
+
+	creator.SetFilterOptions(mflt_isotopic_fit, mint_min_intensity, mint_lc_min_scan, mint_lc_max_scan, mint_ims_min_scan, mint_ims_max_scan,
+		mflt_mono_mass_start, mflt_mono_mass_end, mbln_process_chunks, mint_max_data_points, mint_mono_mass_overlap, (float) mint_chunk_size);
+
+	creator.SetOptionsEx(mflt_mono_mass_weight, mflt_mono_mass_constraint, mbln_mono_mass_ppm, mflt_avg_mass_weight, mflt_avg_mass_constraint, mbln_avg_mass_ppm,
+		mflt_log_abundance_weight, mflt_scan_weight, mflt_net_weight, mflt_fit_weight, mflt_max_distance, mbln_use_generic_net, mflt_ims_drift_weight, mbln_use_charge);
+	creator.SetCollapseImsConformers(mbln_collapse_ims_conformers);
+	creator.SetSkipIsolatedPeaks(mbln_skip_isolated_peaks);
+	creator.SetMaxGaps(mint_max_scan_gap, mflt_max_net_gap, mflt_max_drift_time_gap);
+}
+
+// directory + input file name without directory and _isos.csv
+static void GetInputFilePrefix(const char *inputFile, const char *directory, char *prefix, int maxLength)
+{
+	char inputFileName[1024] ;
+
+	// Remove any directory information from the filename
+	const char *fileNameStart = inputFile ;
+	for (const char *ch = inputFile ; *ch != '\0' ; ch++)
+	{
+		if (*ch == '\\' || *ch == '/')
+			fileNameStart = ch + 1 ;
+	}
+	strncpy(inputFileName, fileNameStart, sizeof(inputFileName) - 1) ;
+	inputFileName[sizeof(inputFileName) - 1] = '\0' ;
+
+	// Remove the extension of a compressed file, so that Dataset_isos.csv.gz gives the names of Dataset_isos.csv
+	int nameLength = (int) strlen(inputFileName) ;
+	if (nameLength > 3 && strcmp(inputFileName + nameLength - 3, ".gz") == 0)
+		inputFileName[nameLength - 3] = '\0' ;
+	else if (nameLength > 4 && strcmp(inputFileName + nameLength - 4, ".zst") == 0)
+		inputFileName[nameLength - 4] = '\0' ;
+
+	// Remove the "_isos.csv" file extension
+	char* fileExtension = strstr(inputFileName, "_isos.csv");
+	if (fileExtension != NULL)
+		*fileExtension = '\0' ;
+
+	// Append the Input File Name to the directory to create the prefix
+	snprintf(prefix, maxLength, "%s%c%s", directory, PATH_SEPARATOR, inputFileName) ;
+}
+
+void FeatureFinderOptions::GetBaseFileName(char *baseFileName, int maxLength)
+{
+	GetInputFilePrefix(mstr_input_file, mstr_output_directory, baseFileName, maxLength) ;
+}
+
+void FeatureFinderOptions::GetTempFilePrefix(char *tempFilePrefix, int maxLength)
+{
+	GetInputFilePrefix(mstr_input_file, mstr_temp_directory[0] != '\0' ? mstr_temp_directory : mstr_output_directory, tempFilePrefix, maxLength) ;
+}
+
+void FeatureFinderOptions::GetOutputFileName(const char *fileName, char *outputFileName, int maxLength)
+{
+	snprintf(outputFileName, maxLength, "%s%c%s", mstr_output_directory, PATH_SEPARATOR, fileName) ;
+}
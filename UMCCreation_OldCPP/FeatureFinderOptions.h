@@ -0,0 +1,79 @@
+#pragma once
+#include "UMCCreator.h"
+#include <string>
+#include <vector>
+
+/*
+ * Settings of one feature finding run, as read from the INI file given to the feature finder
+ * (sections Files, DataFilters and UMCCreationOptions). Shared by clsUMCCreator::LoadProgramOptions
+ * and the native command line tool so that both interpret a settings file the same way.
+ */
+class FeatureFinderOptions
+{
+public:
+	// [Files]
+	char mstr_input_file[1024] ;
+	char mstr_output_directory[1024] ;
+	char mstr_temp_directory[1024] ;		// run files of the out of core mode; empty: OutputDirectory
+	CompressionFormat menm_output_compression ;		// OutputCompression=none, gzip or zstd
+	int mint_output_compression_level ;		// 0: default of the codec
+	int mint_output_compression_threads ;		// 0: one per core
+
+	// [DataFilters]
+	float mflt_isotopic_fit ;
+	int mint_min_intensity ;
+	float mflt_mono_mass_start ;
+	float mflt_mono_mass_end ;
+	bool mbln_process_chunks ;
+	bool mbln_merge_chunk_files ;		// merge the files of the chunks into one feature file and one peak map
+	int mint_pipeline_queue_depth ;
+	int mint_memory_budget_mb ;		// > 0: find the features out of core within this much memory for peaks
+	int mint_max_data_points ;
+	int mint_chunk_size ;
+	int mint_mono_mass_overlap ;
+	int mint_ims_min_scan ;
+	int mint_ims_max_scan ;
+	int mint_lc_min_scan ;
+	int mint_lc_max_scan ;
+
+	// [UMCCreationOptions]
+	float mflt_mono_mass_weight ;
+	float mflt_mono_mass_constraint ;
+	bool mbln_mono_mass_ppm ;
+	float mflt_ims_drift_weight ;
+	float mflt_log_abundance_weight ;
+	float mflt_net_weight ;
+	float mflt_fit_weight ;
+	float mflt_avg_mass_weight ;
+	float mflt_avg_mass_constraint ;
+	bool mbln_avg_mass_ppm ;
+	float mflt_scan_weight ;
+	float mflt_max_distance ;
+	// MaxScanGap, MaxNETGap, MaxDriftTimeGap: largest gaps between two linked peaks; 0 for no limit
+	int mint_max_scan_gap ;
+	float mflt_max_net_gap ;
+	float mflt_max_drift_time_gap ;
+	bool mbln_use_generic_net ;
+	int mint_min_umc_length ;
+	bool mbln_use_charge ;
+	bool mbln_collapse_ims_conformers ;		// CollapseIMSConformers: cluster the rows of IMS data per frame first
+	bool mbln_skip_isolated_peaks ;		// SkipIsolatedPeaks: leave the peaks with no possible link out of the sweep
+	bool mbln_use_weighted_euclidean ;
+
+	FeatureFinderOptions(void) ;
+	~FeatureFinderOptions(void) ;
+
+	// Settings that were present but could not be parsed (the default was kept), e.g. "DataFilters/ChunkSize: 'abc' is not an integer"
+	std::vector<std::string> mvect_errors ;
+
+	// Reads every setting, falling back to the defaults of the constructor; false if the file does not exist
+	bool LoadFromIniFile(const char *iniFileName) ;
+	// Passes the data filters and clustering options on to the engine
+	void ApplyTo(UMCCreator &creator) ;
+	// OutputDirectory + input file name without directory and _isos.csv; the prefix of every output file
+	void GetBaseFileName(char *baseFileName, int maxLength) ;
+	// Same as GetBaseFileName, but in TempDirectory; the prefix of the run files of the out of core mode
+	void GetTempFilePrefix(char *tempFilePrefix, int maxLength) ;
+	// OutputDirectory + fileName, for output that does not belong to one input file
+	void GetOutputFileName(const char *fileName, char *outputFileName, int maxLength) ;
+};
@@ -0,0 +1,111 @@
+// FeatureTable.cpp : columns of the features of a UMCCreator behind the flat UMCFeatureTable view.
+
+#include "FeatureTable.h"
+#include "UMCCreator.h"
+#include <string.h>
+
+namespace
+{
+	template <class T> const T * DataOf(const std::vector<T> &values)
+	{
+		return values.empty() ? NULL : &values[0] ;
+	}
+}
+
+FeatureTable::FeatureTable(void)
+{
+	memset(&mstruct_table, 0, sizeof(mstruct_table)) ;
+}
+
+FeatureTable::~FeatureTable(void)
+{
+}
+
+void FeatureTable::Build(UMCCreator &creator)
+{
+	if (creator.mvect_umc_raw_index.size() != creator.mvect_umc_num_members.size())
+		creator.SaveRawClusters() ;
+
+	int numFeatures = (int) creator.mvect_umcs.size() ;
+	mvect_umc_index.resize(numFeatures) ;
+	mvect_scan.resize(numFeatures) ;
+	mvect_start_scan.resize(numFeatures) ;
+	mvect_end_scan.resize(numFeatures) ;
+	mvect_net.resize(numFeatures) ;
+	mvect_mono_mass.resize(numFeatures) ;
+	mvect_average_mono_mass.resize(numFeatures) ;
+	mvect_min_mono_mass.resize(numFeatures) ;
+	mvect_max_mono_mass.resize(numFeatures) ;
+	mvect_abundance.resize(numFeatures) ;
+	mvect_max_abundance.resize(numFeatures) ;
+	mvect_class_rep_mz.resize(numFeatures) ;
+	mvect_class_rep_charge.resize(numFeatures) ;
+	mvect_num_members.resize(numFeatures) ;
+
+	bool useNet = creator.mint_lc_max_scan > creator.mint_lc_min_scan ;
+	for (int featureNum = 0 ; featureNum < numFeatures ; featureNum++)
+	{
+		UMC &umc = creator.mvect_umcs[featureNum] ;
+		mvect_umc_index[featureNum] = umc.mint_umc_index ;
+		mvect_scan[featureNum] = umc.mint_max_abundance_scan ;
+		mvect_start_scan[featureNum] = umc.mint_start_scan ;
+		mvect_end_scan[featureNum] = umc.mint_stop_scan ;
+		// the same generic NET as clsUMCCreator::GetUMCs
+		mvect_net[featureNum] = useNet ? (umc.mint_max_abundance_scan - creator.mint_lc_min_scan) * 1.0 / (creator.mint_lc_max_scan - creator.mint_lc_min_scan)
+			: (double) umc.mint_max_abundance_scan ;
+		mvect_mono_mass[featureNum] = umc.mdbl_median_mono_mass ;
+		mvect_average_mono_mass[featureNum] = umc.mdbl_average_mono_mass ;
+		mvect_min_mono_mass[featureNum] = umc.mdbl_min_mono_mass ;
+		mvect_max_mono_mass[featureNum] = umc.mdbl_max_mono_mass ;
+		mvect_abundance[featureNum] = umc.mdbl_sum_abundance ;
+		mvect_max_abundance[featureNum] = umc.mdbl_max_abundance ;
+		mvect_class_rep_mz[featureNum] = umc.mdbl_class_rep_mz ;
+		mvect_class_rep_charge[featureNum] = (int) umc.mshort_class_rep_charge ;
+		mvect_num_members[featureNum] = umc.min_num_members ;
+	}
+
+	// the features are the raw clusters named by mvect_umc_raw_index, in that order
+	int numMappings = 0 ;
+	for (int featureNum = 0 ; featureNum < numFeatures ; featureNum++)
+	{
+		int rawIndex = creator.mvect_umc_raw_index[featureNum] ;
+		numMappings += creator.mvect_raw_umc_start[rawIndex + 1] - creator.mvect_raw_umc_start[rawIndex] ;
+	}
+	mvect_peak_start.resize(numFeatures + 1) ;
+	mvect_peak_index.resize(numMappings) ;
+	mvect_peak_feature.resize(numMappings) ;
+	int mappingNum = 0 ;
+	for (int featureNum = 0 ; featureNum < numFeatures ; featureNum++)
+	{
+		int rawIndex = creator.mvect_umc_raw_index[featureNum] ;
+		int rawStart = creator.mvect_raw_umc_start[rawIndex] ;
+		int numMembers = creator.mvect_raw_umc_start[rawIndex + 1] - rawStart ;
+		mvect_peak_start[featureNum] = mappingNum ;
+		if (numMembers > 0)
+			memcpy(&mvect_peak_index[mappingNum], &creator.mvect_raw_umc_peaks[rawStart], numMembers * sizeof(int)) ;
+		for (int memberNum = 0 ; memberNum < numMembers ; memberNum++)
+			mvect_peak_feature[mappingNum + memberNum] = featureNum ;
+		mappingNum += numMembers ;
+	}
+	mvect_peak_start[numFeatures] = mappingNum ;
+
+	mstruct_table.num_features = numFeatures ;
+	mstruct_table.num_mappings = numMappings ;
+	mstruct_table.umc_index = DataOf(mvect_umc_index) ;
+	mstruct_table.scan = DataOf(mvect_scan) ;
+	mstruct_table.start_scan = DataOf(mvect_start_scan) ;
+	mstruct_table.end_scan = DataOf(mvect_end_scan) ;
+	mstruct_table.net = DataOf(mvect_net) ;
+	mstruct_table.mono_mass = DataOf(mvect_mono_mass) ;
+	mstruct_table.average_mono_mass = DataOf(mvect_average_mono_mass) ;
+	mstruct_table.min_mono_mass = DataOf(mvect_min_mono_mass) ;
+	mstruct_table.max_mono_mass = DataOf(mvect_max_mono_mass) ;
+	mstruct_table.abundance = DataOf(mvect_abundance) ;
+	mstruct_table.max_abundance = DataOf(mvect_max_abundance) ;
+	mstruct_table.class_rep_mz = DataOf(mvect_class_rep_mz) ;
+	mstruct_table.class_rep_charge = DataOf(mvect_class_rep_charge) ;
+	mstruct_table.num_members = DataOf(mvect_num_members) ;
+	mstruct_table.peak_start = DataOf(mvect_peak_start) ;
+	mstruct_table.peak_index = DataOf(mvect_peak_index) ;
+	mstruct_table.peak_feature = DataOf(mvect_peak_feature) ;
+}
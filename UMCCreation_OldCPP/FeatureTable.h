@@ -0,0 +1,84 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Flat C view of the features of a clustering, for hosts that read them without a managed object per feature.
+ * Every column is a contiguous array of num_features values, in feature order; the peaks of feature i are
+ * peak_index[peak_start[i]] up to peak_index[peak_start[i+1] - 1], ascending. peak_feature holds the feature of each
+ * entry of peak_index, so the two make the (feature, peak) pairs of clsUMCCreator::GetUmcMapping already sorted by
+ * feature and then peak. A peak index is the position of the peak in UMCCreator::mvect_isotope_peaks (for
+ * clsUMCCreator::SetIsotopePeaks, its index in the array passed in).
+ * The arrays belong to the FeatureTable that filled the view and stay valid until it is built again or destroyed.
+ */
+typedef struct UMCFeatureTable
+{
+	int num_features ;
+	int num_mappings ;
+
+	const int *umc_index ;
+	const int *scan ;					// scan of the most abundant peak
+	const int *start_scan ;
+	const int *end_scan ;
+	const double *net ;					// scan of the most abundant peak as a generic NET if the LC scan range is known, else the scan
+	const double *mono_mass ;			// median mono mass
+	const double *average_mono_mass ;
+	const double *min_mono_mass ;
+	const double *max_mono_mass ;
+	const double *abundance ;			// sum of the abundances of the peaks
+	const double *max_abundance ;
+	const double *class_rep_mz ;
+	const int *class_rep_charge ;
+	const int *num_members ;
+
+	const int *peak_start ;				// num_features + 1 offsets into peak_index
+	const int *peak_index ;				// num_mappings peak indices
+	const int *peak_feature ;			// num_mappings feature indices
+} UMCFeatureTable ;
+
+#ifdef __cplusplus
+}
+
+#include <vector>
+
+class UMCCreator ;
+
+/*
+ * Owner of the columns behind a UMCFeatureTable. Build copies the features of a creator once, after CalculateUMCs,
+ * into one array per column, and takes the peaks of each feature from its raw cluster, which already holds them in
+ * ascending order; the multimap is not walked and nothing is sorted.
+ */
+class FeatureTable
+{
+	std::vector<int> mvect_umc_index ;
+	std::vector<int> mvect_scan ;
+	std::vector<int> mvect_start_scan ;
+	std::vector<int> mvect_end_scan ;
+	std::vector<double> mvect_net ;
+	std::vector<double> mvect_mono_mass ;
+	std::vector<double> mvect_average_mono_mass ;
+	std::vector<double> mvect_min_mono_mass ;
+	std::vector<double> mvect_max_mono_mass ;
+	std::vector<double> mvect_abundance ;
+	std::vector<double> mvect_max_abundance ;
+	std::vector<double> mvect_class_rep_mz ;
+	std::vector<int> mvect_class_rep_charge ;
+	std::vector<int> mvect_num_members ;
+	std::vector<int> mvect_peak_start ;
+	std::vector<int> mvect_peak_index ;
+	std::vector<int> mvect_peak_feature ;
+
+	UMCFeatureTable mstruct_table ;
+
+public:
+	FeatureTable(void) ;
+	~FeatureTable(void) ;
+
+	// Fills the table with the UMCs of the last CalculateUMCs of creator; saves its raw clusters first if they
+	// are out of date, like CalculateUMCs does
+	void Build(UMCCreator &creator) ;
+	const UMCFeatureTable * GetTable() { return &mstruct_table ; } ;
+};
+#endif
@@ -0,0 +1,120 @@
+#include "ImsCandidateIndex.h"
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+
+namespace
+{
+	// the drift times, or the scans as floats (exact up to 2^24)
+	struct KeyOrder
+	{
+		const std::vector<float> *mvect_keys ;
+		bool operator()(int a, int b) const
+		{
+			float keyA = (*mvect_keys)[a] ;
+			float keyB = (*mvect_keys)[b] ;
+			return keyA < keyB || (keyA == keyB && a < b) ;
+		}
+	} ;
+}
+
+ImsCandidateIndex::ImsCandidateIndex(void)
+{
+	mbln_scan_order = false ;
+}
+
+void ImsCandidateIndex::Build(const std::vector<IsotopePeak> &sortedPeaks, bool scanOrder)
+{
+	int numPeaks = (int) sortedPeaks.size() ;
+	mbln_scan_order = scanOrder ;
+	mvect_drift_times.resize(numPeaks) ;
+	mvect_scans.resize(numPeaks) ;
+	mvect_block_order.resize(numPeaks) ;
+	mvect_block_keys.resize(numPeaks) ;
+	std::vector<float> keys(numPeaks) ;
+	for (int index = 0 ; index < numPeaks ; index++)
+	{
+		mvect_drift_times[index] = sortedPeaks[index].mflt_ims_drift_time ;
+		mvect_scans[index] = sortedPeaks[index].mint_lc_scan ;
+		mvect_block_order[index] = index ;
+		keys[index] = scanOrder ? (float) sortedPeaks[index].mint_lc_scan : sortedPeaks[index].mflt_ims_drift_time ;
+	}
+
+	KeyOrder order ;
+	order.mvect_keys = &keys ;
+	for (int blockStart = 0 ; blockStart < numPeaks ; blockStart += BLOCK_PEAKS)
+	{
+		int blockEnd = blockStart + BLOCK_PEAKS < numPeaks ? blockStart + BLOCK_PEAKS : numPeaks ;
+		std::sort(mvect_block_order.begin() + blockStart, mvect_block_order.begin() + blockEnd, order) ;
+	}
+	for (int index = 0 ; index < numPeaks ; index++)
+		mvect_block_keys[index] = keys[mvect_block_order[index]] ;
+}
+
+void ImsCandidateIndex::Clear()
+{
+	std::vector<float>().swap(mvect_drift_times) ;
+	std::vector<int>().swap(mvect_scans) ;
+	std::vector<int>().swap(mvect_block_order) ;
+	std::vector<float>().swap(mvect_block_keys) ;
+}
+
+inline void ImsCandidateIndex::AddCandidate(int index, int scan, int scanTolerance, std::vector<int> &candidates) const
+{
+	if (abs(mvect_scans[index] - scan) <= scanTolerance)
+		candidates.push_back(index) ;
+}
+
+void ImsCandidateIndex::FindCandidates(int first, int last, float driftTime, float driftTolerance, int scan, int scanTolerance,
+	std::vector<int> &candidates) const
+{
+	int numPeaks = (int) mvect_drift_times.size() ;
+	if (last > numPeaks)
+		last = numPeaks ;
+	// the binary search only narrows down the peaks that get the exact test, so it may look a little wider
+	float minKey ;
+	float maxKey ;
+	if (mbln_scan_order)
+	{
+		minKey = (float) ((double) scan - scanTolerance) - 1 ;
+		maxKey = (float) ((double) scan + scanTolerance) + 1 ;
+	}
+	else
+	{
+		float searchTolerance = driftTolerance * 1.001F ;
+		minKey = driftTime - searchTolerance ;
+		maxKey = driftTime + searchTolerance ;
+	}
+
+	int index = first ;
+	while (index < last)
+	{
+		int blockStart = index - index % BLOCK_PEAKS ;
+		int blockEnd = blockStart + BLOCK_PEAKS < numPeaks ? blockStart + BLOCK_PEAKS : numPeaks ;
+		if (index > blockStart || blockEnd > last)
+		{
+			// part of a block, at either end of the window
+			int end = blockEnd < last ? blockEnd : last ;
+			for ( ; index < end ; index++)
+			{
+				if (fabs(mvect_drift_times[index] - driftTime) <= driftTolerance)
+					AddCandidate(index, scan, scanTolerance, candidates) ;
+			}
+			continue ;
+		}
+
+		size_t numBefore = candidates.size() ;
+		const float *blockKeys = &mvect_block_keys[blockStart] ;
+		int numInBlock = blockEnd - blockStart ;
+		int position = (int) (std::lower_bound(blockKeys, blockKeys + numInBlock, minKey) - blockKeys) ;
+		for ( ; position < numInBlock && blockKeys[position] <= maxKey ; position++)
+		{
+			int candidate = mvect_block_order[blockStart + position] ;
+			if (fabs(mvect_drift_times[candidate] - driftTime) <= driftTolerance)
+				AddCandidate(candidate, scan, scanTolerance, candidates) ;
+		}
+		// back in mass order, the order the sweep links peaks in
+		std::sort(candidates.begin() + numBefore, candidates.end()) ;
+		index = blockEnd ;
+	}
+}
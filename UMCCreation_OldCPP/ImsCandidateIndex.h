@@ -0,0 +1,39 @@
+#pragma once
+#include "IsotopePeak.h"
+#include <vector>
+
+/*
+ * Candidate index of the clustering sweep for IMS data. The sweep compares every peak with all heavier peaks in its
+ * mass window, but on IMS data most of those are other conformers or other frames, far away in drift time.
+ * The mass-sorted peaks are cut into blocks of BLOCK_PEAKS consecutive peaks, each kept in drift time order as well,
+ * so the peaks of a window that are close enough in drift time are found by a binary search per block instead of
+ * by a distance per peak. Windows shorter than a few blocks are checked peak by peak against copies of the drift
+ * times and frames, which is still far cheaper than UMCCreator::PeakDistance.
+ *
+ * With a maximum scan gap (MaxScanGap / MaxNETGap) and no drift time to go by, LC-MS data included, the blocks are
+ * kept in scan order instead and searched on the scan, so that a window spanning the whole gradient only costs
+ * the peaks within the gap of the current one.
+ */
+class ImsCandidateIndex
+{
+	std::vector<float> mvect_drift_times ;		// drift time of each sorted peak
+	std::vector<int> mvect_scans ;				// LC scan (frame) of each sorted peak
+	bool mbln_scan_order ;						// blocks ordered on the scan rather than the drift time
+	// per block, the sorted indices of its peaks in drift time (or scan) order, and their drift times (or scans)
+	std::vector<int> mvect_block_order ;
+	std::vector<float> mvect_block_keys ;
+
+	void AddCandidate(int index, int scan, int scanTolerance, std::vector<int> &candidates) const ;
+
+public:
+	static const int BLOCK_PEAKS = 64 ;
+
+	ImsCandidateIndex(void) ;
+	// scanOrder: order the blocks on the scan, for searches with a scan tolerance and no drift time tolerance
+	void Build(const std::vector<IsotopePeak> &sortedPeaks, bool scanOrder) ;
+	void Clear() ;
+	// Appends to candidates, in increasing order, every index first <= i < last whose drift time is at most
+	// driftTolerance and whose scan at most scanTolerance away from driftTime and scan; FLT_MAX and INT_MAX do not limit
+	void FindCandidates(int first, int last, float driftTime, float driftTolerance, int scan, int scanTolerance,
+		std::vector<int> &candidates) const ;
+};
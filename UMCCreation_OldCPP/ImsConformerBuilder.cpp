@@ -0,0 +1,114 @@
+#include "ImsConformerBuilder.h"
+#include <stdlib.h>
+#include <algorithm>
+
+namespace
+{
+	struct ChargeAndMassOrder
+	{
+		const std::vector<IsotopePeak> *mvect_peaks ;
+		const int *mptr_frame_peaks ;
+		bool operator()(int a, int b) const
+		{
+			const IsotopePeak &peakA = (*mvect_peaks)[mptr_frame_peaks[a]] ;
+			const IsotopePeak &peakB = (*mvect_peaks)[mptr_frame_peaks[b]] ;
+			if (peakA.mshort_charge != peakB.mshort_charge)
+				return peakA.mshort_charge < peakB.mshort_charge ;
+			if (peakA.mdbl_mono_mass != peakB.mdbl_mono_mass)
+				return peakA.mdbl_mono_mass < peakB.mdbl_mono_mass ;
+			return a < b ;
+		}
+	} ;
+}
+
+ImsConformerBuilder::ImsConformerBuilder(float massConstraint, bool massConstraintIsPpm)
+{
+	mflt_mass_constraint = massConstraint ;
+	mbln_mass_constraint_is_ppm = massConstraintIsPpm ;
+}
+
+int ImsConformerBuilder::FindGroup(int position)
+{
+	int root = position ;
+	while (mvect_parent[root] != root)
+		root = mvect_parent[root] ;
+	// shorten the path for the next lookups
+	while (mvect_parent[position] != root)
+	{
+		int next = mvect_parent[position] ;
+		mvect_parent[position] = root ;
+		position = next ;
+	}
+	return root ;
+}
+
+void ImsConformerBuilder::AddFrame(const std::vector<IsotopePeak> &peaks, const int *framePeaks, int numFramePeaks,
+	std::vector<IsotopePeak> &nodes, std::vector<int> &nodeOfPeak)
+{
+	mvect_mass_order.resize(numFramePeaks) ;
+	mvect_parent.resize(numFramePeaks) ;
+	for (int position = 0 ; position < numFramePeaks ; position++)
+	{
+		mvect_mass_order[position] = position ;
+		mvect_parent[position] = position ;
+	}
+	ChargeAndMassOrder order ;
+	order.mvect_peaks = &peaks ;
+	order.mptr_frame_peaks = framePeaks ;
+	std::sort(mvect_mass_order.begin(), mvect_mass_order.end(), order) ;
+
+	// join every row with the heavier rows of the same charge within the mass constraint that are at most one IMS scan away
+	for (int orderNum = 0 ; orderNum < numFramePeaks ; orderNum++)
+	{
+		const IsotopePeak &peak = peaks[framePeaks[mvect_mass_order[orderNum]]] ;
+		double maxMass = peak.mdbl_mono_mass + (mbln_mass_constraint_is_ppm ? mflt_mass_constraint * peak.mdbl_mono_mass / 1000000.0
+			: mflt_mass_constraint) ;
+		for (int matchNum = orderNum + 1 ; matchNum < numFramePeaks ; matchNum++)
+		{
+			const IsotopePeak &match = peaks[framePeaks[mvect_mass_order[matchNum]]] ;
+			if (match.mshort_charge != peak.mshort_charge || match.mdbl_mono_mass > maxMass)
+				break ;
+			if (abs(match.mint_ims_scan - peak.mint_ims_scan) <= 1)
+			{
+				int group = FindGroup(mvect_mass_order[orderNum]) ;
+				int matchGroup = FindGroup(mvect_mass_order[matchNum]) ;
+				// the earlier row stays the root, so roots are the first rows of their groups
+				if (group < matchGroup)
+					mvect_parent[matchGroup] = group ;
+				else if (matchGroup < group)
+					mvect_parent[group] = matchGroup ;
+			}
+		}
+	}
+
+	// one node per group, in file order of the first rows; the most abundant row (the first of equals) is the apex
+	int firstNode = (int) nodes.size() ;
+	mvect_node_of_group.assign(numFramePeaks, -1) ;
+	mvect_apex_abundance.clear() ;
+	for (int position = 0 ; position < numFramePeaks ; position++)
+	{
+		int peakIndex = framePeaks[position] ;
+		const IsotopePeak &peak = peaks[peakIndex] ;
+		int group = FindGroup(position) ;
+		int nodeIndex = mvect_node_of_group[group] ;
+		if (nodeIndex == -1)
+		{
+			nodeIndex = (int) nodes.size() ;
+			mvect_node_of_group[group] = nodeIndex ;
+			nodes.push_back(peak) ;
+			mvect_apex_abundance.push_back(peak.mdbl_abundance) ;
+		}
+		else
+		{
+			IsotopePeak &node = nodes[nodeIndex] ;
+			double abundance = node.mdbl_abundance + peak.mdbl_abundance ;
+			if (peak.mdbl_abundance > mvect_apex_abundance[nodeIndex - firstNode])
+			{
+				node = peak ;
+				mvect_apex_abundance[nodeIndex - firstNode] = peak.mdbl_abundance ;
+			}
+			node.mdbl_abundance = abundance ;
+		}
+		nodeOfPeak[peakIndex] = nodeIndex ;
+	}
+}
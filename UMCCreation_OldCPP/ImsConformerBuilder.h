@@ -0,0 +1,34 @@
+#pragma once
+#include "IsotopePeak.h"
+#include <vector>
+
+/*
+ * First stage of the two-stage clustering of IMS data. An isos file holds a row for every IMS scan a species was
+ * seen in, so within one LC frame a species shows up as a run of rows in adjacent IMS scans with nearly the same mass.
+ * Such rows (same charge, IMS scans at most one apart, mono masses within the mass constraint, taken transitively)
+ * are collapsed into one conformer node: a copy of the most abundant row with the abundance of the whole group. The
+ * clustering then links nodes across frames, and every row ends up in the UMC of its node.
+ * Only reads the peaks, so the frames can be split over several builders.
+ */
+class ImsConformerBuilder
+{
+	float mflt_mass_constraint ;
+	bool mbln_mass_constraint_is_ppm ;
+
+	// scratch space of AddFrame; a row is known by its position among the rows of the frame
+	std::vector<int> mvect_mass_order ;			// positions ordered by charge, then mono mass
+	std::vector<int> mvect_parent ;				// union-find of the groups, by position
+	std::vector<int> mvect_node_of_group ;		// node of each group, by position of its root; -1 if it has none yet
+	std::vector<double> mvect_apex_abundance ;	// abundance of the apex row of each node of the frame
+
+	int FindGroup(int position) ;
+
+public:
+	ImsConformerBuilder(float massConstraint, bool massConstraintIsPpm) ;
+
+	// Appends the nodes of one frame to nodes, in the order of their first row. framePeaks holds the indices into
+	// peaks of the rows of the frame in file order; nodeOfPeak[framePeaks[i]] is set to the index of the node of that
+	// row in nodes.
+	void AddFrame(const std::vector<IsotopePeak> &peaks, const int *framePeaks, int numFramePeaks, std::vector<IsotopePeak> &nodes,
+		std::vector<int> &nodeOfPeak) ;
+};
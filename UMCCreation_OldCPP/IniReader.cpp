@@ -1,47 +1,184 @@
-//Source code downlaoded from 
-//http://www.codeproject.com/KB/cpp/IniReader.aspx
-
-
-#include "IniReader.h"
-#include <iostream>
-#include <Windows.h>
-
-CIniReader::CIniReader(char* szFileName)
-{
- memset(m_szFileName, 0x00, 255);
- memcpy(m_szFileName, szFileName, strlen(szFileName));
-}
-int CIniReader::ReadInteger(char* szSection, char* szKey, int iDefaultValue)
-{
- int iResult = GetPrivateProfileInt(szSection,  szKey, iDefaultValue, m_szFileName); 
- return iResult;
-}
-float CIniReader::ReadFloat(char* szSection, char* szKey, float fltDefaultValue)
-{
- char szResult[255];
- char szDefault[255];
- float fltResult;
- sprintf(szDefault, "%f",fltDefaultValue);
- GetPrivateProfileString(szSection,  szKey, szDefault, szResult, 255, m_szFileName); 
- fltResult =  atof(szResult);
- return fltResult;
-}
-bool CIniReader::ReadBoolean(char* szSection, char* szKey, bool bolDefaultValue)
-{
- char szResult[255];
- char szDefault[255];
- bool bolResult;
- sprintf(szDefault, "%s", bolDefaultValue? "True" : "False");
- GetPrivateProfileString(szSection, szKey, szDefault, szResult, 255, m_szFileName); 
- bolResult =  (strcmp(szResult, "True") == 0 || 
-		strcmp(szResult, "true") == 0) ? true : false;
- return bolResult;
-}
-char* CIniReader::ReadString(char* szSection, char* szKey, const char* szDefaultValue)
-{
- char* szResult = new char[255];
- memset(szResult, 0x00, 255);
- GetPrivateProfileString(szSection,  szKey, 
-		szDefaultValue, szResult, 255, m_szFileName); 
- return szResult;
-}
\ No newline at end of file
+//Interface originally from 
+//http://www.codeproject.com/KB/cpp/IniReader.aspx
+//The file is now parsed once in the constructor instead of calling GetPrivateProfileString for every key.
+
+
+#include "IniReader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+
+static std::string ToLower(const char* szText)
+{
+ std::string result(szText);
+ for (size_t i = 0; i < result.size(); i++)
+  result[i] = (char)tolower((unsigned char)result[i]);
+ return result;
+}
+
+static std::string Trim(const std::string &text)
+{
+ size_t start = 0;
+ size_t end = text.size();
+ while (start < end && isspace((unsigned char)text[start]))
+  start++;
+ while (end > start && isspace((unsigned char)text[end-1]))
+  end--;
+ return text.substr(start, end - start);
+}
+
+static std::string MakeKey(const char* szSection, const char* szKey)
+{
+ return ToLower(szSection) + "\n" + ToLower(szKey);
+}
+
+CIniReader::CIniReader(const char* szFileName)
+{
+ m_bLoaded = false;
+ FILE *file = fopen(szFileName, "r");
+ if (file == NULL)
+  return;
+
+ std::string section;
+ std::string line;
+ char chunk[1024];
+ bool firstLine = true;
+ while (fgets(chunk, sizeof(chunk), file) != NULL)
+ {
+  line += chunk;
+  if (line[line.size()-1] != '\n' && !feof(file))
+   continue;
+
+  // UTF-8 byte order mark written by Notepad
+  if (firstLine && line.compare(0, 3, "\xEF\xBB\xBF") == 0)
+   line.erase(0, 3);
+  firstLine = false;
+
+  std::string text = Trim(line);
+  line.clear();
+  if (text.empty() || text[0] == ';' || text[0] == '#')
+   continue;
+
+  if (text[0] == '[')
+  {
+   size_t close = text.find(']');
+   section = ToLower(Trim(text.substr(1, close == std::string::npos ? std::string::npos : close - 1)).c_str());
+   continue;
+  }
+
+  size_t equals = text.find('=');
+  if (equals == std::string::npos)
+   continue;
+  std::string key = section + "\n" + ToLower(Trim(text.substr(0, equals)).c_str());
+  if (m_mapValues.find(key) == m_mapValues.end())
+   m_mapValues[key] = Trim(text.substr(equals + 1));
+ }
+ fclose(file);
+ m_bLoaded = true;
+}
+
+const std::string* CIniReader::Find(const char* szSection, const char* szKey) const
+{
+ std::map<std::string, std::string>::const_iterator iter = m_mapValues.find(MakeKey(szSection, szKey));
+ if (iter == m_mapValues.end())
+  return NULL;
+ return &iter->second;
+}
+
+void CIniReader::AddError(const char* szSection, const char* szKey, const std::string &value, const char* szType)
+{
+ std::string error = std::string(szSection) + "/" + szKey + ": '" + value + "' is not " + szType + "; using the default";
+ m_vectErrors.push_back(error);
+}
+
+bool CIniReader::HasKey(const char* szSection, const char* szKey) const
+{
+ return Find(szSection, szKey) != NULL;
+}
+
+int CIniReader::ReadInteger(const char* szSection, const char* szKey, int iDefaultValue)
+{
+ const std::string *value = Find(szSection, szKey);
+ if (value == NULL || value->empty())
+  return iDefaultValue;
+
+ char *end;
+ errno = 0;
+ long result = strtol(value->c_str(), &end, 10);
+ if (*end != '\0' || errno == ERANGE || result > 2147483647L || result < -2147483647L - 1)
+ {
+  AddError(szSection, szKey, *value, "an integer");
+  return iDefaultValue;
+ }
+ return (int)result;
+}
+
+float CIniReader::ReadFloat(const char* szSection, const char* szKey, float fltDefaultValue)
+{
+ const std::string *value = Find(szSection, szKey);
+ if (value == NULL || value->empty())
+  return fltDefaultValue;
+
+ char *end;
+ double result = strtod(value->c_str(), &end);
+ if (*end != '\0')
+ {
+  AddError(szSection, szKey, *value, "a number");
+  return fltDefaultValue;
+ }
+ return (float)result;
+}
+
+bool CIniReader::ReadBoolean(const char* szSection, const char* szKey, bool bolDefaultValue)
+{
+ const std::string *value = Find(szSection, szKey);
+ if (value == NULL || value->empty())
+  return bolDefaultValue;
+
+ std::string text = ToLower(value->c_str());
+ if (text == "true" || text == "1" || text == "yes")
+  return true;
+ if (text == "false" || text == "0" || text == "no")
+  return false;
+ AddError(szSection, szKey, *value, "True or False");
+ return bolDefaultValue;
+}
+
+const char* CIniReader::ReadString(const char* szSection, const char* szKey, const char* szDefaultValue)
+{
+ const std::string *value = Find(szSection, szKey);
+ if (value == NULL)
+  return szDefaultValue;
+ return value->c_str();
+}
+
+bool CIniReader::ReadFloatList(const char* szSection, const char* szKey, std::vector<float> &vectValues)
+{
+ const std::string *value = Find(szSection, szKey);
+ if (value == NULL || value->empty())
+  return false;
+
+ std::vector<float> values;
+ size_t start = 0;
+ while (start <= value->size())
+ {
+  size_t comma = value->find(',', start);
+  if (comma == std::string::npos)
+   comma = value->size();
+  std::string item = Trim(value->substr(start, comma - start));
+
+  char *end;
+  double result = strtod(item.c_str(), &end);
+  if (item.empty() || *end != '\0')
+  {
+   AddError(szSection, szKey, *value, "a list of numbers");
+   return false;
+  }
+  values.push_back((float)result);
+  start = comma + 1;
+ }
+ vectValues = values;
+ return true;
+}
@@ -1,14 +1,34 @@
-#ifndef INIREADER_H
-#define INIREADER_H
-class CIniReader
-{
-public:
- CIniReader(char* szFileName); 
- int ReadInteger(char* szSection, char* szKey, int iDefaultValue);
- float ReadFloat(char* szSection, char* szKey, float fltDefaultValue);
- bool ReadBoolean(char* szSection, char* szKey, bool bolDefaultValue);
- char* ReadString(char* szSection, char* szKey, const char* szDefaultValue);
-private:
-  char m_szFileName[255];
-};
-#endif//INIREADER_H
\ No newline at end of file
+#ifndef INIREADER_H
+#define INIREADER_H
+#include <map>
+#include <string>
+#include <vector>
+
+// Reads the whole INI file once into a table; lookups after that never touch the disk.
+// Section and key names are case-insensitive (as with the Win32 profile API), the first
+// occurrence of a key wins, and values that do not parse as the requested type fall back
+// to the default and are recorded in GetErrors().
+class CIniReader
+{
+public:
+ CIniReader(const char* szFileName); 
+ bool IsLoaded() const { return m_bLoaded; }
+ bool HasKey(const char* szSection, const char* szKey) const;
+ int ReadInteger(const char* szSection, const char* szKey, int iDefaultValue);
+ float ReadFloat(const char* szSection, const char* szKey, float fltDefaultValue);
+ bool ReadBoolean(const char* szSection, const char* szKey, bool bolDefaultValue);
+ // The returned string belongs to the reader (or is szDefaultValue) and lives as long as the reader
+ const char* ReadString(const char* szSection, const char* szKey, const char* szDefaultValue);
+ // Comma separated numbers, e.g. MaxDistance=0.1,0.2,0.3; vectValues is left untouched when the key
+ // is missing or any item is not a number (the error is recorded)
+ bool ReadFloatList(const char* szSection, const char* szKey, std::vector<float> &vectValues);
+ const std::vector<std::string>& GetErrors() const { return m_vectErrors; }
+private:
+  bool m_bLoaded;
+  std::map<std::string, std::string> m_mapValues; // "section\nkey" (lower case) -> value
+  std::vector<std::string> m_vectErrors;
+
+  const std::string* Find(const char* szSection, const char* szKey) const;
+  void AddError(const char* szSection, const char* szKey, const std::string &value, const char* szType);
+};
+#endif//INIREADER_H
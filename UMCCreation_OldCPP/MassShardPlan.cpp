@@ -0,0 +1,102 @@
+// MassShardPlan.cpp : mono mass shards of a sharded feature finding run and their plan file.
+
+#include "MassShardPlan.h"
+#include "IniReader.h"
+#include <stdio.h>
+
+MassShardPlan::MassShardPlan(void)
+{
+	mint_num_shards = 0 ;
+	mflt_overlap = 0 ;
+	mint_num_peaks = 0 ;
+	mbln_is_ims_data = false ;
+	mint_lc_min_scan = 0 ;
+	mint_lc_max_scan = 0 ;
+	mint_ims_min_scan = 0 ;
+	mint_ims_max_scan = 0 ;
+}
+
+MassShardPlan::~MassShardPlan(void)
+{
+}
+
+void MassShardPlan::GetLoadRange(int shardNum, float &loadStart, float &loadEnd) const
+{
+	loadStart = mvect_boundaries[shardNum] - mflt_overlap ;
+	if (loadStart < mvect_boundaries[0])
+		loadStart = mvect_boundaries[0] ;
+	loadEnd = mvect_boundaries[shardNum + 1] + mflt_overlap ;
+	if (loadEnd > mvect_boundaries[mint_num_shards])
+		loadEnd = mvect_boundaries[mint_num_shards] ;
+}
+
+bool MassShardPlan::IsInCore(int shardNum, double monoMass) const
+{
+	if (monoMass < mvect_boundaries[shardNum])
+		return false ;
+	return shardNum == mint_num_shards - 1 ? monoMass <= mvect_boundaries[shardNum + 1] : monoMass < mvect_boundaries[shardNum + 1] ;
+}
+
+bool MassShardPlan::WriteFile(const char *fileName) const
+{
+	FILE *planFile = fopen(fileName, "w") ;
+	if (planFile == NULL)
+		return false ;
+
+	// %.9g gives every float back unchanged
+	fprintf(planFile, "[MassShardPlan]\n") ;
+	fprintf(planFile, "Shards=%d\n", mint_num_shards) ;
+	fprintf(planFile, "Peaks=%d\n", mint_num_peaks) ;
+	fprintf(planFile, "OverlapDa=%.9g\n", mflt_overlap) ;
+	fprintf(planFile, "IsIMSData=%s\n", mbln_is_ims_data ? "True" : "False") ;
+	fprintf(planFile, "LCMinScan=%d\n", mint_lc_min_scan) ;
+	fprintf(planFile, "LCMaxScan=%d\n", mint_lc_max_scan) ;
+	fprintf(planFile, "IMSMinScan=%d\n", mint_ims_min_scan) ;
+	fprintf(planFile, "IMSMaxScan=%d\n", mint_ims_max_scan) ;
+	for (int shardNum = 0 ; shardNum < mint_num_shards ; shardNum++)
+	{
+		fprintf(planFile, "Shard%d=%.9g,%.9g\n", shardNum + 1, mvect_boundaries[shardNum], mvect_boundaries[shardNum + 1]) ;
+		fprintf(planFile, "Shard%dPeaks=%d\n", shardNum + 1, mvect_shard_peaks[shardNum]) ;
+	}
+	return fclose(planFile) == 0 ;
+}
+
+bool MassShardPlan::ReadFile(const char *fileName)
+{
+	CIniReader iniReader(fileName) ;
+	if (!iniReader.IsLoaded())
+		return false ;
+
+	mint_num_shards = iniReader.ReadInteger("MassShardPlan", "Shards", 0) ;
+	mint_num_peaks = iniReader.ReadInteger("MassShardPlan", "Peaks", 0) ;
+	mflt_overlap = iniReader.ReadFloat("MassShardPlan", "OverlapDa", 0) ;
+	mbln_is_ims_data = iniReader.ReadBoolean("MassShardPlan", "IsIMSData", false) ;
+	mint_lc_min_scan = iniReader.ReadInteger("MassShardPlan", "LCMinScan", 0) ;
+	mint_lc_max_scan = iniReader.ReadInteger("MassShardPlan", "LCMaxScan", 0) ;
+	mint_ims_min_scan = iniReader.ReadInteger("MassShardPlan", "IMSMinScan", 0) ;
+	mint_ims_max_scan = iniReader.ReadInteger("MassShardPlan", "IMSMaxScan", 0) ;
+	if (mint_num_shards < 1 || !iniReader.GetErrors().empty())
+		return false ;
+
+	mvect_boundaries.clear() ;
+	mvect_shard_peaks.clear() ;
+	char key[32] ;
+	std::vector<float> core ;
+	for (int shardNum = 0 ; shardNum < mint_num_shards ; shardNum++)
+	{
+		sprintf(key, "Shard%d", shardNum + 1) ;
+		core.clear() ;
+		if (!iniReader.ReadFloatList("MassShardPlan", key, core) || core.size() != 2 || !(core[0] < core[1]))
+			return false ;
+		// the cores must follow on from each other
+		if (shardNum == 0)
+			mvect_boundaries.push_back(core[0]) ;
+		else if (core[0] != mvect_boundaries.back())
+			return false ;
+		mvect_boundaries.push_back(core[1]) ;
+
+		sprintf(key, "Shard%dPeaks", shardNum + 1) ;
+		mvect_shard_peaks.push_back(iniReader.ReadInteger("MassShardPlan", key, 0)) ;
+	}
+	return true ;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+
+/*
+ * Split of one isos file into mono mass shards that separate processes cluster on their own (UMCCreatorSharded.cpp).
+ * Made by UMCCreator::PlanMassShards in one pass over the file, and kept in a small INI file so that workers on
+ * other nodes (sharing the directory) cluster with the same split.
+ *
+ * Shard i owns the peaks of its core, mvect_boundaries[i] <= mass < mvect_boundaries[i+1] (the last core includes its
+ * end), and loads mflt_overlap Da more on both sides so that every link of a core peak is seen by its shard. The
+ * scan ranges are those of the whole file: the NET of a peak, and so its distances, must not depend on its shard.
+ */
+class MassShardPlan
+{
+public:
+	int mint_num_shards ;
+	std::vector<float> mvect_boundaries ;		// mint_num_shards + 1 core boundaries, ascending
+	std::vector<int> mvect_shard_peaks ;		// peaks in the core of each shard
+	float mflt_overlap ;
+	int mint_num_peaks ;
+	bool mbln_is_ims_data ;
+	int mint_lc_min_scan ;
+	int mint_lc_max_scan ;
+	int mint_ims_min_scan ;
+	int mint_ims_max_scan ;
+
+	MassShardPlan(void) ;
+	~MassShardPlan(void) ;
+
+	// Range of peaks shard shardNum loads: its core plus the overlap, within the first and last boundary
+	void GetLoadRange(int shardNum, float &loadStart, float &loadEnd) const ;
+	bool IsInCore(int shardNum, double monoMass) const ;
+
+	// [MassShardPlan] section; false if the file cannot be written, or read back into a consistent plan
+	bool WriteFile(const char *fileName) const ;
+	bool ReadFile(const char *fileName) ;
+};
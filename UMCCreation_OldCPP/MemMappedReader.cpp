@@ -1,226 +1,396 @@
-#include ".\memmappedreader.h"
-
-MemMappedReader::MemMappedReader(void)
-{
-	filebuffer = 0 ; 
-	hMemMap = 0;
-	hFile   = 0;
-	
-	//clear both buffer pointers
-	filebuffer   = 0;
-	adjustedptr  = 0;
-
-	mappedoffset = 0;
-	mappedlength = 0;
-	filebufferlength = 0;
-
-	GetSystemInfo(&info);
-	const int wanted_memory = 4 * 1024 * 1024 ; 
-	MEM_BLOCK_SIZE = ((int)(wanted_memory / info.dwAllocationGranularity)) * info.dwAllocationGranularity ; 
-
-}
-
-MemMappedReader::~MemMappedReader(void)
-{
-}
-
-bool MemMappedReader::Close()
-{
-	if(filebuffer == 0)
-		return false;
-
-	//close the view of the file
-	UnmapViewOfFile(filebuffer);
-
-	//
-	CloseHandle(hMemMap);
-	CloseHandle(this->hFile);
-
-	hMemMap = 0;
-	hFile   = 0;
-	
-	//clear both buffer pointers
-	filebuffer   = 0;
-	adjustedptr  = 0;
-
-	mappedoffset = 0;
-	mappedlength = 0;
-	filebufferlength = 0;
-
-	return TRUE;
-}
-
-bool MemMappedReader::Load(char *filename)
-{
-    HANDLE hTemp;
-
-    //try to open the specified file for read-only access
-    hTemp = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, 0,
-            OPEN_EXISTING, 0, 0); 
-
-    //if we failed to open the file, then exit now and keep the current file open
-    if(hTemp == INVALID_HANDLE_VALUE)
-        return false;
-    
-    //now close the CURRENT file, and let the new file become the current one
-    Close();
-    hFile = hTemp;
-
-    //create a file mapping which spans the entire file.
-    //This works even for the 4Gb file sizes
-    hMemMap = CreateFileMapping(hFile, 0, PAGE_READONLY, 0, 0, 0);
-    
-    filebufferlength = GetFileSize(hFile, 0);
-    currentOffset = 0 ;
-
-    mappedlength = min(filebufferlength, MEM_BLOCK_SIZE);
-    filebuffer = (char *)MapViewOfFile(hMemMap, FILE_MAP_READ, 0, 0, mappedlength);
-
-    mappedoffset = 0;
-    adjustedptr = filebuffer - mappedoffset;    
-
-	return TRUE;
-}
-
-char *MemMappedReader::get_adjusted_ptr(__int64 offset)
-{
-	if (offset % info.dwAllocationGranularity != 0)
-		throw "Specified offset is not appropriate. Its needs to be a multiple of allocation granularity" ; 
-
-	if (offset >= filebufferlength)
-	{
-		return NULL ; 
-	}
-
-	//otherwise, map in the new area
-    if(filebuffer)
-        UnmapViewOfFile(filebuffer);
-
-    mappedlength = min(filebufferlength - offset, MEM_BLOCK_SIZE);
-    filebuffer = (char *)MapViewOfFile(hMemMap, FILE_MAP_READ, 0, offset, mappedlength);
-
-    mappedoffset = offset;
-    adjustedptr = filebuffer - mappedoffset;    
-
-    return adjustedptr;
-}
-bool MemMappedReader::GetNextLine(char *buffer, int maxLength, char *stopLine, int stopLineLength)
-{
-	int numCopied = 0 ; 
-	buffer[0] = '\0' ; 
-
-	while(currentOffset < mappedoffset + mappedlength && filebuffer[currentOffset-mappedoffset] != '\n' && numCopied < maxLength)
-	{
-		buffer[numCopied++] = filebuffer[currentOffset-mappedoffset] ; 
-		currentOffset++ ; 
-	}
-	if (currentOffset >= mappedoffset + mappedlength)
-	{
-		char *source = get_adjusted_ptr(mappedoffset+mappedlength) ; 
-		if (source == NULL)
-		{
-			if(strncmp(buffer, stopLine, stopLineLength) == 0)
-			{
-				buffer[0] = '\0' ;
-				return false ; 
-			}
-			else
-			{
-				return true ; 
-			}
-		} 
-		while(currentOffset != mappedoffset + mappedlength && filebuffer[currentOffset-mappedoffset] != '\n' && numCopied < maxLength)
-		{
-			buffer[numCopied++] = filebuffer[currentOffset-mappedoffset] ; 
-			currentOffset++ ; 
-		}
-	}
-	currentOffset++ ; 
-
-	if(strncmp(buffer, stopLine, stopLineLength) == 0)
-	{
-		buffer[0] = '\0' ;
-		return false ; 
-	}
-	else
-	{
-		if (numCopied < maxLength)
-			buffer[numCopied] = '\0' ; 
-		else
-			buffer[maxLength-1] = '\0' ; 
-		return true ; 
-	}
-}
-bool MemMappedReader::SkipToAfterLine(char *startLine, char *bufferLine, int startLineLength, int maxLength)
-{
-	int numCopied = 0 ; 
-
-	while(currentOffset < filebufferlength)
-	{
-		numCopied = 0 ;
-		while(currentOffset < mappedoffset + mappedlength && filebuffer[currentOffset-mappedoffset] != '\n' && numCopied < maxLength)
-		{
-			bufferLine[numCopied++] = filebuffer[currentOffset-mappedoffset] ; 
-			currentOffset++ ; 
-		}
-		if (currentOffset >= mappedoffset + mappedlength)
-		{
-			char *source = get_adjusted_ptr(mappedoffset + mappedlength) ; 
-			if (source == NULL)
-			{
-				return false ; 
-			} 
-			while(currentOffset != mappedoffset + mappedlength && filebuffer[currentOffset-mappedoffset] != '\n' && numCopied < maxLength)
-			{
-				bufferLine[numCopied++] = filebuffer[currentOffset-mappedoffset] ; 
-				currentOffset++ ; 
-			}
-		}
-		currentOffset++ ; 
-
-		if(strncmp(bufferLine, startLine, startLineLength) == 0)
-		{
-			return true ; 
-		}
-	}
-	return false ; 
-}
-
-bool MemMappedReader::SkipToAfterLine(char *startLine, int startLineLength)
-{
-	int numCopied = 0 ; 
-	const int maxLength = 1024 ;
-	char buffer[maxLength] ; 
-
-	while(currentOffset < filebufferlength)
-	{
-		numCopied = 0 ; 
-		while(currentOffset < mappedoffset + mappedlength && filebuffer[currentOffset-mappedoffset] != '\n' && numCopied < maxLength)
-		{
-			buffer[numCopied++] = filebuffer[currentOffset-mappedoffset] ; 
-			currentOffset++ ; 
-		}
-		if (currentOffset >= mappedoffset + mappedlength)
-		{
-			char *source = get_adjusted_ptr(mappedoffset+mappedlength) ; 
-			if (source == NULL)
-			{
-				return false ; 
-			} 
-			while(currentOffset != mappedoffset + mappedlength && filebuffer[currentOffset-mappedoffset] != '\n' && numCopied < maxLength)
-			{
-				buffer[numCopied++] = filebuffer[currentOffset-mappedoffset] ; 
-				currentOffset++ ; 
-			}
-		}
-		currentOffset++ ; 
-
-		if(strncmp(buffer, startLine, startLineLength) == 0)
-		{
-			return true ; 
-		}
-	}
-	return false ; 
-}
-
-
+#include "MemMappedReader.h"
+#include "StreamDecompressor.h"
+#include <string.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MemMappedReader::MemMappedReader(void)
+{
+	filebuffer = 0 ; 
+#ifdef _WIN32
+	hMemMap = 0;
+	hFile   = 0;
+#else
+	fd = -1 ; 
+#endif
+	
+	//clear both buffer pointers
+	filebuffer   = 0;
+	adjustedptr  = 0;
+
+	mappedoffset = 0;
+	mappedlength = 0;
+	filebufferlength = 0;
+	inputlength = 0 ; 
+	currentOffset = 0 ; 
+	decompressor = 0 ; 
+	inputposition = 0 ; 
+
+#ifdef _WIN32
+	SYSTEM_INFO info ; 
+	GetSystemInfo(&info);
+	allocationGranularity = (int) info.dwAllocationGranularity ; 
+#else
+	allocationGranularity = (int) sysconf(_SC_PAGESIZE) ; 
+#endif
+	const int wanted_memory = 4 * 1024 * 1024 ; 
+	MEM_BLOCK_SIZE = ((int)(wanted_memory / allocationGranularity)) * allocationGranularity ; 
+
+}
+
+MemMappedReader::~MemMappedReader(void)
+{
+	Close() ; 
+}
+
+void MemMappedReader::unmap_view()
+{
+	if (filebuffer == 0)
+		return ; 
+	// the view of a compressed file is a block owned by the decompressor
+	if (decompressor != 0)
+	{
+		filebuffer = 0 ; 
+		return ; 
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(filebuffer);
+#else
+	munmap(filebuffer, (size_t) mappedlength) ; 
+#endif
+	filebuffer = 0 ; 
+}
+
+char *MemMappedReader::map_view(__int64 offset, __int64 length)
+{
+#ifdef _WIN32
+	return (char *)MapViewOfFile(hMemMap, FILE_MAP_READ, (DWORD) (offset >> 32), (DWORD) (offset & 0xFFFFFFFF), (SIZE_T) length);
+#else
+	void *view = mmap(0, (size_t) length, PROT_READ, MAP_PRIVATE, fd, (off_t) offset) ; 
+	if (view == MAP_FAILED)
+		return 0 ; 
+	// lines are read front to back
+	madvise(view, (size_t) length, MADV_SEQUENTIAL) ; 
+	return (char *) view ; 
+#endif
+}
+
+bool MemMappedReader::Close()
+{
+#ifdef _WIN32
+	if(hFile == 0)
+		return false;
+
+	//close the view of the file
+	unmap_view();
+
+	//
+	if (hMemMap != 0)
+		CloseHandle(hMemMap);
+	CloseHandle(this->hFile);
+
+	hMemMap = 0;
+	hFile   = 0;
+#else
+	if (fd < 0)
+		return false ; 
+
+	unmap_view() ; 
+	close(fd) ; 
+	fd = -1 ; 
+#endif
+	if (decompressor != 0)
+	{
+		delete decompressor ; 
+		decompressor = 0 ; 
+	}
+	
+	//clear both buffer pointers
+	filebuffer   = 0;
+	adjustedptr  = 0;
+
+	mappedoffset = 0;
+	mappedlength = 0;
+	filebufferlength = 0;
+	inputlength = 0 ; 
+	currentOffset = 0 ; 
+	inputposition = 0 ; 
+
+	return true;
+}
+
+bool MemMappedReader::Load(char *filename)
+{
+#ifdef _WIN32
+    HANDLE hTemp;
+
+    //try to open the specified file for read-only access
+    hTemp = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, 0,
+            OPEN_EXISTING, 0, 0); 
+
+    //if we failed to open the file, then exit now and keep the current file open
+    if(hTemp == INVALID_HANDLE_VALUE)
+        return false;
+    
+    //now close the CURRENT file, and let the new file become the current one
+    Close();
+    hFile = hTemp;
+
+    //create a file mapping which spans the entire file.
+    //This works even for the 4Gb file sizes
+    hMemMap = CreateFileMapping(hFile, 0, PAGE_READONLY, 0, 0, 0);
+    
+	LARGE_INTEGER fileSize ; 
+	GetFileSizeEx(hFile, &fileSize) ; 
+    filebufferlength = fileSize.QuadPart ;
+#else
+	int fdTemp = open(filename, O_RDONLY) ; 
+	if (fdTemp < 0)
+		return false ; 
+
+	struct stat fileStat ; 
+	if (fstat(fdTemp, &fileStat) != 0)
+	{
+		close(fdTemp) ; 
+		return false ; 
+	}
+
+	Close() ; 
+	fd = fdTemp ; 
+	filebufferlength = (__int64) fileStat.st_size ; 
+#endif
+    currentOffset = 0 ;
+	inputlength = filebufferlength ; 
+
+	// an empty file has nothing to map; eof() is already true
+	if (filebufferlength == 0)
+		return true ; 
+
+    mappedlength = filebufferlength < MEM_BLOCK_SIZE ? filebufferlength : MEM_BLOCK_SIZE ;
+    filebuffer = map_view(0, mappedlength);
+	if (filebuffer == 0)
+	{
+		mappedlength = 0 ; 
+		Close() ; 
+		return false ; 
+	}
+
+    mappedoffset = 0;
+    adjustedptr = filebuffer - mappedoffset;    
+
+	CompressionFormat format = StreamDecompressor::DetectFormat(filebuffer, mappedlength) ; 
+	if (format != COMPRESSION_NONE)
+	{
+		// the decoded blocks take the place of the views; the decoded length is known once the last one is in
+		unmap_view() ; 
+		decompressor = new StreamDecompressor() ; 
+		if (!decompressor->Open(filename, format))
+		{
+			Close() ; 
+			return false ; 
+		}
+		mappedlength = 0 ; 
+		filebufferlength = 0x7FFFFFFFFFFFFFFFLL ; 
+	}
+
+	return true;
+}
+
+char *MemMappedReader::next_decoded_block()
+{
+	char *data ; 
+	__int64 length ; 
+	__int64 position ; 
+	if (!decompressor->NextBlock(data, length, position))
+	{
+		filebufferlength = mappedoffset + mappedlength ; 
+		return NULL ; 
+	}
+
+	filebuffer = data ; 
+	mappedoffset += mappedlength ; 
+	mappedlength = length ; 
+	inputposition = position ; 
+	adjustedptr = filebuffer - mappedoffset ; 
+	return adjustedptr ; 
+}
+
+char *MemMappedReader::get_adjusted_ptr(__int64 offset)
+{
+	// compressed files are decoded front to back, and the readers only ask for the block after the current one
+	if (decompressor != 0)
+		return offset == mappedoffset + mappedlength ? next_decoded_block() : NULL ; 
+
+	if (offset % allocationGranularity != 0)
+		throw "Specified offset is not appropriate. Its needs to be a multiple of allocation granularity" ; 
+
+	if (offset >= filebufferlength)
+	{
+		return NULL ; 
+	}
+
+	//otherwise, map in the new area
+	unmap_view();
+
+    mappedlength = filebufferlength - offset < MEM_BLOCK_SIZE ? filebufferlength - offset : MEM_BLOCK_SIZE ;
+    filebuffer = map_view(offset, mappedlength);
+	if (filebuffer == 0)
+		return NULL ; 
+
+    mappedoffset = offset;
+    adjustedptr = filebuffer - mappedoffset;    
+
+    return adjustedptr;
+}
+bool MemMappedReader::SeekTo(__int64 offset)
+{
+	if (decompressor != 0)
+	{
+		if (offset < currentOffset || offset >= mappedoffset + mappedlength)
+			return false ; 
+		currentOffset = offset ; 
+		return true ; 
+	}
+	if (offset >= filebufferlength)
+	{
+		currentOffset = filebufferlength ; 
+		return false ; 
+	}
+	if (filebuffer == 0 || offset < mappedoffset || offset >= mappedoffset + mappedlength)
+	{
+		if (get_adjusted_ptr(offset - offset % allocationGranularity) == NULL)
+			return false ; 
+	}
+	currentOffset = offset ; 
+	return true ; 
+}
+
+bool MemMappedReader::GetNextLine(char *buffer, int maxLength, char *stopLine, int stopLineLength)
+{
+	int numCopied = 0 ; 
+	buffer[0] = '\0' ; 
+
+	while(currentOffset < mappedoffset + mappedlength && filebuffer[currentOffset-mappedoffset] != '\n' && numCopied < maxLength)
+	{
+		buffer[numCopied++] = filebuffer[currentOffset-mappedoffset] ; 
+		currentOffset++ ; 
+	}
+	if (currentOffset >= mappedoffset + mappedlength)
+	{
+		char *source = get_adjusted_ptr(mappedoffset+mappedlength) ; 
+		if (source == NULL)
+		{
+			// the end of a compressed file only shows once its last block is used up, after the last line
+			if (decompressor != 0 && numCopied == 0)
+				return false ; 
+			if(strncmp(buffer, stopLine, stopLineLength) == 0)
+			{
+				buffer[0] = '\0' ;
+				return false ; 
+			}
+			else
+			{
+				return true ; 
+			}
+		} 
+		while(currentOffset != mappedoffset + mappedlength && filebuffer[currentOffset-mappedoffset] != '\n' && numCopied < maxLength)
+		{
+			buffer[numCopied++] = filebuffer[currentOffset-mappedoffset] ; 
+			currentOffset++ ; 
+		}
+	}
+	currentOffset++ ; 
+
+	if(strncmp(buffer, stopLine, stopLineLength) == 0)
+	{
+		buffer[0] = '\0' ;
+		return false ; 
+	}
+	else
+	{
+		if (numCopied < maxLength)
+			buffer[numCopied] = '\0' ; 
+		else
+			buffer[maxLength-1] = '\0' ; 
+		return true ; 
+	}
+}
+bool MemMappedReader::SkipToAfterLine(char *startLine, char *bufferLine, int startLineLength, int maxLength)
+{
+	int numCopied = 0 ; 
+
+	while(currentOffset < filebufferlength)
+	{
+		numCopied = 0 ;
+		while(currentOffset < mappedoffset + mappedlength && filebuffer[currentOffset-mappedoffset] != '\n' && numCopied < maxLength)
+		{
+			bufferLine[numCopied++] = filebuffer[currentOffset-mappedoffset] ; 
+			currentOffset++ ; 
+		}
+		if (currentOffset >= mappedoffset + mappedlength)
+		{
+			char *source = get_adjusted_ptr(mappedoffset + mappedlength) ; 
+			if (source == NULL)
+			{
+				return false ; 
+			} 
+			while(currentOffset != mappedoffset + mappedlength && filebuffer[currentOffset-mappedoffset] != '\n' && numCopied < maxLength)
+			{
+				bufferLine[numCopied++] = filebuffer[currentOffset-mappedoffset] ; 
+				currentOffset++ ; 
+			}
+		}
+		currentOffset++ ; 
+		// the callers read the line as a string
+		bufferLine[numCopied < maxLength ? numCopied : maxLength - 1] = '\0' ; 
+
+		if(strncmp(bufferLine, startLine, startLineLength) == 0)
+		{
+			return true ; 
+		}
+	}
+	return false ; 
+}
+
+bool MemMappedReader::SkipToAfterLine(char *startLine, int startLineLength)
+{
+	int numCopied = 0 ; 
+	const int maxLength = 1024 ;
+	char buffer[maxLength] ; 
+
+	while(currentOffset < filebufferlength)
+	{
+		numCopied = 0 ; 
+		while(currentOffset < mappedoffset + mappedlength && filebuffer[currentOffset-mappedoffset] != '\n' && numCopied < maxLength)
+		{
+			buffer[numCopied++] = filebuffer[currentOffset-mappedoffset] ; 
+			currentOffset++ ; 
+		}
+		if (currentOffset >= mappedoffset + mappedlength)
+		{
+			char *source = get_adjusted_ptr(mappedoffset+mappedlength) ; 
+			if (source == NULL)
+			{
+				return false ; 
+			} 
+			while(currentOffset != mappedoffset + mappedlength && filebuffer[currentOffset-mappedoffset] != '\n' && numCopied < maxLength)
+			{
+				buffer[numCopied++] = filebuffer[currentOffset-mappedoffset] ; 
+				currentOffset++ ; 
+			}
+		}
+		currentOffset++ ; 
+
+		if(strncmp(buffer, startLine, startLineLength) == 0)
+		{
+			return true ; 
+		}
+	}
+	return false ; 
+}
+
+
@@ -1,50 +1,79 @@
-#pragma once
-#include "Windows.h"
-
-class MemMappedReader
-{
-public:
-    MemMappedReader();
-    ~MemMappedReader();
-    bool Load(char *filename);
-    bool Close();
-
-    __int64 size();
-    bool MoveToLine(char *startLine, __int64 offset, __int64 length);
-	bool GetNextLine(char *buffer, int maxLength, char *stopLine, int stopLineLength) ; 
-	bool SkipToAfterLine(char *startLine, char *buffer, int startLineLength, int maxLength) ; 
-	bool SkipToAfterLine(char *startLine, int startLineLength) ; 
-	__int64 FileLength() { return filebufferlength ; } 
-	inline __int64 CurrentPosition() { return currentOffset ; } ; 
-	bool eof() { return currentOffset >= filebufferlength ; }
-private:
-    char *get_adjusted_ptr(__int64 offset);
-	SYSTEM_INFO info ; 
-
-    // private implementation details
-
-    HANDLE hMemMap;            //memory mapped object
-    HANDLE hFile;              //handle to current file
-    __int64 filebufferlength;   //size in bytes of the entire file
-    char *filebuffer;          //base of the view of the file
-    char *adjustedptr;         //an adjusted version of the filebuffer pointer
-    __int64 mappedoffset;       //offset of the current view within the memmap object
-    __int64 mappedlength;       //length of the view
-	__int64 currentOffset ; // current offset.
-	int MEM_BLOCK_SIZE ; 
-//	static const int MEM_BLOCK_SIZE = 4 * 1024 * 1024 ; 
-
-	__int64 inline calc_index_base(__int64 index)
-	{
-		if(index < MEM_BLOCK_SIZE / 2)
-		{
-			return 0;
-		}
-		else
-		{
-			return ((index + MEM_BLOCK_SIZE / 4) & 
-				(~(MEM_BLOCK_SIZE / 2 - 1))) - MEM_BLOCK_SIZE / 2;
-		}
-	}
-
-};
+#pragma once
+#ifdef _WIN32
+#include "Windows.h"
+#else
+// __int64 is a Microsoft keyword; give the other compilers the same 64 bit type
+typedef long long __int64 ;
+#endif
+
+class StreamDecompressor ;
+
+/*
+ * Reads a text file front to back through a sliding memory mapped view.
+ * A gzip or zstd file is recognized from its first bytes and read through a StreamDecompressor instead; the
+ * views are then its decoded blocks, CurrentPosition counts decoded bytes and only forward reads are possible.
+ */
+class MemMappedReader
+{
+public:
+    MemMappedReader();
+    ~MemMappedReader();
+    bool Load(char *filename);
+    bool Close();
+
+    __int64 size();
+    bool MoveToLine(char *startLine, __int64 offset, __int64 length);
+	bool GetNextLine(char *buffer, int maxLength, char *stopLine, int stopLineLength) ; 
+	bool SkipToAfterLine(char *startLine, char *buffer, int startLineLength, int maxLength) ; 
+	bool SkipToAfterLine(char *startLine, int startLineLength) ; 
+	// Size of the file on disk
+	__int64 FileLength() { return inputlength ; } 
+	inline __int64 CurrentPosition() { return currentOffset ; } ; 
+	// Bytes of the file on disk read so far, for progress against FileLength; CurrentPosition unless compressed
+	__int64 InputPosition() { return decompressor == 0 ? currentOffset : inputposition ; } 
+	bool IsCompressed() { return decompressor != 0 ; } 
+	bool eof() { return currentOffset >= filebufferlength ; }
+	// Positions the reader at any byte offset, mapping the view that contains it; a compressed file can
+	// only move forward within the current block
+	bool SeekTo(__int64 offset) ; 
+private:
+    char *get_adjusted_ptr(__int64 offset);
+	char *next_decoded_block() ; 
+	void unmap_view() ; 
+	char *map_view(__int64 offset, __int64 length) ; 
+	int allocationGranularity ; //views must start at a multiple of this
+
+    // private implementation details
+
+#ifdef _WIN32
+    HANDLE hMemMap;            //memory mapped object
+    HANDLE hFile;              //handle to current file
+#else
+	int fd ;                   //descriptor of the current file
+#endif
+    __int64 filebufferlength;   //size in bytes of the entire file (decoded; unknown until the end of a compressed file)
+    __int64 inputlength;        //size in bytes of the file on disk
+    char *filebuffer;          //base of the view of the file
+    char *adjustedptr;         //an adjusted version of the filebuffer pointer
+    __int64 mappedoffset;       //offset of the current view within the memmap object
+    __int64 mappedlength;       //length of the view
+	__int64 currentOffset ; // current offset.
+	StreamDecompressor *decompressor ; //decodes a compressed file, otherwise 0
+	__int64 inputposition ;     //compressed bytes up to the end of the current block
+	int MEM_BLOCK_SIZE ; 
+//	static const int MEM_BLOCK_SIZE = 4 * 1024 * 1024 ; 
+
+	__int64 inline calc_index_base(__int64 index)
+	{
+		if(index < MEM_BLOCK_SIZE / 2)
+		{
+			return 0;
+		}
+		else
+		{
+			return ((index + MEM_BLOCK_SIZE / 4) & 
+				(~(MEM_BLOCK_SIZE / 2 - 1))) - MEM_BLOCK_SIZE / 2;
+		}
+	}
+
+};
@@ -0,0 +1,377 @@
+// OutputFileWriter.cpp : plain or block compressed output files, compressed on threads of their own.
+// Native only (uses <thread> through BoundedQueue); the header can be included by /clr code.
+
+#include "OutputFileWriter.h"
+#include "BoundedQueue.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#ifdef UMCCREATOR_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef UMCCREATOR_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define vsnprintf _vsnprintf
+#endif
+
+namespace
+{
+	// text compressed as one gzip member / zstd frame; large enough that the per block header and the
+	// history lost at block boundaries cost little in ratio
+	const int OUTPUT_BLOCK_BYTES = 1024 * 1024 ;
+}
+
+struct OutputBlock
+{
+	std::vector<char> mvect_text ;
+	size_t mint_text_length ;
+	std::vector<char> mvect_compressed ;
+	size_t mint_compressed_length ;
+	bool mbln_compressed ;		// set by the worker, under mobj_mutex
+	bool mbln_failed ;
+} ;
+
+struct OutputFileWriterState
+{
+	FILE *mobj_file ;
+	CompressionFormat menm_format ;
+	int mint_level ;
+	std::vector<OutputBlock*> mvect_blocks ;
+	OutputBlock *mobj_current ;		// the block the caller is filling
+	BoundedQueue<OutputBlock*> mobj_free ;
+	BoundedQueue<OutputBlock*> mobj_to_compress ;
+	// the same blocks in the order they were filled, for the thread writing them out
+	BoundedQueue<OutputBlock*> mobj_to_write ;
+	std::mutex mobj_mutex ;
+	std::condition_variable mobj_compressed ;
+	std::vector<std::thread> mvect_workers ;
+	std::thread mobj_writer ;
+	long long mlng_bytes_written ;
+	bool mbln_failed ;		// a block could not be compressed or written; set by the writer thread
+
+	OutputFileWriterState(int numBlocks) : mobj_free(numBlocks), mobj_to_compress(numBlocks), mobj_to_write(numBlocks)
+	{
+		mobj_file = NULL ;
+		menm_format = COMPRESSION_NONE ;
+		mint_level = 0 ;
+		mobj_current = NULL ;
+		mlng_bytes_written = 0 ;
+		mbln_failed = false ;
+	}
+} ;
+
+namespace
+{
+#ifdef UMCCREATOR_HAVE_ZLIB
+	struct GzipEncoder
+	{
+		z_stream mobj_stream ;
+		bool mbln_ready ;
+		GzipEncoder(int level)
+		{
+			memset(&mobj_stream, 0, sizeof(mobj_stream)) ;
+			// 15 + 16: largest window with a gzip header and trailer, so every block is a complete gzip member
+			mbln_ready = deflateInit2(&mobj_stream, level > 0 ? level : Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8,
+				Z_DEFAULT_STRATEGY) == Z_OK ;
+		}
+		~GzipEncoder() { if (mbln_ready) deflateEnd(&mobj_stream) ; }
+
+		bool Compress(OutputBlock &block)
+		{
+			if (!mbln_ready || deflateReset(&mobj_stream) != Z_OK)
+				return false ;
+			block.mvect_compressed.resize(deflateBound(&mobj_stream, (uLong) block.mint_text_length)) ;
+			mobj_stream.next_in = (Bytef *) &block.mvect_text[0] ;
+			mobj_stream.avail_in = (uInt) block.mint_text_length ;
+			mobj_stream.next_out = (Bytef *) &block.mvect_compressed[0] ;
+			mobj_stream.avail_out = (uInt) block.mvect_compressed.size() ;
+			if (deflate(&mobj_stream, Z_FINISH) != Z_STREAM_END)
+				return false ;
+			block.mint_compressed_length = block.mvect_compressed.size() - mobj_stream.avail_out ;
+			return true ;
+		}
+	} ;
+#endif
+
+#ifdef UMCCREATOR_HAVE_ZSTD
+	struct ZstdEncoder
+	{
+		ZSTD_CCtx *mobj_context ;
+		int mint_level ;
+		ZstdEncoder(int level)
+		{
+			mobj_context = ZSTD_createCCtx() ;
+			// 0 is the default level of zstd
+			mint_level = level ;
+		}
+		~ZstdEncoder() { ZSTD_freeCCtx(mobj_context) ; }
+
+		bool Compress(OutputBlock &block)
+		{
+			if (mobj_context == NULL)
+				return false ;
+			block.mvect_compressed.resize(ZSTD_compressBound(block.mint_text_length)) ;
+			size_t length = ZSTD_compressCCtx(mobj_context, &block.mvect_compressed[0], block.mvect_compressed.size(),
+				&block.mvect_text[0], block.mint_text_length, mint_level) ;
+			if (ZSTD_isError(length))
+				return false ;
+			block.mint_compressed_length = length ;
+			return true ;
+		}
+	} ;
+#endif
+
+	void CompressBlocks(OutputFileWriterState *state)
+	{
+#ifdef UMCCREATOR_HAVE_ZLIB
+		GzipEncoder gzip(state->mint_level) ;
+#endif
+#ifdef UMCCREATOR_HAVE_ZSTD
+		ZstdEncoder zstd(state->mint_level) ;
+#endif
+		OutputBlock *block ;
+		while (state->mobj_to_compress.Pop(block))
+		{
+			bool success = false ;
+#ifdef UMCCREATOR_HAVE_ZLIB
+			if (state->menm_format == COMPRESSION_GZIP)
+				success = gzip.Compress(*block) ;
+#endif
+#ifdef UMCCREATOR_HAVE_ZSTD
+			if (state->menm_format == COMPRESSION_ZSTD)
+				success = zstd.Compress(*block) ;
+#endif
+			std::lock_guard<std::mutex> lock(state->mobj_mutex) ;
+			block->mbln_failed = !success ;
+			block->mbln_compressed = true ;
+			state->mobj_compressed.notify_all() ;
+		}
+	}
+
+	void WriteBlocks(OutputFileWriterState *state)
+	{
+		OutputBlock *block ;
+		while (state->mobj_to_write.Pop(block))
+		{
+			{
+				std::unique_lock<std::mutex> lock(state->mobj_mutex) ;
+				while (!block->mbln_compressed)
+					state->mobj_compressed.wait(lock) ;
+			}
+			if (block->mbln_failed || fwrite(&block->mvect_compressed[0], 1, block->mint_compressed_length, state->mobj_file)
+				!= block->mint_compressed_length)
+				state->mbln_failed = true ;
+			else
+				state->mlng_bytes_written += (long long) block->mint_compressed_length ;
+			block->mint_text_length = 0 ;
+			state->mobj_free.Push(block) ;
+		}
+	}
+}
+
+OutputFileWriter::OutputFileWriter(void)
+{
+	mobj_state = NULL ;
+	mlng_bytes_written = 0 ;
+}
+
+OutputFileWriter::~OutputFileWriter(void)
+{
+	Close() ;
+}
+
+bool OutputFileWriter::IsSupported(CompressionFormat format)
+{
+#ifdef UMCCREATOR_HAVE_ZLIB
+	if (format == COMPRESSION_GZIP)
+		return true ;
+#endif
+#ifdef UMCCREATOR_HAVE_ZSTD
+	if (format == COMPRESSION_ZSTD)
+		return true ;
+#endif
+	return format == COMPRESSION_NONE ;
+}
+
+bool OutputFileWriter::Open(const char *fileName, CompressionFormat format, int level, int numThreads)
+{
+	Close() ;
+	mlng_bytes_written = 0 ;
+	if (!IsSupported(format))
+		return false ;
+
+	// plain output keeps the text mode line endings the files always had
+	FILE *file = fopen(fileName, format == COMPRESSION_NONE ? "w" : "wb") ;
+	if (file == NULL)
+		return false ;
+
+	if (numThreads <= 0)
+		numThreads = (int) std::thread::hardware_concurrency() ;
+	if (numThreads <= 0)
+		numThreads = 1 ;
+	// enough blocks for every worker to have one while the caller fills the next and the writer writes another
+	int numBlocks = format == COMPRESSION_NONE ? 0 : numThreads + 2 ;
+
+	mobj_state = new OutputFileWriterState(numBlocks > 0 ? numBlocks : 1) ;
+	mobj_state->mobj_file = file ;
+	mobj_state->menm_format = format ;
+	mobj_state->mint_level = level ;
+	if (format == COMPRESSION_NONE)
+		return true ;
+
+	for (int blockNum = 0 ; blockNum < numBlocks ; blockNum++)
+	{
+		OutputBlock *block = new OutputBlock() ;
+		block->mvect_text.resize(OUTPUT_BLOCK_BYTES) ;
+		block->mint_text_length = 0 ;
+		block->mint_compressed_length = 0 ;
+		block->mbln_compressed = false ;
+		block->mbln_failed = false ;
+		mobj_state->mvect_blocks.push_back(block) ;
+		if (blockNum > 0)
+			mobj_state->mobj_free.Push(block) ;
+	}
+	mobj_state->mobj_current = mobj_state->mvect_blocks[0] ;
+	for (int threadNum = 0 ; threadNum < numThreads ; threadNum++)
+		mobj_state->mvect_workers.push_back(std::thread(CompressBlocks, mobj_state)) ;
+	mobj_state->mobj_writer = std::thread(WriteBlocks, mobj_state) ;
+	return true ;
+}
+
+void OutputFileWriter::QueueBlock(OutputBlock *block)
+{
+	// a block coming back from the writer still has the flags of its last use
+	{
+		std::lock_guard<std::mutex> lock(mobj_state->mobj_mutex) ;
+		block->mbln_compressed = false ;
+		block->mbln_failed = false ;
+	}
+	mobj_state->mobj_to_write.Push(block) ;
+	mobj_state->mobj_to_compress.Push(block) ;
+}
+
+void OutputFileWriter::SubmitBlock()
+{
+	QueueBlock(mobj_state->mobj_current) ;
+	// waits while every block is being compressed or written
+	mobj_state->mobj_free.Pop(mobj_state->mobj_current) ;
+}
+
+void OutputFileWriter::Write(const char *data, size_t length)
+{
+	if (mobj_state == NULL)
+		return ;
+	if (mobj_state->menm_format == COMPRESSION_NONE)
+	{
+		fwrite(data, 1, length, mobj_state->mobj_file) ;
+		return ;
+	}
+
+	while (length > 0)
+	{
+		OutputBlock *block = mobj_state->mobj_current ;
+		size_t available = block->mvect_text.size() - block->mint_text_length ;
+		size_t numCopied = length < available ? length : available ;
+		memcpy(&block->mvect_text[block->mint_text_length], data, numCopied) ;
+		block->mint_text_length += numCopied ;
+		data += numCopied ;
+		length -= numCopied ;
+		if (block->mint_text_length == block->mvect_text.size())
+			SubmitBlock() ;
+	}
+}
+
+void OutputFileWriter::Printf(const char *format, ...)
+{
+	if (mobj_state == NULL)
+		return ;
+
+	va_list args ;
+	if (mobj_state->menm_format == COMPRESSION_NONE)
+	{
+		va_start(args, format) ;
+		vfprintf(mobj_state->mobj_file, format, args) ;
+		va_end(args) ;
+		return ;
+	}
+
+	// formatted straight into the block; text that does not fit what is left of it goes at the start of the next one
+	for (int attempt = 0 ; attempt < 2 ; attempt++)
+	{
+		OutputBlock *block = mobj_state->mobj_current ;
+		size_t available = block->mvect_text.size() - block->mint_text_length ;
+		va_start(args, format) ;
+		int length = vsnprintf(&block->mvect_text[block->mint_text_length], available, format, args) ;
+		va_end(args) ;
+		if (length >= 0 && (size_t) length < available)
+		{
+			block->mint_text_length += (size_t) length ;
+			return ;
+		}
+		if (block->mint_text_length == 0)
+			break ;
+		SubmitBlock() ;
+	}
+
+	// longer than a whole block
+	std::vector<char> text(2 * OUTPUT_BLOCK_BYTES) ;
+	while (true)
+	{
+		va_start(args, format) ;
+		int length = vsnprintf(&text[0], text.size(), format, args) ;
+		va_end(args) ;
+		if (length >= 0 && (size_t) length < text.size())
+		{
+			Write(&text[0], (size_t) length) ;
+			return ;
+		}
+		text.resize(length >= 0 ? (size_t) length + 1 : 2 * text.size()) ;
+	}
+}
+
+bool OutputFileWriter::Close()
+{
+	if (mobj_state == NULL)
+		return true ;
+
+	bool success = true ;
+	if (mobj_state->menm_format != COMPRESSION_NONE)
+	{
+		OutputBlock *block = mobj_state->mobj_current ;
+		if (block->mint_text_length > 0)
+			QueueBlock(block) ;
+		// the workers and the writer finish what was queued before they see the queues closed
+		mobj_state->mobj_to_compress.Close() ;
+		for (int threadNum = 0 ; threadNum < (int) mobj_state->mvect_workers.size() ; threadNum++)
+			mobj_state->mvect_workers[threadNum].join() ;
+		mobj_state->mobj_to_write.Close() ;
+		mobj_state->mobj_writer.join() ;
+		success = !mobj_state->mbln_failed ;
+	}
+	else
+	{
+		fflush(mobj_state->mobj_file) ;
+		mobj_state->mlng_bytes_written = ftell(mobj_state->mobj_file) ;
+		success = ferror(mobj_state->mobj_file) == 0 ;
+	}
+	if (fclose(mobj_state->mobj_file) != 0)
+		success = false ;
+
+	long long bytesWritten = mobj_state->mlng_bytes_written ;
+	for (int blockNum = 0 ; blockNum < (int) mobj_state->mvect_blocks.size() ; blockNum++)
+		delete mobj_state->mvect_blocks[blockNum] ;
+	delete mobj_state ;
+	mobj_state = NULL ;
+	mlng_bytes_written = bytesWritten ;
+	return success ;
+}
+
+long long OutputFileWriter::GetBytesWritten()
+{
+	return mlng_bytes_written ;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "CompressionFormat.h"
+#include <stddef.h>
+
+struct OutputFileWriterState ;
+struct OutputBlock ;
+
+/*
+ * Text output file of the feature finder, plain or gzip / zstd compressed.
+ * Plain output goes straight to the file. Compressed output is collected in 1 MB blocks that worker threads
+ * compress while the caller goes on formatting; the blocks are written in order, each as a gzip member or zstd
+ * frame of its own, which gzip -dc, zstdcat and MemMappedReader read back as one stream.
+ * The header can be included by /clr code; the threads live in OutputFileWriter.cpp.
+ */
+class OutputFileWriter
+{
+	OutputFileWriterState *mobj_state ;
+	long long mlng_bytes_written ;
+
+	OutputFileWriter(const OutputFileWriter &) ;
+	OutputFileWriter & operator=(const OutputFileWriter &) ;
+
+	void QueueBlock(OutputBlock *block) ;
+	void SubmitBlock() ;
+
+public:
+	OutputFileWriter(void) ;
+	~OutputFileWriter(void) ;
+
+	static bool IsSupported(CompressionFormat format) ;
+
+	// level 0 takes the default of the codec and numThreads 0 one thread per core; false if the file cannot be
+	// created or the format is not supported by this build
+	bool Open(const char *fileName, CompressionFormat format = COMPRESSION_NONE, int level = 0, int numThreads = 0) ;
+	void Write(const char *data, size_t length) ;
+	void Printf(const char *format, ...) ;
+	// Writes what is left and closes the file; false if any of the output could not be compressed or written
+	bool Close() ;
+	// Bytes in the file on disk, once it is closed
+	long long GetBytesWritten() ;
+};
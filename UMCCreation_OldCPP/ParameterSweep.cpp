@@ -0,0 +1,152 @@
+// ParameterSweep.cpp : clusters one loaded dataset under many option sets on a WorkStealingPool.
+// Native only (WorkStealingPool uses <thread>); the header can be included by /clr code.
+
+#include "ParameterSweep.h"
+#include "WorkStealingPool.h"
+#include "IniReader.h"
+#include "ProcessStats.h"
+#include <stdio.h>
+#include <string.h>
+#include <exception>
+
+ParameterSweep::ParameterSweep(const FeatureFinderOptions &options, int numThreads)
+{
+	mobj_options = options ;
+	mint_num_threads = numThreads > 0 ? numThreads : WorkStealingPool::GetHardwareThreads() ;
+	mint_num_peaks = 0 ;
+	mobj_parent_telemetry = NULL ;
+}
+
+ParameterSweep::~ParameterSweep(void)
+{
+}
+
+void ParameterSweep::AddSetting(float monoMassConstraint, float maxDistance, float netWeight, float logAbundanceWeight)
+{
+	SweepSetting setting ;
+	setting.mflt_mono_mass_constraint = monoMassConstraint ;
+	setting.mflt_max_distance = maxDistance ;
+	setting.mflt_net_weight = netWeight ;
+	setting.mflt_log_abundance_weight = logAbundanceWeight ;
+	setting.mint_num_umcs = 0 ;
+	setting.mdbl_seconds = 0 ;
+	setting.mbln_success = false ;
+	mvect_settings.push_back(setting) ;
+}
+
+bool ParameterSweep::LoadFromIniFile(const char *iniFileName, std::vector<std::string> &errors)
+{
+	CIniReader iniReader(iniFileName) ;
+	if (!iniReader.IsLoaded())
+		return false ;
+
+	std::vector<float> monoMassConstraints(1, mobj_options.mflt_mono_mass_constraint) ;
+	std::vector<float> maxDistances(1, mobj_options.mflt_max_distance) ;
+	std::vector<float> netWeights(1, mobj_options.mflt_net_weight) ;
+	std::vector<float> logAbundanceWeights(1, mobj_options.mflt_log_abundance_weight) ;
+
+	iniReader.ReadFloatList("ParameterSweep", "MonoMassConstraint", monoMassConstraints) ;
+	iniReader.ReadFloatList("ParameterSweep", "MaxDistance", maxDistances) ;
+	iniReader.ReadFloatList("ParameterSweep", "NETWeight", netWeights) ;
+	iniReader.ReadFloatList("ParameterSweep", "LogAbundanceWeight", logAbundanceWeights) ;
+	errors.insert(errors.end(), iniReader.GetErrors().begin(), iniReader.GetErrors().end()) ;
+
+	for (int massNum = 0 ; massNum < (int) monoMassConstraints.size() ; massNum++)
+		for (int distanceNum = 0 ; distanceNum < (int) maxDistances.size() ; distanceNum++)
+			for (int netNum = 0 ; netNum < (int) netWeights.size() ; netNum++)
+				for (int abundanceNum = 0 ; abundanceNum < (int) logAbundanceWeights.size() ; abundanceNum++)
+					AddSetting(monoMassConstraints[massNum], maxDistances[distanceNum], netWeights[netNum], logAbundanceWeights[abundanceNum]) ;
+	return true ;
+}
+
+int ParameterSweep::Run()
+{
+	WorkStealingPool pool(mint_num_threads) ;
+
+	// load and sort once; both stay read-only while the settings run
+	UMCCreator loader ;
+	loader.GetTelemetry().SetParent(mobj_parent_telemetry) ;
+	mobj_options.ApplyTo(loader) ;
+	mint_num_peaks = loader.ReadCSVFileParallel(pool, pool.GetNumThreads()) ;
+	std::vector<IsotopePeak> sortedPeaks ;
+	loader.SortPeaksForClustering(sortedPeaks) ;
+
+	char baseFileName[1024] ;
+	mobj_options.GetBaseFileName(baseFileName, sizeof(baseFileName)) ;
+
+	std::vector<std::function<void()> > tasks ;
+	for (int settingNum = 0 ; settingNum < (int) mvect_settings.size() ; settingNum++)
+	{
+		tasks.push_back([this, settingNum, &loader, &sortedPeaks, &baseFileName]()
+		{
+			SweepSetting &setting = mvect_settings[settingNum] ;
+			double startTime = GetWallClockSeconds() ;
+			try
+			{
+				FeatureFinderOptions options = mobj_options ;
+				options.mflt_mono_mass_constraint = setting.mflt_mono_mass_constraint ;
+				options.mflt_max_distance = setting.mflt_max_distance ;
+				options.mflt_net_weight = setting.mflt_net_weight ;
+				options.mflt_log_abundance_weight = setting.mflt_log_abundance_weight ;
+
+				// the cluster assignment is written into the peaks, so each setting needs its own copy of them;
+				// at most one copy per worker exists at a time
+				UMCCreator creator ;
+				creator.GetTelemetry().SetParent(mobj_parent_telemetry) ;
+				options.ApplyTo(creator) ;
+				creator.mvect_isotope_peaks = loader.mvect_isotope_peaks ;
+				creator.mint_lc_min_scan = loader.mint_lc_min_scan ;
+				creator.mint_lc_max_scan = loader.mint_lc_max_scan ;
+				creator.mint_ims_min_scan = loader.mint_ims_min_scan ;
+				creator.mint_ims_max_scan = loader.mint_ims_max_scan ;
+
+				creator.CreateUMCsSinglyLinkedWithAll(sortedPeaks) ;
+				creator.RemoveShortUMCs(options.mint_min_umc_length) ;
+				creator.CalculateUMCs() ;
+				setting.mint_num_umcs = creator.GetNumUmcs() ;
+
+				char settingFileName[1100] ;
+				sprintf(settingFileName, "%s_Sweep%d", baseFileName, settingNum + 1) ;
+				if (!creator.CreateFeatureFiles(settingFileName))
+					throw "Unable to write the feature files" ;
+				setting.mbln_success = true ;
+			}
+			catch (std::exception &e)
+			{
+				setting.mstr_error = e.what() ;
+			}
+			catch (const char *message)
+			{
+				setting.mstr_error = message ;
+			}
+			setting.mdbl_seconds = GetWallClockSeconds() - startTime ;
+		}) ;
+	}
+	pool.Run(tasks) ;
+
+	int numFailed = 0 ;
+	for (int settingNum = 0 ; settingNum < (int) mvect_settings.size() ; settingNum++)
+	{
+		if (!mvect_settings[settingNum].mbln_success)
+			numFailed++ ;
+	}
+	return numFailed ;
+}
+
+bool ParameterSweep::WriteSummaryFile(const char *fileName)
+{
+	FILE *summary = fopen(fileName, "w") ;
+	if (summary == NULL)
+		return false ;
+
+	fprintf(summary, "Setting\tMonoMassConstraint\tMaxDistance\tNETWeight\tLogAbundanceWeight\tPeaks\tFeatures\tSeconds\tStatus\n") ;
+	for (int settingNum = 0 ; settingNum < (int) mvect_settings.size() ; settingNum++)
+	{
+		SweepSetting &setting = mvect_settings[settingNum] ;
+		fprintf(summary, "%d\t%g\t%g\t%g\t%g\t%d\t%d\t%.3f\t%s\n", settingNum + 1, setting.mflt_mono_mass_constraint, setting.mflt_max_distance,
+			setting.mflt_net_weight, setting.mflt_log_abundance_weight, mint_num_peaks, setting.mint_num_umcs, setting.mdbl_seconds,
+			setting.mbln_success ? "OK" : setting.mstr_error.c_str()) ;
+	}
+	fclose(summary) ;
+	return true ;
+}
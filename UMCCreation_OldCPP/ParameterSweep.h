@@ -0,0 +1,65 @@
+#pragma once
+#include "FeatureFinderOptions.h"
+#include <string>
+#include <vector>
+
+class ProgressTelemetry ;
+
+// One combination of clustering options tried by a ParameterSweep, and what it produced
+struct SweepSetting
+{
+	float mflt_mono_mass_constraint ;
+	float mflt_max_distance ;
+	float mflt_net_weight ;
+	float mflt_log_abundance_weight ;
+
+	int mint_num_umcs ;
+	double mdbl_seconds ;
+	bool mbln_success ;
+	std::string mstr_error ;
+} ;
+
+/*
+ * Clusters one dataset under many option sets. The isos file is loaded and sorted by mass once; every setting
+ * then runs CreateUMCsSinglyLinkedWithAll, RemoveShortUMCs and CalculateUMCs on its own UMCCreator as a task
+ * of a WorkStealingPool, reading the shared mass-sorted peaks, and writes
+ *		baseFileName_Sweep<N>_LCMSFeatures.txt and baseFileName_Sweep<N>_LCMSFeatureToPeakMap.txt
+ * where N is the 1-based position of the setting. WriteSummaryFile lists the settings and their feature counts.
+ *
+ * The settings come from the [ParameterSweep] section of an INI file, one comma separated list per option:
+ *		[ParameterSweep]
+ *		MonoMassConstraint=5,10,20
+ *		MaxDistance=0.1,0.2
+ * Every combination of the lists is run; options without a list keep the value of the base options.
+ * Chunking (ProcessDataInChunks) does not apply: the whole file is clustered at once for every setting.
+ */
+class ParameterSweep
+{
+	FeatureFinderOptions mobj_options ;
+	int mint_num_threads ;
+	int mint_num_peaks ;
+	std::vector<SweepSetting> mvect_settings ;
+	ProgressTelemetry *mobj_parent_telemetry ;
+
+public:
+	// numThreads <= 0 uses one thread per hardware thread
+	ParameterSweep(const FeatureFinderOptions &options, int numThreads) ;
+	~ParameterSweep(void) ;
+
+	void AddSetting(float monoMassConstraint, float maxDistance, float netWeight, float logAbundanceWeight) ;
+	// Adds every combination listed in [ParameterSweep]; false if the file cannot be read.
+	// Lists that cannot be parsed are reported in errors and replaced by the base value.
+	bool LoadFromIniFile(const char *iniFileName, std::vector<std::string> &errors) ;
+	int GetNumSettings() { return (int) mvect_settings.size() ; } ;
+	int GetNumPeaks() { return mint_num_peaks ; } ;
+	// The counters of the load and of every setting are added to telemetry as well (see ProgressTelemetry::SetParent)
+	void SetParentTelemetry(ProgressTelemetry *telemetry) { mobj_parent_telemetry = telemetry ; } ;
+
+	// Loads the input file of the base options and runs every setting; returns the number of settings that failed.
+	// Throws like UMCCreator::ReadCSVFile when the input cannot be loaded.
+	int Run() ;
+	// Tab separated table of the settings and their results
+	bool WriteSummaryFile(const char *fileName) ;
+
+	std::vector<SweepSetting> & GetSettings() { return mvect_settings ; } ;
+};
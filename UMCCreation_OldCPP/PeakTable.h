@@ -0,0 +1,57 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Flat C layouts of a set of isotope peaks handed to the engine in one call (UMCCreator::SetPeaks), for hosts that
+ * hold their peaks in arrays instead of building a clsIsotopePeak per peak.
+ *
+ * UMCPeakColumns points at one array of num_peaks values per field. lc_scan, charge, abundance and mono_mass are
+ * required; any other column may be NULL, which sets the field to 0 (original_index: to the position of the peak).
+ * Giving ims_scan marks the data as IMS data, as the IMS columns of an isos file do.
+ *
+ * The original indices of the peaks (column or records) must be 0 to num_peaks - 1, each once; the peak map refers
+ * to the peaks by them, and the engine keeps the peaks in that order.
+ *
+ * UMCPeakRecord is one peak of a packed buffer; its fields are ordered so that it has no padding (72 bytes), and a
+ * host can declare the same layout (e.g. a .NET struct with LayoutKind.Sequential) and pass an array of them.
+ */
+typedef struct UMCPeakColumns
+{
+	int num_peaks ;
+
+	const int *original_index ;
+	const int *lc_scan ;
+	const int *charge ;
+	const double *abundance ;
+	const double *mz ;
+	const float *fit ;
+	const double *average_mass ;
+	const double *mono_mass ;
+	const double *max_abundance_mass ;
+	const double *i2_abundance ;
+	const int *ims_scan ;
+	const float *ims_drift_time ;
+} UMCPeakColumns ;
+
+typedef struct UMCPeakRecord
+{
+	double abundance ;
+	double mz ;
+	double average_mass ;
+	double mono_mass ;
+	double max_abundance_mass ;
+	double i2_abundance ;
+	float fit ;
+	float ims_drift_time ;
+	int original_index ;
+	int lc_scan ;
+	int ims_scan ;				// ignored unless SetPeaks is told the records hold IMS data
+	int charge ;
+} UMCPeakRecord ;
+
+#ifdef __cplusplus
+}
+#endif
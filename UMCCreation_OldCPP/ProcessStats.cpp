@@ -0,0 +1,104 @@
+#include "ProcessStats.h"
+#include <chrono>
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define STATS_THREAD_LOCAL __declspec(thread)
+#else
+#define STATS_THREAD_LOCAL thread_local
+#endif
+
+// CPU seconds added to GetThreadCpuSeconds of this thread by AddThreadWorkCpuSeconds
+static STATS_THREAD_LOCAL double gdbl_thread_work_cpu_offset = 0 ;
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+
+static double FileTimeToSeconds(const FILETIME &time)
+{
+	ULARGE_INTEGER value ;
+	value.LowPart = time.dwLowDateTime ;
+	value.HighPart = time.dwHighDateTime ;
+	// FILETIME is in 100 ns units
+	return value.QuadPart / 1.0e7 ;
+}
+
+double GetThreadCpuSeconds()
+{
+	FILETIME creation, exitTime, kernel, user ;
+	if (!GetThreadTimes(GetCurrentThread(), &creation, &exitTime, &kernel, &user))
+		return 0 ;
+	return FileTimeToSeconds(kernel) + FileTimeToSeconds(user) ;
+}
+
+double GetProcessCpuSeconds()
+{
+	FILETIME creation, exitTime, kernel, user ;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel, &user))
+		return 0 ;
+	return FileTimeToSeconds(kernel) + FileTimeToSeconds(user) ;
+}
+
+long long GetPeakResidentBytes()
+{
+	PROCESS_MEMORY_COUNTERS counters ;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0 ;
+	return (long long) counters.PeakWorkingSetSize ;
+}
+
+#else
+#include <time.h>
+#include <sys/resource.h>
+
+static double TimeSpecToSeconds(const struct timespec &time)
+{
+	return time.tv_sec + time.tv_nsec / 1.0e9 ;
+}
+
+double GetThreadCpuSeconds()
+{
+	struct timespec time ;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0)
+		return 0 ;
+	return TimeSpecToSeconds(time) ;
+}
+
+double GetProcessCpuSeconds()
+{
+	struct timespec time ;
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0)
+		return 0 ;
+	return TimeSpecToSeconds(time) ;
+}
+
+long long GetPeakResidentBytes()
+{
+	struct rusage usage ;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0 ;
+#ifdef __APPLE__
+	return (long long) usage.ru_maxrss ;
+#else
+	// Linux reports kilobytes
+	return (long long) usage.ru_maxrss * 1024 ;
+#endif
+}
+
+#endif
+
+double GetWallClockSeconds()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count() / 1.0e6 ;
+}
+
+double GetThreadWorkCpuSeconds()
+{
+	return GetThreadCpuSeconds() + gdbl_thread_work_cpu_offset ;
+}
+
+void AddThreadWorkCpuSeconds(double seconds)
+{
+	gdbl_thread_work_cpu_offset += seconds ;
+}
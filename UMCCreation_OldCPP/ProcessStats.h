@@ -0,0 +1,21 @@
+#pragma once
+
+// Small platform wrappers used by the run instrumentation
+
+// CPU time (user + kernel) consumed so far by the calling thread
+double GetThreadCpuSeconds() ;
+
+// CPU time of the work the calling thread is responsible for, as a stage measures it: GetThreadCpuSeconds plus
+// what AddThreadWorkCpuSeconds added on this thread. WorkStealingPool adds the CPU time its tasks spent on other
+// threads to the thread that waited for them, and takes the tasks of other threads it ran in between off.
+double GetThreadWorkCpuSeconds() ;
+void AddThreadWorkCpuSeconds(double seconds) ;
+
+// CPU time (user + kernel) consumed so far by the whole process
+double GetProcessCpuSeconds() ;
+
+// Largest resident set (working set) the process has had so far, in bytes
+long long GetPeakResidentBytes() ;
+
+// Monotonic wall clock, only meaningful as a difference between two calls
+double GetWallClockSeconds() ;
@@ -0,0 +1,260 @@
+#include "ProgressTelemetry.h"
+#include "ProcessStats.h"
+#include <atomic>
+#include <stddef.h>
+#include <chrono>
+
+typedef std::chrono::steady_clock TelemetryClock ;
+
+static long long TelemetryNow()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(TelemetryClock::now().time_since_epoch()).count() ;
+}
+
+struct ProgressTelemetry::Counters
+{
+	std::atomic<int> mint_stage ;
+	std::atomic<long long> mlng_items_processed ;
+	std::atomic<long long> mlng_items_total ;
+	std::atomic<long long> mlng_bytes_read ;
+	std::atomic<long long> mlng_bytes_written ;
+	std::atomic<long long> mlng_peaks_kept ;
+	std::atomic<long long> mlng_peaks_rejected ;
+	std::atomic<long long> mlng_distance_evaluations ;
+	std::atomic<long long> mlng_merges ;
+	std::atomic<long long> mlng_stage_start_ns ;
+	std::atomic<long long> mlng_stage_ns[STAGE_NUM_STAGES] ;
+	// only touched by the thread running the stages
+	double mdbl_stage_start_cpu ;
+	std::atomic<long long> mlng_stage_cpu_ns[STAGE_NUM_STAGES] ;
+	std::atomic<long long> mlng_stage_items[STAGE_NUM_STAGES] ;
+	std::atomic<long long> mlng_stage_peak_rss[STAGE_NUM_STAGES] ;
+} ;
+
+ProgressTelemetry::ProgressTelemetry(void)
+{
+	mobj_parent = NULL ;
+	mobj_counters = new Counters() ;
+	Reset() ;
+}
+
+ProgressTelemetry::ProgressTelemetry(const ProgressTelemetry &)
+{
+	mobj_parent = NULL ;
+	mobj_counters = new Counters() ;
+	Reset() ;
+}
+
+ProgressTelemetry & ProgressTelemetry::operator=(const ProgressTelemetry &)
+{
+	Reset() ;
+	return *this ;
+}
+
+ProgressTelemetry::~ProgressTelemetry(void)
+{
+	delete mobj_counters ;
+}
+
+void ProgressTelemetry::Reset()
+{
+	mobj_counters->mint_stage.store(STAGE_IDLE) ;
+	mobj_counters->mlng_items_processed.store(0) ;
+	mobj_counters->mlng_items_total.store(0) ;
+	mobj_counters->mlng_bytes_read.store(0) ;
+	mobj_counters->mlng_bytes_written.store(0) ;
+	mobj_counters->mlng_peaks_kept.store(0) ;
+	mobj_counters->mlng_peaks_rejected.store(0) ;
+	mobj_counters->mlng_distance_evaluations.store(0) ;
+	mobj_counters->mlng_merges.store(0) ;
+	mobj_counters->mlng_stage_start_ns.store(TelemetryNow()) ;
+	mobj_counters->mdbl_stage_start_cpu = 0 ;
+	for (int stage = 0 ; stage < STAGE_NUM_STAGES ; stage++)
+	{
+		mobj_counters->mlng_stage_ns[stage].store(0) ;
+		mobj_counters->mlng_stage_cpu_ns[stage].store(0) ;
+		mobj_counters->mlng_stage_items[stage].store(0) ;
+		mobj_counters->mlng_stage_peak_rss[stage].store(0) ;
+	}
+}
+
+void ProgressTelemetry::BeginStage(TelemetryStage stage, long long total)
+{
+	EndStage() ;
+	mobj_counters->mlng_items_processed.store(0, std::memory_order_relaxed) ;
+	mobj_counters->mlng_items_total.store(total, std::memory_order_relaxed) ;
+	mobj_counters->mlng_stage_start_ns.store(TelemetryNow(), std::memory_order_relaxed) ;
+	mobj_counters->mdbl_stage_start_cpu = GetThreadWorkCpuSeconds() ;
+	mobj_counters->mint_stage.store(stage, std::memory_order_release) ;
+}
+
+void ProgressTelemetry::EndStage()
+{
+	int stage = mobj_counters->mint_stage.load(std::memory_order_acquire) ;
+	if (stage == STAGE_IDLE)
+		return ;
+	long long elapsed = TelemetryNow() - mobj_counters->mlng_stage_start_ns.load(std::memory_order_relaxed) ;
+	mobj_counters->mlng_stage_ns[stage].fetch_add(elapsed, std::memory_order_relaxed) ;
+	long long cpu = (long long) ((GetThreadWorkCpuSeconds() - mobj_counters->mdbl_stage_start_cpu) * 1.0e9) ;
+	mobj_counters->mlng_stage_cpu_ns[stage].fetch_add(cpu, std::memory_order_relaxed) ;
+	long long total = mobj_counters->mlng_items_total.load(std::memory_order_relaxed) ;
+	mobj_counters->mlng_stage_items[stage].fetch_add(total, std::memory_order_relaxed) ;
+	mobj_counters->mlng_stage_peak_rss[stage].store(GetPeakResidentBytes(), std::memory_order_relaxed) ;
+	mobj_counters->mlng_items_processed.store(total, std::memory_order_relaxed) ;
+	mobj_counters->mint_stage.store(STAGE_IDLE, std::memory_order_release) ;
+}
+
+void ProgressTelemetry::SetItemsProcessed(long long processed)
+{
+	mobj_counters->mlng_items_processed.store(processed, std::memory_order_relaxed) ;
+}
+
+void ProgressTelemetry::SetBytesRead(long long bytes)
+{
+	// the parent sums the reads of its children, so it gets the growth since the last call
+	long long previous = mobj_counters->mlng_bytes_read.exchange(bytes, std::memory_order_relaxed) ;
+	if (mobj_parent != NULL)
+		mobj_parent->AddBytesRead(bytes - previous) ;
+}
+
+void ProgressTelemetry::AddBytesRead(long long bytes)
+{
+	mobj_counters->mlng_bytes_read.fetch_add(bytes, std::memory_order_relaxed) ;
+	if (mobj_parent != NULL)
+		mobj_parent->AddBytesRead(bytes) ;
+}
+
+void ProgressTelemetry::AddBytesWritten(long long bytes)
+{
+	mobj_counters->mlng_bytes_written.fetch_add(bytes, std::memory_order_relaxed) ;
+	if (mobj_parent != NULL)
+		mobj_parent->AddBytesWritten(bytes) ;
+}
+
+void ProgressTelemetry::AddPeaksKept(long long count)
+{
+	mobj_counters->mlng_peaks_kept.fetch_add(count, std::memory_order_relaxed) ;
+	if (mobj_parent != NULL)
+		mobj_parent->AddPeaksKept(count) ;
+}
+
+void ProgressTelemetry::AddPeaksRejected(long long count)
+{
+	mobj_counters->mlng_peaks_rejected.fetch_add(count, std::memory_order_relaxed) ;
+	if (mobj_parent != NULL)
+		mobj_parent->AddPeaksRejected(count) ;
+}
+
+void ProgressTelemetry::AddDistanceEvaluations(long long count)
+{
+	mobj_counters->mlng_distance_evaluations.fetch_add(count, std::memory_order_relaxed) ;
+	if (mobj_parent != NULL)
+		mobj_parent->AddDistanceEvaluations(count) ;
+}
+
+void ProgressTelemetry::AddMerges(long long count)
+{
+	mobj_counters->mlng_merges.fetch_add(count, std::memory_order_relaxed) ;
+	if (mobj_parent != NULL)
+		mobj_parent->AddMerges(count) ;
+}
+
+TelemetryStage ProgressTelemetry::GetStage() const
+{
+	return (TelemetryStage) mobj_counters->mint_stage.load(std::memory_order_acquire) ;
+}
+
+short ProgressTelemetry::GetPercentComplete() const
+{
+	long long total = mobj_counters->mlng_items_total.load(std::memory_order_relaxed) ;
+	long long processed = mobj_counters->mlng_items_processed.load(std::memory_order_relaxed) ;
+	if (total <= 0)
+		return 0 ;
+	long long percent = (100 * processed) / total ;
+	if (percent > 100)
+		percent = 100 ;
+	if (percent < 0)
+		percent = 0 ;
+	return (short) percent ;
+}
+
+long long ProgressTelemetry::GetDistanceEvaluations() const
+{
+	return mobj_counters->mlng_distance_evaluations.load(std::memory_order_relaxed) ;
+}
+
+long long ProgressTelemetry::GetMerges() const
+{
+	return mobj_counters->mlng_merges.load(std::memory_order_relaxed) ;
+}
+
+long long ProgressTelemetry::GetPeaksKept() const
+{
+	return mobj_counters->mlng_peaks_kept.load(std::memory_order_relaxed) ;
+}
+
+long long ProgressTelemetry::GetPeaksRejected() const
+{
+	return mobj_counters->mlng_peaks_rejected.load(std::memory_order_relaxed) ;
+}
+
+long long ProgressTelemetry::GetBytesRead() const
+{
+	return mobj_counters->mlng_bytes_read.load(std::memory_order_relaxed) ;
+}
+
+long long ProgressTelemetry::GetBytesWritten() const
+{
+	return mobj_counters->mlng_bytes_written.load(std::memory_order_relaxed) ;
+}
+
+double ProgressTelemetry::GetStageSeconds(TelemetryStage stage) const
+{
+	if (stage <= STAGE_IDLE || stage >= STAGE_NUM_STAGES)
+		return 0 ;
+	long long elapsed = mobj_counters->mlng_stage_ns[stage].load(std::memory_order_relaxed) ;
+	if (GetStage() == stage)
+		elapsed += TelemetryNow() - mobj_counters->mlng_stage_start_ns.load(std::memory_order_relaxed) ;
+	return elapsed / 1.0e9 ;
+}
+
+void ProgressTelemetry::GetSnapshot(TelemetrySnapshot &snapshot) const
+{
+	snapshot.menm_stage = GetStage() ;
+	snapshot.mlng_items_processed = mobj_counters->mlng_items_processed.load(std::memory_order_relaxed) ;
+	snapshot.mlng_items_total = mobj_counters->mlng_items_total.load(std::memory_order_relaxed) ;
+	snapshot.mlng_bytes_read = GetBytesRead() ;
+	snapshot.mlng_bytes_written = GetBytesWritten() ;
+	snapshot.mlng_peaks_kept = GetPeaksKept() ;
+	snapshot.mlng_peaks_rejected = GetPeaksRejected() ;
+	snapshot.mlng_distance_evaluations = GetDistanceEvaluations() ;
+	snapshot.mlng_merges = GetMerges() ;
+	for (int stage = 0 ; stage < STAGE_NUM_STAGES ; stage++)
+	{
+		snapshot.mdbl_stage_seconds[stage] = GetStageSeconds((TelemetryStage) stage) ;
+		snapshot.mdbl_stage_cpu_seconds[stage] = mobj_counters->mlng_stage_cpu_ns[stage].load(std::memory_order_relaxed) / 1.0e9 ;
+		snapshot.mlng_stage_items[stage] = mobj_counters->mlng_stage_items[stage].load(std::memory_order_relaxed) ;
+		snapshot.mlng_stage_peak_rss[stage] = mobj_counters->mlng_stage_peak_rss[stage].load(std::memory_order_relaxed) ;
+	}
+}
+
+const char * ProgressTelemetry::GetStageName(TelemetryStage stage)
+{
+	switch (stage)
+	{
+		case STAGE_LOADING:
+			return "load" ;
+		case STAGE_SORTING:
+			return "sort" ;
+		case STAGE_CLUSTERING:
+			return "cluster" ;
+		case STAGE_FILTERING:
+			return "filter" ;
+		case STAGE_SUMMARIZING:
+			return "summarize" ;
+		case STAGE_WRITING:
+			return "write" ;
+		default:
+			return "idle" ;
+	}
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+// Processing stages reported by ProgressTelemetry
+enum TelemetryStage
+{
+	STAGE_IDLE = 0,
+	STAGE_LOADING,
+	STAGE_SORTING,
+	STAGE_CLUSTERING,
+	STAGE_FILTERING,
+	STAGE_SUMMARIZING,
+	STAGE_WRITING,
+	STAGE_NUM_STAGES
+} ;
+
+// Plain copy of the counters, taken with ProgressTelemetry::GetSnapshot
+struct TelemetrySnapshot
+{
+	TelemetryStage menm_stage ;
+	long long mlng_items_processed ;
+	long long mlng_items_total ;
+	long long mlng_bytes_read ;
+	long long mlng_bytes_written ;
+	long long mlng_peaks_kept ;
+	long long mlng_peaks_rejected ;
+	long long mlng_distance_evaluations ;
+	long long mlng_merges ;
+	double mdbl_stage_seconds[STAGE_NUM_STAGES] ;
+	// Filled in when a stage ends: CPU time of the thread that ran it and of the pool tasks it waited for
+	// (GetThreadWorkCpuSeconds), work items and process peak RSS
+	double mdbl_stage_cpu_seconds[STAGE_NUM_STAGES] ;
+	long long mlng_stage_items[STAGE_NUM_STAGES] ;
+	long long mlng_stage_peak_rss[STAGE_NUM_STAGES] ;
+} ;
+
+/*
+ * Progress and phase counters of a UMCCreator.
+ * The worker thread updates the counters and any other thread may read them at any time;
+ * all counters are atomics so no locks are taken on either side.
+ * Hot loops are expected to accumulate locally and publish every PUBLISH_INTERVAL iterations,
+ * and the percentage is only computed when somebody asks for it.
+ *
+ * The atomics live in a private block allocated by the .cpp so that this header can still be
+ * included from code compiled with /clr. Copying a ProgressTelemetry gives fresh, zeroed counters.
+ *
+ * A run that splits its work over several UMCCreators (mass chunks, batch datasets, sweep settings) gives
+ * each of them the telemetry of the caller as parent: the byte, peak, distance and merge counters are then
+ * added to the parent as well, while stages and percentages stay with each creator.
+ */
+class ProgressTelemetry
+{
+	struct Counters ;
+	Counters *mobj_counters ;
+	ProgressTelemetry *mobj_parent ;
+
+	void AddBytesRead(long long bytes) ;
+
+public:
+	static const int PUBLISH_INTERVAL = 4096 ;
+	static const int PUBLISH_MASK = PUBLISH_INTERVAL - 1 ;
+
+	ProgressTelemetry(void) ;
+	ProgressTelemetry(const ProgressTelemetry &) ;
+	ProgressTelemetry & operator=(const ProgressTelemetry &) ;
+	~ProgressTelemetry(void) ;
+
+	// Resets the counters; the parent is kept
+	void Reset() ;
+	// Not copied with the telemetry; NULL stops the forwarding
+	void SetParent(ProgressTelemetry *parent) { mobj_parent = parent ; } ;
+	ProgressTelemetry * GetParent() { return mobj_parent ; } ;
+
+	// Closes the current stage (adding its elapsed time) and starts a new one with total work items
+	void BeginStage(TelemetryStage stage, long long total) ;
+	void EndStage() ;
+
+	void SetItemsProcessed(long long processed) ;
+	void SetBytesRead(long long bytes) ;
+	void AddBytesWritten(long long bytes) ;
+	void AddPeaksKept(long long count) ;
+	void AddPeaksRejected(long long count) ;
+	void AddDistanceEvaluations(long long count) ;
+	void AddMerges(long long count) ;
+
+	TelemetryStage GetStage() const ;
+	short GetPercentComplete() const ;
+	long long GetDistanceEvaluations() const ;
+	long long GetMerges() const ;
+	long long GetPeaksKept() const ;
+	long long GetPeaksRejected() const ;
+	long long GetBytesRead() const ;
+	long long GetBytesWritten() const ;
+	// Seconds spent in the stage so far, including the running time of the current stage
+	double GetStageSeconds(TelemetryStage stage) const ;
+	void GetSnapshot(TelemetrySnapshot &snapshot) const ;
+
+	static const char * GetStageName(TelemetryStage stage) ;
+};
@@ -0,0 +1,102 @@
+#include "RunArena.h"
+#include <stdlib.h>
+
+namespace
+{
+	// every block starts on this boundary, enough for any member of the nodes stored here
+	const size_t ARENA_ALIGNMENT = 16 ;
+	// blocks up to this size are cut from the chunks; bigger ones (rare) come straight from the heap
+	const size_t MAX_ARENA_BLOCK = 512 ;
+	const size_t DEFAULT_CHUNK_BYTES = 1024 * 1024 ;
+}
+
+RunArena::RunArena(void)
+{
+	mptr_next = NULL ;
+	mptr_end = NULL ;
+	mlng_bytes_reserved = 0 ;
+	mvect_free_lists.assign(MAX_ARENA_BLOCK / ARENA_ALIGNMENT + 1, (void *) NULL) ;
+}
+
+RunArena::RunArena(const RunArena &)
+{
+	mptr_next = NULL ;
+	mptr_end = NULL ;
+	mlng_bytes_reserved = 0 ;
+	mvect_free_lists.assign(MAX_ARENA_BLOCK / ARENA_ALIGNMENT + 1, (void *) NULL) ;
+}
+
+RunArena::~RunArena(void)
+{
+	Release() ;
+}
+
+void RunArena::AddChunk(size_t bytes)
+{
+	char *chunk = (char *) malloc(bytes) ;
+	if (chunk == NULL)
+		throw std::bad_alloc() ;
+	mvect_chunks.push_back(chunk) ;
+	mptr_next = chunk ;
+	mptr_end = chunk + bytes ;
+	mlng_bytes_reserved += bytes ;
+}
+
+void RunArena::Reserve(size_t bytes)
+{
+	if ((size_t) (mptr_end - mptr_next) < bytes)
+		AddChunk((bytes + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT) ;
+}
+
+void * RunArena::Allocate(size_t bytes)
+{
+	if (bytes > MAX_ARENA_BLOCK)
+	{
+		void *block = malloc(bytes) ;
+		if (block == NULL)
+			throw std::bad_alloc() ;
+		return block ;
+	}
+
+	size_t sizeClass = bytes > 0 ? (bytes + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT : 1 ;
+	void *block = mvect_free_lists[sizeClass] ;
+	if (block != NULL)
+	{
+		// a free block keeps the next one of its list in its first bytes
+		mvect_free_lists[sizeClass] = *(void **) block ;
+		return block ;
+	}
+
+	size_t blockBytes = sizeClass * ARENA_ALIGNMENT ;
+	if ((size_t) (mptr_end - mptr_next) < blockBytes)
+		AddChunk(DEFAULT_CHUNK_BYTES) ;
+	block = mptr_next ;
+	mptr_next += blockBytes ;
+	return block ;
+}
+
+void RunArena::Deallocate(void *block, size_t bytes)
+{
+	if (block == NULL)
+		return ;
+	if (bytes > MAX_ARENA_BLOCK)
+	{
+		free(block) ;
+		return ;
+	}
+
+	size_t sizeClass = bytes > 0 ? (bytes + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT : 1 ;
+	*(void **) block = mvect_free_lists[sizeClass] ;
+	mvect_free_lists[sizeClass] = block ;
+}
+
+void RunArena::Release()
+{
+	for (int chunkNum = 0 ; chunkNum < (int) mvect_chunks.size() ; chunkNum++)
+		free(mvect_chunks[chunkNum]) ;
+	mvect_chunks.clear() ;
+	mvect_free_lists.assign(mvect_free_lists.size(), (void *) NULL) ;
+	mptr_next = NULL ;
+	mptr_end = NULL ;
+	mlng_bytes_reserved = 0 ;
+}
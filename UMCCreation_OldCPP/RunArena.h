@@ -0,0 +1,68 @@
+#pragma once
+#include <stddef.h>
+#include <new>
+#include <vector>
+
+/*
+ * Memory for the many small, short lived objects of one run, such as the nodes of UMCCreator::mmultimap_umc_2_peak_index.
+ * Blocks are cut from large chunks by moving a pointer; a freed block goes on the free list of its size and is handed
+ * out again before new chunk memory. Nothing goes back to the heap until Release, which the owner calls once
+ * every container using the arena is empty (UMCCreator::Reset), so the chunks of one run leave no holes behind.
+ * Not thread safe: each UMCCreator has its own.
+ */
+class RunArena
+{
+	std::vector<char*> mvect_chunks ;
+	char *mptr_next ;
+	char *mptr_end ;
+	std::vector<void*> mvect_free_lists ;		// first free block of each size class
+	size_t mlng_bytes_reserved ;
+
+	void AddChunk(size_t bytes) ;
+
+public:
+	RunArena(void) ;
+	// Blocks belong to the arena that handed them out: a copy starts empty, and assigning leaves an arena as it was
+	RunArena(const RunArena &) ;
+	RunArena & operator=(const RunArena &) { return *this ; } ;
+	~RunArena(void) ;
+
+	// Makes sure the next bytes of allocations come from a single chunk, e.g. sized from the peak count before a clustering
+	void Reserve(size_t bytes) ;
+	void * Allocate(size_t bytes) ;
+	void Deallocate(void *block, size_t bytes) ;
+	// Returns every chunk to the heap; all blocks handed out become invalid
+	void Release() ;
+	size_t GetBytesReserved() const { return mlng_bytes_reserved ; } ;
+};
+
+// Standard allocator handing out the memory of a RunArena, for the containers of a run
+template <class T> class ArenaAllocator
+{
+public:
+	typedef T value_type ;
+	typedef T* pointer ;
+	typedef const T* const_pointer ;
+	typedef T& reference ;
+	typedef const T& const_reference ;
+	typedef size_t size_type ;
+	typedef ptrdiff_t difference_type ;
+	template <class U> struct rebind { typedef ArenaAllocator<U> other ; } ;
+
+	RunArena *mobj_arena ;
+
+	ArenaAllocator(RunArena *arena) : mobj_arena(arena) { }
+	template <class U> ArenaAllocator(const ArenaAllocator<U> &other) : mobj_arena(other.mobj_arena) { }
+
+	pointer address(reference value) const { return &value ; }
+	const_pointer address(const_reference value) const { return &value ; }
+	size_type max_size() const { return ((size_type) -1) / sizeof(T) ; }
+
+	pointer allocate(size_type count, const void * = 0) { return (pointer) mobj_arena->Allocate(count * sizeof(T)) ; }
+	void deallocate(pointer block, size_type count) { mobj_arena->Deallocate(block, count * sizeof(T)) ; }
+	void construct(pointer block, const T &value) { new ((void *) block) T(value) ; }
+	void destroy(pointer block) { block->~T() ; }
+};
+
+template <class T, class U> bool operator==(const ArenaAllocator<T> &first, const ArenaAllocator<U> &second) { return first.mobj_arena == second.mobj_arena ; }
+template <class T, class U> bool operator!=(const ArenaAllocator<T> &first, const ArenaAllocator<U> &second) { return first.mobj_arena != second.mobj_arena ; }
@@ -0,0 +1,158 @@
+#include "RunReport.h"
+#include "ProcessStats.h"
+#include <string.h>
+
+// Writes a string value with the characters JSON requires to be escaped (Windows paths have backslashes)
+static void WriteJsonString(FILE *stream, const char *value)
+{
+	fputc('"', stream) ;
+	for (const char *ch = value ; *ch != '\0' ; ch++)
+	{
+		if (*ch == '"' || *ch == '\\')
+			fputc('\\', stream) ;
+		if ((unsigned char) *ch < 0x20)
+			fprintf(stream, "\\u%04x", (unsigned char) *ch) ;
+		else
+			fputc(*ch, stream) ;
+	}
+	fputc('"', stream) ;
+}
+
+static double PerSecond(long long count, double seconds)
+{
+	if (seconds <= 0)
+		return 0 ;
+	return count / seconds ;
+}
+
+RunReport::RunReport(void)
+{
+	mstr_input_file[0] = '\0' ;
+	Start() ;
+}
+
+RunReport::~RunReport(void)
+{
+}
+
+void RunReport::Start()
+{
+	mdbl_start_wall = GetWallClockSeconds() ;
+	mdbl_start_cpu = GetProcessCpuSeconds() ;
+	mint_num_runs = 0 ;
+	mlng_num_features = 0 ;
+	memset(&mobj_totals, 0, sizeof(mobj_totals)) ;
+}
+
+void RunReport::SetInputFileName(const char *fileName)
+{
+	strncpy(mstr_input_file, fileName, sizeof(mstr_input_file) - 1) ;
+	mstr_input_file[sizeof(mstr_input_file) - 1] = '\0' ;
+}
+
+void RunReport::AddTelemetry(const ProgressTelemetry &telemetry)
+{
+	TelemetrySnapshot snapshot ;
+	telemetry.GetSnapshot(snapshot) ;
+
+	mobj_totals.mlng_bytes_read += snapshot.mlng_bytes_read ;
+	mobj_totals.mlng_bytes_written += snapshot.mlng_bytes_written ;
+	mobj_totals.mlng_peaks_kept += snapshot.mlng_peaks_kept ;
+	mobj_totals.mlng_peaks_rejected += snapshot.mlng_peaks_rejected ;
+	mobj_totals.mlng_distance_evaluations += snapshot.mlng_distance_evaluations ;
+	mobj_totals.mlng_merges += snapshot.mlng_merges ;
+
+	for (int stage = 0 ; stage < STAGE_NUM_STAGES ; stage++)
+	{
+		mobj_totals.mdbl_stage_seconds[stage] += snapshot.mdbl_stage_seconds[stage] ;
+		mobj_totals.mdbl_stage_cpu_seconds[stage] += snapshot.mdbl_stage_cpu_seconds[stage] ;
+		mobj_totals.mlng_stage_items[stage] += snapshot.mlng_stage_items[stage] ;
+		if (snapshot.mlng_stage_peak_rss[stage] > mobj_totals.mlng_stage_peak_rss[stage])
+			mobj_totals.mlng_stage_peak_rss[stage] = snapshot.mlng_stage_peak_rss[stage] ;
+	}
+	mint_num_runs++ ;
+}
+
+bool RunReport::WriteJson(FILE *stream)
+{
+	if (stream == NULL)
+		return false ;
+
+	double wallSeconds = GetWallClockSeconds() - mdbl_start_wall ;
+	double cpuSeconds = GetProcessCpuSeconds() - mdbl_start_cpu ;
+	long long peaksRead = mobj_totals.mlng_peaks_kept + mobj_totals.mlng_peaks_rejected ;
+
+	fprintf(stream, "{\n") ;
+	fprintf(stream, "  \"input_file\": ") ;
+	WriteJsonString(stream, mstr_input_file) ;
+	fprintf(stream, ",\n") ;
+	fprintf(stream, "  \"wall_seconds\": %.6f,\n", wallSeconds) ;
+	fprintf(stream, "  \"cpu_seconds\": %.6f,\n", cpuSeconds) ;
+	fprintf(stream, "  \"peak_rss_bytes\": %lld,\n", GetPeakResidentBytes()) ;
+	fprintf(stream, "  \"num_chunks\": %d,\n", mint_num_runs) ;
+	fprintf(stream, "  \"peaks_read\": %lld,\n", peaksRead) ;
+	fprintf(stream, "  \"peaks_kept\": %lld,\n", mobj_totals.mlng_peaks_kept) ;
+	fprintf(stream, "  \"peaks_rejected\": %lld,\n", mobj_totals.mlng_peaks_rejected) ;
+	fprintf(stream, "  \"features\": %lld,\n", mlng_num_features) ;
+	fprintf(stream, "  \"bytes_read\": %lld,\n", mobj_totals.mlng_bytes_read) ;
+	fprintf(stream, "  \"bytes_written\": %lld,\n", mobj_totals.mlng_bytes_written) ;
+	fprintf(stream, "  \"distance_evaluations\": %lld,\n", mobj_totals.mlng_distance_evaluations) ;
+	fprintf(stream, "  \"merges\": %lld,\n", mobj_totals.mlng_merges) ;
+	fprintf(stream, "  \"stages\": [\n") ;
+
+	for (int stage = STAGE_IDLE + 1 ; stage < STAGE_NUM_STAGES ; stage++)
+	{
+		double stageSeconds = mobj_totals.mdbl_stage_seconds[stage] ;
+		long long items = mobj_totals.mlng_stage_items[stage] ;
+		long long bytesRead = 0 ;
+		long long bytesWritten = 0 ;
+		long long distanceEvaluations = 0 ;
+		const char *itemUnit = "peaks" ;
+
+		switch (stage)
+		{
+			case STAGE_LOADING:
+				// the telemetry of the load stage counts file bytes, the report counts the peaks read
+				items = peaksRead ;
+				bytesRead = mobj_totals.mlng_bytes_read ;
+				break ;
+			case STAGE_CLUSTERING:
+				distanceEvaluations = mobj_totals.mlng_distance_evaluations ;
+				break ;
+			case STAGE_FILTERING:
+			case STAGE_SUMMARIZING:
+				itemUnit = "features" ;
+				break ;
+			case STAGE_WRITING:
+				itemUnit = "features" ;
+				bytesWritten = mobj_totals.mlng_bytes_written ;
+				break ;
+		}
+
+		fprintf(stream, "    {\"name\": \"%s\", ", ProgressTelemetry::GetStageName((TelemetryStage) stage)) ;
+		fprintf(stream, "\"wall_seconds\": %.6f, ", stageSeconds) ;
+		fprintf(stream, "\"cpu_seconds\": %.6f, ", mobj_totals.mdbl_stage_cpu_seconds[stage]) ;
+		fprintf(stream, "\"peak_rss_bytes\": %lld, ", mobj_totals.mlng_stage_peak_rss[stage]) ;
+		fprintf(stream, "\"items\": %lld, \"item_unit\": \"%s\", ", items, itemUnit) ;
+		fprintf(stream, "\"items_per_second\": %.1f, ", PerSecond(items, stageSeconds)) ;
+		fprintf(stream, "\"bytes_read\": %lld, ", bytesRead) ;
+		fprintf(stream, "\"bytes_written\": %lld, ", bytesWritten) ;
+		fprintf(stream, "\"distance_evaluations\": %lld, ", distanceEvaluations) ;
+		fprintf(stream, "\"distance_evaluations_per_second\": %.1f}", PerSecond(distanceEvaluations, stageSeconds)) ;
+		fprintf(stream, stage + 1 < STAGE_NUM_STAGES ? ",\n" : "\n") ;
+	}
+
+	fprintf(stream, "  ]\n") ;
+	fprintf(stream, "}\n") ;
+	return true ;
+}
+
+bool RunReport::WriteJsonFile(const char *fileName)
+{
+	FILE *file = fopen(fileName, "w") ;
+	if (file == NULL)
+		return false ;
+	bool success = WriteJson(file) ;
+	fclose(file) ;
+	return success ;
+}
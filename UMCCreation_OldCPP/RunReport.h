@@ -0,0 +1,32 @@
+#pragma once
+#include "ProgressTelemetry.h"
+#include <stdio.h>
+
+/*
+ * Per-stage timing and memory report written next to the feature files (baseFileName_FeatureFinder_Stats.json).
+ * The telemetry of every UMCCreator that took part in the run (one per chunk when chunking) is folded in
+ * with AddTelemetry; stage times and counters are summed, the peak RSS is the maximum seen.
+ * The file is plain JSON so that job schedulers can track the numbers across datasets.
+ */
+class RunReport
+{
+	char mstr_input_file[1024] ;
+	double mdbl_start_wall ;
+	double mdbl_start_cpu ;
+	int mint_num_runs ;
+	long long mlng_num_features ;
+	TelemetrySnapshot mobj_totals ;
+
+public:
+	RunReport(void) ;
+	~RunReport(void) ;
+
+	// Restarts the overall wall and CPU clocks and clears the totals
+	void Start() ;
+	void SetInputFileName(const char *fileName) ;
+	void SetNumFeatures(long long numFeatures) { mlng_num_features = numFeatures ; } ;
+	void AddTelemetry(const ProgressTelemetry &telemetry) ;
+
+	bool WriteJson(FILE *stream) ;
+	bool WriteJsonFile(const char *fileName) ;
+};
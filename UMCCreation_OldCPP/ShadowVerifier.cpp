@@ -0,0 +1,213 @@
+// ShadowVerifier.cpp : compares an accelerated clustering with the reference one on the same peaks.
+// Native only (WorkStealingPool uses <thread>); the header can be included by /clr code.
+
+#include "ShadowVerifier.h"
+#include "WorkStealingPool.h"
+#include "ProcessStats.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+namespace
+{
+	bool IsWithinTolerance(double a, double b, double tolerance)
+	{
+		double scale = fabs(a) > fabs(b) ? fabs(a) : fabs(b) ;
+		return fabs(a - b) <= tolerance * scale ;
+	}
+}
+
+ShadowVerifier::ShadowVerifier(const FeatureFinderOptions &options, int numThreads)
+{
+	mobj_options = options ;
+	mint_num_threads = numThreads > 0 ? numThreads : WorkStealingPool::GetHardwareThreads() ;
+	menm_path = SHADOW_PATH_POOL ;
+	mdbl_tolerance = 1e-9 ;
+	mint_num_peaks = 0 ;
+	mint_num_reference_umcs = 0 ;
+	mint_num_candidate_umcs = 0 ;
+	mdbl_reference_seconds = 0 ;
+	mdbl_candidate_seconds = 0 ;
+	mint_num_peak_differences = 0 ;
+	mint_num_umc_differences = 0 ;
+}
+
+ShadowVerifier::~ShadowVerifier(void)
+{
+}
+
+bool ShadowVerifier::SetPath(const char *pathName)
+{
+	if (strcmp(pathName, "index") == 0)
+		menm_path = SHADOW_PATH_INDEX ;
+	else if (strcmp(pathName, "pool") == 0)
+		menm_path = SHADOW_PATH_POOL ;
+	else
+		return false ;
+	return true ;
+}
+
+const char *ShadowVerifier::GetPathName()
+{
+	return menm_path == SHADOW_PATH_INDEX ? "index" : "pool" ;
+}
+
+void ShadowVerifier::AddDifference(const char *text)
+{
+	if ((int) mvect_differences.size() < MAX_REPORTED_DIFFERENCES)
+		mvect_differences.push_back(text) ;
+}
+
+int ShadowVerifier::Run()
+{
+	WorkStealingPool pool(mint_num_threads) ;
+
+	mint_num_peak_differences = 0 ;
+	mint_num_umc_differences = 0 ;
+	mvect_differences.clear() ;
+
+	// the clustering writes into the peaks, so each run gets its own copy of the loaded ones
+	UMCCreator reference ;
+	mobj_options.ApplyTo(reference) ;
+	mint_num_peaks = reference.ReadCSVFileParallel(pool, pool.GetNumThreads()) ;
+	UMCCreator candidate(reference) ;
+
+	double startTime = GetWallClockSeconds() ;
+	reference.SetUseImsCandidateIndex(false) ;
+	reference.SetCollapseImsConformers(false) ;
+	reference.CreateUMCsSinglyLinkedWithAll() ;
+	reference.RemoveShortUMCs(mobj_options.mint_min_umc_length) ;
+	reference.CalculateUMCs() ;
+	mdbl_reference_seconds = GetWallClockSeconds() - startTime ;
+	mint_num_reference_umcs = reference.GetNumUmcs() ;
+
+	startTime = GetWallClockSeconds() ;
+	if (menm_path == SHADOW_PATH_INDEX)
+	{
+		candidate.SetUseImsCandidateIndex(true) ;
+		candidate.CreateUMCsSinglyLinkedWithAll() ;
+	}
+	else
+		candidate.CreateUMCsSinglyLinkedWithAll(pool) ;
+	candidate.RemoveShortUMCs(mobj_options.mint_min_umc_length) ;
+	candidate.CalculateUMCs() ;
+	mdbl_candidate_seconds = GetWallClockSeconds() - startTime ;
+	mint_num_candidate_umcs = candidate.GetNumUmcs() ;
+
+	std::vector<int> candidateOfReference ;
+	ComparePeaks(reference, candidate, candidateOfReference) ;
+	CompareUMCs(reference, candidate, candidateOfReference) ;
+	return mint_num_peak_differences + mint_num_umc_differences ;
+}
+
+void ShadowVerifier::ComparePeaks(UMCCreator &reference, UMCCreator &candidate, std::vector<int> &candidateOfReference)
+{
+	// the first peak of a feature pairs it with the feature of the other run; features with a peak that breaks the
+	// pairing end up as -2
+	candidateOfReference.assign(mint_num_reference_umcs, -1) ;
+	std::vector<int> referenceOfCandidate(mint_num_candidate_umcs, -1) ;
+	std::vector<bool> referenceDiffers(mint_num_reference_umcs, false) ;
+
+	int numPeaks = (int) reference.mvect_isotope_peaks.size() ;
+	for (int peakNum = 0 ; peakNum < numPeaks ; peakNum++)
+	{
+		IsotopePeak &peak = reference.mvect_isotope_peaks[peakNum] ;
+		int referenceUmc = peak.mint_umc_index ;
+		int candidateUmc = candidate.mvect_isotope_peaks[peakNum].mint_umc_index ;
+
+		bool isDifferent ;
+		if (referenceUmc == -1 || candidateUmc == -1)
+			isDifferent = referenceUmc != candidateUmc ;
+		else
+		{
+			if (candidateOfReference[referenceUmc] == -1 && referenceOfCandidate[candidateUmc] == -1)
+			{
+				candidateOfReference[referenceUmc] = candidateUmc ;
+				referenceOfCandidate[candidateUmc] = referenceUmc ;
+			}
+			isDifferent = candidateOfReference[referenceUmc] != candidateUmc || referenceOfCandidate[candidateUmc] != referenceUmc ;
+		}
+		if (!isDifferent)
+			continue ;
+
+		if (referenceUmc != -1)
+			referenceDiffers[referenceUmc] = true ;
+		if (candidateUmc != -1 && referenceOfCandidate[candidateUmc] != -1)
+			referenceDiffers[referenceOfCandidate[candidateUmc]] = true ;
+		mint_num_peak_differences++ ;
+
+		char text[256] ;
+		sprintf(text, "Peak\tline %d\tmass %.4f\tscan %d\tIMS scan %d\treference feature %d\t%s feature %d", peak.mint_line_number_in_file,
+			peak.mdbl_mono_mass, peak.mint_lc_scan, peak.mint_ims_scan, referenceUmc, GetPathName(), candidateUmc) ;
+		AddDifference(text) ;
+	}
+
+	for (int umcNum = 0 ; umcNum < mint_num_reference_umcs ; umcNum++)
+	{
+		if (referenceDiffers[umcNum])
+			candidateOfReference[umcNum] = -2 ;
+	}
+}
+
+void ShadowVerifier::CompareUMCs(UMCCreator &reference, UMCCreator &candidate, std::vector<int> &candidateOfReference)
+{
+	for (int umcNum = 0 ; umcNum < mint_num_reference_umcs ; umcNum++)
+	{
+		// features whose peaks differ are already reported peak by peak
+		if (candidateOfReference[umcNum] < 0)
+			continue ;
+
+		UMC &referenceUmc = reference.mvect_umcs[umcNum] ;
+		UMC &candidateUmc = candidate.mvect_umcs[candidateOfReference[umcNum]] ;
+		const char *field = NULL ;
+		if (referenceUmc.min_num_members != candidateUmc.min_num_members)
+			field = "member count" ;
+		else if (referenceUmc.mint_start_scan != candidateUmc.mint_start_scan || referenceUmc.mint_stop_scan != candidateUmc.mint_stop_scan)
+			field = "scan range" ;
+		else if (referenceUmc.mint_max_abundance_scan != candidateUmc.mint_max_abundance_scan)
+			field = "scan of the maximum abundance" ;
+		else if (referenceUmc.mshort_class_rep_charge != candidateUmc.mshort_class_rep_charge)
+			field = "class representative charge" ;
+		else if (!IsWithinTolerance(referenceUmc.mdbl_median_mono_mass, candidateUmc.mdbl_median_mono_mass, mdbl_tolerance)
+			|| !IsWithinTolerance(referenceUmc.mdbl_average_mono_mass, candidateUmc.mdbl_average_mono_mass, mdbl_tolerance)
+			|| !IsWithinTolerance(referenceUmc.mdbl_min_mono_mass, candidateUmc.mdbl_min_mono_mass, mdbl_tolerance)
+			|| !IsWithinTolerance(referenceUmc.mdbl_max_mono_mass, candidateUmc.mdbl_max_mono_mass, mdbl_tolerance))
+			field = "mono mass" ;
+		else if (!IsWithinTolerance(referenceUmc.mdbl_max_abundance, candidateUmc.mdbl_max_abundance, mdbl_tolerance)
+			|| !IsWithinTolerance(referenceUmc.mdbl_sum_abundance, candidateUmc.mdbl_sum_abundance, mdbl_tolerance))
+			field = "abundance" ;
+		else if (!IsWithinTolerance(referenceUmc.mdbl_class_rep_mz, candidateUmc.mdbl_class_rep_mz, mdbl_tolerance))
+			field = "class representative m/z" ;
+		if (field == NULL)
+			continue ;
+
+		mint_num_umc_differences++ ;
+		char text[256] ;
+		sprintf(text, "Feature\treference feature %d\t%s feature %d\t%s differs", umcNum, GetPathName(), candidateOfReference[umcNum], field) ;
+		AddDifference(text) ;
+	}
+}
+
+bool ShadowVerifier::WriteReportFile(const char *fileName)
+{
+	FILE *report = fopen(fileName, "w") ;
+	if (report == NULL)
+		return false ;
+
+	fprintf(report, "Input file\t%s\n", mobj_options.mstr_input_file) ;
+	fprintf(report, "Path\t%s\n", GetPathName()) ;
+	fprintf(report, "Worker threads\t%d\n", mint_num_threads) ;
+	fprintf(report, "Peaks\t%d\n", mint_num_peaks) ;
+	fprintf(report, "Reference features\t%d\n", mint_num_reference_umcs) ;
+	fprintf(report, "Reference seconds\t%.3f\n", mdbl_reference_seconds) ;
+	fprintf(report, "%s features\t%d\n", GetPathName(), mint_num_candidate_umcs) ;
+	fprintf(report, "%s seconds\t%.3f\n", GetPathName(), mdbl_candidate_seconds) ;
+	fprintf(report, "Peaks that differ\t%d\n", mint_num_peak_differences) ;
+	fprintf(report, "Features that differ\t%d\n", mint_num_umc_differences) ;
+	for (int differenceNum = 0 ; differenceNum < (int) mvect_differences.size() ; differenceNum++)
+		fprintf(report, "%s\n", mvect_differences[differenceNum].c_str()) ;
+	if (mint_num_peak_differences + mint_num_umc_differences > (int) mvect_differences.size())
+		fprintf(report, "(only the first %d differences are listed)\n", MAX_REPORTED_DIFFERENCES) ;
+	fclose(report) ;
+	return true ;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "FeatureFinderOptions.h"
+#include <string>
+#include <vector>
+
+// Accelerated clustering checked by a ShadowVerifier
+enum ShadowPath
+{
+	SHADOW_PATH_INDEX = 0,	// CreateUMCsSinglyLinkedWithAll() with the IMS candidate index (on LC-MS data, with a scan gap)
+	SHADOW_PATH_POOL		// CreateUMCsSinglyLinkedWithAll(WorkStealingPool &): charge partitions, conformer nodes as set in the options
+} ;
+
+/*
+ * Runs an accelerated clustering next to the reference one on the same peaks and reports where they disagree.
+ * The isos file is loaded once; the reference is CreateUMCsSinglyLinkedWithAll() with the IMS candidate index and
+ * conformer collapsing off, the candidate is the path chosen by SetPath with the options as given; both are followed
+ * by RemoveShortUMCs and CalculateUMCs and timed on their own.
+ *
+ * The features are compared up to their numbering: a peak differs when it is in a feature in only one of the runs, or
+ * when its feature does not pair with the same feature of the other run as the earlier peaks of that feature did.
+ * Features whose peaks all agree have their statistics compared, masses and abundances within a relative tolerance,
+ * scans, charge and member count exactly. WriteReportFile lists the first MAX_REPORTED_DIFFERENCES differences.
+ * Like ParameterSweep, chunking and the out of core mode do not apply.
+ */
+class ShadowVerifier
+{
+	FeatureFinderOptions mobj_options ;
+	int mint_num_threads ;
+	ShadowPath menm_path ;
+	double mdbl_tolerance ;
+
+	int mint_num_peaks ;
+	int mint_num_reference_umcs ;
+	int mint_num_candidate_umcs ;
+	double mdbl_reference_seconds ;
+	double mdbl_candidate_seconds ;
+	int mint_num_peak_differences ;
+	int mint_num_umc_differences ;
+	std::vector<std::string> mvect_differences ;
+
+	void AddDifference(const char *text) ;
+	void ComparePeaks(UMCCreator &reference, UMCCreator &candidate, std::vector<int> &candidateOfReference) ;
+	void CompareUMCs(UMCCreator &reference, UMCCreator &candidate, std::vector<int> &candidateOfReference) ;
+
+public:
+	static const int MAX_REPORTED_DIFFERENCES = 100 ;
+
+	// numThreads <= 0 uses one thread per hardware thread
+	ShadowVerifier(const FeatureFinderOptions &options, int numThreads) ;
+	~ShadowVerifier(void) ;
+
+	// "index" or "pool"; false for any other name
+	bool SetPath(const char *pathName) ;
+	const char *GetPathName() ;
+	// Largest relative difference of two masses or abundances that still counts as equal; 1e-9 by default
+	void SetTolerance(double tolerance) { mdbl_tolerance = tolerance ; } ;
+
+	// Loads the input file of the options, runs both clusterings and compares them; returns the number of
+	// differences (peaks plus features). Throws like UMCCreator::ReadCSVFile when the input cannot be loaded.
+	int Run() ;
+	bool WriteReportFile(const char *fileName) ;
+
+	int GetNumPeaks() { return mint_num_peaks ; } ;
+	int GetNumReferenceUmcs() { return mint_num_reference_umcs ; } ;
+	int GetNumCandidateUmcs() { return mint_num_candidate_umcs ; } ;
+	double GetReferenceSeconds() { return mdbl_reference_seconds ; } ;
+	double GetCandidateSeconds() { return mdbl_candidate_seconds ; } ;
+	int GetNumPeakDifferences() { return mint_num_peak_differences ; } ;
+	int GetNumUmcDifferences() { return mint_num_umc_differences ; } ;
+};
@@ -0,0 +1,339 @@
+// StreamDecompressor.cpp : gzip / zstd decoding on a thread of its own for MemMappedReader.
+// Native only (uses <thread> through BoundedQueue); the header can be included by /clr code.
+
+#include "StreamDecompressor.h"
+#include "BoundedQueue.h"
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+#ifdef UMCCREATOR_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef UMCCREATOR_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace
+{
+	// decoded bytes handed to the reader at a time; lines are far shorter, so a line spans at most two blocks
+	const int DECODED_BLOCK_BYTES = 2 * 1024 * 1024 ;
+	// decoded blocks that may wait for the reader; two more are held by the decoder and the reader
+	const int DECODED_QUEUE_DEPTH = 4 ;
+	const int INPUT_BLOCK_BYTES = 1024 * 1024 ;
+}
+
+struct DecodedBlock
+{
+	std::vector<char> mvect_data ;
+	long long mlng_length ;
+	long long mlng_input_position ;
+} ;
+
+struct StreamDecompressorState
+{
+	FILE *mobj_file ;
+	CompressionFormat menm_format ;
+	std::vector<DecodedBlock*> mvect_blocks ;
+	BoundedQueue<DecodedBlock*> mobj_decoded ;
+	BoundedQueue<DecodedBlock*> mobj_free ;
+	DecodedBlock *mobj_current ;		// the block the reader is on
+	std::thread mobj_thread ;
+	// set by the decoder before it closes mobj_decoded
+	const char *mstr_error ;
+
+	StreamDecompressorState() : mobj_decoded(DECODED_QUEUE_DEPTH), mobj_free(DECODED_QUEUE_DEPTH + 2)
+	{
+		mobj_file = NULL ;
+		menm_format = COMPRESSION_NONE ;
+		mobj_current = NULL ;
+		mstr_error = NULL ;
+	}
+} ;
+
+namespace
+{
+	// Fills decoded blocks for the decoder and passes the full ones on to the reader
+	class DecodedBlockWriter
+	{
+		StreamDecompressorState *mobj_state ;
+		DecodedBlock *mobj_block ;
+
+	public:
+		DecodedBlockWriter(StreamDecompressorState *state)
+		{
+			mobj_state = state ;
+			mobj_block = NULL ;
+		}
+
+		// Returns false once the reader has closed the stream
+		bool Begin()
+		{
+			if (!mobj_state->mobj_free.Pop(mobj_block))
+				return false ;
+			mobj_block->mlng_length = 0 ;
+			return true ;
+		}
+		char *Space() { return &mobj_block->mvect_data[0] + mobj_block->mlng_length ; }
+		size_t Available() { return mobj_block->mvect_data.size() - (size_t) mobj_block->mlng_length ; }
+
+		bool Produced(size_t bytes, long long inputPosition)
+		{
+			mobj_block->mlng_length += (long long) bytes ;
+			if (Available() > 0)
+				return true ;
+			return Flush(inputPosition) && Begin() ;
+		}
+
+		bool Flush(long long inputPosition)
+		{
+			if (mobj_block->mlng_length == 0)
+				return true ;
+			mobj_block->mlng_input_position = inputPosition ;
+			return mobj_state->mobj_decoded.Push(mobj_block) ;
+		}
+	};
+
+#ifdef UMCCREATOR_HAVE_ZLIB
+	struct GzipStream
+	{
+		z_stream mobj_stream ;
+		GzipStream()
+		{
+			memset(&mobj_stream, 0, sizeof(mobj_stream)) ;
+			// 15 + 32: largest window, gzip or zlib header detected from the stream
+			if (inflateInit2(&mobj_stream, 15 + 32) != Z_OK)
+				throw "Unable to start the gzip decoder" ;
+		}
+		~GzipStream() { inflateEnd(&mobj_stream) ; }
+	} ;
+
+	void DecodeGzip(StreamDecompressorState *state, DecodedBlockWriter &writer)
+	{
+		GzipStream gzip ;
+		z_stream &stream = gzip.mobj_stream ;
+		std::vector<unsigned char> input(INPUT_BLOCK_BYTES) ;
+		long long inputPosition = 0 ;
+		bool memberEnded = false ;
+		bool outputFull = false ;
+
+		while (true)
+		{
+			// a full output block may leave decoded bytes inside the decoder, so only read on once it has room to spare
+			if (stream.avail_in == 0 && !outputFull)
+			{
+				size_t numRead = fread(&input[0], 1, input.size(), state->mobj_file) ;
+				if (numRead == 0)
+					break ;
+				inputPosition += (long long) numRead ;
+				stream.next_in = &input[0] ;
+				stream.avail_in = (uInt) numRead ;
+			}
+			if (memberEnded && stream.avail_in > 0)
+			{
+				// files written by several gzip runs (or pigz) hold one member after the other
+				inflateReset(&stream) ;
+				memberEnded = false ;
+			}
+
+			stream.next_out = (Bytef *) writer.Space() ;
+			stream.avail_out = (uInt) writer.Available() ;
+			int result = inflate(&stream, Z_NO_FLUSH) ;
+			if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+				throw "Corrupt gzip input" ;
+			memberEnded = result == Z_STREAM_END ;
+
+			size_t produced = writer.Available() - stream.avail_out ;
+			outputFull = stream.avail_out == 0 ;
+			if (!writer.Produced(produced, inputPosition - stream.avail_in))
+				return ;
+		}
+		if (!memberEnded)
+			throw "Truncated gzip input" ;
+		writer.Flush(inputPosition) ;
+	}
+#endif
+
+#ifdef UMCCREATOR_HAVE_ZSTD
+	struct ZstdStream
+	{
+		ZSTD_DStream *mobj_stream ;
+		ZstdStream()
+		{
+			mobj_stream = ZSTD_createDStream() ;
+			if (mobj_stream == NULL || ZSTD_isError(ZSTD_initDStream(mobj_stream)))
+			{
+				ZSTD_freeDStream(mobj_stream) ;
+				throw "Unable to start the zstd decoder" ;
+			}
+		}
+		~ZstdStream() { ZSTD_freeDStream(mobj_stream) ; }
+	} ;
+
+	void DecodeZstd(StreamDecompressorState *state, DecodedBlockWriter &writer)
+	{
+		ZstdStream zstd ;
+		std::vector<char> input(INPUT_BLOCK_BYTES) ;
+		long long inputPosition = 0 ;
+		// 0 once a frame is complete; frames may follow each other
+		size_t lastResult = 0 ;
+
+		while (true)
+		{
+			size_t numRead = fread(&input[0], 1, input.size(), state->mobj_file) ;
+			if (numRead == 0)
+				break ;
+			inputPosition += (long long) numRead ;
+
+			ZSTD_inBuffer in = { &input[0], numRead, 0 } ;
+			bool outputFull = false ;
+			while (in.pos < in.size || outputFull)
+			{
+				ZSTD_outBuffer out = { writer.Space(), writer.Available(), 0 } ;
+				lastResult = ZSTD_decompressStream(zstd.mobj_stream, &out, &in) ;
+				if (ZSTD_isError(lastResult))
+					throw "Corrupt zstd input" ;
+				outputFull = out.pos == out.size ;
+				if (!writer.Produced(out.pos, inputPosition - (long long) (in.size - in.pos)))
+					return ;
+			}
+		}
+		if (lastResult != 0)
+			throw "Truncated zstd input" ;
+		writer.Flush(inputPosition) ;
+	}
+#endif
+
+	void DecodeFile(StreamDecompressorState *state)
+	{
+		try
+		{
+			DecodedBlockWriter writer(state) ;
+			if (writer.Begin())
+			{
+#ifdef UMCCREATOR_HAVE_ZLIB
+				if (state->menm_format == COMPRESSION_GZIP)
+					DecodeGzip(state, writer) ;
+#endif
+#ifdef UMCCREATOR_HAVE_ZSTD
+				if (state->menm_format == COMPRESSION_ZSTD)
+					DecodeZstd(state, writer) ;
+#endif
+			}
+		}
+		catch (const char *message)
+		{
+			state->mstr_error = message ;
+		}
+		catch (...)
+		{
+			state->mstr_error = "Unable to decompress the input file" ;
+		}
+		state->mobj_decoded.Close() ;
+	}
+}
+
+StreamDecompressor::StreamDecompressor(void)
+{
+	mobj_state = NULL ;
+}
+
+StreamDecompressor::~StreamDecompressor(void)
+{
+	Close() ;
+}
+
+CompressionFormat StreamDecompressor::DetectFormat(const char *header, long long headerLength)
+{
+	const unsigned char *bytes = (const unsigned char *) header ;
+	if (headerLength >= 2 && bytes[0] == 0x1F && bytes[1] == 0x8B)
+		return COMPRESSION_GZIP ;
+	if (headerLength >= 4 && bytes[0] == 0x28 && bytes[1] == 0xB5 && bytes[2] == 0x2F && bytes[3] == 0xFD)
+		return COMPRESSION_ZSTD ;
+	return COMPRESSION_NONE ;
+}
+
+bool StreamDecompressor::IsSupported(CompressionFormat format)
+{
+#ifdef UMCCREATOR_HAVE_ZLIB
+	if (format == COMPRESSION_GZIP)
+		return true ;
+#endif
+#ifdef UMCCREATOR_HAVE_ZSTD
+	if (format == COMPRESSION_ZSTD)
+		return true ;
+#endif
+	return format == COMPRESSION_NONE ;
+}
+
+bool StreamDecompressor::Open(const char *fileName, CompressionFormat format)
+{
+	Close() ;
+	FILE *file = fopen(fileName, "rb") ;
+	if (file == NULL)
+		return false ;
+
+	mobj_state = new StreamDecompressorState() ;
+	mobj_state->mobj_file = file ;
+	mobj_state->menm_format = format ;
+	if (format == COMPRESSION_NONE || !IsSupported(format))
+	{
+		// reported by the first NextBlock, where the reader expects errors about the contents
+		mobj_state->mstr_error = "Compressed input is not supported by this build" ;
+		mobj_state->mobj_decoded.Close() ;
+		return true ;
+	}
+
+	for (int blockNum = 0 ; blockNum < DECODED_QUEUE_DEPTH + 2 ; blockNum++)
+	{
+		DecodedBlock *block = new DecodedBlock() ;
+		block->mvect_data.resize(DECODED_BLOCK_BYTES) ;
+		block->mlng_length = 0 ;
+		block->mlng_input_position = 0 ;
+		mobj_state->mvect_blocks.push_back(block) ;
+		mobj_state->mobj_free.Push(block) ;
+	}
+	mobj_state->mobj_thread = std::thread(DecodeFile, mobj_state) ;
+	return true ;
+}
+
+bool StreamDecompressor::NextBlock(char *&data, long long &length, long long &inputPosition)
+{
+	if (mobj_state == NULL)
+		return false ;
+
+	if (mobj_state->mobj_current != NULL)
+	{
+		mobj_state->mobj_free.Push(mobj_state->mobj_current) ;
+		mobj_state->mobj_current = NULL ;
+	}
+	DecodedBlock *block ;
+	if (!mobj_state->mobj_decoded.Pop(block))
+	{
+		if (mobj_state->mstr_error != NULL)
+			throw mobj_state->mstr_error ;
+		return false ;
+	}
+	mobj_state->mobj_current = block ;
+	data = &block->mvect_data[0] ;
+	length = block->mlng_length ;
+	inputPosition = block->mlng_input_position ;
+	return true ;
+}
+
+void StreamDecompressor::Close()
+{
+	if (mobj_state == NULL)
+		return ;
+
+	// a decoder still running finds both queues closed and stops at its next block
+	mobj_state->mobj_decoded.Close() ;
+	mobj_state->mobj_free.Close() ;
+	if (mobj_state->mobj_thread.joinable())
+		mobj_state->mobj_thread.join() ;
+	fclose(mobj_state->mobj_file) ;
+	for (int blockNum = 0 ; blockNum < (int) mobj_state->mvect_blocks.size() ; blockNum++)
+		delete mobj_state->mvect_blocks[blockNum] ;
+	delete mobj_state ;
+	mobj_state = NULL ;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "CompressionFormat.h"
+
+struct StreamDecompressorState ;
+
+/*
+ * Decompresses a gzip or zstd file on a thread of its own and hands the output to the reader in large blocks,
+ * so that the decompression of block N+1 overlaps the parsing of block N. At most a few blocks are held at a time.
+ * The codecs are compiled in when UMCCREATOR_HAVE_ZLIB / UMCCREATOR_HAVE_ZSTD are defined; a file in a format this
+ * build cannot read fails on the first NextBlock.
+ * The header can be included by /clr code; the thread lives in StreamDecompressor.cpp.
+ */
+class StreamDecompressor
+{
+	StreamDecompressorState *mobj_state ;
+
+	StreamDecompressor(const StreamDecompressor &) ;
+	StreamDecompressor & operator=(const StreamDecompressor &) ;
+
+public:
+	StreamDecompressor(void) ;
+	~StreamDecompressor(void) ;
+
+	// Recognizes the format from the first bytes of a file (the gzip and zstd magic numbers)
+	static CompressionFormat DetectFormat(const char *header, long long headerLength) ;
+	static bool IsSupported(CompressionFormat format) ;
+
+	// Starts decompressing fileName; returns false if the file cannot be opened
+	bool Open(const char *fileName, CompressionFormat format) ;
+	// Hands over the next block of decompressed bytes, valid until the next call or Close, and the number of
+	// compressed bytes consumed up to the end of it. Returns false at the end of the stream; throws on corrupt
+	// input or a format that is not supported by this build.
+	bool NextBlock(char *&data, long long &length, long long &inputPosition) ;
+	void Close() ;
+};
@@ -1,9 +1,9 @@
-#include ".\umc.h"
-
-UMC::UMC(void)
-{
-}
-
-UMC::~UMC(void)
-{
-}
+#include "UMC.h"
+
+UMC::UMC(void)
+{
+}
+
+UMC::~UMC(void)
+{
+}
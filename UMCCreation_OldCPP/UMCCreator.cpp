@@ -1,1161 +1,1952 @@
-#include ".\umccreator.h"
-#include "MemMappedReader.h"
-#include <stdlib.h> 
-#include <algorithm>
-#include <iostream> 
-#include <fstream>
-#include <cmath>
-#include <stddef.h>
-
-#define DEBUG
-#define DATAFILTERS
-using namespace std;
-
-bool SortUMCsByMonoMassAndScan(UMC &a, UMC &b)
-{
-	if ( a.mdbl_average_mono_mass < b.mdbl_average_mono_mass){
-		return true;
-	}
-
-	return false;
-}
-
-
-bool SortIsotopesByMonoMassAndScan(IsotopePeak &a, IsotopePeak &b) 
-{
-	if (a.mdbl_mono_mass < b.mdbl_mono_mass)
-		return true ; 
-
-	return false;
-}
-
-UMCCreator::UMCCreator(void)
-{
-	mflt_wt_mono_mass = 0.01F ; // using ppms 10 ppm = length of 0.1 ppm
-	mflt_wt_average_mass = 0.01F ; // using ppms 10 ppm = length of 0.1 ppm
-	mflt_wt_log_abundance = 0.1F ; 
-	mflt_wt_scan = 0.01F ; 
-	mflt_wt_fit = 0.1F ; 
-	mflt_wt_ims_drift_time = 0.1F ;
-
-	mflt_constraint_mono_mass = 10.0F ; // is in ppm
-	mflt_constraint_average_mass = 10.0F ; // is in ppm. 
-	mdbl_max_distance = 0.1 ; 
-	
-	mbln_use_net = true ;
-	mbln_constraint_mono_mass_is_ppm = true ;
-	mbln_constraint_average_mass_is_ppm = true ;
-
-	mshort_percent_complete = 0 ;
-
-	mint_lc_min_scan = INT_MAX ; 
-	mint_lc_max_scan = 0 ;
-	mint_ims_min_scan = INT_MAX;
-	mint_ims_max_scan = 0;
-}
-
-UMCCreator::~UMCCreator(void)
-{
-}
-
-int UMCCreator::ReadCSVFile(){
-	return ReadCSVFile(mstr_inputFile);
-}
-
-int UMCCreator::ReadCSVFile(char *fileName)
-{
-	char startTag[1024] ; //will be defined based on header
-	int startTagLength;
-	char *stopTag = "Blah" ; 
-	int stopTagLen = (int)strlen(stopTag) ; 
-
-	
-	Reset() ; 
-	MemMappedReader mappedReader ; 
-	mappedReader.Load(fileName) ; 
-	__int64 file_len = mappedReader.FileLength() ; 
-
-
-	//columns for IMS data 
-	//'frame_num,ims_scan_num,charge,abundance,mz,fit,average_mw,monoisotopic_mw,mostabundant_mw,fwhm,signal_noise,mono_abundance,mono_plus2_abundance,orig_intensity,TIA_orig_intensity, drift_time,cumulative_drift_time\n'
-
-	//columns for LC-MS data
-	//scan_num,charge,abundance,mz,fit,average_mw,monoisotopic_mw,mostabundant_mw,fwhm,signal_noise,mono_abundance,mono_plus2_abundance/
-
-
-	bool reading = false ; 
-	bool is_first_scan = true ; 
-
-	IsotopePeak pk ; 
-	short charge = 0 ; 
-	double abundance = 0 ;
-	float fit = 0, mz = 0 , averageMass = 0 , monoMass = 0 , maxMass = 0 ;  
-
-	int numPeaks = 0 ; 
-	int origLineNumber = 0;
-
-	mshort_percent_complete = 0 ;
-
-	pk.mdbl_abundance = 0 ; 
-	pk.mdbl_i2_abundance = 0 ; 
-	pk.mdbl_average_mass = 0 ; 
-	pk.mflt_fit = 0 ; 
-	pk.mdbl_max_abundance_mass = 0 ; 
-	pk.mdbl_mono_mass = 0 ; 
-	pk.mdbl_mz = 0 ; 
-	pk.mshort_charge = 0 ; 
-	pk.mflt_ims_drift_time = 0 ;
-
-	mint_lc_min_scan = INT_MAX ; 
-	mint_lc_max_scan = 0 ; 
-
-	int pos = 0 ; 
-	const int MAX_HEADER_BUFFER_LEN = 1024 ; 
-	const int MAX_BUFFER_LEN = 1024 ; 
-	char buffer[MAX_BUFFER_LEN] ;
-
-	mshort_percent_complete = (short)((100.0 * mappedReader.CurrentPosition()) / file_len) ; 
-	if (mshort_percent_complete > 99)
-		mshort_percent_complete = 99 ; 
-
-	bool success = mappedReader.GetNextLine(buffer, MAX_BUFFER_LEN, "\n", MAX_BUFFER_LEN);
-
-#ifdef DBUG
-	std::cout << "Success = " << success << "\n";
-#endif
-
-	if (success){
-		if (buffer[0] == 'f'){
-			strcpy(startTag, "frame_num,ims_scan_num,charge,abundance,mz,fit,average_mw,monoisotopic_mw,mostabundant_mw,fwhm,signal_noise,mono_abundance,mono_plus2_abundance,orig_intensity,TIA_orig_intensity,drift_time");
-			mbln_is_ims_data = true;
-		}
-		else{
-			strcpy(startTag,"scan_num,charge,abundance,mz,fit,average_mw, monoisotopic_mw,mostabundant_mw,fwhm,signal_noise,mono_abundance,mono_plus2_abundance") ; 
-			mbln_is_ims_data = false;
-		}
-	}
-	
-	startTagLength = (int)strlen(startTag) ; 
-
-#ifdef DBUG
-	std::cout << "Data file is IMS? (1=Yes, 0=No):: " << mbln_is_ims_data << "\n";
-#endif
-
-	//success = mappedReader.SkipToAfterLine(startTag, buffer, startTagLength, MAX_BUFFER_LEN) ; 
-	if (!success)
-	{
-		throw "Incorrect header for file" ; 
-	}
-	double fwhm = 0, s2n = 0 ;
-
-	while(!mappedReader.eof() && mappedReader.GetNextLine(buffer, MAX_BUFFER_LEN, stopTag, stopTagLen))
-	{
-
-		mshort_percent_complete = (short)((100.0 * mappedReader.CurrentPosition()) / file_len) ; 
-
-		if (mshort_percent_complete > 99)
-			mshort_percent_complete = 99 ; 
-		char *stopPtr ; 
-		char *stopPtrNext ; 
-
-		//in either case the first value is the lc_scan_num
-		pk.mint_lc_scan = strtol(buffer, &stopPtr, 10) ; 
-
-
-		stopPtr++ ; 
-
-		if (mbln_is_ims_data){
-			//then we need to parse out ims_scan number
-			pk.mint_ims_scan =strtol(stopPtr, &stopPtrNext, 10) ; 
-			stopPtr = ++stopPtrNext;
-		}
-
-		pk.mshort_charge = (short) strtol(stopPtr, &stopPtrNext, 10) ; 
-		stopPtr = ++stopPtrNext ; 
-		pk.mdbl_abundance = strtod(stopPtr, &stopPtrNext) ; 
-		stopPtr = ++stopPtrNext ; 
-		pk.mdbl_mz = strtod(stopPtr, &stopPtrNext) ; 
-		stopPtr = ++stopPtrNext ; 
-		pk.mflt_fit = (float)strtod(stopPtr, &stopPtrNext) ; 
-		stopPtr = ++stopPtrNext ; 
-		pk.mdbl_average_mass = strtod(stopPtr, &stopPtrNext) ; 
-		stopPtr = ++stopPtrNext ; 
-		pk.mdbl_mono_mass = strtod(stopPtr, &stopPtrNext) ; 
-		stopPtr = ++stopPtrNext ; 
-		pk.mdbl_max_abundance_mass = strtod(stopPtr, &stopPtrNext) ; 
-		stopPtr = ++stopPtrNext ; 
-		fwhm = strtod(stopPtr, &stopPtrNext) ; 
-		stopPtr = ++stopPtrNext ; 
-		s2n = strtod(stopPtr, &stopPtrNext) ; 
-		stopPtr = ++stopPtrNext ; 
-		pk.mdbl_mono_abundance = strtod(stopPtr, &stopPtrNext) ; 
-		stopPtr = ++stopPtrNext ; 
-		pk.mdbl_i2_abundance = strtod(stopPtr, &stopPtrNext) ; 
-		stopPtr = ++stopPtrNext ; 
-
-		//if it's ims data then we have to read four more columns of data
-		if (mbln_is_ims_data){
-			//orig intensity, TIA original intensity, drift time and cumulative drift time
-			pk.mflt_orig_intensity = strtod(stopPtr, &stopPtrNext);
-			stopPtr = ++stopPtrNext;
-
-			pk.mflt_tia_orig_intensity = strtod(stopPtr, &stopPtrNext);
-			stopPtr = ++stopPtrNext;
-			pk.mflt_ims_drift_time = strtod(stopPtr, &stopPtrNext);
-			stopPtr = ++stopPtrNext;
-			pk.mflt_cum_drift_time = strtod(stopPtr, &stopPtrNext);
-			stopPtr = ++stopPtrNext;
-
-		}
-
-		// Check here to see of MAP index is correct. Dameng
-		pk.mint_original_index = numPeaks ; //when reading from the file, this should be the line number in the original isos file
-		pk.mint_line_number_in_file = origLineNumber;
-
-		//check if the filter criteria is satisfied before adding a peak
-		if ( ConsiderPeak(pk)){
-
-			// Remove the following condition may cause one segment has more than mint_max_data_points
-			if ( false ){
-				if ( mbln_process_mass_seg ){
-					if ( numPeaks > mint_max_data_points ){
-						std::cout << "I know this happens" << "\n";
-						numPeaks--;
-						break;
-					}
-				}
-			}
-				#ifdef DBUG
-					std::cout << "Adding peak ... "  << ConsiderPeak(pk) << "\n";
-				#endif
-            
-				//check if the min scans and max scans for both lc and ims need to be fixed
-				if (pk.mint_lc_scan <= mint_lc_min_scan ){
-					mint_lc_min_scan = pk.mint_lc_scan;
-				}
-	
-				if (pk.mint_lc_scan >= mint_lc_max_scan){
-					mint_lc_max_scan = pk.mint_lc_scan;
-				}
-
-				if ( mbln_is_ims_data ){
-					//need to fix the ims min scans and max scans that were loaded
-					if ( pk.mint_ims_scan <= mint_ims_min_scan ){
-						mint_ims_min_scan = pk.mint_ims_scan;
-					}
-
-					if ( pk.mint_ims_scan >= mint_ims_max_scan ){
-						mint_ims_max_scan = pk.mint_ims_scan;
-					}
-				}
-	
-				mvect_isotope_peaks.push_back(pk) ;
-
-				#ifdef DBUG
-					pk.printPeak();
-				#endif
-				//increment number of peaks read
-				numPeaks++ ; 
-
-		}
-
-		origLineNumber++;
-		
-	}
-
-	mappedReader.Close();
-	return numPeaks;
-}
-
-int UMCCreator::LoadPeaksFromDatabase(){
-	//this is to read a sql lite database and retrieve the peaks from it into the mvect_isotope_peaks array.
-
-	return 0;
-
-}
-
-//Method not used, 
-void UMCCreator::SerializeObjects(){
-
-
-	//First write out all loaded isotopic peaks
-	//we should be smarter about this file writing since there's going to be sufficient 
-	//number of peaks that don't get used into any UMC or get removed as part of short UMCs
-	//maybe each peak needs to have a bit whether to used or not
-	ofstream ofs("mvect_isotope_peaks.ros", ios::binary);
-
-	//this should write only peaks that are being used to the file
-	int count = 0;
-	for ( int i = 0; i < mvect_isotope_peaks.size(); i++){
-
-		IsotopePeak pk = (IsotopePeak ) mvect_isotope_peaks[i];
-		if ( pk.mint_umc_index != -1){
-       		ofs.write( (char*)&mvect_isotope_peaks[i], sizeof(IsotopePeak));
-			count++;
-		}
-	}
-
-	std::cout<<"Number of peaks written to file is " << count << " while total = " << mvect_isotope_peaks.size() << std::endl;
-
-	ofs.close();
-
-	//write out the umc classes
-	ofstream ofs1("mvect_umcs", ios::binary);
-	for ( int  i=0; i < mvect_umcs.size(); i++){
-		ofs1.write( (char*)&mvect_umcs[i], sizeof(UMC));
-	}
-
-	ofs1.close();
-
-
-	//write out the multimap that maps the indices on the isotopic peaks
-	//to the indices on the umcs
-	fstream fs("mmultimap_umc_2_peak_index", ios::out);
-		
-	for (std::multimap<int,int>::iterator iter = mmultimap_umc_2_peak_index.begin() ; iter != mmultimap_umc_2_peak_index.end() ; )
-	{
-			
-		int umc_index = (*iter).first ; 
-		int peak_index = (*iter).second;
-		fs << umc_index << "\t" << peak_index <<std::endl;
-	}
-
-	fs.close();
-}
-
-
-void UMCCreator::DeserializeObjects(){
-
-}
-
-
-float UMCCreator::GetLastMonoMassLoaded(){
-	float mass = FLT_MAX;
-	try{
-		IsotopePeak peak = (IsotopePeak) mvect_isotope_peaks[mvect_isotope_peaks.size()];
-		mass = peak.mdbl_mono_mass;
-	}
-	catch(exception e){
-	}
-	return mass;
-
-}
-void UMCCreator::SetInputFileName(char *filename){
-	strcpy(mstr_inputFile, filename);
-}
-
-void UMCCreator::SetOutputDiretory(char * dir){
-	strcpy(outputDir, dir);
-}
-
-//could all start going into a single branch but have kept it such so that it's a little easier to read.
-//Method to determine whether the filter 
-bool UMCCreator::ConsiderPeak(IsotopePeak peak ){
-
-	bool consider = false;
-
-	if ( peak.mdbl_abundance >= mint_min_intensity && peak.mflt_fit <= mflt_isotopic_fit_filter){
-			consider = true;
-	}
-		//if we're processing a particular mass range then we have to check for the mono mass to be within bounds
-	if ( consider && mflt_mono_mass_start <= peak.mdbl_mono_mass && peak.mdbl_mono_mass <= mflt_mono_mass_end ){
-		consider = true;
-	}
-	else{
-		consider = false;
-	}
-		
-	
-	//check if data is within LC scan range
-	if ( consider && mint_lc_min_scan_filter <=  peak.mint_lc_scan && peak.mint_lc_scan <= mint_lc_max_scan_filter  ){
-		consider = true;
-	}
-	else{
-		consider = false;
-	}
-
-	if ( mbln_is_ims_data ){
-		//check fi data is within ims scans
-		if ( consider && mint_ims_min_scan_filter <= peak.mint_ims_scan && peak.mint_ims_scan <= mint_ims_max_scan_filter ){
-			consider = true;
-		}
-		else{
-			consider = false;
-		}
-	}
-
-	return consider;
-}
-
-void UMCCreator::CalculateUMCs()
-{
-	mvect_umcs.clear() ; 
-	mvect_umcs.reserve(mvect_umc_num_members.size()) ; 
-
-	std::vector<double> vect_mass ; 
-
-	UMC new_umc ; 
-	mshort_percent_complete = 0 ; 
-	int num_umcs = mvect_umcs.size() ; 
-
-	for (std::multimap<int,int>::iterator iter = mmultimap_umc_2_peak_index.begin() ; iter != mmultimap_umc_2_peak_index.end() ; )
-	{
-		vect_mass.clear() ; 
-		int umc_index = (*iter).first ; 
-		mshort_percent_complete = (short) ((100.0 * umc_index) / num_umcs) ; 
-		int numMembers = mvect_umc_num_members[umc_index] ; 
-		int minScan = INT_MAX ; 
-		int maxScan = INT_MIN ; 
-		double minMass = DBL_MAX ; 
-		double maxMass = -1 * DBL_MAX ; 
-		double maxAbundance = -1 * DBL_MAX ; 
-		double sumAbundance = 0 ; 
-		double sumMonoMass = 0 ; 
-		int maxAbundanceScan = 0 ; 
-		short classRepCharge = 0 ; 
-		double classRepMz = 0 ; 
-
-		while(iter != mmultimap_umc_2_peak_index.end() && (*iter).first == umc_index)
-		{
-			IsotopePeak pk = mvect_isotope_peaks[(*iter).second] ; 
-			vect_mass.push_back(pk.mdbl_mono_mass) ; 
-
-			if (pk.mint_lc_scan > maxScan)
-				maxScan = pk.mint_lc_scan ; 
-			if (pk.mint_lc_scan < minScan )
-				minScan = pk.mint_lc_scan ; 
-
-			if (pk.mdbl_mono_mass > maxMass)
-				maxMass = pk.mdbl_mono_mass ; 
-			if (pk.mdbl_mono_mass < minMass )
-				minMass = pk.mdbl_mono_mass ; 
-
-			if (pk.mdbl_abundance > maxAbundance)
-			{
-				maxAbundance = pk.mdbl_abundance ; 
-				maxAbundanceScan = pk.mint_lc_scan ; 
-				classRepCharge = pk.mshort_charge ; 
-				classRepMz = pk.mdbl_mz ; 
-			}
-			sumAbundance += pk.mdbl_abundance ; 
-
-			sumMonoMass += pk.mdbl_mono_mass ; 
-
-			iter++ ; 
-		}
-
-		sort(vect_mass.begin(), vect_mass.end()) ; 
-
-		new_umc.mint_umc_index = umc_index ; 
-		new_umc.min_num_members = numMembers ; 
-		new_umc.mint_start_scan = minScan ; 
-		new_umc.mint_stop_scan = maxScan ; 
-		new_umc.mint_max_abundance_scan = maxAbundanceScan ; 
-
-		new_umc.mdbl_max_abundance = maxAbundance ; 
-		new_umc.mdbl_sum_abundance = sumAbundance ;
-
-		new_umc.mdbl_min_mono_mass = minMass ; 
-		new_umc.mdbl_max_mono_mass = maxMass ; 
-		new_umc.mdbl_average_mono_mass = sumMonoMass/numMembers ; 
-
-		new_umc.mdbl_class_rep_mz = classRepMz ; 
-		new_umc.mshort_class_rep_charge = classRepCharge ; 
-
-		if (numMembers % 2 == 1)
-		{
-			new_umc.mdbl_median_mono_mass = vect_mass[numMembers/2] ; 
-		}
-		else
-		{
-			new_umc.mdbl_median_mono_mass = 0.5 * (vect_mass[numMembers/2-1] + vect_mass[numMembers/2]) ; 
-		}
-		mvect_umcs.push_back(new_umc) ; 
-	}
-}
-
-void UMCCreator::RemoveShortUMCs(int min_length)
-{
-	std::vector<int> vectNewUMCLength ; 
-	// first reset all isotope peak umc indices to -1. 
-	int numIsotopePeaks = mvect_isotope_peaks.size() ;
-	for (int peakNum = 0 ; peakNum < numIsotopePeaks ; peakNum++)
-	{
-		mvect_isotope_peaks[peakNum].mint_umc_index = -1 ; 
-	}
-
-	int numUmcsSoFar = 0 ; 
-
-	mshort_percent_complete = 0 ; 
-
-	int num_umcs = mmultimap_umc_2_peak_index.size() ; 
-	for (std::multimap<int,int>::iterator iter = mmultimap_umc_2_peak_index.begin() ; iter != mmultimap_umc_2_peak_index.end() ; )
-	{
-		int currentOldUmcNum = (*iter).first ; 
-		mshort_percent_complete = (short) ((100.0 * currentOldUmcNum) / num_umcs) ; 
-
-		int numMembers = mvect_umc_num_members[currentOldUmcNum] ; 
-		while(iter != mmultimap_umc_2_peak_index.end() && (*iter).first == currentOldUmcNum)
-		{
-			if (numMembers >= min_length)
-			{
-				mvect_isotope_peaks[(*iter).second].mint_umc_index = numUmcsSoFar ; 
-			}
-			iter++ ; 
-		}
-		if (numMembers >= min_length)
-		{
-			mvect_umc_num_members[numUmcsSoFar] = numMembers ; 
-			numUmcsSoFar++ ; 
-		}
-	}
-	mvect_umc_num_members.resize(numUmcsSoFar) ; 
-	// now set the map object. 
-	mmultimap_umc_2_peak_index.clear() ; 
-	for (int pkNum = 0 ; pkNum < numIsotopePeaks ; pkNum++)
-	{
-		IsotopePeak pk = mvect_isotope_peaks[pkNum] ; 
-		if (pk.mint_umc_index != -1)
-		{
-			mmultimap_umc_2_peak_index.insert(std::pair<int,int>(pk.mint_umc_index, pkNum)) ; 
-		}
-	}
-	// DONE!! 
-}
-
-
-bool UMCCreator::withinMassTolerance(double observedMass, double realMass){
-	double massDifferenceInPPM = abs(realMass - observedMass)* 1000000/realMass;
-	return ( massDifferenceInPPM <= mflt_constraint_mono_mass);
-}
-
-
-
-void UMCCreator::CreateUMCsSinglyLinkedWithAll()
-{
-	bool chargeStateMatch = true;
-	mshort_percent_complete = 0 ; 
-	mmultimap_umc_2_peak_index.clear() ; 
-	int numPeaks = mvect_isotope_peaks.size() ; 
-	for (int pkNum = 0 ; pkNum < numPeaks ; pkNum++)
-	{
-		mvect_isotope_peaks[pkNum].mint_umc_index = -1 ; 
-	}
-
-	std::vector<IsotopePeak> vectTempPeaks ; 
-
-	vectTempPeaks.insert(vectTempPeaks.begin(), mvect_isotope_peaks.begin(), mvect_isotope_peaks.end()) ; 
-
-	// basically take all umcs sorted in mass and perform single linkage clustering. 
-	sort(vectTempPeaks.begin(), vectTempPeaks.end(), &SortIsotopesByMonoMassAndScan) ; 
-
-
-	// now we are sorted. Start with the first index and move rightwards.
-	// For each index, 
-	// 1. If it already belongs to a UMC, move right comparing to all umcs in mass tolerance. For each match
-	//		a. If match is not in a UMC, calculate distance. If within tolerance add it to current umc.
-	//		b. If match is in the same UMC skip.
-	//		c. If match is in a different UMC, calculate distance. If within tolerance, merge umcs, update current guys UMC number.
-	// 2. If it does not belong to a UMC, move right comparing to all umcs in mass tolerance. For each match, calculate distance.
-	//		a. Create new UMC and follow 1.
-
-	int currentIndex = 0 ; 
-
-	IsotopePeak currentPeak ; 
-	IsotopePeak matchPeak ; 
-	int numUmcsSoFar = 0 ; 
-	double currentDistance = 0 ; 
-	std::multimap<int, int>::iterator iter ; 
-	std::multimap<int, int>::iterator deleteIter ; 
-	std::vector<int> tempIndices ; // used to store indices of isotope peaks that are moved from one umc to another. 
-	tempIndices.reserve(128) ; 
-
-
-	mshort_percent_complete = 0 ; 
-	while(currentIndex < numPeaks)
-	{
-		mshort_percent_complete = (short)((100.0 * currentIndex)/numPeaks) ; 
-		currentPeak = vectTempPeaks[currentIndex] ; 
-		if (currentPeak.mint_umc_index == -1)
-		{
-			// create UMC
-			mmultimap_umc_2_peak_index.insert(std::pair<int,int>(numUmcsSoFar, currentIndex)) ; 
-			currentPeak.mint_umc_index = numUmcsSoFar ; 
-			vectTempPeaks[currentIndex].mint_umc_index = numUmcsSoFar ; 
-			numUmcsSoFar++ ; 
-		}
-		int matchIndex = currentIndex + 1; 
-		if (matchIndex == numPeaks)
-			break ;
-
-		double massTolerance = mflt_constraint_mono_mass ; 
-		if (mbln_constraint_mono_mass_is_ppm)
-			massTolerance *= currentPeak.mdbl_mono_mass / 1000000.0 ;		// Convert from ppm to Da tolerance
-
-		double maxMass = currentPeak.mdbl_mono_mass + massTolerance ; 
-		matchPeak = vectTempPeaks[matchIndex] ; 
-		while (matchPeak.mdbl_mono_mass < maxMass)
-		{
-			if (matchPeak.mint_umc_index != currentPeak.mint_umc_index)
-			{		
-				currentDistance = PeakDistance(currentPeak, matchPeak) ; 
-				if (mbln_constraint_charge_state){
-						chargeStateMatch = (currentPeak.mshort_charge == matchPeak.mshort_charge);
-				}
-				if (currentDistance < mdbl_max_distance && chargeStateMatch)
-				{
-					if (matchPeak.mint_umc_index == -1)
-					{
-						mmultimap_umc_2_peak_index.insert(std::pair<int,int>(currentPeak.mint_umc_index, matchIndex)) ; 
-						vectTempPeaks[matchIndex].mint_umc_index = currentPeak.mint_umc_index ; 
-					}
-					else
-					{
-						tempIndices.clear() ; 
-						int numPeaksMerged = 0 ; 
-						// merging time. Merge this guy's umc into the next guys UMC.
-						for (iter = mmultimap_umc_2_peak_index.find(currentPeak.mint_umc_index) ; iter != mmultimap_umc_2_peak_index.end()
-							&& (*iter).first == currentPeak.mint_umc_index; )
-						{
-							deleteIter = iter ; 
-							int deletePeakIndex = (*iter).second ; 
-							tempIndices.push_back(deletePeakIndex) ; 
-							vectTempPeaks[deletePeakIndex].mint_umc_index = matchPeak.mint_umc_index ; 
-							iter++ ; 
-							mmultimap_umc_2_peak_index.erase(deleteIter) ; 
-							numPeaksMerged++ ; 
-						}
-						for (int mergedPeakNum = 0 ; mergedPeakNum < numPeaksMerged ; mergedPeakNum++)
-						{
-							mmultimap_umc_2_peak_index.insert(std::pair<int,int>(matchPeak.mint_umc_index, tempIndices[mergedPeakNum])) ; 
-						}
-						currentPeak.mint_umc_index = matchPeak.mint_umc_index ; 
-					}
-				}
-			}
-			matchIndex++ ;
-			if (matchIndex < numPeaks)
-			{
-				matchPeak = vectTempPeaks[matchIndex] ; 
-			}
-			else
-				break ; 
-		}
-		currentIndex++ ; 
-	}
-
-	// At the end of all of this. The mapping from mmultimap_umc_2_peak_index is from umc_index to index in sorted stuff. 
-	// Also, several of the umc indices are no longer valid. So lets step through the map, get new umc indices, renumber them,
-	// and set the umc indices in the original vectors.
-	numUmcsSoFar = 0 ; 
-	for (std::multimap<int,int>::iterator iter = mmultimap_umc_2_peak_index.begin() ; iter != mmultimap_umc_2_peak_index.end() ; )
-	{
-		int currentOldUmcNum = (*iter).first ; 
-		int numMembers = 0 ; 
-		while(iter != mmultimap_umc_2_peak_index.end() && (*iter).first == currentOldUmcNum)
-		{
-			IsotopePeak pk = vectTempPeaks[(*iter).second] ; 
-			mvect_isotope_peaks[pk.mint_original_index].mint_umc_index = numUmcsSoFar ; 
-			iter++ ; 
-			numMembers++ ; 
-		}
-		mvect_umc_num_members.push_back(numMembers) ; 
-		numUmcsSoFar++ ; 
-	}
-	// now set the map object. 
-	mmultimap_umc_2_peak_index.clear() ; 
-	for (int pkNum = 0 ; pkNum < numPeaks ; pkNum++)
-	{
-		IsotopePeak pk = mvect_isotope_peaks[pkNum] ; 
-		mmultimap_umc_2_peak_index.insert(std::pair<int,int>(pk.mint_umc_index, pkNum)) ; 
-	}
-	// DONE!! 
-}
-	
-void UMCCreator::SetPeks(std::vector<IsotopePeak> &vectPks)
-{
-	mvect_isotope_peaks.clear() ; 
-	mvect_isotope_peaks.insert(mvect_isotope_peaks.begin(), vectPks.begin(), vectPks.end()) ; 
-
-	int numPeaks = mvect_isotope_peaks.size() ; 
-	for (int i = 0 ; i < numPeaks  ; i++)
-	{
-		IsotopePeak pk = mvect_isotope_peaks[i] ; 
-		if (pk.mint_lc_scan > mint_lc_max_scan)
-			mint_lc_max_scan = pk.mint_lc_scan ; 
-		if (pk.mint_lc_scan < mint_lc_min_scan)
-			mint_lc_min_scan = pk.mint_lc_scan ; 
-	}
-}
-void UMCCreator::ReadPekFileMemoryMapped(char *fileName)
-{
-	Reset() ; 
-	MemMappedReader mappedReader ; 
-	mappedReader.Load(fileName) ; 
-	__int64 file_len = mappedReader.FileLength() ; 
-
-	char *fileNameTag = "Filename:" ; 
-	int fileNameTagLength = (int)strlen(fileNameTag) ; 
-	char *startTag = "CS,  Abundance,   m/z,   Fit,    Average MW, Monoisotopic MW,    Most abundant MW" ; 
-	char *startTagIsotopicLabeled = "CS,  Abundance,   m/z,   Fit,    Average MW, Monoisotopic MW,    Most abundant MW,   Imono,   I+2" ; 
-	int startTagLength = (int)strlen(startTag) ; 
-	char *stopTag = "Processing stop time:" ; 
-	int stopTagLen = (int)strlen(stopTag) ; 
-	bool reading = false ; 
-	bool isotopically_labeled = false ;
-	bool is_first_scan = true ; 
-	bool is_pek_file_from_wiff = false ; 
-
-	IsotopePeak pk ; 
-
-	short charge = 0 ; 
-	double abundance = 0 ;
-	float fit = 0, mz = 0 , averageMass = 0 , monoMass = 0 , maxMass = 0 ;  
-
-	int numPeaks = 0 ; 
-
-	mshort_percent_complete = 0 ;
-
-	pk.mdbl_abundance = 0 ; 
-	pk.mdbl_i2_abundance = 0 ; 
-	pk.mdbl_average_mass = 0 ; 
-	pk.mflt_fit = 0 ; 
-	pk.mdbl_max_abundance_mass = 0 ; 
-	pk.mdbl_mono_mass = 0 ; 
-	pk.mdbl_mz = 0 ; 
-	pk.mshort_charge = 0 ; 
-	pk.mflt_ims_drift_time = 0 ;
-
-	int mint_min_scan = INT_MAX ; 
-	int mint_max_scan = 0 ; 
-
-	int pos = 0 ; 
-	const int MAX_HEADER_BUFFER_LEN = 1024 ; 
-	char headerBuffer[MAX_HEADER_BUFFER_LEN] ;
-	const int MAX_BUFFER_LEN = 1024 ; 
-	char buffer[MAX_BUFFER_LEN] ;
-
-	while (!mappedReader.eof())
-	{
-		mshort_percent_complete = (short)((100.0 * mappedReader.CurrentPosition()) / file_len) ; 
-		if (mshort_percent_complete > 99)
-			mshort_percent_complete = 99 ; 
-
-		bool success = mappedReader.SkipToAfterLine(fileNameTag, headerBuffer, fileNameTagLength, MAX_HEADER_BUFFER_LEN) ; 
-		if (!success)
-		{
-			break ; 
-		}
-		else
-		{
-			// found file name. start at the end. 
-			int index = (int)strlen(headerBuffer) ; 
-			while (index > 0 && headerBuffer[index] != '.')
-			{
-				index-- ; 
-			}
-			index++ ; 
-			// wiff file pek files have a weird format. Another ICR2LS-ism.
-			if (is_first_scan)
-			{
-				if(_strnicmp(&headerBuffer[index], "wiff", 4) ==0)
-				{
-					is_pek_file_from_wiff = true ; 
-					// REMEMBER TO DELETE WHEN PARAMETERS ARE SET ELSEWHERE
-					mflt_wt_mono_mass = 0.0025F ; // using ppms 10 ppm = length of 0.1 ppm
-					mflt_wt_average_mass = 0.0025F ; // using ppms 10 ppm = length of 0.1 ppm
-					mflt_wt_log_abundance = 0.1F ; 
-					mflt_wt_scan = 0.01F ; 
-					mflt_wt_fit = 0.1F ; 
-					mflt_wt_ims_drift_time = 0.1F ;
-
-					mflt_constraint_mono_mass = 25.0F ; // is in ppm
-					mflt_constraint_average_mass = 25.0F ; // is in ppm. 
-
-					mbln_use_net = true ;
-					mbln_constraint_mono_mass_is_ppm = true ;
-					mbln_constraint_average_mass_is_ppm = true ;
-
-					mdbl_max_distance = 0.1 ; 
-
-					mshort_percent_complete = 0 ;
-				}
-			}
-			if (is_pek_file_from_wiff)
-				index += 5 ; 
-			pk.mint_lc_scan = atoi(&headerBuffer[index]) ; 
-			if (pk.mint_lc_scan > mint_max_scan)
-				mint_max_scan = pk.mint_lc_scan ; 
-			if (pk.mint_lc_scan < mint_min_scan)
-				mint_min_scan = pk.mint_lc_scan ; 
-		}
-
-		if (is_first_scan)
-		{
-			bool success = mappedReader.SkipToAfterLine(startTag, headerBuffer, startTagLength, MAX_HEADER_BUFFER_LEN) ; 
-			if (!success)
-				break ; 
-			if (strncmp(headerBuffer, startTagIsotopicLabeled, strlen(startTagIsotopicLabeled)) == 0)
-			{
-				isotopically_labeled = true ; 
-			}
-			is_first_scan = false ; 
-		}
-		else
-		{
-			bool success = mappedReader.SkipToAfterLine(startTag, startTagLength) ; 
-			if (!success)
-				break ; 
-		}
-		while(!mappedReader.eof() && mappedReader.GetNextLine(buffer, MAX_BUFFER_LEN, stopTag, stopTagLen))
-		{
-			if (isotopically_labeled)
-			{
-				char *stopPtr ; 
-				char *stopPtrNext ; 
-				pk.mshort_charge = (short) strtol(buffer, &stopPtr, 10) ; 
-				pk.mdbl_abundance = strtod(stopPtr, &stopPtrNext) ; 
-				stopPtr = stopPtrNext ; 
-				pk.mdbl_mz = strtod(stopPtr, &stopPtrNext) ; 
-				stopPtr = stopPtrNext ; 
-				pk.mflt_fit = (float)strtod(stopPtr, &stopPtrNext) ; 
-				stopPtr = stopPtrNext ; 
-				pk.mdbl_average_mass = strtod(stopPtr, &stopPtrNext) ; 
-				stopPtr = stopPtrNext ; 
-				pk.mdbl_mono_mass = strtod(stopPtr, &stopPtrNext) ; 
-				stopPtr = stopPtrNext ; 
-				pk.mdbl_max_abundance_mass = strtod(stopPtr, &stopPtrNext) ; 
-				stopPtr = stopPtrNext ; 
-				pk.mdbl_mono_abundance = strtod(stopPtr, &stopPtrNext) ; 
-				stopPtr = stopPtrNext ; 
-				pk.mdbl_i2_abundance = strtod(stopPtr, &stopPtrNext) ; 
-				stopPtr = stopPtrNext ; 
-
-				pk.mflt_ims_drift_time = 0 ;
-			}
-			else
-			{
-				char *stopPtr ; 
-				char *stopPtrNext ; 
-				pk.mshort_charge = (short) strtol(buffer, &stopPtr, 10) ; 
-				pk.mdbl_abundance = strtod(stopPtr, &stopPtrNext) ; 
-				stopPtr = stopPtrNext ; 
-				pk.mdbl_mz = strtod(stopPtr, &stopPtrNext) ; 
-				stopPtr = stopPtrNext ; 
-				pk.mflt_fit = (float)strtod(stopPtr, &stopPtrNext) ; 
-				stopPtr = stopPtrNext ; 
-				pk.mdbl_average_mass = strtod(stopPtr, &stopPtrNext) ; 
-				stopPtr = stopPtrNext ; 
-				pk.mdbl_mono_mass = strtod(stopPtr, &stopPtrNext) ; 
-				stopPtr = stopPtrNext ; 
-				pk.mdbl_max_abundance_mass = strtod(stopPtr, &stopPtrNext) ; 
-				stopPtr = stopPtrNext ; 
-
-				pk.mflt_ims_drift_time = 0 ;
-			}
-			pk.mint_original_index = numPeaks ; 
-			mvect_isotope_peaks.push_back(pk) ; 
-			numPeaks++ ; 
-		}
-	}
-	mappedReader.Close() ; 	
-}
-
-
-void UMCCreator::ReadPekFile(char *fileName)
-{
-	Reset() ; 
-	FILE *fp = fopen(fileName, "r") ;
-	int success = fseek(fp, 0, SEEK_END) ; 
-	int file_len = ftell(fp) ; 
-	success = fseek(fp, 0, SEEK_SET) ; 
-
-	const int MAX_LINE_LENGTH = 512 ; 
-	char buffer[MAX_LINE_LENGTH] ; 
-	char *fileNameTag = "Filename:" ; 
-	int fileNameTagLength = strlen(fileNameTag) ; 
-	char *startTag = "CS,  Abundance,   m/z,   Fit,    Average MW, Monoisotopic MW,    Most abundant MW" ; 
-	char *startTagIsotopicLabeled = "CS,  Abundance,   m/z,   Fit,    Average MW, Monoisotopic MW,    Most abundant MW,   Imono,   I+2" ; 
-	int startTagLength = strlen(startTag) ; 
-	char *stopTag = "Processing stop time:" ; 
-	bool reading = false ; 
-	bool isotopically_labeled = false ;
-	bool is_first_scan = true ; 
-
-	IsotopePeak pk ; 
-	int stopTagLen = (int)strlen(stopTag) ; 
-
-	short charge = 0 ; 
-	double abundance = 0 ;
-	float fit = 0, mz = 0 , averageMass = 0 , monoMass = 0 , maxMass = 0 ;  
-
-	int numPeaks = 0 ; 
-
-	mshort_percent_complete = 0 ;
-
-	pk.mdbl_abundance = 0 ; 
-	pk.mdbl_i2_abundance = 0 ; 
-	pk.mdbl_average_mass = 0 ; 
-	pk.mflt_fit = 0 ; 
-	pk.mdbl_max_abundance_mass = 0 ; 
-	pk.mdbl_mono_mass = 0 ; 
-	pk.mdbl_mz = 0 ; 
-	pk.mshort_charge = 0 ; 
-	pk.mflt_ims_drift_time = 0 ;
-
-	mint_lc_min_scan = INT_MAX ; 
-	mint_lc_max_scan = 0 ; 
-
-
-	int pos = 0 ; 
-	while (!feof(fp))
-	{
-		mshort_percent_complete = (short)((100.0 * pos) / file_len) ; 
-		if (!reading)
-		{
-			fgets(buffer, MAX_LINE_LENGTH, fp) ; 
-			pos += (int) strlen(buffer) ; 
-			if (strncmp(buffer, startTag, startTagLength) == 0)
-			{
-				reading = true ; 
-				if (is_first_scan)
-				{
-					if (strncmp(buffer, startTagIsotopicLabeled, strlen(startTagIsotopicLabeled)) == 0)
-					{
-						isotopically_labeled = true ; 
-					}
-					is_first_scan = false ; 
-				}
-			}
-			else if (strncmp(buffer, fileNameTag, fileNameTagLength) == 0)
-			{
-				// found file name. start at the end. 
-				int index = strlen(buffer) ; 
-				while (index > 0 && buffer[index] != '.')
-				{
-					index-- ; 
-				}
-				index++ ; 
-				pk.mint_lc_scan = atoi(&buffer[index]) ; 
-				if (pk.mint_lc_scan > mint_lc_max_scan)
-					mint_lc_max_scan = pk.mint_lc_scan ; 
-				if (pk.mint_lc_scan < mint_lc_min_scan)
-					mint_lc_min_scan = pk.mint_lc_scan ; 
-			}
-		}
-		else
-		{
-			//int numRead = fscanf(fp, "%hd\t%lg\t%g\t%g\t%g\t%g\t%g", &charge, &abundance, &mz, &fit, 
-			//	&averageMass, &monoMass, &maxMass) ; 
-			int numRead = 0 ; 
-			if (isotopically_labeled)
-			{
-				numRead = fscanf(fp, "%hd\t%lg\t%lg\t%g\t%lg\t%lg\t%lg\t%lg\t%lg", &pk.mshort_charge, &pk.mdbl_abundance, &pk.mdbl_mz, &pk.mflt_fit, 
-					&pk.mdbl_average_mass, &pk.mdbl_mono_mass, &pk.mdbl_max_abundance_mass, &pk.mdbl_mono_abundance, &pk.mdbl_i2_abundance) ; 
-				pos += 71 ; // this is really approximate, but its better than using ftellp
-			}
-			else
-			{
-				numRead = fscanf(fp, "%hd\t%lg\t%lg\t%g\t%lg\t%lg\t%lg", &pk.mshort_charge, &pk.mdbl_abundance, &pk.mdbl_mz, &pk.mflt_fit, 
-					&pk.mdbl_average_mass, &pk.mdbl_mono_mass, &pk.mdbl_max_abundance_mass) ; 
-				pos += 51 ; // this is really approximate, but its better than using ftellp
-			}
-			if (numRead == 0)
-			{
-				// at the end of the reading sections
-				reading = false ; 
-				pos += stopTagLen ; 
-			}
-			else
-			{
-				pk.mint_original_index = numPeaks ; 
-				mvect_isotope_peaks.push_back(pk) ; 
-				numPeaks++ ; 
-			}
-		}
-	}
-}
-
-// Will map be affected by chunking?
-bool UMCCreator::PrintMapping(FILE *stream, int featureStartIndex){
-
-	fprintf(stream, "Feature_Index\tPeak_Index\n");
-
-	for (std::multimap<int,int>::iterator iter = mmultimap_umc_2_peak_index.begin() ; iter != mmultimap_umc_2_peak_index.end() ; ){
-		int currentUmcNum = (*iter).first;
-		while(iter != mmultimap_umc_2_peak_index.end() && (*iter).first == currentUmcNum)
-		{
-				IsotopePeak pk = mvect_isotope_peaks[(*iter).second] ; 
-				
-				fprintf(stream, "%d\t",currentUmcNum + featureStartIndex) ; 
-				fprintf(stream, "%d\n",pk.mint_line_number_in_file);
-				iter++ ;
-		}
-			 
-	}
-
-	return true;
-
-}
-
-//method can be called with either stdout or an output file to write to 
-bool UMCCreator::PrintUMCs(FILE *stream, bool print_members, int featureStartIndex){
-	bool success = true;
-	fprintf(stream, "Feature_Index\tMonoisotopic_Mass\tAverage_Mono_Mass\tUMC_MW_Min\tUMC_MW_Max\tScan_Start\tScan_End\tScan\tUMC_Member_Count\tMax_Abundance\tAbundance\tClass_Rep_MZ\tClass_Rep_Charge") ; 
-	if (print_members){
-		fprintf(stream, "\tData") ; 
-	}
-	
-	fprintf(stream, "\n") ; 
-
-	
-	int numPrinted = 1 ; 
-	for (std::multimap<int,int>::iterator iter = mmultimap_umc_2_peak_index.begin() ; iter != mmultimap_umc_2_peak_index.end() ; )
-	{
-		int currentUmcNum = (*iter).first; 
-		UMC current_umc = mvect_umcs[currentUmcNum] ; 
-		fprintf(stream, "%d\t", current_umc.mint_umc_index + featureStartIndex) ; 		
-		fprintf(stream, "%4.4f\t", current_umc.mdbl_median_mono_mass);
-		fprintf(stream, "%4.4f\t", current_umc.mdbl_average_mono_mass) ; 
-		fprintf(stream, "%4.4f\t", current_umc.mdbl_min_mono_mass);
-		fprintf(stream, "%4.4f\t", current_umc.mdbl_max_mono_mass);
-		fprintf(stream, "%d\t", current_umc.mint_start_scan) ; 
-		fprintf(stream, "%d\t", current_umc.mint_stop_scan);
-		fprintf(stream, "%d\t",current_umc.mint_max_abundance_scan);
-		fprintf(stream, "%d\t",current_umc.min_num_members) ; 
-		fprintf(stream, "%4.4f\t", current_umc.mdbl_max_abundance);
-		fprintf(stream, "%4.4f\t", current_umc.mdbl_sum_abundance) ; 
-		fprintf(stream, "%4.4f\t", current_umc.mdbl_class_rep_mz) ; 
-		fprintf(stream, "%d\t", current_umc.mshort_class_rep_charge) ; 
-
-			while(iter != mmultimap_umc_2_peak_index.end() && (*iter).first == currentUmcNum)
-			{
-				if (print_members){	
-			
-				IsotopePeak pk = mvect_isotope_peaks[(*iter).second] ; 
-				
-				fprintf(stream, "%4.4f\t",pk.mdbl_mono_mass) ; 
-				fprintf(stream, "%d\t",pk.mint_lc_scan);
-				fprintf(stream, "%4.4\t", pk.mdbl_abundance) ; 
-				}
-				iter++ ; 
-			}
-		
-
-		numPrinted++ ; 
-		fprintf(stream, "\n") ; 
-		fflush(stream);
-	}
-
-	fclose(stream);
-
-	if ( numPrinted < 1 ){
-		success = false;
-	}
-
-	return success;
-
-}
-
-void UMCCreator::PrintUMCs(bool print_members)
-{
-	std::cout<<"UMCIndex\tUMCMonoMW\tAverageMonoMass\tUMCMWMin\tUMCMWMax\tScanStart\tScanEnd\tScanClassRep\tUMCMemberCount\tMaxAbundance\tUMCAbundance" ; 
-	if (print_members)
-		std::cout<<"\tData" ; 
-		std::cout<<"\n" ; 
-	std::cout.precision(4);     
-	std::cout.flags(std::ios::right + std::ios::fixed);
-	int numPrinted = 1 ; 
-	for (std::multimap<int,int>::iterator iter = mmultimap_umc_2_peak_index.begin() ; iter != mmultimap_umc_2_peak_index.end() ; )
-	{
-		int currentUmcNum = (*iter).first; 
-		UMC current_umc = mvect_umcs[currentUmcNum] ; 
-		std::cout.precision(0) ; 
-		std::cout<<current_umc.mint_umc_index<<"\t" ; 		
-		std::cout.precision(4) ; 
-		std::cout<<current_umc.mdbl_median_mono_mass<<"\t"<<current_umc.mdbl_average_mono_mass<<"\t" ; 
-		std::cout<<current_umc.mdbl_min_mono_mass<<"\t"<<current_umc.mdbl_max_mono_mass<<"\t"<<current_umc.mint_start_scan<<"\t" ; 
-		std::cout.precision(0) ; 
-		std::cout<<current_umc.mint_stop_scan<<"\t"<<current_umc.mint_max_abundance_scan<<"\t"<<current_umc.min_num_members<<"\t" ; 
-		std::cout<<current_umc.mdbl_max_abundance<<"\t"<<current_umc.mdbl_sum_abundance ; 
-		while(iter != mmultimap_umc_2_peak_index.end() && (*iter).first == currentUmcNum)
-		{
-			if (print_members)
-			{
-				IsotopePeak pk = mvect_isotope_peaks[(*iter).second] ; 
-				std::cout.precision(4) ; 
-				std::cout<<"\t"<<pk.mdbl_mono_mass<<"\t" ; 
-				std::cout.precision(0) ; 
-				std::cout<<pk.mint_lc_scan<<"\t"<<pk.mdbl_abundance<<"\t" ; 
-			}
-			iter++ ; 
-		}
-		numPrinted++ ; 
-		std::cout<<"\n" ; 
-	}
-}
-
-void UMCCreator::PrintPeaks()
-{
-	int numPeaks = mvect_isotope_peaks.size() ; 
-	std::cout<<"Scan\tCharge\tAbundance\tMZ\tFit\tAverageMass\tMonoMass\tMaxMass\n" ; 
-
-	std::cout.precision(4);     
-	std::cout.flags(std::ios::right + std::ios::fixed);
-
-	for (int i = 0 ; i < numPeaks  ; i++)
-	{
-		IsotopePeak pk = mvect_isotope_peaks[i] ; 
-		std::cout.precision(0) ; 
-		std::cout<<pk.mint_lc_scan<<"\t"<<pk.mshort_charge<<"\t"<<pk.mdbl_abundance<<"\t" ; 
-		std::cout.precision(4) ; 
-		std::cout<<pk.mdbl_mz<<"\t" ; 
-		std::cout.precision(3) ; 
-		std::cout<<pk.mflt_fit<<"\t" ; 
-		std::cout.precision(4) ; 
-
-		std::cout<<pk.mdbl_average_mass ; 
-		std::cout<<"\t"<<pk.mdbl_mono_mass ; 
-		std::cout<<"\t"<<pk.mdbl_max_abundance_mass<<"\n" ; 
-	}
-}
-
-void UMCCreator::Reset()
-{
-	mvect_isotope_peaks.clear() ; 
-	mvect_umcs.clear() ; 
-	mvect_umc_num_members.clear() ;
-	mmultimap_umc_2_peak_index.clear() ; 
-	mshort_percent_complete = 0 ; 
-}
-
-/*
- * Calls the worker functions for creating and outputting the Features.
- */
-bool UMCCreator::CreateFeatureFiles(char* baseFileName, int featureStartIndex)
-{
-	bool success;
-	char completeFileName[1024];
-	FILE *file;
-
-	// Create the file where the LCMS Features will be written
-	strcpy(completeFileName, baseFileName);
-	strcat(completeFileName, "_LCMSFeatures.txt");
-	file = fopen(completeFileName, "w");
-
-	success = PrintUMCs(file, false, featureStartIndex);
-	fclose(file);
-
-	if (success)
-	{
-		// Create the file where the "Features to Peak Map" will be written
-		strcpy(completeFileName, baseFileName);
-		strcat(completeFileName, "_LCMSFeatureToPeakMap.txt");
-		file = fopen (completeFileName, "w");
-
-		success = PrintMapping(file, featureStartIndex);
-		fclose(file);
-	}
-
-	return success;
-}
+#include "UMCCreator.h"
+#include "MemMappedReader.h"
+#include "OutputFileWriter.h"
+#include "ImsCandidateIndex.h"
+#include <stdlib.h> 
+#include <algorithm>
+#include <iostream> 
+#include <fstream>
+#include <cmath>
+#include <stddef.h>
+#ifndef _WIN32
+#include <strings.h>
+#define _strnicmp strncasecmp
+#endif
+
+#define DEBUG
+#define DATAFILTERS
+using namespace std;
+
+bool SortUMCsByMonoMassAndScan(UMC &a, UMC &b)
+{
+	if ( a.mdbl_average_mono_mass < b.mdbl_average_mono_mass){
+		return true;
+	}
+
+	return false;
+}
+
+
+bool SortIsotopesByMonoMassAndScan(IsotopePeak &a, IsotopePeak &b) 
+{
+	if (a.mdbl_mono_mass < b.mdbl_mono_mass)
+		return true ; 
+	// equal masses stay in file order, so that a sweep over any subset of the peaks (one charge state, one mass
+	// shard, one cluster) visits them in the order of the sweep over all of them
+	if (a.mdbl_mono_mass == b.mdbl_mono_mass)
+		return a.mint_original_index < b.mint_original_index ; 
+
+	return false;
+}
+
+// end of the mass window of the clustering sweep in the mass sorted peaks
+static bool PeakMassBelow(const IsotopePeak &pk, double mass)
+{
+	return pk.mdbl_mono_mass < mass ; 
+}
+
+// rows read before ReadCSVFile estimates the number of peaks in the file
+static const int RESERVE_SAMPLE_LINES = 4096 ;
+
+UMCCreator::UMCCreator(void)
+	: mmultimap_umc_2_peak_index(std::less<int>(), ArenaAllocator<std::pair<const int, int> >(&mobj_arena))
+{
+	mflt_wt_mono_mass = 0.01F ; // using ppms 10 ppm = length of 0.1 ppm
+	mflt_wt_average_mass = 0.01F ; // using ppms 10 ppm = length of 0.1 ppm
+	mflt_wt_log_abundance = 0.1F ; 
+	mflt_wt_scan = 0.01F ; 
+	mflt_wt_fit = 0.1F ; 
+	mflt_wt_ims_drift_time = 0.1F ;
+
+	mflt_constraint_mono_mass = 10.0F ; // is in ppm
+	mflt_constraint_average_mass = 10.0F ; // is in ppm. 
+	mdbl_max_distance = 0.1 ; 
+	mint_max_scan_gap = 0 ; 
+	mflt_max_net_gap = 0 ; 
+	mflt_max_drift_time_gap = 0 ; 
+	
+	mbln_use_net = true ;
+	mbln_constraint_mono_mass_is_ppm = true ;
+	mbln_constraint_average_mass_is_ppm = true ;
+	mbln_is_ims_data = false ; 
+	mbln_use_ims_candidate_index = true ; 
+	mbln_collapse_ims_conformers = false ; 
+	mint_num_conformer_nodes = 0 ; 
+	mbln_skip_isolated_peaks = false ; 
+	mint_num_isolated_peaks = 0 ; 
+
+	mint_lc_min_scan = INT_MAX ; 
+	mint_lc_max_scan = 0 ;
+	mint_ims_min_scan = INT_MAX;
+	mint_ims_max_scan = 0;
+
+	menm_output_compression = COMPRESSION_NONE ; 
+	mint_output_compression_level = 0 ; 
+	mint_output_compression_threads = 0 ; 
+}
+
+UMCCreator::UMCCreator(const UMCCreator &other)
+	: mmultimap_umc_2_peak_index(std::less<int>(), ArenaAllocator<std::pair<const int, int> >(&mobj_arena))
+{
+	*this = other ; 
+}
+
+UMCCreator & UMCCreator::operator=(const UMCCreator &other)
+{
+	if (this == &other)
+		return *this ; 
+
+	memcpy(mstr_inputFile, other.mstr_inputFile, sizeof(mstr_inputFile)) ; 
+	memcpy(outputDir, other.outputDir, sizeof(outputDir)) ; 
+
+	mflt_isotopic_fit_filter = other.mflt_isotopic_fit_filter ; 
+	mint_min_intensity = other.mint_min_intensity ; 
+	mflt_mono_mass_start = other.mflt_mono_mass_start ; 
+	mflt_mono_mass_end = other.mflt_mono_mass_end ; 
+	mbln_process_mass_seg = other.mbln_process_mass_seg ; 
+	mint_max_data_points = other.mint_max_data_points ; 
+	mint_mono_mass_seg_overlap = other.mint_mono_mass_seg_overlap ; 
+	mint_ims_min_scan_filter = other.mint_ims_min_scan_filter ; 
+	mint_ims_max_scan_filter = other.mint_ims_max_scan_filter ; 
+	mint_lc_min_scan_filter = other.mint_lc_min_scan_filter ; 
+	mint_lc_max_scan_filter = other.mint_lc_max_scan_filter ; 
+
+	mflt_wt_mono_mass = other.mflt_wt_mono_mass ; 
+	mflt_wt_average_mass = other.mflt_wt_average_mass ; 
+	mflt_wt_log_abundance = other.mflt_wt_log_abundance ; 
+	mflt_wt_scan = other.mflt_wt_scan ; 
+	mflt_wt_net = other.mflt_wt_net ; 
+	mflt_wt_fit = other.mflt_wt_fit ; 
+	mflt_wt_ims_drift_time = other.mflt_wt_ims_drift_time ; 
+
+	mflt_constraint_mono_mass = other.mflt_constraint_mono_mass ; 
+	mbln_constraint_mono_mass_is_ppm = other.mbln_constraint_mono_mass_is_ppm ; 
+	mflt_constraint_average_mass = other.mflt_constraint_average_mass ; 
+	mbln_constraint_average_mass_is_ppm = other.mbln_constraint_average_mass_is_ppm ; 
+	mbln_constraint_charge_state = other.mbln_constraint_charge_state ; 
+	mint_max_scan_gap = other.mint_max_scan_gap ; 
+	mflt_max_net_gap = other.mflt_max_net_gap ; 
+	mflt_max_drift_time_gap = other.mflt_max_drift_time_gap ; 
+	mdbl_max_distance = other.mdbl_max_distance ; 
+
+	// gives zeroed counters and keeps the parent of this telemetry
+	mobj_telemetry = other.mobj_telemetry ; 
+
+	mbln_use_net = other.mbln_use_net ; 
+	mbln_is_ims_data = other.mbln_is_ims_data ; 
+	mbln_use_ims_candidate_index = other.mbln_use_ims_candidate_index ; 
+	mbln_collapse_ims_conformers = other.mbln_collapse_ims_conformers ; 
+	mint_num_conformer_nodes = other.mint_num_conformer_nodes ; 
+	mbln_skip_isolated_peaks = other.mbln_skip_isolated_peaks ; 
+	mint_num_isolated_peaks = other.mint_num_isolated_peaks ; 
+	mflt_segment_size = other.mflt_segment_size ; 
+
+	menm_output_compression = other.menm_output_compression ; 
+	mint_output_compression_level = other.mint_output_compression_level ; 
+	mint_output_compression_threads = other.mint_output_compression_threads ; 
+
+	mint_lc_min_scan = other.mint_lc_min_scan ; 
+	mint_lc_max_scan = other.mint_lc_max_scan ; 
+	mint_ims_min_scan = other.mint_ims_min_scan ; 
+	mint_ims_max_scan = other.mint_ims_max_scan ; 
+
+	// the nodes are inserted one by one, so they come from this creator's arena whatever the allocator of other
+	mmultimap_umc_2_peak_index.clear() ; 
+	mmultimap_umc_2_peak_index.insert(other.mmultimap_umc_2_peak_index.begin(), other.mmultimap_umc_2_peak_index.end()) ; 
+	mvect_isotope_peaks = other.mvect_isotope_peaks ; 
+	mvect_umc_num_members = other.mvect_umc_num_members ; 
+	mvect_umcs = other.mvect_umcs ; 
+	mvect_raw_umc_start = other.mvect_raw_umc_start ; 
+	mvect_raw_umc_peaks = other.mvect_raw_umc_peaks ; 
+	mvect_umc_raw_index = other.mvect_umc_raw_index ; 
+	mvect_raw_umcs = other.mvect_raw_umcs ; 
+	mvect_raw_umc_stats_index = other.mvect_raw_umc_stats_index ; 
+	return *this ; 
+}
+
+UMCCreator::~UMCCreator(void)
+{
+}
+
+int UMCCreator::ReadCSVFile(){
+	return ReadCSVFile(mstr_inputFile);
+}
+
+int UMCCreator::ReadCSVFile(char *fileName)
+{
+	char startTag[1024] ; //will be defined based on header
+	int startTagLength;
+	char *stopTag = "Blah" ; 
+	int stopTagLen = (int)strlen(stopTag) ; 
+
+	
+	Reset() ; 
+	MemMappedReader mappedReader ; 
+	mappedReader.Load(fileName) ; 
+	__int64 file_len = mappedReader.FileLength() ; 
+
+
+	//columns for IMS data 
+	//'frame_num,ims_scan_num,charge,abundance,mz,fit,average_mw,monoisotopic_mw,mostabundant_mw,fwhm,signal_noise,mono_abundance,mono_plus2_abundance,orig_intensity,TIA_orig_intensity, drift_time,cumulative_drift_time\n'
+
+	//columns for LC-MS data
+	//scan_num,charge,abundance,mz,fit,average_mw,monoisotopic_mw,mostabundant_mw,fwhm,signal_noise,mono_abundance,mono_plus2_abundance/
+
+
+	bool reading = false ; 
+	bool is_first_scan = true ; 
+
+	IsotopePeak pk ; 
+	short charge = 0 ; 
+	double abundance = 0 ;
+	float fit = 0, mz = 0 , averageMass = 0 , monoMass = 0 , maxMass = 0 ;  
+
+	int numPeaks = 0 ; 
+	int origLineNumber = 0;
+	int numPeaksPublished = 0 ;
+	int numLinesPublished = 0 ;
+
+	mobj_telemetry.BeginStage(STAGE_LOADING, file_len) ;
+
+	pk.mdbl_abundance = 0 ; 
+	pk.mdbl_i2_abundance = 0 ; 
+	pk.mdbl_average_mass = 0 ; 
+	pk.mflt_fit = 0 ; 
+	pk.mdbl_max_abundance_mass = 0 ; 
+	pk.mdbl_mono_mass = 0 ; 
+	pk.mdbl_mz = 0 ; 
+	pk.mshort_charge = 0 ; 
+	pk.mflt_ims_drift_time = 0 ;
+
+	mint_lc_min_scan = INT_MAX ; 
+	mint_lc_max_scan = 0 ; 
+
+	int pos = 0 ; 
+	const int MAX_HEADER_BUFFER_LEN = 1024 ; 
+	const int MAX_BUFFER_LEN = 1024 ; 
+	char buffer[MAX_BUFFER_LEN] ;
+
+	bool success = mappedReader.GetNextLine(buffer, MAX_BUFFER_LEN, "\n", MAX_BUFFER_LEN);
+
+#ifdef DBUG
+	std::cout << "Success = " << success << "\n";
+#endif
+
+	if (success){
+		SetIsosLayout(buffer, startTag) ;
+	}
+	
+	startTagLength = (int)strlen(startTag) ; 
+
+#ifdef DBUG
+	std::cout << "Data file is IMS? (1=Yes, 0=No):: " << mbln_is_ims_data << "\n";
+#endif
+
+	//success = mappedReader.SkipToAfterLine(startTag, buffer, startTagLength, MAX_BUFFER_LEN) ; 
+	if (!success)
+	{
+		throw "Incorrect header for file" ; 
+	}
+	while(!mappedReader.eof() && mappedReader.GetNextLine(buffer, MAX_BUFFER_LEN, stopTag, stopTagLen))
+	{
+		// publish progress once per batch of rows instead of once per row
+		if ((origLineNumber & ProgressTelemetry::PUBLISH_MASK) == 0)
+		{
+			mobj_telemetry.SetItemsProcessed(mappedReader.InputPosition()) ;
+			mobj_telemetry.SetBytesRead(mappedReader.InputPosition()) ;
+			mobj_telemetry.AddPeaksKept(numPeaks - numPeaksPublished) ;
+			mobj_telemetry.AddPeaksRejected((origLineNumber - numLinesPublished) - (numPeaks - numPeaksPublished)) ;
+			numPeaksPublished = numPeaks ;
+			numLinesPublished = origLineNumber ;
+		}
+
+		// once a sample of rows is in, make room for the rest of the file at the same bytes per row and fraction kept
+		if (origLineNumber == RESERVE_SAMPLE_LINES && numPeaks > 0)
+		{
+			double linesPerByte = (double) origLineNumber / (double) mappedReader.InputPosition() ; 
+			double fractionKept = (double) numPeaks / (double) origLineNumber ; 
+			double expectedPeaks = (double) file_len * linesPerByte * fractionKept * 1.1 ; 
+			if (expectedPeaks < INT_MAX)
+				mvect_isotope_peaks.reserve((size_t) expectedPeaks) ; 
+		}
+
+		ParseIsosLine(buffer, pk) ;
+
+		// Check here to see of MAP index is correct. Dameng
+		pk.mint_original_index = numPeaks ; //when reading from the file, this should be the line number in the original isos file
+		pk.mint_line_number_in_file = origLineNumber;
+
+		//check if the filter criteria is satisfied before adding a peak
+		if ( ConsiderPeak(pk)){
+
+			// Remove the following condition may cause one segment has more than mint_max_data_points
+			if ( false ){
+				if ( mbln_process_mass_seg ){
+					if ( numPeaks > mint_max_data_points ){
+						std::cout << "I know this happens" << "\n";
+						numPeaks--;
+						break;
+					}
+				}
+			}
+				#ifdef DBUG
+					std::cout << "Adding peak ... "  << ConsiderPeak(pk) << "\n";
+				#endif
+            
+				UpdateScanRange(pk) ;
+	
+				mvect_isotope_peaks.push_back(pk) ;
+
+				#ifdef DBUG
+					pk.printPeak();
+				#endif
+				//increment number of peaks read
+				numPeaks++ ; 
+
+		}
+
+		origLineNumber++;
+		
+	}
+
+	mobj_telemetry.SetBytesRead(mappedReader.InputPosition()) ;
+	mobj_telemetry.AddPeaksKept(numPeaks - numPeaksPublished) ;
+	mobj_telemetry.AddPeaksRejected((origLineNumber - numLinesPublished) - (numPeaks - numPeaksPublished)) ;
+	mobj_telemetry.EndStage() ;
+
+	mappedReader.Close();
+	return numPeaks;
+}
+
+// Recognizes the LC-MS and IMS isos layouts from the header row and copies the expected header to startTag
+void UMCCreator::SetIsosLayout(char *headerLine, char *startTag)
+{
+	if (headerLine[0] == 'f'){
+		strcpy(startTag, "frame_num,ims_scan_num,charge,abundance,mz,fit,average_mw,monoisotopic_mw,mostabundant_mw,fwhm,signal_noise,mono_abundance,mono_plus2_abundance,orig_intensity,TIA_orig_intensity,drift_time");
+		mbln_is_ims_data = true;
+	}
+	else{
+		strcpy(startTag,"scan_num,charge,abundance,mz,fit,average_mw, monoisotopic_mw,mostabundant_mw,fwhm,signal_noise,mono_abundance,mono_plus2_abundance") ; 
+		mbln_is_ims_data = false;
+	}
+}
+
+// Parses one data row of an isos file; the layout (LC-MS or IMS) must have been set by SetIsosLayout.
+// Values are read positionally, skipping one separator character, so comma and tab separated files both work.
+void UMCCreator::ParseIsosLine(char *buffer, IsotopePeak &pk)
+{
+	double fwhm = 0, s2n = 0 ;
+	char *stopPtr ; 
+	char *stopPtrNext ; 
+
+	//in either case the first value is the lc_scan_num
+	pk.mint_lc_scan = strtol(buffer, &stopPtr, 10) ; 
+
+
+	stopPtr++ ; 
+
+	if (mbln_is_ims_data){
+		//then we need to parse out ims_scan number
+		pk.mint_ims_scan =strtol(stopPtr, &stopPtrNext, 10) ; 
+		stopPtr = ++stopPtrNext;
+	}
+
+	pk.mshort_charge = (short) strtol(stopPtr, &stopPtrNext, 10) ; 
+	stopPtr = ++stopPtrNext ; 
+	pk.mdbl_abundance = strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = ++stopPtrNext ; 
+	pk.mdbl_mz = strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = ++stopPtrNext ; 
+	pk.mflt_fit = (float)strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = ++stopPtrNext ; 
+	pk.mdbl_average_mass = strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = ++stopPtrNext ; 
+	pk.mdbl_mono_mass = strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = ++stopPtrNext ; 
+	pk.mdbl_max_abundance_mass = strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = ++stopPtrNext ; 
+	fwhm = strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = ++stopPtrNext ; 
+	s2n = strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = ++stopPtrNext ; 
+	pk.mdbl_mono_abundance = strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = ++stopPtrNext ; 
+	pk.mdbl_i2_abundance = strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = ++stopPtrNext ; 
+
+	//if it's ims data then we have to read four more columns of data
+	if (mbln_is_ims_data){
+		//orig intensity, TIA original intensity, drift time and cumulative drift time
+		pk.mflt_orig_intensity = strtod(stopPtr, &stopPtrNext);
+		stopPtr = ++stopPtrNext;
+
+		pk.mflt_tia_orig_intensity = strtod(stopPtr, &stopPtrNext);
+		stopPtr = ++stopPtrNext;
+		pk.mflt_ims_drift_time = strtod(stopPtr, &stopPtrNext);
+		stopPtr = ++stopPtrNext;
+		pk.mflt_cum_drift_time = strtod(stopPtr, &stopPtrNext);
+		stopPtr = ++stopPtrNext;
+
+	}
+}
+
+// Widens the LC (and IMS) scan range of the loaded data to include pk
+void UMCCreator::UpdateScanRange(IsotopePeak &pk)
+{
+	//check if the min scans and max scans for both lc and ims need to be fixed
+	if (pk.mint_lc_scan <= mint_lc_min_scan ){
+		mint_lc_min_scan = pk.mint_lc_scan;
+	}
+	
+	if (pk.mint_lc_scan >= mint_lc_max_scan){
+		mint_lc_max_scan = pk.mint_lc_scan;
+	}
+
+	if ( mbln_is_ims_data ){
+		//need to fix the ims min scans and max scans that were loaded
+		if ( pk.mint_ims_scan <= mint_ims_min_scan ){
+			mint_ims_min_scan = pk.mint_ims_scan;
+		}
+
+		if ( pk.mint_ims_scan >= mint_ims_max_scan ){
+			mint_ims_max_scan = pk.mint_ims_scan;
+		}
+	}
+}
+
+int UMCCreator::LoadPeaksFromDatabase(){
+	//this is to read a sql lite database and retrieve the peaks from it into the mvect_isotope_peaks array.
+
+	return 0;
+
+}
+
+//Method not used, 
+void UMCCreator::SerializeObjects(){
+
+
+	//First write out all loaded isotopic peaks
+	//we should be smarter about this file writing since there's going to be sufficient 
+	//number of peaks that don't get used into any UMC or get removed as part of short UMCs
+	//maybe each peak needs to have a bit whether to used or not
+	ofstream ofs("mvect_isotope_peaks.ros", ios::binary);
+
+	//this should write only peaks that are being used to the file
+	int count = 0;
+	for ( int i = 0; i < mvect_isotope_peaks.size(); i++){
+
+		IsotopePeak pk = (IsotopePeak ) mvect_isotope_peaks[i];
+		if ( pk.mint_umc_index != -1){
+       		ofs.write( (char*)&mvect_isotope_peaks[i], sizeof(IsotopePeak));
+			count++;
+		}
+	}
+
+	std::cout<<"Number of peaks written to file is " << count << " while total = " << mvect_isotope_peaks.size() << std::endl;
+
+	ofs.close();
+
+	//write out the umc classes
+	ofstream ofs1("mvect_umcs", ios::binary);
+	for ( int  i=0; i < mvect_umcs.size(); i++){
+		ofs1.write( (char*)&mvect_umcs[i], sizeof(UMC));
+	}
+
+	ofs1.close();
+
+
+	//write out the multimap that maps the indices on the isotopic peaks
+	//to the indices on the umcs
+	fstream fs("mmultimap_umc_2_peak_index", ios::out);
+		
+	for (UMCPeakMultimap::iterator iter = mmultimap_umc_2_peak_index.begin() ; iter != mmultimap_umc_2_peak_index.end() ; )
+	{
+			
+		int umc_index = (*iter).first ; 
+		int peak_index = (*iter).second;
+		fs << umc_index << "\t" << peak_index <<std::endl;
+	}
+
+	fs.close();
+}
+
+
+void UMCCreator::DeserializeObjects(){
+
+}
+
+
+float UMCCreator::GetLastMonoMassLoaded(){
+	float mass = FLT_MAX;
+	try{
+		IsotopePeak peak = (IsotopePeak) mvect_isotope_peaks[mvect_isotope_peaks.size()];
+		mass = peak.mdbl_mono_mass;
+	}
+	catch(exception e){
+	}
+	return mass;
+
+}
+void UMCCreator::SetInputFileName(char *filename){
+	strcpy(mstr_inputFile, filename);
+}
+
+void UMCCreator::SetOutputDiretory(char * dir){
+	strcpy(outputDir, dir);
+}
+
+//could all start going into a single branch but have kept it such so that it's a little easier to read.
+//Method to determine whether the filter 
+bool UMCCreator::ConsiderPeak(IsotopePeak peak ){
+
+	bool consider = false;
+
+	if ( peak.mdbl_abundance >= mint_min_intensity && peak.mflt_fit <= mflt_isotopic_fit_filter){
+			consider = true;
+	}
+		//if we're processing a particular mass range then we have to check for the mono mass to be within bounds
+	if ( consider && mflt_mono_mass_start <= peak.mdbl_mono_mass && peak.mdbl_mono_mass <= mflt_mono_mass_end ){
+		consider = true;
+	}
+	else{
+		consider = false;
+	}
+		
+	
+	//check if data is within LC scan range
+	if ( consider && mint_lc_min_scan_filter <=  peak.mint_lc_scan && peak.mint_lc_scan <= mint_lc_max_scan_filter  ){
+		consider = true;
+	}
+	else{
+		consider = false;
+	}
+
+	if ( mbln_is_ims_data ){
+		//check fi data is within ims scans
+		if ( consider && mint_ims_min_scan_filter <= peak.mint_ims_scan && peak.mint_ims_scan <= mint_ims_max_scan_filter ){
+			consider = true;
+		}
+		else{
+			consider = false;
+		}
+	}
+
+	return consider;
+}
+
+void UMCCreator::CalculateUMCs()
+{
+	// UMCs that did not come from CreateUMCsSinglyLinkedWithAll (or whose clusters were changed by hand) start a new raw clustering
+	if (mvect_umc_raw_index.size() != mvect_umc_num_members.size())
+		SaveRawClusters() ; 
+
+	mvect_umcs.clear() ; 
+	mvect_umcs.reserve(mvect_umc_num_members.size()) ; 
+
+	int numUmcs = (int) mvect_umc_raw_index.size() ; 
+	int maxMembers = 0 ; 
+	for (int umc_index = 0 ; umc_index < numUmcs ; umc_index++)
+	{
+		if (mvect_umc_num_members[umc_index] > maxMembers)
+			maxMembers = mvect_umc_num_members[umc_index] ; 
+	}
+	// sized for the biggest UMC up front, so summarizing never reallocates it
+	std::vector<double> vect_mass ; 
+	vect_mass.reserve(maxMembers) ; 
+
+	mobj_telemetry.BeginStage(STAGE_SUMMARIZING, (long long) numUmcs) ; 
+
+	for (int umc_index = 0 ; umc_index < numUmcs ; umc_index++)
+	{
+		if ((umc_index & ProgressTelemetry::PUBLISH_MASK) == 0)
+			mobj_telemetry.SetItemsProcessed(umc_index) ; 
+
+		// the statistics of a raw cluster do not depend on the filtering, so each is only worked out once
+		int rawIndex = mvect_umc_raw_index[umc_index] ; 
+		if (mvect_raw_umc_stats_index[rawIndex] == -1)
+		{
+			UMC new_umc ; 
+			SummarizeRawUMC(rawIndex, new_umc, vect_mass) ; 
+			mvect_raw_umc_stats_index[rawIndex] = (int) mvect_raw_umcs.size() ; 
+			mvect_raw_umcs.push_back(new_umc) ; 
+		}
+		mvect_umcs.push_back(mvect_raw_umcs[mvect_raw_umc_stats_index[rawIndex]]) ; 
+		mvect_umcs.back().mint_umc_index = umc_index ; 
+	}
+	mobj_telemetry.EndStage() ; 
+}
+
+void UMCCreator::SummarizeRawUMC(int rawIndex, UMC &new_umc, std::vector<double> &vect_mass)
+{
+	int firstMember = mvect_raw_umc_start[rawIndex] ; 
+	int numMembers = mvect_raw_umc_start[rawIndex + 1] - firstMember ; 
+	SummarizeMembers(mvect_isotope_peaks, &mvect_raw_umc_peaks[firstMember], numMembers, new_umc, vect_mass) ; 
+	new_umc.mint_umc_index = rawIndex ; 
+}
+
+void UMCCreator::SummarizeMembers(std::vector<IsotopePeak> &peaks, const int *members, int numMembers, UMC &new_umc, std::vector<double> &vect_mass)
+{
+	vect_mass.clear() ; 
+	int minScan = INT_MAX ; 
+	int maxScan = INT_MIN ; 
+	double minMass = DBL_MAX ; 
+	double maxMass = -1 * DBL_MAX ; 
+	double maxAbundance = -1 * DBL_MAX ; 
+	double sumAbundance = 0 ; 
+	double sumMonoMass = 0 ; 
+	int maxAbundanceScan = 0 ; 
+	short classRepCharge = 0 ; 
+	double classRepMz = 0 ; 
+
+	for (int memberNum = 0 ; memberNum < numMembers ; memberNum++)
+	{
+		IsotopePeak &pk = peaks[members[memberNum]] ; 
+		vect_mass.push_back(pk.mdbl_mono_mass) ; 
+
+		if (pk.mint_lc_scan > maxScan)
+			maxScan = pk.mint_lc_scan ; 
+		if (pk.mint_lc_scan < minScan )
+			minScan = pk.mint_lc_scan ; 
+
+		if (pk.mdbl_mono_mass > maxMass)
+			maxMass = pk.mdbl_mono_mass ; 
+		if (pk.mdbl_mono_mass < minMass )
+			minMass = pk.mdbl_mono_mass ; 
+
+		if (pk.mdbl_abundance > maxAbundance)
+		{
+			maxAbundance = pk.mdbl_abundance ; 
+			maxAbundanceScan = pk.mint_lc_scan ; 
+			classRepCharge = pk.mshort_charge ; 
+			classRepMz = pk.mdbl_mz ; 
+		}
+		sumAbundance += pk.mdbl_abundance ; 
+
+		sumMonoMass += pk.mdbl_mono_mass ; 
+	}
+
+	sort(vect_mass.begin(), vect_mass.end()) ; 
+
+	new_umc.min_num_members = numMembers ; 
+	new_umc.mint_start_scan = minScan ; 
+	new_umc.mint_stop_scan = maxScan ; 
+	new_umc.mint_max_abundance_scan = maxAbundanceScan ; 
+
+	new_umc.mdbl_max_abundance = maxAbundance ; 
+	new_umc.mdbl_sum_abundance = sumAbundance ;
+
+	new_umc.mdbl_min_mono_mass = minMass ; 
+	new_umc.mdbl_max_mono_mass = maxMass ; 
+	new_umc.mdbl_average_mono_mass = sumMonoMass/numMembers ; 
+
+	new_umc.mdbl_class_rep_mz = classRepMz ; 
+	new_umc.mshort_class_rep_charge = classRepCharge ; 
+
+	if (numMembers % 2 == 1)
+	{
+		new_umc.mdbl_median_mono_mass = vect_mass[numMembers/2] ; 
+	}
+	else
+	{
+		new_umc.mdbl_median_mono_mass = 0.5 * (vect_mass[numMembers/2-1] + vect_mass[numMembers/2]) ; 
+	}
+}
+
+void UMCCreator::SaveRawClusters()
+{
+	int numUmcs = (int) mvect_umc_num_members.size() ; 
+	mvect_raw_umc_start.clear() ; 
+	mvect_raw_umc_start.reserve(numUmcs + 1) ; 
+	mvect_raw_umc_peaks.clear() ; 
+	mvect_raw_umc_peaks.reserve(mmultimap_umc_2_peak_index.size()) ; 
+	mvect_umc_raw_index.clear() ; 
+	mvect_umc_raw_index.reserve(numUmcs) ; 
+
+	// the map is ordered by umc and then by peak, which is the order the members are stored in
+	UMCPeakMultimap::iterator iter = mmultimap_umc_2_peak_index.begin() ; 
+	for (int umcNum = 0 ; umcNum < numUmcs ; umcNum++)
+	{
+		mvect_raw_umc_start.push_back((int) mvect_raw_umc_peaks.size()) ; 
+		mvect_umc_raw_index.push_back(umcNum) ; 
+		for ( ; iter != mmultimap_umc_2_peak_index.end() && (*iter).first == umcNum ; iter++)
+			mvect_raw_umc_peaks.push_back((*iter).second) ; 
+	}
+	mvect_raw_umc_start.push_back((int) mvect_raw_umc_peaks.size()) ; 
+
+	mvect_raw_umcs.clear() ; 
+	mvect_raw_umc_stats_index.assign(numUmcs, -1) ; 
+}
+
+void UMCCreator::RemoveShortUMCs(int min_length)
+{
+	if (mvect_umc_raw_index.size() != mvect_umc_num_members.size())
+		SaveRawClusters() ; 
+
+	// first reset all isotope peak umc indices to -1. 
+	int numIsotopePeaks = mvect_isotope_peaks.size() ;
+	for (int peakNum = 0 ; peakNum < numIsotopePeaks ; peakNum++)
+	{
+		mvect_isotope_peaks[peakNum].mint_umc_index = -1 ; 
+	}
+
+	// always filter the raw clusters, never the result of an earlier call, so the length can go down again
+	int numRawUmcs = (int) mvect_raw_umc_start.size() - 1 ; 
+	mobj_telemetry.BeginStage(STAGE_FILTERING, (long long) numRawUmcs) ; 
+
+	mvect_umc_num_members.clear() ; 
+	mvect_umc_raw_index.clear() ; 
+	mmultimap_umc_2_peak_index.clear() ; 
+	for (int rawIndex = 0 ; rawIndex < numRawUmcs ; rawIndex++)
+	{
+		if ((rawIndex & ProgressTelemetry::PUBLISH_MASK) == 0)
+			mobj_telemetry.SetItemsProcessed(rawIndex) ; 
+
+		int numMembers = mvect_raw_umc_start[rawIndex + 1] - mvect_raw_umc_start[rawIndex] ; 
+		if (numMembers < min_length)
+			continue ; 
+
+		int numUmcsSoFar = (int) mvect_umc_num_members.size() ; 
+		for (int memberNum = mvect_raw_umc_start[rawIndex] ; memberNum < mvect_raw_umc_start[rawIndex + 1] ; memberNum++)
+		{
+			int pkNum = mvect_raw_umc_peaks[memberNum] ; 
+			mvect_isotope_peaks[pkNum].mint_umc_index = numUmcsSoFar ; 
+			// umcs and their peaks arrive in increasing order, so every insert goes at the end of the map
+			mmultimap_umc_2_peak_index.insert(mmultimap_umc_2_peak_index.end(), std::pair<int,int>(numUmcsSoFar, pkNum)) ; 
+		}
+		mvect_umc_num_members.push_back(numMembers) ; 
+		mvect_umc_raw_index.push_back(rawIndex) ; 
+	}
+	mobj_telemetry.EndStage() ; 
+	// DONE!! 
+}
+
+
+bool UMCCreator::withinMassTolerance(double observedMass, double realMass){
+	double massDifferenceInPPM = abs(realMass - observedMass)* 1000000/realMass;
+	return ( massDifferenceInPPM <= mflt_constraint_mono_mass);
+}
+
+
+
+void UMCCreator::CreateUMCsSinglyLinkedWithAll()
+{
+	std::vector<IsotopePeak> vectTempPeaks ; 
+
+	mobj_telemetry.BeginStage(STAGE_SORTING, (long long) mvect_isotope_peaks.size()) ; 
+	SortPeaksForClustering(vectTempPeaks) ; 
+	CreateUMCsSinglyLinkedWithAll(vectTempPeaks) ; 
+}
+
+void UMCCreator::SortPeaksForClustering(std::vector<IsotopePeak> &sortedPeaks)
+{
+	sortedPeaks.clear() ; 
+	sortedPeaks.insert(sortedPeaks.begin(), mvect_isotope_peaks.begin(), mvect_isotope_peaks.end()) ; 
+	SortForClustering(sortedPeaks) ; 
+}
+
+void UMCCreator::SortForClustering(std::vector<IsotopePeak> &peaks)
+{
+	// basically take all umcs sorted in mass and perform single linkage clustering. 
+	sort(peaks.begin(), peaks.end(), &SortIsotopesByMonoMassAndScan) ; 
+}
+
+void UMCCreator::GetCandidateTolerances(float &driftTolerance, int &scanTolerance)
+{
+	// a drift time or scan difference beyond these alone makes PeakDistance at least mdbl_max_distance; the margin
+	// covers the rounding of the float terms
+	const double TOLERANCE_MARGIN = 1.00001 ; 
+	driftTolerance = FLT_MAX ; 
+	if (mflt_wt_ims_drift_time > 0 && mdbl_max_distance > 0 && mdbl_max_distance < DBL_MAX)
+		driftTolerance = (float) (mdbl_max_distance / mflt_wt_ims_drift_time * TOLERANCE_MARGIN) ; 
+	// the gaps are compared as PeakDistance compares them, so they need no margin
+	if (mflt_max_drift_time_gap > 0 && mflt_max_drift_time_gap < driftTolerance)
+		driftTolerance = mflt_max_drift_time_gap ; 
+
+	scanTolerance = INT_MAX ; 
+	double scanWeight = mbln_use_net ? (mint_lc_max_scan > mint_lc_min_scan ? mflt_wt_net / (double) (mint_lc_max_scan - mint_lc_min_scan) : 0)
+		: mflt_wt_scan ; 
+	if (scanWeight > 0)
+	{
+		double maxScanDifference = mdbl_max_distance / scanWeight * TOLERANCE_MARGIN ; 
+		if (maxScanDifference < INT_MAX - 1)
+			scanTolerance = (int) maxScanDifference + 1 ; 
+	}
+	int maxScanGap = GetMaxScanGap() ; 
+	if (maxScanGap < scanTolerance)
+		scanTolerance = maxScanGap ; 
+}
+
+int UMCCreator::GetMaxScanGap()
+{
+	int maxScanGap = mint_max_scan_gap > 0 ? mint_max_scan_gap : INT_MAX ; 
+	if (mflt_max_net_gap > 0 && mint_lc_max_scan > mint_lc_min_scan)
+	{
+		double netScanGap = mflt_max_net_gap * (double) (mint_lc_max_scan - mint_lc_min_scan) ; 
+		if (netScanGap < maxScanGap)
+			maxScanGap = (int) netScanGap ; 
+	}
+	return maxScanGap ; 
+}
+
+void UMCCreator::LinkPeaks(IsotopePeak &currentPeak, IsotopePeak &matchPeak, int matchIndex, int &currentUmcIndex,
+	std::vector<int> &vectSortedUmcIndex, UMCPeakMultimap &umcPeaks, std::vector<int> &tempIndices, long long &numDistanceEvaluations,
+	long long &numMerges)
+{
+	UMCPeakMultimap::iterator iter ; 
+	UMCPeakMultimap::iterator deleteIter ; 
+	int matchUmcIndex = vectSortedUmcIndex[matchIndex] ; 
+	// peaks of different charge states are never linked, so their distance is not needed
+	if (matchUmcIndex != currentUmcIndex && (!mbln_constraint_charge_state || currentPeak.mshort_charge == matchPeak.mshort_charge))
+	{		
+		double currentDistance = PeakDistance(currentPeak, matchPeak) ; 
+		numDistanceEvaluations++ ; 
+		if (currentDistance < mdbl_max_distance)
+		{
+			if (matchUmcIndex == -1)
+			{
+				umcPeaks.insert(std::pair<int,int>(currentUmcIndex, matchIndex)) ; 
+				vectSortedUmcIndex[matchIndex] = currentUmcIndex ; 
+			}
+			else
+			{
+				tempIndices.clear() ; 
+				int numPeaksMerged = 0 ; 
+				numMerges++ ; 
+				// merging time. Merge this guy's umc into the next guys UMC.
+				for (iter = umcPeaks.find(currentUmcIndex) ; iter != umcPeaks.end() && (*iter).first == currentUmcIndex; )
+				{
+					deleteIter = iter ; 
+					int deletePeakIndex = (*iter).second ; 
+					tempIndices.push_back(deletePeakIndex) ; 
+					vectSortedUmcIndex[deletePeakIndex] = matchUmcIndex ; 
+					iter++ ; 
+					umcPeaks.erase(deleteIter) ; 
+					numPeaksMerged++ ; 
+				}
+				for (int mergedPeakNum = 0 ; mergedPeakNum < numPeaksMerged ; mergedPeakNum++)
+				{
+					umcPeaks.insert(std::pair<int,int>(matchUmcIndex, tempIndices[mergedPeakNum])) ; 
+				}
+				currentUmcIndex = matchUmcIndex ; 
+			}
+		}
+	}
+}
+
+void UMCCreator::CreateUMCsSinglyLinkedWithAll(const std::vector<IsotopePeak> &sortedPeaks)
+{
+	mmultimap_umc_2_peak_index.clear() ; 
+	mvect_umc_num_members.clear() ; 
+	mint_num_conformer_nodes = 0 ; 
+	mint_num_isolated_peaks = 0 ; 
+	int numPeaks = mvect_isotope_peaks.size() ; 
+	// the map never holds more than one node per peak, and erased nodes are reused, so this covers the whole run
+	mobj_arena.Reserve(numPeaks * MAP_NODE_BYTES) ; 
+	for (int pkNum = 0 ; pkNum < numPeaks ; pkNum++)
+	{
+		mvect_isotope_peaks[pkNum].mint_umc_index = -1 ; 
+	}
+
+	// umc index of each sorted peak; kept apart from the peaks so that sortedPeaks can be shared
+	// by several creators clustering the same data with different options
+	std::vector<int> vectSortedUmcIndex(numPeaks, -1) ; 
+
+	mobj_telemetry.BeginStage(STAGE_CLUSTERING, numPeaks) ; 
+	SweepSortedPeaks(sortedPeaks, vectSortedUmcIndex, mmultimap_umc_2_peak_index, NULL, true) ; 
+
+	// At the end of all of this. The mapping from mmultimap_umc_2_peak_index is from umc_index to index in sorted stuff. 
+	// Also, several of the umc indices are no longer valid. So lets step through the map, get new umc indices, renumber them,
+	// and set the umc indices in the original vectors.
+	int numUmcsSoFar = 0 ; 
+	for (UMCPeakMultimap::iterator iter = mmultimap_umc_2_peak_index.begin() ; iter != mmultimap_umc_2_peak_index.end() ; )
+	{
+		int currentOldUmcNum = (*iter).first ; 
+		int numMembers = 0 ; 
+		while(iter != mmultimap_umc_2_peak_index.end() && (*iter).first == currentOldUmcNum)
+		{
+			const IsotopePeak &pk = sortedPeaks[(*iter).second] ; 
+			mvect_isotope_peaks[pk.mint_original_index].mint_umc_index = numUmcsSoFar ; 
+			iter++ ; 
+			numMembers++ ; 
+		}
+		mvect_umc_num_members.push_back(numMembers) ; 
+		numUmcsSoFar++ ; 
+	}
+	FinishClustering() ; 
+	// DONE!! 
+}
+
+void UMCCreator::FinishClustering()
+{
+	// now set the map object. The peaks are put in order of umc, then peak (a counting sort on the umc sizes), so
+	// that each one goes at the end of the map instead of being looked up in it
+	mmultimap_umc_2_peak_index.clear() ; 
+	int numPeaks = mvect_isotope_peaks.size() ; 
+	int numUmcs = (int) mvect_umc_num_members.size() ; 
+	std::vector<int> vectUmcStart(numUmcs + 1, 0) ; 
+	for (int umcNum = 0 ; umcNum < numUmcs ; umcNum++)
+		vectUmcStart[umcNum + 1] = vectUmcStart[umcNum] + mvect_umc_num_members[umcNum] ; 
+	std::vector<int> vectPeaksByUmc(numPeaks) ; 
+	for (int pkNum = 0 ; pkNum < numPeaks ; pkNum++)
+		vectPeaksByUmc[vectUmcStart[mvect_isotope_peaks[pkNum].mint_umc_index]++] = pkNum ; 
+	for (int orderNum = 0 ; orderNum < numPeaks ; orderNum++)
+	{
+		int pkNum = vectPeaksByUmc[orderNum] ; 
+		mmultimap_umc_2_peak_index.insert(mmultimap_umc_2_peak_index.end(), std::pair<int,int>(mvect_isotope_peaks[pkNum].mint_umc_index, pkNum)) ; 
+	}
+	SaveRawClusters() ; 
+	mobj_telemetry.EndStage() ; 
+}
+
+void UMCCreator::SweepSortedPeaks(const std::vector<IsotopePeak> &sortedPeaks, std::vector<int> &vectSortedUmcIndex, UMCPeakMultimap &umcPeaks,
+	std::vector<int> *vectUmcFirstPeak, bool publishProgress)
+{
+	int numPeaks = (int) sortedPeaks.size() ; 
+
+	// now we are sorted. Start with the first index and move rightwards.
+	// For each index, 
+	// 1. If it already belongs to a UMC, move right comparing to all umcs in mass tolerance. For each match
+	//		a. If match is not in a UMC, calculate distance. If within tolerance add it to current umc.
+	//		b. If match is in the same UMC skip.
+	//		c. If match is in a different UMC, calculate distance. If within tolerance, merge umcs, update current guys UMC number.
+	// 2. If it does not belong to a UMC, move right comparing to all umcs in mass tolerance. For each match, calculate distance.
+	//		a. Create new UMC and follow 1.
+
+	int currentIndex = 0 ; 
+
+	IsotopePeak currentPeak ; 
+	IsotopePeak matchPeak ; 
+	int currentUmcIndex ; 
+	int numUmcsSoFar = 0 ; 
+	std::vector<int> tempIndices ; // used to store indices of isotope peaks that are moved from one umc to another. 
+	tempIndices.reserve(128) ; 
+
+	// counted locally and published once per batch of peaks
+	long long numDistanceEvaluations = 0 ; 
+	long long numMerges = 0 ; 
+
+	// On IMS data the candidates of each peak come from an index that also leaves out the peaks too far away in drift
+	// time or frame to be within mdbl_max_distance; those would fail the distance test anyway, so the features are the same.
+	// With a scan gap limit (or a drift time gap on IMS data) the index leaves out the peaks beyond it, on LC-MS data too.
+	ImsCandidateIndex candidateIndex ; 
+	std::vector<int> candidates ; 
+	float driftTolerance = FLT_MAX ; 
+	int scanTolerance = INT_MAX ; 
+	bool hasGapLimit = GetMaxScanGap() < INT_MAX || (mbln_is_ims_data && mflt_max_drift_time_gap > 0) ; 
+	bool useCandidateIndex = mbln_use_ims_candidate_index && (hasGapLimit || (mbln_is_ims_data && mflt_wt_ims_drift_time > 0
+		&& mdbl_max_distance > 0 && mdbl_max_distance < DBL_MAX)) ; 
+	if (useCandidateIndex)
+	{
+		GetCandidateTolerances(driftTolerance, scanTolerance) ; 
+		// the drift times of LC-MS peaks are all 0
+		if (!mbln_is_ims_data)
+			driftTolerance = FLT_MAX ; 
+		candidateIndex.Build(sortedPeaks, driftTolerance == FLT_MAX) ; 
+		candidates.reserve(256) ; 
+	}
+
+	while(currentIndex < numPeaks)
+	{
+		if ((currentIndex & ProgressTelemetry::PUBLISH_MASK) == 0)
+		{
+			if (publishProgress)
+				mobj_telemetry.SetItemsProcessed(currentIndex) ; 
+			mobj_telemetry.AddDistanceEvaluations(numDistanceEvaluations) ; 
+			mobj_telemetry.AddMerges(numMerges) ; 
+			numDistanceEvaluations = 0 ; 
+			numMerges = 0 ; 
+		}
+		currentPeak = sortedPeaks[currentIndex] ; 
+		currentUmcIndex = vectSortedUmcIndex[currentIndex] ; 
+		if (currentUmcIndex == -1)
+		{
+			// create UMC
+			umcPeaks.insert(std::pair<int,int>(numUmcsSoFar, currentIndex)) ; 
+			if (vectUmcFirstPeak != NULL)
+				vectUmcFirstPeak->push_back(currentIndex) ; 
+			currentUmcIndex = numUmcsSoFar ; 
+			vectSortedUmcIndex[currentIndex] = numUmcsSoFar ; 
+			numUmcsSoFar++ ; 
+		}
+		int matchIndex = currentIndex + 1; 
+		if (matchIndex == numPeaks)
+			break ;
+
+		double massTolerance = mflt_constraint_mono_mass ; 
+		if (mbln_constraint_mono_mass_is_ppm)
+			massTolerance *= currentPeak.mdbl_mono_mass / 1000000.0 ;		// Convert from ppm to Da tolerance
+
+		double maxMass = currentPeak.mdbl_mono_mass + massTolerance ; 
+		if (useCandidateIndex)
+		{
+			// only the peaks of the mass window that are close enough in drift time and frame to be within mdbl_max_distance
+			int lastIndex = (int) (std::lower_bound(sortedPeaks.begin() + matchIndex, sortedPeaks.end(), maxMass, &PeakMassBelow) - sortedPeaks.begin()) ; 
+			candidates.clear() ; 
+			candidateIndex.FindCandidates(matchIndex, lastIndex, currentPeak.mflt_ims_drift_time, driftTolerance, currentPeak.mint_lc_scan,
+				scanTolerance, candidates) ; 
+			for (int candidateNum = 0 ; candidateNum < (int) candidates.size() ; candidateNum++)
+			{
+				matchPeak = sortedPeaks[candidates[candidateNum]] ; 
+				LinkPeaks(currentPeak, matchPeak, candidates[candidateNum], currentUmcIndex, vectSortedUmcIndex, umcPeaks, tempIndices,
+					numDistanceEvaluations, numMerges) ; 
+			}
+		}
+		else
+		{
+			matchPeak = sortedPeaks[matchIndex] ; 
+			while (matchPeak.mdbl_mono_mass < maxMass)
+			{
+				LinkPeaks(currentPeak, matchPeak, matchIndex, currentUmcIndex, vectSortedUmcIndex, umcPeaks, tempIndices, numDistanceEvaluations,
+					numMerges) ; 
+				matchIndex++ ;
+				if (matchIndex < numPeaks)
+				{
+					matchPeak = sortedPeaks[matchIndex] ; 
+				}
+				else
+					break ; 
+			}
+		}
+		currentIndex++ ; 
+	}
+	mobj_telemetry.AddDistanceEvaluations(numDistanceEvaluations) ; 
+	mobj_telemetry.AddMerges(numMerges) ; 
+}
+
+void UMCCreator::SetPeks(std::vector<IsotopePeak> &vectPks)
+{
+	mvect_isotope_peaks.clear() ; 
+	mvect_isotope_peaks.insert(mvect_isotope_peaks.begin(), vectPks.begin(), vectPks.end()) ; 
+
+	int numPeaks = mvect_isotope_peaks.size() ; 
+	for (int i = 0 ; i < numPeaks  ; i++)
+	{
+		IsotopePeak pk = mvect_isotope_peaks[i] ; 
+		if (pk.mint_lc_scan > mint_lc_max_scan)
+			mint_lc_max_scan = pk.mint_lc_scan ; 
+		if (pk.mint_lc_scan < mint_lc_min_scan)
+			mint_lc_min_scan = pk.mint_lc_scan ; 
+	}
+}
+
+void UMCCreator::CopyPeaks(const UMCCreator &other)
+{
+	mvect_isotope_peaks = other.mvect_isotope_peaks ; 
+	mint_lc_min_scan = other.mint_lc_min_scan ; 
+	mint_lc_max_scan = other.mint_lc_max_scan ; 
+	mint_ims_min_scan = other.mint_ims_min_scan ; 
+	mint_ims_max_scan = other.mint_ims_max_scan ; 
+	mbln_is_ims_data = other.mbln_is_ims_data ; 
+}
+
+void UMCCreator::AdoptPeaks(std::vector<IsotopePeak> &vectPks)
+{
+	mvect_isotope_peaks.clear() ; 
+	mvect_isotope_peaks.swap(vectPks) ; 
+
+	int numPeaks = mvect_isotope_peaks.size() ; 
+	for (int i = 0 ; i < numPeaks ; i++)
+		UpdateScanRange(mvect_isotope_peaks[i]) ; 
+}
+
+// The distance takes the log of the abundance, so it has to be positive; NaN fails every comparison
+static bool CheckPeakValues(const IsotopePeak &pk, int pkNum, std::string &error)
+{
+	const char *field = NULL ; 
+	if (!(pk.mdbl_abundance > 0 && pk.mdbl_abundance <= DBL_MAX))
+		field = "abundance" ; 
+	else if (!(pk.mdbl_mono_mass >= 0 && pk.mdbl_mono_mass <= DBL_MAX))
+		field = "mono mass" ; 
+	else if (!(pk.mdbl_average_mass >= 0 && pk.mdbl_average_mass <= DBL_MAX))
+		field = "average mass" ; 
+	if (field == NULL)
+		return true ; 
+
+	char message[128] ; 
+	sprintf(message, "Peak %d has an invalid %s", pkNum, field) ; 
+	error = message ; 
+	return false ; 
+}
+
+// The clustering stores the UMC of a peak at mvect_isotope_peaks[mint_original_index], so the original indices of a
+// host have to be 0 to numPeaks - 1, each once. The peaks are put in that order, as a loader would have read them.
+static bool OrderByOriginalIndex(std::vector<IsotopePeak> &vectPks, std::string &error)
+{
+	int numPeaks = (int) vectPks.size() ; 
+	std::vector<int> vectPeakOfIndex(numPeaks, -1) ; 
+	bool inOrder = true ; 
+	char message[128] ; 
+	for (int pkNum = 0 ; pkNum < numPeaks ; pkNum++)
+	{
+		int originalIndex = vectPks[pkNum].mint_original_index ; 
+		if (originalIndex < 0 || originalIndex >= numPeaks)
+		{
+			sprintf(message, "Peak %d has original index %d, outside 0 to %d", pkNum, originalIndex, numPeaks - 1) ; 
+			error = message ; 
+			return false ; 
+		}
+		if (vectPeakOfIndex[originalIndex] != -1)
+		{
+			sprintf(message, "Peaks %d and %d have the same original index %d", vectPeakOfIndex[originalIndex], pkNum, originalIndex) ; 
+			error = message ; 
+			return false ; 
+		}
+		vectPeakOfIndex[originalIndex] = pkNum ; 
+		inOrder = inOrder && originalIndex == pkNum ; 
+	}
+	if (inOrder)
+		return true ; 
+
+	std::vector<IsotopePeak> vectOrdered(numPeaks) ; 
+	for (int originalIndex = 0 ; originalIndex < numPeaks ; originalIndex++)
+		vectOrdered[originalIndex] = vectPks[vectPeakOfIndex[originalIndex]] ; 
+	vectPks.swap(vectOrdered) ; 
+	return true ; 
+}
+
+bool UMCCreator::SetPeaks(const UMCPeakColumns &columns, std::string &error)
+{
+	int numPeaks = columns.num_peaks ; 
+	if (numPeaks < 0)
+	{
+		error = "The number of peaks is negative" ; 
+		return false ; 
+	}
+	if (numPeaks > 0 && (columns.lc_scan == NULL || columns.charge == NULL || columns.abundance == NULL || columns.mono_mass == NULL))
+	{
+		error = "The scan, charge, abundance and mono mass columns are required" ; 
+		return false ; 
+	}
+
+	std::vector<IsotopePeak> vectPks(numPeaks) ; 
+	for (int pkNum = 0 ; pkNum < numPeaks ; pkNum++)
+	{
+		IsotopePeak &pk = vectPks[pkNum] ; 
+		pk.mint_original_index = columns.original_index != NULL ? columns.original_index[pkNum] : pkNum ; 
+		pk.mint_line_number_in_file = 0 ; 
+		pk.mint_umc_index = -1 ; 
+		pk.mint_lc_scan = columns.lc_scan[pkNum] ; 
+		pk.mshort_charge = (short) columns.charge[pkNum] ; 
+		pk.mdbl_abundance = columns.abundance[pkNum] ; 
+		pk.mdbl_mz = columns.mz != NULL ? columns.mz[pkNum] : 0 ; 
+		pk.mflt_fit = columns.fit != NULL ? columns.fit[pkNum] : 0 ; 
+		pk.mdbl_average_mass = columns.average_mass != NULL ? columns.average_mass[pkNum] : 0 ; 
+		pk.mdbl_mono_mass = columns.mono_mass[pkNum] ; 
+		pk.mdbl_max_abundance_mass = columns.max_abundance_mass != NULL ? columns.max_abundance_mass[pkNum] : 0 ; 
+		pk.mdbl_i2_abundance = columns.i2_abundance != NULL ? columns.i2_abundance[pkNum] : 0 ; 
+		pk.mdbl_mono_abundance = 0 ; 
+		pk.mint_ims_scan = columns.ims_scan != NULL ? columns.ims_scan[pkNum] : 0 ; 
+		pk.mflt_ims_drift_time = columns.ims_drift_time != NULL ? columns.ims_drift_time[pkNum] : 0 ; 
+		pk.mflt_orig_intensity = 0 ; 
+		pk.mflt_tia_orig_intensity = 0 ; 
+		pk.mflt_cum_drift_time = 0 ; 
+		if (!CheckPeakValues(pk, pkNum, error))
+			return false ; 
+	}
+
+	if (columns.original_index != NULL && !OrderByOriginalIndex(vectPks, error))
+		return false ; 
+
+	mbln_is_ims_data = columns.ims_scan != NULL ; 
+	AdoptPeaks(vectPks) ; 
+	return true ; 
+}
+
+bool UMCCreator::SetPeaks(const UMCPeakRecord *records, int numRecords, bool isImsData, std::string &error)
+{
+	if (numRecords < 0 || (numRecords > 0 && records == NULL))
+	{
+		error = "No peak records" ; 
+		return false ; 
+	}
+
+	std::vector<IsotopePeak> vectPks(numRecords) ; 
+	for (int pkNum = 0 ; pkNum < numRecords ; pkNum++)
+	{
+		const UMCPeakRecord &record = records[pkNum] ; 
+		IsotopePeak &pk = vectPks[pkNum] ; 
+		pk.mint_original_index = record.original_index ; 
+		pk.mint_line_number_in_file = 0 ; 
+		pk.mint_umc_index = -1 ; 
+		pk.mint_lc_scan = record.lc_scan ; 
+		pk.mshort_charge = (short) record.charge ; 
+		pk.mdbl_abundance = record.abundance ; 
+		pk.mdbl_mz = record.mz ; 
+		pk.mflt_fit = record.fit ; 
+		pk.mdbl_average_mass = record.average_mass ; 
+		pk.mdbl_mono_mass = record.mono_mass ; 
+		pk.mdbl_max_abundance_mass = record.max_abundance_mass ; 
+		pk.mdbl_i2_abundance = record.i2_abundance ; 
+		pk.mdbl_mono_abundance = 0 ; 
+		pk.mint_ims_scan = isImsData ? record.ims_scan : 0 ; 
+		pk.mflt_ims_drift_time = record.ims_drift_time ; 
+		pk.mflt_orig_intensity = 0 ; 
+		pk.mflt_tia_orig_intensity = 0 ; 
+		pk.mflt_cum_drift_time = 0 ; 
+		if (!CheckPeakValues(pk, pkNum, error))
+			return false ; 
+	}
+
+	if (!OrderByOriginalIndex(vectPks, error))
+		return false ; 
+
+	mbln_is_ims_data = isImsData ; 
+	AdoptPeaks(vectPks) ; 
+	return true ; 
+}
+
+int UMCCreator::ParsePekScanNumber(char *fileNameLine, bool isFirstScan, bool &isFromWiff)
+{
+	// found file name. start at the end. 
+	int index = (int)strlen(fileNameLine) ; 
+	while (index > 0 && fileNameLine[index] != '.')
+	{
+		index-- ; 
+	}
+	index++ ; 
+	// wiff file pek files have a weird format. Another ICR2LS-ism.
+	if (isFirstScan)
+	{
+		if(_strnicmp(&fileNameLine[index], "wiff", 4) ==0)
+		{
+			isFromWiff = true ; 
+			// REMEMBER TO DELETE WHEN PARAMETERS ARE SET ELSEWHERE
+			mflt_wt_mono_mass = 0.0025F ; // using ppms 10 ppm = length of 0.1 ppm
+			mflt_wt_average_mass = 0.0025F ; // using ppms 10 ppm = length of 0.1 ppm
+			mflt_wt_log_abundance = 0.1F ; 
+			mflt_wt_scan = 0.01F ; 
+			mflt_wt_fit = 0.1F ; 
+			mflt_wt_ims_drift_time = 0.1F ;
+
+			mflt_constraint_mono_mass = 25.0F ; // is in ppm
+			mflt_constraint_average_mass = 25.0F ; // is in ppm. 
+
+			mbln_use_net = true ;
+			mbln_constraint_mono_mass_is_ppm = true ;
+			mbln_constraint_average_mass_is_ppm = true ;
+
+			mdbl_max_distance = 0.1 ; 
+		}
+	}
+	if (isFromWiff)
+		index += 5 ; 
+	return atoi(&fileNameLine[index]) ; 
+}
+
+void UMCCreator::ParsePekLine(char *buffer, IsotopePeak &pk, bool isotopicallyLabeled)
+{
+	char *stopPtr ; 
+	char *stopPtrNext ; 
+	pk.mshort_charge = (short) strtol(buffer, &stopPtr, 10) ; 
+	pk.mdbl_abundance = strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = stopPtrNext ; 
+	pk.mdbl_mz = strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = stopPtrNext ; 
+	pk.mflt_fit = (float)strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = stopPtrNext ; 
+	pk.mdbl_average_mass = strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = stopPtrNext ; 
+	pk.mdbl_mono_mass = strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = stopPtrNext ; 
+	pk.mdbl_max_abundance_mass = strtod(stopPtr, &stopPtrNext) ; 
+	stopPtr = stopPtrNext ; 
+	if (isotopicallyLabeled)
+	{
+		pk.mdbl_mono_abundance = strtod(stopPtr, &stopPtrNext) ; 
+		stopPtr = stopPtrNext ; 
+		pk.mdbl_i2_abundance = strtod(stopPtr, &stopPtrNext) ; 
+		stopPtr = stopPtrNext ; 
+	}
+
+	pk.mflt_ims_drift_time = 0 ;
+}
+
+void UMCCreator::ReadPekFileMemoryMapped(char *fileName)
+{
+	Reset() ; 
+	MemMappedReader mappedReader ; 
+	mappedReader.Load(fileName) ; 
+	__int64 file_len = mappedReader.FileLength() ; 
+
+	char *fileNameTag = "Filename:" ; 
+	int fileNameTagLength = (int)strlen(fileNameTag) ; 
+	char *startTag = "CS,  Abundance,   m/z,   Fit,    Average MW, Monoisotopic MW,    Most abundant MW" ; 
+	char *startTagIsotopicLabeled = "CS,  Abundance,   m/z,   Fit,    Average MW, Monoisotopic MW,    Most abundant MW,   Imono,   I+2" ; 
+	int startTagLength = (int)strlen(startTag) ; 
+	char *stopTag = "Processing stop time:" ; 
+	int stopTagLen = (int)strlen(stopTag) ; 
+	bool reading = false ; 
+	bool isotopically_labeled = false ;
+	bool is_first_scan = true ; 
+	bool is_pek_file_from_wiff = false ; 
+
+	IsotopePeak pk ; 
+
+	short charge = 0 ; 
+	double abundance = 0 ;
+	float fit = 0, mz = 0 , averageMass = 0 , monoMass = 0 , maxMass = 0 ;  
+
+	int numPeaks = 0 ; 
+
+	mobj_telemetry.BeginStage(STAGE_LOADING, file_len) ;
+
+	pk.mdbl_abundance = 0 ; 
+	pk.mdbl_i2_abundance = 0 ; 
+	pk.mdbl_average_mass = 0 ; 
+	pk.mflt_fit = 0 ; 
+	pk.mdbl_max_abundance_mass = 0 ; 
+	pk.mdbl_mono_mass = 0 ; 
+	pk.mdbl_mz = 0 ; 
+	pk.mshort_charge = 0 ; 
+	pk.mflt_ims_drift_time = 0 ;
+	pk.mdbl_mono_abundance = 0 ; 
+	pk.mint_line_number_in_file = 0 ; 
+	pk.mint_ims_scan = 0 ; 
+
+	int mint_min_scan = INT_MAX ; 
+	int mint_max_scan = 0 ; 
+
+	int pos = 0 ; 
+	const int MAX_HEADER_BUFFER_LEN = 1024 ; 
+	char headerBuffer[MAX_HEADER_BUFFER_LEN] ;
+	const int MAX_BUFFER_LEN = 1024 ; 
+	char buffer[MAX_BUFFER_LEN] ;
+
+	while (!mappedReader.eof())
+	{
+		// once per scan block
+		mobj_telemetry.SetItemsProcessed(mappedReader.InputPosition()) ; 
+		mobj_telemetry.SetBytesRead(mappedReader.InputPosition()) ; 
+
+		bool success = mappedReader.SkipToAfterLine(fileNameTag, headerBuffer, fileNameTagLength, MAX_HEADER_BUFFER_LEN) ; 
+		if (!success)
+		{
+			break ; 
+		}
+		else
+		{
+			pk.mint_lc_scan = ParsePekScanNumber(headerBuffer, is_first_scan, is_pek_file_from_wiff) ; 
+			if (pk.mint_lc_scan > mint_max_scan)
+				mint_max_scan = pk.mint_lc_scan ; 
+			if (pk.mint_lc_scan < mint_min_scan)
+				mint_min_scan = pk.mint_lc_scan ; 
+		}
+
+		if (is_first_scan)
+		{
+			bool success = mappedReader.SkipToAfterLine(startTag, headerBuffer, startTagLength, MAX_HEADER_BUFFER_LEN) ; 
+			if (!success)
+				break ; 
+			if (strncmp(headerBuffer, startTagIsotopicLabeled, strlen(startTagIsotopicLabeled)) == 0)
+			{
+				isotopically_labeled = true ; 
+			}
+			is_first_scan = false ; 
+		}
+		else
+		{
+			bool success = mappedReader.SkipToAfterLine(startTag, startTagLength) ; 
+			if (!success)
+				break ; 
+		}
+		while(!mappedReader.eof() && mappedReader.GetNextLine(buffer, MAX_BUFFER_LEN, stopTag, stopTagLen))
+		{
+			ParsePekLine(buffer, pk, isotopically_labeled) ; 
+			pk.mint_original_index = numPeaks ; 
+			mvect_isotope_peaks.push_back(pk) ; 
+			numPeaks++ ; 
+		}
+	}
+	mobj_telemetry.SetBytesRead(mappedReader.InputPosition()) ; 
+	mobj_telemetry.AddPeaksKept(numPeaks) ; 
+	mobj_telemetry.EndStage() ; 
+	mappedReader.Close() ; 	
+}
+
+
+void UMCCreator::ReadPekFile(char *fileName)
+{
+	Reset() ; 
+	FILE *fp = fopen(fileName, "r") ;
+	int success = fseek(fp, 0, SEEK_END) ; 
+	int file_len = ftell(fp) ; 
+	success = fseek(fp, 0, SEEK_SET) ; 
+
+	const int MAX_LINE_LENGTH = 512 ; 
+	char buffer[MAX_LINE_LENGTH] ; 
+	char *fileNameTag = "Filename:" ; 
+	int fileNameTagLength = strlen(fileNameTag) ; 
+	char *startTag = "CS,  Abundance,   m/z,   Fit,    Average MW, Monoisotopic MW,    Most abundant MW" ; 
+	char *startTagIsotopicLabeled = "CS,  Abundance,   m/z,   Fit,    Average MW, Monoisotopic MW,    Most abundant MW,   Imono,   I+2" ; 
+	int startTagLength = strlen(startTag) ; 
+	char *stopTag = "Processing stop time:" ; 
+	bool reading = false ; 
+	bool isotopically_labeled = false ;
+	bool is_first_scan = true ; 
+
+	IsotopePeak pk ; 
+	int stopTagLen = (int)strlen(stopTag) ; 
+
+	short charge = 0 ; 
+	double abundance = 0 ;
+	float fit = 0, mz = 0 , averageMass = 0 , monoMass = 0 , maxMass = 0 ;  
+
+	int numPeaks = 0 ; 
+
+	mobj_telemetry.BeginStage(STAGE_LOADING, file_len) ;
+
+	pk.mdbl_abundance = 0 ; 
+	pk.mdbl_i2_abundance = 0 ; 
+	pk.mdbl_average_mass = 0 ; 
+	pk.mflt_fit = 0 ; 
+	pk.mdbl_max_abundance_mass = 0 ; 
+	pk.mdbl_mono_mass = 0 ; 
+	pk.mdbl_mz = 0 ; 
+	pk.mshort_charge = 0 ; 
+	pk.mflt_ims_drift_time = 0 ;
+
+	mint_lc_min_scan = INT_MAX ; 
+	mint_lc_max_scan = 0 ; 
+
+
+	int pos = 0 ; 
+	while (!feof(fp))
+	{
+		if (!reading)
+		{
+			fgets(buffer, MAX_LINE_LENGTH, fp) ; 
+			pos += (int) strlen(buffer) ; 
+			mobj_telemetry.SetItemsProcessed(pos) ; 
+			if (strncmp(buffer, startTag, startTagLength) == 0)
+			{
+				reading = true ; 
+				if (is_first_scan)
+				{
+					if (strncmp(buffer, startTagIsotopicLabeled, strlen(startTagIsotopicLabeled)) == 0)
+					{
+						isotopically_labeled = true ; 
+					}
+					is_first_scan = false ; 
+				}
+			}
+			else if (strncmp(buffer, fileNameTag, fileNameTagLength) == 0)
+			{
+				// found file name. start at the end. 
+				int index = strlen(buffer) ; 
+				while (index > 0 && buffer[index] != '.')
+				{
+					index-- ; 
+				}
+				index++ ; 
+				pk.mint_lc_scan = atoi(&buffer[index]) ; 
+				if (pk.mint_lc_scan > mint_lc_max_scan)
+					mint_lc_max_scan = pk.mint_lc_scan ; 
+				if (pk.mint_lc_scan < mint_lc_min_scan)
+					mint_lc_min_scan = pk.mint_lc_scan ; 
+			}
+		}
+		else
+		{
+			//int numRead = fscanf(fp, "%hd\t%lg\t%g\t%g\t%g\t%g\t%g", &charge, &abundance, &mz, &fit, 
+			//	&averageMass, &monoMass, &maxMass) ; 
+			int numRead = 0 ; 
+			if (isotopically_labeled)
+			{
+				numRead = fscanf(fp, "%hd\t%lg\t%lg\t%g\t%lg\t%lg\t%lg\t%lg\t%lg", &pk.mshort_charge, &pk.mdbl_abundance, &pk.mdbl_mz, &pk.mflt_fit, 
+					&pk.mdbl_average_mass, &pk.mdbl_mono_mass, &pk.mdbl_max_abundance_mass, &pk.mdbl_mono_abundance, &pk.mdbl_i2_abundance) ; 
+				pos += 71 ; // this is really approximate, but its better than using ftellp
+			}
+			else
+			{
+				numRead = fscanf(fp, "%hd\t%lg\t%lg\t%g\t%lg\t%lg\t%lg", &pk.mshort_charge, &pk.mdbl_abundance, &pk.mdbl_mz, &pk.mflt_fit, 
+					&pk.mdbl_average_mass, &pk.mdbl_mono_mass, &pk.mdbl_max_abundance_mass) ; 
+				pos += 51 ; // this is really approximate, but its better than using ftellp
+			}
+			if (numRead == 0)
+			{
+				// at the end of the reading sections
+				reading = false ; 
+				pos += stopTagLen ; 
+			}
+			else
+			{
+				pk.mint_original_index = numPeaks ; 
+				mvect_isotope_peaks.push_back(pk) ; 
+				numPeaks++ ; 
+			}
+		}
+	}
+	mobj_telemetry.SetBytesRead(file_len) ; 
+	mobj_telemetry.AddPeaksKept(numPeaks) ; 
+	mobj_telemetry.EndStage() ; 
+}
+
+// Will map be affected by chunking?
+bool UMCCreator::PrintMapping(OutputFileWriter &stream, int featureStartIndex){
+
+	stream.Printf("Feature_Index\tPeak_Index\n");
+
+	for (UMCPeakMultimap::iterator iter = mmultimap_umc_2_peak_index.begin() ; iter != mmultimap_umc_2_peak_index.end() ; ){
+		int currentUmcNum = (*iter).first;
+		while(iter != mmultimap_umc_2_peak_index.end() && (*iter).first == currentUmcNum)
+		{
+				IsotopePeak pk = mvect_isotope_peaks[(*iter).second] ; 
+				
+				stream.Printf("%d\t%d\n", currentUmcNum + featureStartIndex, pk.mint_line_number_in_file) ; 
+				iter++ ;
+		}
+			 
+	}
+
+	return true;
+
+}
+
+void UMCCreator::PrintUMCHeader(OutputFileWriter &stream, bool print_members)
+{
+	stream.Printf("Feature_Index\tMonoisotopic_Mass\tAverage_Mono_Mass\tUMC_MW_Min\tUMC_MW_Max\tScan_Start\tScan_End\tScan\tUMC_Member_Count\tMax_Abundance\tAbundance\tClass_Rep_MZ\tClass_Rep_Charge") ; 
+	if (print_members){
+		stream.Printf("\tData") ; 
+	}
+	
+	stream.Printf("\n") ; 
+}
+
+// Every column of one feature, each followed by a tab; the caller ends the row
+void UMCCreator::PrintUMCRow(OutputFileWriter &stream, UMC &current_umc, int featureIndex)
+{
+	stream.Printf("%d\t", featureIndex) ; 		
+	stream.Printf("%4.4f\t", current_umc.mdbl_median_mono_mass);
+	stream.Printf("%4.4f\t", current_umc.mdbl_average_mono_mass) ; 
+	stream.Printf("%4.4f\t", current_umc.mdbl_min_mono_mass);
+	stream.Printf("%4.4f\t", current_umc.mdbl_max_mono_mass);
+	stream.Printf("%d\t", current_umc.mint_start_scan) ; 
+	stream.Printf("%d\t", current_umc.mint_stop_scan);
+	stream.Printf("%d\t",current_umc.mint_max_abundance_scan);
+	stream.Printf("%d\t",current_umc.min_num_members) ; 
+	stream.Printf("%4.4f\t", current_umc.mdbl_max_abundance);
+	stream.Printf("%4.4f\t", current_umc.mdbl_sum_abundance) ; 
+	stream.Printf("%4.4f\t", current_umc.mdbl_class_rep_mz) ; 
+	stream.Printf("%d\t", current_umc.mshort_class_rep_charge) ; 
+}
+
+bool UMCCreator::PrintUMCs(OutputFileWriter &stream, bool print_members, int featureStartIndex){
+	bool success = true;
+	PrintUMCHeader(stream, print_members) ; 
+	
+	int numPrinted = 1 ; 
+	for (UMCPeakMultimap::iterator iter = mmultimap_umc_2_peak_index.begin() ; iter != mmultimap_umc_2_peak_index.end() ; )
+	{
+		int currentUmcNum = (*iter).first; 
+		UMC current_umc = mvect_umcs[currentUmcNum] ; 
+		PrintUMCRow(stream, current_umc, current_umc.mint_umc_index + featureStartIndex) ; 
+
+			while(iter != mmultimap_umc_2_peak_index.end() && (*iter).first == currentUmcNum)
+			{
+				if (print_members){	
+			
+				IsotopePeak pk = mvect_isotope_peaks[(*iter).second] ; 
+				
+				stream.Printf("%4.4f\t",pk.mdbl_mono_mass) ; 
+				stream.Printf("%d\t",pk.mint_lc_scan);
+				stream.Printf("%4.4\t", pk.mdbl_abundance) ; 
+				}
+				iter++ ; 
+			}
+		
+
+		numPrinted++ ; 
+		stream.Printf("\n") ; 
+	}
+
+	// the stream belongs to the caller (CreateFeatureFiles) and is closed there
+
+	if ( numPrinted < 1 ){
+		success = false;
+	}
+
+	return success;
+
+}
+
+void UMCCreator::PrintUMCs(bool print_members)
+{
+	std::cout<<"UMCIndex\tUMCMonoMW\tAverageMonoMass\tUMCMWMin\tUMCMWMax\tScanStart\tScanEnd\tScanClassRep\tUMCMemberCount\tMaxAbundance\tUMCAbundance" ; 
+	if (print_members)
+		std::cout<<"\tData" ; 
+		std::cout<<"\n" ; 
+	std::cout.precision(4);     
+	std::cout.flags(std::ios::right | std::ios::fixed);
+	int numPrinted = 1 ; 
+	for (UMCPeakMultimap::iterator iter = mmultimap_umc_2_peak_index.begin() ; iter != mmultimap_umc_2_peak_index.end() ; )
+	{
+		int currentUmcNum = (*iter).first; 
+		UMC current_umc = mvect_umcs[currentUmcNum] ; 
+		std::cout.precision(0) ; 
+		std::cout<<current_umc.mint_umc_index<<"\t" ; 		
+		std::cout.precision(4) ; 
+		std::cout<<current_umc.mdbl_median_mono_mass<<"\t"<<current_umc.mdbl_average_mono_mass<<"\t" ; 
+		std::cout<<current_umc.mdbl_min_mono_mass<<"\t"<<current_umc.mdbl_max_mono_mass<<"\t"<<current_umc.mint_start_scan<<"\t" ; 
+		std::cout.precision(0) ; 
+		std::cout<<current_umc.mint_stop_scan<<"\t"<<current_umc.mint_max_abundance_scan<<"\t"<<current_umc.min_num_members<<"\t" ; 
+		std::cout<<current_umc.mdbl_max_abundance<<"\t"<<current_umc.mdbl_sum_abundance ; 
+		while(iter != mmultimap_umc_2_peak_index.end() && (*iter).first == currentUmcNum)
+		{
+			if (print_members)
+			{
+				IsotopePeak pk = mvect_isotope_peaks[(*iter).second] ; 
+				std::cout.precision(4) ; 
+				std::cout<<"\t"<<pk.mdbl_mono_mass<<"\t" ; 
+				std::cout.precision(0) ; 
+				std::cout<<pk.mint_lc_scan<<"\t"<<pk.mdbl_abundance<<"\t" ; 
+			}
+			iter++ ; 
+		}
+		numPrinted++ ; 
+		std::cout<<"\n" ; 
+	}
+}
+
+void UMCCreator::PrintPeaks()
+{
+	int numPeaks = mvect_isotope_peaks.size() ; 
+	std::cout<<"Scan\tCharge\tAbundance\tMZ\tFit\tAverageMass\tMonoMass\tMaxMass\n" ; 
+
+	std::cout.precision(4);     
+	std::cout.flags(std::ios::right | std::ios::fixed);
+
+	for (int i = 0 ; i < numPeaks  ; i++)
+	{
+		IsotopePeak pk = mvect_isotope_peaks[i] ; 
+		std::cout.precision(0) ; 
+		std::cout<<pk.mint_lc_scan<<"\t"<<pk.mshort_charge<<"\t"<<pk.mdbl_abundance<<"\t" ; 
+		std::cout.precision(4) ; 
+		std::cout<<pk.mdbl_mz<<"\t" ; 
+		std::cout.precision(3) ; 
+		std::cout<<pk.mflt_fit<<"\t" ; 
+		std::cout.precision(4) ; 
+
+		std::cout<<pk.mdbl_average_mass ; 
+		std::cout<<"\t"<<pk.mdbl_mono_mass ; 
+		std::cout<<"\t"<<pk.mdbl_max_abundance_mass<<"\n" ; 
+	}
+}
+
+void UMCCreator::Reset()
+{
+	mvect_isotope_peaks.clear() ; 
+	mvect_umcs.clear() ; 
+	mvect_umc_num_members.clear() ;
+	mmultimap_umc_2_peak_index.clear() ; 
+	// the map is empty, so the nodes of this run go back to the heap in one piece
+	mobj_arena.Release() ; 
+	mvect_raw_umc_start.clear() ; 
+	mvect_raw_umc_peaks.clear() ; 
+	mvect_umc_raw_index.clear() ; 
+	mvect_raw_umcs.clear() ; 
+	mvect_raw_umc_stats_index.clear() ; 
+	mobj_telemetry.Reset() ; 
+}
+
+/*
+ * Calls the worker functions for creating and outputting the Features.
+ */
+bool UMCCreator::CreateFeatureFiles(char* baseFileName, int featureStartIndex)
+{
+	bool success;
+	OutputFileWriter file;
+
+	mobj_telemetry.BeginStage(STAGE_WRITING, (long long) mvect_umcs.size());
+
+	// Create the file where the LCMS Features will be written
+	if (!OpenOutputFile(file, baseFileName, "_LCMSFeatures.txt"))
+	{
+		mobj_telemetry.EndStage();
+		return false;
+	}
+
+	success = PrintUMCs(file, false, featureStartIndex);
+	success = file.Close() && success;
+	mobj_telemetry.AddBytesWritten(file.GetBytesWritten());
+
+	if (success)
+	{
+		// Create the file where the "Features to Peak Map" will be written
+		if (!OpenOutputFile(file, baseFileName, "_LCMSFeatureToPeakMap.txt"))
+		{
+			mobj_telemetry.EndStage();
+			return false;
+		}
+
+		success = PrintMapping(file, featureStartIndex);
+		success = file.Close() && success;
+		mobj_telemetry.AddBytesWritten(file.GetBytesWritten());
+	}
+
+	mobj_telemetry.EndStage();
+	return success;
+}
+
+bool UMCCreator::OpenOutputFile(OutputFileWriter &writer, const char *baseFileName, const char *suffix)
+{
+	char completeFileName[1100] ;
+	sprintf(completeFileName, "%s%s%s", baseFileName, suffix, GetCompressionExtension(menm_output_compression)) ;
+	return writer.Open(completeFileName, menm_output_compression, mint_output_compression_level, mint_output_compression_threads) ;
+}
+
+// Opens the feature or peak map file CreateFeatureFiles wrote for chunk chunkNum and skips its header
+static bool OpenChunkFile(MemMappedReader &reader, const char *baseFileName, int chunkNum, const char *suffix, CompressionFormat format,
+	char *buffer, int maxLength)
+{
+	char chunkFileName[1100] ;
+	sprintf(chunkFileName, "%s_chunk%d%s%s", baseFileName, chunkNum, suffix, GetCompressionExtension(format)) ;
+	return reader.Load(chunkFileName) && !reader.eof() && reader.GetNextLine(buffer, maxLength, "\n", maxLength) ;
+}
+
+void UMCCreator::AddChunkEndPeaks(float massStart, float massEnd, std::map<int, IsotopePeak> &peaks)
+{
+	// wider than the tolerance MergeChunkFeatureFiles applies to the printed masses, so that it finds every peak it asks for
+	const double MASS_TOLERANCE = 0.001 ; 
+	for (UMCPeakMultimap::iterator iter = mmultimap_umc_2_peak_index.begin() ; iter != mmultimap_umc_2_peak_index.end() ; iter++)
+	{
+		UMC &umc = mvect_umcs[(*iter).first] ; 
+		if (umc.mdbl_min_mono_mass <= massStart + MASS_TOLERANCE || umc.mdbl_max_mono_mass >= massEnd - MASS_TOLERANCE)
+		{
+			IsotopePeak &pk = mvect_isotope_peaks[(*iter).second] ; 
+			peaks[pk.mint_line_number_in_file] = pk ; 
+		}
+	}
+}
+
+// A feature of the merged files that reaches the end of a chunk, waiting for the features of the next chunk that share its peaks
+struct ChunkEndFeature
+{
+	// the columns of the chunk file after the feature index, printed as they are unless other features joined it
+	std::string mstr_columns ; 
+	// lines of the peaks in the input file
+	std::vector<int> mvect_peaks ; 
+	bool mbln_joined ; 
+	// a feature of the chunk being read that reaches its end is part of it, so it waits for the next chunk
+	bool mbln_continues ; 
+	// index of the feature it was joined into, -1 while it is printed itself
+	int mint_joined_into ; 
+} ;
+
+static int FindChunkEndFeature(std::vector<ChunkEndFeature> &features, int featureNum)
+{
+	while (features[featureNum].mint_joined_into >= 0)
+		featureNum = features[featureNum].mint_joined_into ; 
+	return featureNum ; 
+}
+
+// Prints a feature and its map lines; a joined feature gets the statistics of all of its peaks
+static void PrintChunkEndFeature(OutputFileWriter &featureFile, OutputFileWriter &mapFile, ChunkEndFeature &feature,
+	const std::map<int, IsotopePeak> &boundaryPeaks, int featureIndex)
+{
+	std::vector<int> &peakLines = feature.mvect_peaks ; 
+	if (!feature.mbln_joined)
+	{
+		featureFile.Printf("%d%s\n", featureIndex, feature.mstr_columns.c_str()) ; 
+	}
+	else
+	{
+		std::sort(peakLines.begin(), peakLines.end()) ; 
+		peakLines.erase(std::unique(peakLines.begin(), peakLines.end()), peakLines.end()) ; 
+		std::vector<IsotopePeak> peaks ; 
+		std::vector<int> members ; 
+		for (int peakNum = 0 ; peakNum < (int) peakLines.size() ; peakNum++)
+		{
+			std::map<int, IsotopePeak>::const_iterator iter = boundaryPeaks.find(peakLines[peakNum]) ; 
+			if (iter == boundaryPeaks.end())
+				throw "A peak of a feature at a chunk end is missing" ; 
+			peaks.push_back((*iter).second) ; 
+			members.push_back(peakNum) ; 
+		}
+		UMC umc ; 
+		std::vector<double> vect_mass ; 
+		UMCCreator::SummarizeMembers(peaks, &members[0], (int) members.size(), umc, vect_mass) ; 
+		UMCCreator::PrintUMCRow(featureFile, umc, featureIndex) ; 
+		featureFile.Printf("\n") ; 
+	}
+	for (int peakNum = 0 ; peakNum < (int) peakLines.size() ; peakNum++)
+		mapFile.Printf("%d\t%d\n", featureIndex, peakLines[peakNum]) ; 
+}
+
+int UMCCreator::MergeChunkFeatureFiles(char *baseFileName, const std::vector<float> &chunkEnds, const std::map<int, IsotopePeak> &boundaryPeaks,
+	bool removeChunkFiles, int &numDuplicates)
+{
+	char *stopTag = "Blah" ; 
+	int stopTagLen = (int)strlen(stopTag) ; 
+	const int MAX_BUFFER_LEN = 1024 ; 
+	char featureLine[MAX_BUFFER_LEN] ; 
+	char mapLine[MAX_BUFFER_LEN] ; 
+	// the masses are written with 4 decimals
+	const double MASS_PRINT_TOLERANCE = 0.0001 ; 
+
+	int numChunks = (int) chunkEnds.size() ; 
+	numDuplicates = 0 ; 
+	mobj_telemetry.BeginStage(STAGE_WRITING, numChunks) ; 
+
+	OutputFileWriter featureFile ; 
+	OutputFileWriter mapFile ; 
+	if (!OpenOutputFile(featureFile, baseFileName, "_LCMSFeatures.txt") || !OpenOutputFile(mapFile, baseFileName, "_LCMSFeatureToPeakMap.txt"))
+		throw "Unable to create the feature files" ; 
+	PrintUMCHeader(featureFile, false) ; 
+	mapFile.Printf("Feature_Index\tPeak_Index\n") ; 
+
+	// A peak at the mass where two chunks meet is clustered in both, so the features holding it are one feature.
+	// Only the features that reach the end of a chunk can hold one: they are printed once the next chunk is read,
+	// joined with the features of that chunk that share their peaks.
+	std::vector<ChunkEndFeature> endFeatures ; 
+	std::map<int, int> endPeaks ; 
+	std::map<int, int> nextEndPeaks ; 
+	std::vector<int> peakLines ; 
+	std::vector<int> sharedLines ; 
+	std::vector<int> joinedFeatures ; 
+	int numFeatures = 0 ; 
+	for (int chunkNum = 0 ; chunkNum < numChunks ; chunkNum++)
+	{
+		mobj_telemetry.SetItemsProcessed(chunkNum) ; 
+		MemMappedReader featureReader ; 
+		MemMappedReader mapReader ; 
+		if (!OpenChunkFile(featureReader, baseFileName, chunkNum, "_LCMSFeatures.txt", menm_output_compression, featureLine, MAX_BUFFER_LEN)
+			|| !OpenChunkFile(mapReader, baseFileName, chunkNum, "_LCMSFeatureToPeakMap.txt", menm_output_compression, mapLine, MAX_BUFFER_LEN))
+			throw "Unable to open a chunk file" ; 
+
+		// both files are in feature order, so each feature row is followed by its lines of the map
+		int mapFeature = -1 ; 
+		int mapPeak = -1 ; 
+		bool mapLeft = !mapReader.eof() && mapReader.GetNextLine(mapLine, MAX_BUFFER_LEN, stopTag, stopTagLen)
+			&& sscanf(mapLine, "%d\t%d", &mapFeature, &mapPeak) == 2 ; 
+		while (!featureReader.eof() && featureReader.GetNextLine(featureLine, MAX_BUFFER_LEN, stopTag, stopTagLen))
+		{
+			int featureIndex ; 
+			double monoMass, averageMass, minMass, maxMass ; 
+			char *columns = strchr(featureLine, '\t') ; 
+			if (columns == NULL || sscanf(featureLine, "%d\t%lf\t%lf\t%lf\t%lf", &featureIndex, &monoMass, &averageMass, &minMass, &maxMass) != 5)
+				throw "Incorrect feature row in a chunk file" ; 
+
+			bool atStart = chunkNum > 0 && minMass <= chunkEnds[chunkNum - 1] + MASS_PRINT_TOLERANCE ; 
+			bool atEnd = chunkNum + 1 < numChunks && maxMass >= chunkEnds[chunkNum] - MASS_PRINT_TOLERANCE ; 
+			peakLines.clear() ; 
+			sharedLines.clear() ; 
+			joinedFeatures.clear() ; 
+			for ( ; mapLeft && mapFeature == featureIndex ; mapLeft = !mapReader.eof() && mapReader.GetNextLine(mapLine, MAX_BUFFER_LEN, stopTag, stopTagLen)
+				&& sscanf(mapLine, "%d\t%d", &mapFeature, &mapPeak) == 2)
+			{
+				std::map<int, int>::iterator shared = atStart ? endPeaks.find(mapPeak) : endPeaks.end() ; 
+				if (shared == endPeaks.end())
+				{
+					peakLines.push_back(mapPeak) ; 
+					continue ; 
+				}
+				sharedLines.push_back(mapPeak) ; 
+				int endFeature = FindChunkEndFeature(endFeatures, (*shared).second) ; 
+				if (std::find(joinedFeatures.begin(), joinedFeatures.end(), endFeature) == joinedFeatures.end())
+					joinedFeatures.push_back(endFeature) ; 
+			}
+
+			if (joinedFeatures.empty() && !atEnd)
+			{
+				featureFile.Printf("%d%s\n", numFeatures, columns) ; 
+				for (int peakNum = 0 ; peakNum < (int) peakLines.size() ; peakNum++)
+					mapFile.Printf("%d\t%d\n", numFeatures, peakLines[peakNum]) ; 
+				numFeatures++ ; 
+				continue ; 
+			}
+
+			int target ; 
+			if (joinedFeatures.empty())
+			{
+				ChunkEndFeature feature ; 
+				feature.mstr_columns = columns ; 
+				feature.mbln_joined = false ; 
+				feature.mbln_continues = false ; 
+				feature.mint_joined_into = -1 ; 
+				target = (int) endFeatures.size() ; 
+				endFeatures.push_back(feature) ; 
+			}
+			else
+			{
+				// the first feature it shares a peak with takes its other peaks and the other features it shares peaks with
+				target = *std::min_element(joinedFeatures.begin(), joinedFeatures.end()) ; 
+				ChunkEndFeature &targetFeature = endFeatures[target] ; 
+				for (int joinedNum = 0 ; joinedNum < (int) joinedFeatures.size() ; joinedNum++)
+				{
+					ChunkEndFeature &joined = endFeatures[joinedFeatures[joinedNum]] ; 
+					if (joinedFeatures[joinedNum] == target)
+						continue ; 
+					targetFeature.mvect_peaks.insert(targetFeature.mvect_peaks.end(), joined.mvect_peaks.begin(), joined.mvect_peaks.end()) ; 
+					targetFeature.mbln_continues = targetFeature.mbln_continues || joined.mbln_continues ; 
+					joined.mvect_peaks.clear() ; 
+					joined.mint_joined_into = target ; 
+				}
+				// all of its peaks are in one feature of the earlier chunk already
+				if (peakLines.empty() && joinedFeatures.size() == 1)
+					numDuplicates++ ; 
+				else
+					targetFeature.mbln_joined = true ; 
+			}
+			ChunkEndFeature &feature = endFeatures[target] ; 
+			feature.mvect_peaks.insert(feature.mvect_peaks.end(), peakLines.begin(), peakLines.end()) ; 
+			if (atEnd)
+			{
+				feature.mbln_continues = true ; 
+				for (int peakNum = 0 ; peakNum < (int) peakLines.size() ; peakNum++)
+					nextEndPeaks[peakLines[peakNum]] = target ; 
+				for (int peakNum = 0 ; peakNum < (int) sharedLines.size() ; peakNum++)
+					nextEndPeaks[sharedLines[peakNum]] = target ; 
+			}
+		}
+		if (mapLeft)
+			throw "The feature and peak map files of a chunk do not match" ; 
+		featureReader.Close() ; 
+		mapReader.Close() ; 
+
+		// the features no feature of this chunk continues are complete
+		bool lastChunk = chunkNum + 1 == numChunks ; 
+		for (int featureNum = 0 ; featureNum < (int) endFeatures.size() ; featureNum++)
+		{
+			ChunkEndFeature &feature = endFeatures[featureNum] ; 
+			if (feature.mint_joined_into < 0 && (lastChunk || !feature.mbln_continues))
+				PrintChunkEndFeature(featureFile, mapFile, feature, boundaryPeaks, numFeatures++) ; 
+		}
+		std::vector<ChunkEndFeature> continuing ; 
+		std::vector<int> newIndex(endFeatures.size(), -1) ; 
+		for (int featureNum = 0 ; featureNum < (int) endFeatures.size() ; featureNum++)
+		{
+			if (endFeatures[featureNum].mint_joined_into < 0 && endFeatures[featureNum].mbln_continues && !lastChunk)
+			{
+				newIndex[featureNum] = (int) continuing.size() ; 
+				continuing.push_back(endFeatures[featureNum]) ; 
+				continuing.back().mbln_continues = false ; 
+			}
+		}
+		endPeaks.clear() ; 
+		for (std::map<int, int>::iterator iter = nextEndPeaks.begin() ; iter != nextEndPeaks.end() ; iter++)
+			endPeaks[(*iter).first] = newIndex[FindChunkEndFeature(endFeatures, (*iter).second)] ; 
+		endFeatures.swap(continuing) ; 
+		nextEndPeaks.clear() ; 
+	}
+
+	bool success = featureFile.Close() ; 
+	success = mapFile.Close() && success ; 
+	mobj_telemetry.AddBytesWritten(featureFile.GetBytesWritten() + mapFile.GetBytesWritten()) ; 
+	mobj_telemetry.SetItemsProcessed(numChunks) ; 
+	mobj_telemetry.EndStage() ; 
+	if (!success)
+		throw "Unable to write the feature files" ; 
+
+	if (removeChunkFiles)
+	{
+		char chunkFileName[1100] ; 
+		for (int chunkNum = 0 ; chunkNum < numChunks ; chunkNum++)
+		{
+			sprintf(chunkFileName, "%s_chunk%d_LCMSFeatures.txt%s", baseFileName, chunkNum, GetCompressionExtension(menm_output_compression)) ; 
+			remove(chunkFileName) ; 
+			sprintf(chunkFileName, "%s_chunk%d_LCMSFeatureToPeakMap.txt%s", baseFileName, chunkNum, GetCompressionExtension(menm_output_compression)) ; 
+			remove(chunkFileName) ; 
+		}
+	}
+	return numFeatures ; 
+}
@@ -1,250 +1,446 @@
-#pragma once
-#include "IsotopePeak.h" 
-#include <vector> 
-#include <map> 
-#include <math.h> 
-#include <float.h> 
-#include "UMC.h" 
-
-class UMCCreator
-{
-
-	char mstr_inputFile[1024];
-	char outputDir[512];
-
-	//data filters when loading data isotopic_fit, int min_intensity, int mono_mass_start, int mono_mass_end, bool process_mass_seg, int maxDataPoints, int monoMassSegOverlap
-	float mflt_isotopic_fit_filter;
-	int mint_min_intensity;
-	float mflt_mono_mass_start;
-	float mflt_mono_mass_end;
-	bool mbln_process_mass_seg;
-	int mint_max_data_points;
-	int mint_mono_mass_seg_overlap;
-	int mint_ims_min_scan_filter;
-	int mint_ims_max_scan_filter;
-	int mint_lc_min_scan_filter;
-	int mint_lc_max_scan_filter;
-
-
-	// Weights to use when clustering points
-	// Set a weight to 0 to effectively disable that weight
-	float mflt_wt_mono_mass ;
-	float mflt_wt_average_mass ; 
-	float mflt_wt_log_abundance ; 
-	float mflt_wt_scan ; 
-	float mflt_wt_net ; 
-	float mflt_wt_fit ; 
-	float mflt_wt_ims_drift_time ;
-
-	float mflt_constraint_mono_mass ; 
-	bool mbln_constraint_mono_mass_is_ppm ;
-
-	float mflt_constraint_average_mass ; 
-	bool mbln_constraint_average_mass_is_ppm ;
-
-	bool mbln_constraint_charge_state;
-
-	double mdbl_max_distance ; 
-	short mshort_percent_complete ; 
-	
-	bool mbln_use_net ;		// When True, then uses NET and not Scan
-	bool mbln_is_ims_data;
-	//bool mbln_is_weighted_euc;
-
-	float mflt_segment_size;
-
-public:
-	int mint_lc_min_scan ; 
-	int mint_lc_max_scan ; 
-	int mint_ims_min_scan;
-	int mint_ims_max_scan;
-
-
-	std::multimap<int, int> mmultimap_umc_2_peak_index ; 
-	std::vector<IsotopePeak> mvect_isotope_peaks ; 
-	std::vector<int> mvect_umc_num_members ; 
-	std::vector<UMC> mvect_umcs ; 
-
-	UMCCreator(void);
-	~UMCCreator(void);
-
-	short GetPercentComplete() { return mshort_percent_complete ; } ; 
-	inline double PeakDistance(IsotopePeak &a, IsotopePeak &b) 
-	{
-		
-		if (mbln_constraint_mono_mass_is_ppm) {
-			if (a.mdbl_mono_mass > 0 && (abs((a.mdbl_mono_mass - b.mdbl_mono_mass) * mflt_wt_mono_mass / a.mdbl_mono_mass * 1000000) > mflt_constraint_mono_mass))
-				return DBL_MAX ; 
-		} else {
-			if (abs((a.mdbl_mono_mass - b.mdbl_mono_mass)) * mflt_wt_mono_mass > mflt_constraint_mono_mass)
-				return DBL_MAX ; 
-		}
-
-		if (mbln_constraint_average_mass_is_ppm) {
-			if (a.mdbl_average_mass > 0 && (abs((a.mdbl_average_mass - b.mdbl_average_mass) * mflt_wt_average_mass / a.mdbl_average_mass * 1000000) > mflt_constraint_average_mass))
-				return DBL_MAX ; 
-		} else {
-			if (abs((a.mdbl_average_mass - b.mdbl_average_mass)) * mflt_wt_average_mass > mflt_constraint_average_mass)
-				return DBL_MAX ; 
-		}
-			
-		double a_log_abundance = log10(a.mdbl_abundance) ; 
-		double b_log_abundance = log10(b.mdbl_abundance) ; 
-
-		double sqrDist = 0 ;
-		
-		sqrDist += (a.mdbl_mono_mass - b.mdbl_mono_mass) * (a.mdbl_mono_mass - b.mdbl_mono_mass) * mflt_wt_mono_mass * mflt_wt_mono_mass  ; 
-		sqrDist += (a.mdbl_average_mass - b.mdbl_average_mass) * (a.mdbl_average_mass - b.mdbl_average_mass) * mflt_wt_average_mass * mflt_wt_average_mass ; 
-		sqrDist += (a_log_abundance - b_log_abundance) * (a_log_abundance - b_log_abundance) * mflt_wt_log_abundance * mflt_wt_log_abundance; 
-		
-		if (mbln_use_net)
-		{
-			// Convert scan difference to Generic NET
-			double net_distance = (a.mint_lc_scan - b.mint_lc_scan) * 1.0 / (mint_lc_max_scan - mint_lc_min_scan) ; 
-			sqrDist += net_distance * net_distance * mflt_wt_net * mflt_wt_net ; 
-		} else {
-			sqrDist += (a.mint_lc_scan - b.mint_lc_scan) * (a.mint_lc_scan - b.mint_lc_scan) * mflt_wt_scan * mflt_wt_scan ; 
-		}
-
-		sqrDist += (a.mflt_fit - b.mflt_fit) * (a.mflt_fit - b.mflt_fit) * mflt_wt_fit * mflt_wt_fit ; 
-
-		// IMS Drift time
-		sqrDist += (a.mflt_ims_drift_time - b.mflt_ims_drift_time) * (a.mflt_ims_drift_time - b.mflt_ims_drift_time) * mflt_wt_ims_drift_time * mflt_wt_ims_drift_time ; 
-
-		return sqrt(sqrDist) ; 
-
-	}
-
-	int GetNumUmcs() { return mvect_umcs.size() ; } ; 
-	int ReadCSVFile(char *fileName) ; 
-	int ReadCSVFile();
-	void ReadPekFileMemoryMapped(char *fileName) ; 
-	void ReadPekFile(char *fileName) ; 
-	void CreateUMCsSinglyLinkedWithAll() ;
-	void RemoveShortUMCs(int min_length) ; 
-	void CalculateUMCs() ; 
-	void PrintPeaks() ; 
-	void PrintUMCs(bool print_members) ; 
-	bool PrintUMCs(FILE *stream, bool print_members, int featureStartIndex);
-	bool PrintMapping(FILE *stream, int featureStartIndex);
-	bool CreateFeatureFiles(char* baseFileName, int featureStartIndex = 0);
-
-	void Reset() ; 
-	void SetUseNet(bool use) { mbln_use_net = use ; } ; 
-	bool ConsiderPeak(IsotopePeak pk);
-	float GetLastMonoMassLoaded();
-	void SerializeObjects();
-	void DeserializeObjects();
-	int LoadPeaksFromDatabase();
-
-
-	//Functions added by Anuj Shah
-	void CreateUMCsSingleLinkedWithAllOnline();
-	
-	void CreateUMCFromIsotopePeak(IsotopePeak startPeak, UMC &firstUMC);
-	void AddPeakToUMC (IsotopePeak peak, UMC &umc);
-	bool withinMassTolerance(double observedMass, double realMass);
-	int findCandidateUMCsForPeak(IsotopePeak peak, std::vector<UMC> &umcVector, std::vector<UMC> &candidateUMCs);
-
-	void SetFilterOptions(float isotopic_fit, int min_intensity, int min_lc_scan, int max_lc_scan, int min_ims_scan, int max_ims_scan, float mono_mass_start, float mono_mass_end, bool process_mass_seg, int max_data_points, int mono_mass_seg_overlap, float mono_mass_seg_size){
-		mflt_isotopic_fit_filter = isotopic_fit;
-		mint_min_intensity = min_intensity;
-		mflt_mono_mass_start = mono_mass_start;
-		mflt_mono_mass_end = mono_mass_end;
-		mbln_process_mass_seg = process_mass_seg;
-		mint_max_data_points = max_data_points;
-		mint_mono_mass_seg_overlap = mono_mass_seg_overlap;
-		mint_lc_min_scan_filter = min_lc_scan;
-		mint_lc_max_scan_filter = max_lc_scan;
-		mint_ims_min_scan_filter = min_ims_scan;
-		mint_ims_max_scan_filter = max_ims_scan;
-		mflt_segment_size = mono_mass_seg_size;
-	}
-
-	void SetMassRange ( float min_mono_mass, float max_mono_mass ){
-		mflt_mono_mass_start = min_mono_mass;
-		mflt_mono_mass_end = max_mono_mass;
-	}
-
-
-
-	// This function enables the default constraints and assumes ppm units for the mass constraints
-	void SetOptions(float wt_mono_mass, float wt_avg_mass, float wt_log_abundance, float wt_scan, float wt_fit,
-		float wt_net, float mono_constraint, float avg_constraint, double max_dist, bool use_net, float wt_ims_drift_time, bool use_cs)
-	{
-		mflt_wt_mono_mass = wt_mono_mass; 
-		mflt_constraint_mono_mass = mono_constraint ; 
-		mbln_constraint_mono_mass_is_ppm = true ;
-
-		mflt_wt_average_mass = wt_avg_mass ; 
-		mflt_constraint_average_mass = avg_constraint ; 
-		mbln_constraint_average_mass_is_ppm = true ;
-
-		mflt_wt_log_abundance = wt_log_abundance ; 
-		mflt_wt_scan = wt_scan ; 
-		mflt_wt_net = wt_net ; 
-		mflt_wt_fit = wt_fit ;
-		mflt_wt_ims_drift_time = wt_ims_drift_time ;
-
-		mdbl_max_distance = max_dist ; 
-		mbln_use_net = use_net ;
-		mbln_constraint_charge_state = use_cs;
-	}
-
-	// This function allows one to specify the units for the constraints
-	void SetOptionsEx(
-			float wt_mono_mass, float mono_constraint, bool mono_constraint_is_ppm,
-			float wt_avg_mass, float avg_constraint, bool avg_constraint_is_ppm,
-			float wt_log_abundance, float wt_scan, float wt_net, float wt_fit,
-			double max_dist, bool use_net, float wt_ims_drift_time, bool use_cs)
-	{
-		mflt_wt_mono_mass = wt_mono_mass; 
-		mflt_constraint_mono_mass = mono_constraint ; 
-		mbln_constraint_mono_mass_is_ppm = mono_constraint_is_ppm ;
-
-		mflt_wt_average_mass = wt_avg_mass ; 
-		mflt_constraint_average_mass = avg_constraint ; 
-		mbln_constraint_average_mass_is_ppm = avg_constraint_is_ppm ;
-
-		mflt_wt_log_abundance = wt_log_abundance ; 
-		mflt_wt_scan = wt_scan ; 
-		mflt_wt_net = wt_net ; 
-		mflt_wt_fit = wt_fit ;
-		mflt_wt_ims_drift_time = wt_ims_drift_time ;
-
-		mdbl_max_distance = max_dist ; 
-		mbln_use_net = use_net ;
-
-		mbln_constraint_charge_state = use_cs;
-		// mbln_is_weighted_euc = use_weighted_euc;
-	}
-
-	void SetLCMinMaxScan(int minScan, int maxScan) { 
-		mint_lc_min_scan = minScan ;
-		mint_lc_max_scan = maxScan ; 
-
-		// Do not allow the minimum and maximum scans to be the same number (would lead to divide by zero errors)
-		if (mint_lc_min_scan == mint_lc_max_scan)
-				mint_lc_max_scan = mint_lc_min_scan + 1 ;
-	} 
-
-	void SetPeks(std::vector<IsotopePeak> &vectPks) ; 
-
-
-	void SetInputFileName ( char * filename);
-
-	char* GetInputFileName(){
-		return mstr_inputFile;
-	}
-
-	void SetOutputDiretory( char * dir);
-
-	char * GetOutputDirectory(){
-		return outputDir;
-	}
-
-	float GetSegmentSize(){
-		return mflt_segment_size;
-	}
-
-};
+#pragma once
+#include "IsotopePeak.h" 
+#include <vector> 
+#include <map> 
+#include <string>
+#include <math.h> 
+#include <float.h> 
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include "UMC.h" 
+#include "ProgressTelemetry.h"
+#include "RunArena.h"
+#include "CompressionFormat.h"
+#include "PeakTable.h"
+
+class WorkStealingPool ;
+class OutputFileWriter ;
+class MassShardPlan ;
+
+// Peaks of each UMC; the nodes come from the RunArena of the UMCCreator
+typedef std::multimap<int, int, std::less<int>, ArenaAllocator<std::pair<const int, int> > > UMCPeakMultimap ;
+
+class UMCCreator
+{
+
+	char mstr_inputFile[1024];
+	char outputDir[512];
+
+	//data filters when loading data isotopic_fit, int min_intensity, int mono_mass_start, int mono_mass_end, bool process_mass_seg, int maxDataPoints, int monoMassSegOverlap
+	float mflt_isotopic_fit_filter;
+	int mint_min_intensity;
+	float mflt_mono_mass_start;
+	float mflt_mono_mass_end;
+	bool mbln_process_mass_seg;
+	int mint_max_data_points;
+	int mint_mono_mass_seg_overlap;
+	int mint_ims_min_scan_filter;
+	int mint_ims_max_scan_filter;
+	int mint_lc_min_scan_filter;
+	int mint_lc_max_scan_filter;
+
+
+	// Weights to use when clustering points
+	// Set a weight to 0 to effectively disable that weight
+	float mflt_wt_mono_mass ;
+	float mflt_wt_average_mass ; 
+	float mflt_wt_log_abundance ; 
+	float mflt_wt_scan ; 
+	float mflt_wt_net ; 
+	float mflt_wt_fit ; 
+	float mflt_wt_ims_drift_time ;
+
+	float mflt_constraint_mono_mass ; 
+	bool mbln_constraint_mono_mass_is_ppm ;
+
+	float mflt_constraint_average_mass ; 
+	bool mbln_constraint_average_mass_is_ppm ;
+
+	bool mbln_constraint_charge_state;
+
+	// hard limits on how far apart in LC scans, NET and drift time two peaks can be linked, whatever the weights;
+	// 0 leaves that gap unlimited
+	int mint_max_scan_gap ; 
+	float mflt_max_net_gap ; 
+	float mflt_max_drift_time_gap ; 
+
+	double mdbl_max_distance ; 
+	ProgressTelemetry mobj_telemetry ; 
+	// memory of mmultimap_umc_2_peak_index; declared first so that it outlives the map
+	RunArena mobj_arena ; 
+	
+	bool mbln_use_net ;		// When True, then uses NET and not Scan
+	bool mbln_is_ims_data;
+	// prune the candidates of the clustering sweep on drift time and frame for IMS data (ImsCandidateIndex)
+	bool mbln_use_ims_candidate_index ;
+	// collapse the rows of each frame of IMS data into conformer nodes before clustering (ImsConformerBuilder)
+	bool mbln_collapse_ims_conformers ;
+	int mint_num_conformer_nodes ;		// nodes the last clustering linked instead of peaks; 0 if it linked the peaks
+	// leave the peaks (or nodes) that cannot be linked to any other out of the sweep, each one a UMC of its own
+	bool mbln_skip_isolated_peaks ;
+	int mint_num_isolated_peaks ;		// peaks (or nodes) the last clustering left out of the sweep
+	//bool mbln_is_weighted_euc;
+
+	float mflt_segment_size;
+
+	// compression of the feature and peak map files
+	CompressionFormat menm_output_compression ;
+	int mint_output_compression_level ;
+	int mint_output_compression_threads ;
+
+	// roughly one node of mmultimap_umc_2_peak_index: the pair and the links of the tree
+	static const size_t MAP_NODE_BYTES = sizeof(std::pair<const int, int>) + 4 * sizeof(void *) ;
+
+	// Opens baseFileName + suffix, with the extension of the output compression
+	bool OpenOutputFile(OutputFileWriter &writer, const char *baseFileName, const char *suffix) ; 
+
+	// Largest drift time and scan differences two peaks can have and still be within mdbl_max_distance and the gap
+	// limits; FLT_MAX and INT_MAX when nothing limits them
+	void GetCandidateTolerances(float &driftTolerance, int &scanTolerance) ; 
+	// Largest scan difference MaxScanGap and MaxNETGap allow, INT_MAX without either
+	int GetMaxScanGap() ; 
+	// Links matchPeak (sorted index matchIndex) to the UMC of currentPeak, or merges their UMCs in umcPeaks, when they are close enough
+	void LinkPeaks(IsotopePeak &currentPeak, IsotopePeak &matchPeak, int matchIndex, int &currentUmcIndex, std::vector<int> &vectSortedUmcIndex,
+		UMCPeakMultimap &umcPeaks, std::vector<int> &tempIndices, long long &numDistanceEvaluations, long long &numMerges) ; 
+	// Single linkage sweep of CreateUMCsSinglyLinkedWithAll over sortedPeaks: leaves the sorted indices of the peaks of each
+	// cluster in umcPeaks under their (not consecutive) UMC numbers. UMC number i was started by sorted peak
+	// (*vectUmcFirstPeak)[i] when vectUmcFirstPeak is given. Only reads the options, so several sweeps over
+	// different peaks may run at once when publishProgress is false.
+	void SweepSortedPeaks(const std::vector<IsotopePeak> &sortedPeaks, std::vector<int> &vectSortedUmcIndex, UMCPeakMultimap &umcPeaks,
+		std::vector<int> *vectUmcFirstPeak, bool publishProgress) ; 
+	// Rebuilds mmultimap_umc_2_peak_index from the mint_umc_index of the peaks and saves the raw clusters
+	void FinishClustering() ; 
+	// Conformer nodes of the peaks, built frame by frame on the pool; nodeOfPeak gets the node of every peak, and the
+	// mint_original_index of a node is its index in nodes
+	void CollapseImsConformers(WorkStealingPool &pool, std::vector<IsotopePeak> &nodes, std::vector<int> &nodeOfPeak) ; 
+	// Marks in isolated the sorted peaks that the sweep would not link to any other: no peak within the mass tolerance
+	// of either of them (as the sweep applies it), of the same charge state with the constraint on, within mdbl_max_distance.
+	// The sorted peaks are split in ranges checked on the pool; returns the number of isolated peaks.
+	int FindIsolatedPeaks(WorkStealingPool &pool, const std::vector<IsotopePeak> &sortedPeaks, std::vector<char> &isolated) ; 
+
+	// steps of CreateFeatureFilesOutOfCore
+	int SortCSVFileToRuns(const char *tempFilePrefix, long long memoryBudgetBytes, int &numRuns) ; 
+	int ClusterSortedRuns(const char *tempFilePrefix, int numRuns, long long memoryBudgetBytes, int numPeaks, OutputFileWriter &featureFile,
+		OutputFileWriter &mapFile, int min_length) ; 
+
+public:
+	int mint_lc_min_scan ; 
+	int mint_lc_max_scan ; 
+	int mint_ims_min_scan;
+	int mint_ims_max_scan;
+
+
+	UMCPeakMultimap mmultimap_umc_2_peak_index ; 
+	std::vector<IsotopePeak> mvect_isotope_peaks ; 
+	std::vector<int> mvect_umc_num_members ; 
+	std::vector<UMC> mvect_umcs ; 
+
+	// Clusters as CreateUMCsSinglyLinkedWithAll left them, before any RemoveShortUMCs: the peaks of raw cluster i are
+	// mvect_raw_umc_peaks[mvect_raw_umc_start[i]] up to mvect_raw_umc_peaks[mvect_raw_umc_start[i+1] - 1], in peak order.
+	// RemoveShortUMCs and CalculateUMCs only read them, so trying another minimum length does not need a new clustering.
+	std::vector<int> mvect_raw_umc_start ; 
+	std::vector<int> mvect_raw_umc_peaks ; 
+	// raw cluster of each UMC in mvect_umc_num_members
+	std::vector<int> mvect_umc_raw_index ; 
+	// statistics of the raw clusters CalculateUMCs has needed so far (-1 in mvect_raw_umc_stats_index: not worked out yet)
+	std::vector<UMC> mvect_raw_umcs ; 
+	std::vector<int> mvect_raw_umc_stats_index ; 
+
+	UMCCreator(void);
+	// Copies options and data; the copy keeps its map nodes in an arena of its own
+	UMCCreator(const UMCCreator &other);
+	// Copies the options and data of other, member by member. This creator keeps its own arena, and the allocator
+	// of its map that points at it, so the copied map nodes come from this arena; the telemetry counters start at 0.
+	UMCCreator & operator=(const UMCCreator &other);
+	~UMCCreator(void);
+
+	short GetPercentComplete() { return mobj_telemetry.GetPercentComplete() ; } ; 
+	ProgressTelemetry & GetTelemetry() { return mobj_telemetry ; } ; 
+	inline double PeakDistance(IsotopePeak &a, IsotopePeak &b) 
+	{
+		
+		if (mbln_constraint_mono_mass_is_ppm) {
+			if (a.mdbl_mono_mass > 0 && (abs((a.mdbl_mono_mass - b.mdbl_mono_mass) * mflt_wt_mono_mass / a.mdbl_mono_mass * 1000000) > mflt_constraint_mono_mass))
+				return DBL_MAX ; 
+		} else {
+			if (abs((a.mdbl_mono_mass - b.mdbl_mono_mass)) * mflt_wt_mono_mass > mflt_constraint_mono_mass)
+				return DBL_MAX ; 
+		}
+
+		if (mbln_constraint_average_mass_is_ppm) {
+			if (a.mdbl_average_mass > 0 && (abs((a.mdbl_average_mass - b.mdbl_average_mass) * mflt_wt_average_mass / a.mdbl_average_mass * 1000000) > mflt_constraint_average_mass))
+				return DBL_MAX ; 
+		} else {
+			if (abs((a.mdbl_average_mass - b.mdbl_average_mass)) * mflt_wt_average_mass > mflt_constraint_average_mass)
+				return DBL_MAX ; 
+		}
+
+		int scanGap = abs(a.mint_lc_scan - b.mint_lc_scan) ; 
+		if (mint_max_scan_gap > 0 && scanGap > mint_max_scan_gap)
+			return DBL_MAX ; 
+		if (mflt_max_net_gap > 0 && scanGap > mflt_max_net_gap * (double) (mint_lc_max_scan - mint_lc_min_scan))
+			return DBL_MAX ; 
+		if (mflt_max_drift_time_gap > 0 && fabs(a.mflt_ims_drift_time - b.mflt_ims_drift_time) > mflt_max_drift_time_gap)
+			return DBL_MAX ; 
+			
+		double a_log_abundance = log10(a.mdbl_abundance) ; 
+		double b_log_abundance = log10(b.mdbl_abundance) ; 
+
+		double sqrDist = 0 ;
+		
+		sqrDist += (a.mdbl_mono_mass - b.mdbl_mono_mass) * (a.mdbl_mono_mass - b.mdbl_mono_mass) * mflt_wt_mono_mass * mflt_wt_mono_mass  ; 
+		sqrDist += (a.mdbl_average_mass - b.mdbl_average_mass) * (a.mdbl_average_mass - b.mdbl_average_mass) * mflt_wt_average_mass * mflt_wt_average_mass ; 
+		sqrDist += (a_log_abundance - b_log_abundance) * (a_log_abundance - b_log_abundance) * mflt_wt_log_abundance * mflt_wt_log_abundance; 
+		
+		if (mbln_use_net)
+		{
+			// Convert scan difference to Generic NET
+			double net_distance = (a.mint_lc_scan - b.mint_lc_scan) * 1.0 / (mint_lc_max_scan - mint_lc_min_scan) ; 
+			sqrDist += net_distance * net_distance * mflt_wt_net * mflt_wt_net ; 
+		} else {
+			sqrDist += (a.mint_lc_scan - b.mint_lc_scan) * (a.mint_lc_scan - b.mint_lc_scan) * mflt_wt_scan * mflt_wt_scan ; 
+		}
+
+		sqrDist += (a.mflt_fit - b.mflt_fit) * (a.mflt_fit - b.mflt_fit) * mflt_wt_fit * mflt_wt_fit ; 
+
+		// IMS Drift time
+		sqrDist += (a.mflt_ims_drift_time - b.mflt_ims_drift_time) * (a.mflt_ims_drift_time - b.mflt_ims_drift_time) * mflt_wt_ims_drift_time * mflt_wt_ims_drift_time ; 
+
+		return sqrt(sqrDist) ; 
+
+	}
+
+	int GetNumUmcs() { return mvect_umcs.size() ; } ; 
+	int ReadCSVFile(char *fileName) ; 
+	int ReadCSVFile();
+	// Same peaks in the same order as ReadCSVFile, with the rows split into numBlocks byte ranges parsed on the pool;
+	// a gzip or zstd file goes through ReadCSVFile
+	int ReadCSVFileParallel(WorkStealingPool &pool, int numBlocks) ; 
+	void SetIsosLayout(char *headerLine, char *startTag) ; 
+	void ParseIsosLine(char *buffer, IsotopePeak &pk) ; 
+	void UpdateScanRange(IsotopePeak &pk) ; 
+	void ReadPekFileMemoryMapped(char *fileName) ; 
+	// Same peaks in the same order as ReadPekFileMemoryMapped, with the file split into numBlocks byte ranges whose scan
+	// blocks ("Filename:" up to "Processing stop time:") are parsed on the pool; a gzip or zstd file goes through
+	// ReadPekFileMemoryMapped
+	int ReadPekFileParallel(char *fileName, WorkStealingPool &pool, int numBlocks) ; 
+	// Scan number at the end of the "Filename:" line of a scan block; the first scan block tells whether the file came
+	// from a wiff file, which also sets the options for those files
+	int ParsePekScanNumber(char *fileNameLine, bool isFirstScan, bool &isFromWiff) ; 
+	void ParsePekLine(char *buffer, IsotopePeak &pk, bool isotopicallyLabeled) ; 
+	void ReadPekFile(char *fileName) ; 
+	void CreateUMCsSinglyLinkedWithAll() ;
+	// Copy of mvect_isotope_peaks in the order the clustering visits the peaks (mono mass, then scan)
+	void SortPeaksForClustering(std::vector<IsotopePeak> &sortedPeaks) ; 
+	static void SortForClustering(std::vector<IsotopePeak> &peaks) ; 
+	// Clustering on peaks already ordered by SortPeaksForClustering; sortedPeaks is only read, so one sorted
+	// copy can serve several creators that hold the same peaks with different options
+	void CreateUMCsSinglyLinkedWithAll(const std::vector<IsotopePeak> &sortedPeaks) ; 
+	// With the charge state constraint on, every charge state is clustered on its own on the pool (UMCCreatorParallel.cpp),
+	// since no peaks of different charge states can be linked; the UMCs and their numbers are the same as those of
+	// CreateUMCsSinglyLinkedWithAll(). With SetCollapseImsConformers on IMS data, the rows of each frame are first
+	// collapsed into conformer nodes on the pool, the nodes are clustered, and every row goes into the UMC of its node.
+	// With SetSkipIsolatedPeaks, the peaks no other peak can be linked to are found on the pool first and become UMCs of
+	// one peak without going through the sweep. Otherwise (or with the constraint on a pool of one thread) this is
+	// CreateUMCsSinglyLinkedWithAll().
+	void CreateUMCsSinglyLinkedWithAll(WorkStealingPool &pool) ; 
+	// Keeps the raw clusters of at least min_length peaks; may be called again with any other length
+	void RemoveShortUMCs(int min_length) ; 
+	void CalculateUMCs() ; 
+	// Makes the current UMCs the raw clusters; done by the clustering itself
+	void SaveRawClusters() ; 
+	void SummarizeRawUMC(int rawIndex, UMC &new_umc, std::vector<double> &vect_mass) ; 
+	// Statistics of the UMC made of peaks[members[0]] up to peaks[members[numMembers-1]], summed in that order
+	static void SummarizeMembers(std::vector<IsotopePeak> &peaks, const int *members, int numMembers, UMC &new_umc, std::vector<double> &vect_mass) ; 
+	void PrintPeaks() ; 
+	void PrintUMCs(bool print_members) ; 
+	static void PrintUMCHeader(OutputFileWriter &stream, bool print_members) ; 
+	static void PrintUMCRow(OutputFileWriter &stream, UMC &current_umc, int featureIndex) ; 
+	bool PrintUMCs(OutputFileWriter &stream, bool print_members, int featureStartIndex);
+	bool PrintMapping(OutputFileWriter &stream, int featureStartIndex);
+	bool CreateFeatureFiles(char* baseFileName, int featureStartIndex = 0);
+	// Streams the files CreateFeatureFiles wrote for the mass chunks of a chunked run (baseFileName_chunk<N>, N from 0 to
+	// chunkEnds.size() - 1, chunk N ending at mass chunkEnds[N]) into one feature file and one peak map for baseFileName,
+	// renumbering the features from 0. Chunks that meet share the peaks at that mass, and the features of both chunks that
+	// hold one are joined into one feature, whose row is worked out again from boundaryPeaks (AddChunkEndPeaks of every
+	// chunk); a feature of the later chunk made only of peaks of one earlier feature is a duplicate and adds nothing.
+	// Only the features reaching a chunk end are held. Returns the number of features and sets numDuplicates.
+	int MergeChunkFeatureFiles(char *baseFileName, const std::vector<float> &chunkEnds, const std::map<int, IsotopePeak> &boundaryPeaks,
+		bool removeChunkFiles, int &numDuplicates) ; 
+	// Adds the peaks of the UMCs reaching massStart or massEnd to peaks, by line number in the file, for MergeChunkFeatureFiles
+	void AddChunkEndPeaks(float massStart, float massEnd, std::map<int, IsotopePeak> &peaks) ; 
+	// Out of core version of ReadCSVFile through CreateFeatureFiles for isos files larger than memory (UMCCreatorOutOfCore.cpp).
+	// Holds at most memoryBudgetBytes of peaks while sorting them by mass into temporary files named tempFilePrefix_Run<N>.tmp,
+	// then merges those and clusters the merged stream keeping only the peaks within the mass tolerance in memory.
+	// Finds the same features as the in memory path, but numbers them in the order their last peak leaves the mass window.
+	// Returns the number of features and sets numPeaks; mvect_isotope_peaks and the UMC vectors stay empty.
+	int CreateFeatureFilesOutOfCore(char *baseFileName, int min_length, const char *tempFilePrefix, long long memoryBudgetBytes, int &numPeaks) ; 
+	// Sharded run (UMCCreatorSharded.cpp), for files too big for one process: PlanMassShards splits the peaks of the
+	// input file into numShards mono mass shards of about the same number of peaks, reading the file once without
+	// keeping the peaks. ClusterMassShard loads and clusters one shard with its overlap and writes the clusters that
+	// hold peaks of its core to resultFileName, marking those it saw whole; it returns their number. MergeMassShards
+	// reads the result files (tempFilePrefix_Shard<N>.bin) in mass order, joins the clusters that share peaks,
+	// re-clusters the joined ones that no shard saw whole, and writes the same feature files as CreateFeatureFiles
+	// after CreateUMCsSinglyLinkedWithAll(), RemoveShortUMCs and CalculateUMCs, in the same order; it returns the
+	// number of features. Conformer collapsing does not apply.
+	int PlanMassShards(int numShards, MassShardPlan &plan) ; 
+	int ClusterMassShard(const MassShardPlan &plan, int shardNum, const char *resultFileName) ; 
+	int MergeMassShards(const MassShardPlan &plan, const char *tempFilePrefix, char *baseFileName, int min_length) ; 
+	static void GetShardResultFileName(const char *tempFilePrefix, int shardNum, char *fileName) ; 
+
+	void Reset() ; 
+	void SetUseNet(bool use) { mbln_use_net = use ; } ; 
+	// On by default; the features are the same either way, only the number of distance evaluations differs
+	void SetUseImsCandidateIndex(bool use) { mbln_use_ims_candidate_index = use ; } ; 
+	// Off by default; only CreateUMCsSinglyLinkedWithAll(WorkStealingPool &) collapses the conformers
+	void SetCollapseImsConformers(bool collapse) { mbln_collapse_ims_conformers = collapse ; } ; 
+	int GetNumConformerNodes() { return mint_num_conformer_nodes ; } ; 
+	// Off by default; only CreateUMCsSinglyLinkedWithAll(WorkStealingPool &) looks for the isolated peaks. The UMCs
+	// and their numbers are the same either way; the peaks left out are dropped by RemoveShortUMCs(2 or more).
+	void SetSkipIsolatedPeaks(bool skip) { mbln_skip_isolated_peaks = skip ; } ; 
+	int GetNumIsolatedPeaks() { return mint_num_isolated_peaks ; } ; 
+	// Writes the feature and peak map files gzip or zstd compressed (.gz / .zst appended to their names) on
+	// numThreads threads; level and numThreads 0 take the defaults
+	void SetOutputCompression(CompressionFormat format, int level, int numThreads)
+	{
+		menm_output_compression = format ; 
+		mint_output_compression_level = level ; 
+		mint_output_compression_threads = numThreads ; 
+	} ; 
+	bool ConsiderPeak(IsotopePeak pk);
+	float GetLastMonoMassLoaded();
+	void SerializeObjects();
+	void DeserializeObjects();
+	int LoadPeaksFromDatabase();
+
+
+	//Functions added by Anuj Shah
+	void CreateUMCsSingleLinkedWithAllOnline();
+	
+	void CreateUMCFromIsotopePeak(IsotopePeak startPeak, UMC &firstUMC);
+	void AddPeakToUMC (IsotopePeak peak, UMC &umc);
+	bool withinMassTolerance(double observedMass, double realMass);
+	int findCandidateUMCsForPeak(IsotopePeak peak, std::vector<UMC> &umcVector, std::vector<UMC> &candidateUMCs);
+
+	void SetFilterOptions(float isotopic_fit, int min_intensity, int min_lc_scan, int max_lc_scan, int min_ims_scan, int max_ims_scan, float mono_mass_start, float mono_mass_end, bool process_mass_seg, int max_data_points, int mono_mass_seg_overlap, float mono_mass_seg_size){
+		mflt_isotopic_fit_filter = isotopic_fit;
+		mint_min_intensity = min_intensity;
+		mflt_mono_mass_start = mono_mass_start;
+		mflt_mono_mass_end = mono_mass_end;
+		mbln_process_mass_seg = process_mass_seg;
+		mint_max_data_points = max_data_points;
+		mint_mono_mass_seg_overlap = mono_mass_seg_overlap;
+		mint_lc_min_scan_filter = min_lc_scan;
+		mint_lc_max_scan_filter = max_lc_scan;
+		mint_ims_min_scan_filter = min_ims_scan;
+		mint_ims_max_scan_filter = max_ims_scan;
+		mflt_segment_size = mono_mass_seg_size;
+	}
+
+	void SetMassRange ( float min_mono_mass, float max_mono_mass ){
+		mflt_mono_mass_start = min_mono_mass;
+		mflt_mono_mass_end = max_mono_mass;
+	}
+
+
+
+	// This function enables the default constraints and assumes ppm units for the mass constraints
+	void SetOptions(float wt_mono_mass, float wt_avg_mass, float wt_log_abundance, float wt_scan, float wt_fit,
+		float wt_net, float mono_constraint, float avg_constraint, double max_dist, bool use_net, float wt_ims_drift_time, bool use_cs)
+	{
+		mflt_wt_mono_mass = wt_mono_mass; 
+		mflt_constraint_mono_mass = mono_constraint ; 
+		mbln_constraint_mono_mass_is_ppm = true ;
+
+		mflt_wt_average_mass = wt_avg_mass ; 
+		mflt_constraint_average_mass = avg_constraint ; 
+		mbln_constraint_average_mass_is_ppm = true ;
+
+		mflt_wt_log_abundance = wt_log_abundance ; 
+		mflt_wt_scan = wt_scan ; 
+		mflt_wt_net = wt_net ; 
+		mflt_wt_fit = wt_fit ;
+		mflt_wt_ims_drift_time = wt_ims_drift_time ;
+
+		mdbl_max_distance = max_dist ; 
+		mbln_use_net = use_net ;
+		mbln_constraint_charge_state = use_cs;
+	}
+
+	// This function allows one to specify the units for the constraints
+	void SetOptionsEx(
+			float wt_mono_mass, float mono_constraint, bool mono_constraint_is_ppm,
+			float wt_avg_mass, float avg_constraint, bool avg_constraint_is_ppm,
+			float wt_log_abundance, float wt_scan, float wt_net, float wt_fit,
+			double max_dist, bool use_net, float wt_ims_drift_time, bool use_cs)
+	{
+		mflt_wt_mono_mass = wt_mono_mass; 
+		mflt_constraint_mono_mass = mono_constraint ; 
+		mbln_constraint_mono_mass_is_ppm = mono_constraint_is_ppm ;
+
+		mflt_wt_average_mass = wt_avg_mass ; 
+		mflt_constraint_average_mass = avg_constraint ; 
+		mbln_constraint_average_mass_is_ppm = avg_constraint_is_ppm ;
+
+		mflt_wt_log_abundance = wt_log_abundance ; 
+		mflt_wt_scan = wt_scan ; 
+		mflt_wt_net = wt_net ; 
+		mflt_wt_fit = wt_fit ;
+		mflt_wt_ims_drift_time = wt_ims_drift_time ;
+
+		mdbl_max_distance = max_dist ; 
+		mbln_use_net = use_net ;
+
+		mbln_constraint_charge_state = use_cs;
+		// mbln_is_weighted_euc = use_weighted_euc;
+	}
+
+	// Off (0) by default. With a gap limit the sweep takes its candidates from the index of ImsCandidateIndex, in scan
+	// order on LC-MS data, so a mass window spanning the gradient only costs the peaks within the gap
+	void SetMaxGaps(int max_scan_gap, float max_net_gap, float max_drift_time_gap)
+	{
+		mint_max_scan_gap = max_scan_gap ; 
+		mflt_max_net_gap = max_net_gap ; 
+		mflt_max_drift_time_gap = max_drift_time_gap ; 
+	}
+
+	void SetLCMinMaxScan(int minScan, int maxScan) { 
+		mint_lc_min_scan = minScan ;
+		mint_lc_max_scan = maxScan ; 
+
+		// Do not allow the minimum and maximum scans to be the same number (would lead to divide by zero errors)
+		if (mint_lc_min_scan == mint_lc_max_scan)
+				mint_lc_max_scan = mint_lc_min_scan + 1 ;
+	} 
+
+	void SetPeks(std::vector<IsotopePeak> &vectPks) ; 
+	// Peaks, scan ranges and data type (LC-MS or IMS) of other as its load left them; the options stay as they are
+	void CopyPeaks(const UMCCreator &other) ; 
+	// Same as SetPeks, but takes over the peaks of vectPks (left empty) instead of copying them
+	void AdoptPeaks(std::vector<IsotopePeak> &vectPks) ; 
+	// Bulk versions of SetPeks for hosts that hold their peaks in arrays (PeakTable.h): the peaks are written straight
+	// into mvect_isotope_peaks, in the order of their original indices. False, with the peaks left as they were, if a
+	// required column is missing, a peak has a mass or abundance the clustering cannot use, or the original indices are
+	// not 0 to the number of peaks - 1, each once; error then says which.
+	bool SetPeaks(const UMCPeakColumns &columns, std::string &error) ; 
+	bool SetPeaks(const UMCPeakRecord *records, int numRecords, bool isImsData, std::string &error) ; 
+
+
+	void SetInputFileName ( char * filename);
+
+	char* GetInputFileName(){
+		return mstr_inputFile;
+	}
+
+	void SetOutputDiretory( char * dir);
+
+	char * GetOutputDirectory(){
+		return outputDir;
+	}
+
+	float GetSegmentSize(){
+		return mflt_segment_size;
+	}
+
+};
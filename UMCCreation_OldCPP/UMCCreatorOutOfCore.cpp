@@ -0,0 +1,413 @@
+// UMCCreatorOutOfCore.cpp : out of core mode of UMCCreator, for isos files that do not fit in memory.
+//
+// The peaks are put in mass order with an external merge sort: SortCSVFileToRuns fills a buffer of at most the
+// memory budget, sorts it and writes it to a run file, and ClusterSortedRuns merges the runs back together.
+// The merged stream goes straight into a windowed form of the sweep of CreateUMCsSinglyLinkedWithAll. That sweep
+// only links a peak to the peaks above it within the mass tolerance, so only those (the window) and the clusters
+// holding one of them need to be in memory. Once the last peak of a cluster has left the window nothing can join
+// it any more; it is summarized, written out and dropped.
+
+#include "UMCCreator.h"
+#include "MemMappedReader.h"
+#include "OutputFileWriter.h"
+#include <algorithm>
+#include <deque>
+#include <queue>
+
+namespace
+{
+	// A peak of the clustering window
+	struct WindowPeak
+	{
+		IsotopePeak mobj_peak ;
+		double mdbl_max_mass ;		// peaks from this mass on are out of its tolerance
+		int mint_cluster ;
+	} ;
+
+	// A cluster with at least one peak in the window
+	struct OpenCluster
+	{
+		std::vector<IsotopePeak> mvect_members ;
+		std::vector<long long> mvect_positions ;		// position of each member in the merged stream
+		int mint_num_in_window ;
+	} ;
+
+	// Buffered reader of one run file
+	struct RunReader
+	{
+		FILE *mfile ;
+		std::vector<IsotopePeak> mvect_buffer ;
+		int mint_next ;
+		int mint_count ;
+	} ;
+
+	// Orders the heap of the merge so that the run with the lowest current peak is on top
+	struct RunReaderGreater
+	{
+		std::vector<RunReader> *mvect_readers ;
+		bool operator()(int first, int second) const ;
+	} ;
+
+	// below this a merge buffer costs more in reads than it saves in memory
+	const long long MIN_MERGE_BUFFER_BYTES = 64 * 1024 ;
+}
+
+// Mass order of the sweep; equal masses are kept in file order so that the runs merge deterministically
+static bool SortIsotopesByMonoMassAndIndex(const IsotopePeak &a, const IsotopePeak &b)
+{
+	if (a.mdbl_mono_mass != b.mdbl_mono_mass)
+		return a.mdbl_mono_mass < b.mdbl_mono_mass ;
+	return a.mint_original_index < b.mint_original_index ;
+}
+
+bool RunReaderGreater::operator()(int first, int second) const
+{
+	RunReader &firstReader = (*mvect_readers)[first] ;
+	RunReader &secondReader = (*mvect_readers)[second] ;
+	return SortIsotopesByMonoMassAndIndex(secondReader.mvect_buffer[secondReader.mint_next], firstReader.mvect_buffer[firstReader.mint_next]) ;
+}
+
+static void GetRunFileName(const char *tempFilePrefix, int runNum, char *fileName)
+{
+	sprintf(fileName, "%s_Run%d.tmp", tempFilePrefix, runNum + 1) ;
+}
+
+static void RemoveRunFiles(const char *tempFilePrefix, int numRuns)
+{
+	char fileName[1100] ;
+	for (int runNum = 0 ; runNum < numRuns ; runNum++)
+	{
+		GetRunFileName(tempFilePrefix, runNum, fileName) ;
+		remove(fileName) ;
+	}
+}
+
+static void WriteSortedRun(std::vector<IsotopePeak> &peaks, const char *tempFilePrefix, int runNum)
+{
+	char fileName[1100] ;
+	GetRunFileName(tempFilePrefix, runNum, fileName) ;
+	std::sort(peaks.begin(), peaks.end(), &SortIsotopesByMonoMassAndIndex) ;
+
+	FILE *file = fopen(fileName, "wb") ;
+	if (file == NULL)
+		throw "Unable to create a temporary file; check TempDirectory" ;
+	size_t numWritten = fwrite(&peaks[0], sizeof(IsotopePeak), peaks.size(), file) ;
+	fclose(file) ;
+	if (numWritten != peaks.size())
+		throw "Unable to write a temporary file; check the free space of TempDirectory" ;
+	peaks.clear() ;
+}
+
+// Refills the buffer of reader; false once its run is used up
+static bool FillRunBuffer(RunReader &reader)
+{
+	reader.mint_next = 0 ;
+	reader.mint_count = (int) fread(&reader.mvect_buffer[0], sizeof(IsotopePeak), reader.mvect_buffer.size(), reader.mfile) ;
+	return reader.mint_count > 0 ;
+}
+
+int UMCCreator::CreateFeatureFilesOutOfCore(char *baseFileName, int min_length, const char *tempFilePrefix, long long memoryBudgetBytes, int &numPeaks)
+{
+	int numRuns = 0 ;
+	int numFeatures = 0 ;
+	OutputFileWriter featureFile ;
+	OutputFileWriter mapFile ;
+	try
+	{
+		numPeaks = SortCSVFileToRuns(tempFilePrefix, memoryBudgetBytes, numRuns) ;
+
+		if (!OpenOutputFile(featureFile, baseFileName, "_LCMSFeatures.txt") || !OpenOutputFile(mapFile, baseFileName, "_LCMSFeatureToPeakMap.txt"))
+			throw "Unable to create the feature files" ;
+		PrintUMCHeader(featureFile, false) ;
+		mapFile.Printf("Feature_Index\tPeak_Index\n") ;
+
+		numFeatures = ClusterSortedRuns(tempFilePrefix, numRuns, memoryBudgetBytes, numPeaks, featureFile, mapFile, min_length) ;
+		bool written = featureFile.Close() ;
+		written = mapFile.Close() && written ;
+		if (!written)
+			throw "Unable to write the feature files" ;
+		mobj_telemetry.AddBytesWritten(featureFile.GetBytesWritten() + mapFile.GetBytesWritten()) ;
+	}
+	catch (...)
+	{
+		featureFile.Close() ;
+		mapFile.Close() ;
+		RemoveRunFiles(tempFilePrefix, numRuns) ;
+		throw ;
+	}
+
+	RemoveRunFiles(tempFilePrefix, numRuns) ;
+	return numFeatures ;
+}
+
+int UMCCreator::SortCSVFileToRuns(const char *tempFilePrefix, long long memoryBudgetBytes, int &numRuns)
+{
+	char startTag[1024] ;
+	char *stopTag = "Blah" ;
+	int stopTagLen = (int)strlen(stopTag) ;
+	const int MAX_BUFFER_LEN = 1024 ;
+	char buffer[MAX_BUFFER_LEN] ;
+
+	Reset() ;
+	MemMappedReader mappedReader ;
+	if (!mappedReader.Load(mstr_inputFile))
+		throw "Unable to open file" ;
+	__int64 file_len = mappedReader.FileLength() ;
+
+	mobj_telemetry.BeginStage(STAGE_LOADING, file_len) ;
+	mint_lc_min_scan = INT_MAX ;
+	mint_lc_max_scan = 0 ;
+
+	if (!mappedReader.GetNextLine(buffer, MAX_BUFFER_LEN, "\n", MAX_BUFFER_LEN))
+	{
+		throw "Incorrect header for file" ;
+	}
+	SetIsosLayout(buffer, startTag) ;
+
+	// the run being collected is the only big allocation of this step
+	size_t maxRunPeaks = (size_t) (memoryBudgetBytes / sizeof(IsotopePeak)) ;
+	if (maxRunPeaks < 1024)
+		maxRunPeaks = 1024 ;
+	mvect_isotope_peaks.reserve(maxRunPeaks) ;
+
+	IsotopePeak pk ;
+	pk.mdbl_abundance = 0 ;
+	pk.mdbl_i2_abundance = 0 ;
+	pk.mdbl_average_mass = 0 ;
+	pk.mflt_fit = 0 ;
+	pk.mdbl_max_abundance_mass = 0 ;
+	pk.mdbl_mono_mass = 0 ;
+	pk.mdbl_mz = 0 ;
+	pk.mshort_charge = 0 ;
+	pk.mflt_ims_drift_time = 0 ;
+
+	int numPeaks = 0 ;
+	int origLineNumber = 0 ;
+	int numPeaksPublished = 0 ;
+	int numLinesPublished = 0 ;
+	numRuns = 0 ;
+
+	while (!mappedReader.eof() && mappedReader.GetNextLine(buffer, MAX_BUFFER_LEN, stopTag, stopTagLen))
+	{
+		if ((origLineNumber & ProgressTelemetry::PUBLISH_MASK) == 0)
+		{
+			mobj_telemetry.SetItemsProcessed(mappedReader.InputPosition()) ;
+			mobj_telemetry.SetBytesRead(mappedReader.InputPosition()) ;
+			mobj_telemetry.AddPeaksKept(numPeaks - numPeaksPublished) ;
+			mobj_telemetry.AddPeaksRejected((origLineNumber - numLinesPublished) - (numPeaks - numPeaksPublished)) ;
+			numPeaksPublished = numPeaks ;
+			numLinesPublished = origLineNumber ;
+		}
+
+		ParseIsosLine(buffer, pk) ;
+		pk.mint_original_index = numPeaks ;
+		pk.mint_line_number_in_file = origLineNumber ;
+		if (ConsiderPeak(pk))
+		{
+			UpdateScanRange(pk) ;
+			mvect_isotope_peaks.push_back(pk) ;
+			numPeaks++ ;
+			if (mvect_isotope_peaks.size() == maxRunPeaks)
+				WriteSortedRun(mvect_isotope_peaks, tempFilePrefix, numRuns++) ;
+		}
+		origLineNumber++ ;
+	}
+	if (!mvect_isotope_peaks.empty())
+		WriteSortedRun(mvect_isotope_peaks, tempFilePrefix, numRuns++) ;
+	std::vector<IsotopePeak>().swap(mvect_isotope_peaks) ;
+
+	mobj_telemetry.SetBytesRead(mappedReader.InputPosition()) ;
+	mobj_telemetry.AddPeaksKept(numPeaks - numPeaksPublished) ;
+	mobj_telemetry.AddPeaksRejected((origLineNumber - numLinesPublished) - (numPeaks - numPeaksPublished)) ;
+	mobj_telemetry.EndStage() ;
+
+	mappedReader.Close() ;
+	return numPeaks ;
+}
+
+int UMCCreator::ClusterSortedRuns(const char *tempFilePrefix, int numRuns, long long memoryBudgetBytes, int numPeaks, OutputFileWriter &featureFile,
+	OutputFileWriter &mapFile, int min_length)
+{
+	// the budget is shared by the read buffers of the runs
+	long long bufferBytes = numRuns > 0 ? memoryBudgetBytes / numRuns : memoryBudgetBytes ;
+	if (bufferBytes < MIN_MERGE_BUFFER_BYTES)
+		bufferBytes = MIN_MERGE_BUFFER_BYTES ;
+
+	std::vector<RunReader> readers(numRuns) ;
+	RunReaderGreater greater ;
+	greater.mvect_readers = &readers ;
+	std::priority_queue<int, std::vector<int>, RunReaderGreater> mergeHeap(greater) ;
+	char fileName[1100] ;
+	for (int runNum = 0 ; runNum < numRuns ; runNum++)
+	{
+		RunReader &reader = readers[runNum] ;
+		GetRunFileName(tempFilePrefix, runNum, fileName) ;
+		reader.mfile = fopen(fileName, "rb") ;
+		if (reader.mfile == NULL)
+		{
+			for (int openNum = 0 ; openNum < runNum ; openNum++)
+				fclose(readers[openNum].mfile) ;
+			throw "Unable to open a temporary file" ;
+		}
+		reader.mvect_buffer.resize((size_t) (bufferBytes / sizeof(IsotopePeak))) ;
+		if (FillRunBuffer(reader))
+			mergeHeap.push(runNum) ;
+	}
+
+	std::deque<WindowPeak> window ;
+	long long windowStart = 0 ;		// merged stream position of window.front()
+	std::vector<OpenCluster> clusters ;
+	std::vector<int> freeClusters ;
+	std::vector<int> memberOrder ;
+	std::vector<double> vect_mass ;
+	int numFeatures = 0 ;
+
+	long long numDistanceEvaluations = 0 ;
+	long long numMerges = 0 ;
+	long long position = 0 ;
+
+	mobj_telemetry.BeginStage(STAGE_CLUSTERING, numPeaks) ;
+	while (!mergeHeap.empty() || !window.empty())
+	{
+		WindowPeak current ;
+		bool haveCurrent = !mergeHeap.empty() ;
+		if (haveCurrent)
+		{
+			int runNum = mergeHeap.top() ;
+			mergeHeap.pop() ;
+			RunReader &reader = readers[runNum] ;
+			current.mobj_peak = reader.mvect_buffer[reader.mint_next++] ;
+			if (reader.mint_next < reader.mint_count || FillRunBuffer(reader))
+				mergeHeap.push(runNum) ;
+		}
+
+		// peaks that the current one is beyond the tolerance of cannot be linked to anything else; at the end of
+		// the stream that is all of them
+		while (!window.empty() && (!haveCurrent || !(current.mobj_peak.mdbl_mono_mass < window.front().mdbl_max_mass)))
+		{
+			int clusterNum = window.front().mint_cluster ;
+			window.pop_front() ;
+			windowStart++ ;
+
+			OpenCluster &cluster = clusters[clusterNum] ;
+			if (--cluster.mint_num_in_window > 0)
+				continue ;
+
+			// complete: summarize and write it like CalculateUMCs and CreateFeatureFiles, members in file order
+			int numMembers = (int) cluster.mvect_members.size() ;
+			if (numMembers >= min_length)
+			{
+				memberOrder.resize(numMembers) ;
+				for (int memberNum = 0 ; memberNum < numMembers ; memberNum++)
+					memberOrder[memberNum] = memberNum ;
+				std::vector<IsotopePeak> &members = cluster.mvect_members ;
+				std::sort(memberOrder.begin(), memberOrder.end(), [&members](int first, int second)
+				{
+					return members[first].mint_original_index < members[second].mint_original_index ;
+				}) ;
+
+				UMC new_umc ;
+				SummarizeMembers(members, &memberOrder[0], numMembers, new_umc, vect_mass) ;
+				PrintUMCRow(featureFile, new_umc, numFeatures) ;
+				featureFile.Printf("\n") ;
+				for (int memberNum = 0 ; memberNum < numMembers ; memberNum++)
+					mapFile.Printf("%d\t%d\n", numFeatures, members[memberOrder[memberNum]].mint_line_number_in_file) ;
+				numFeatures++ ;
+			}
+			std::vector<IsotopePeak>().swap(cluster.mvect_members) ;
+			std::vector<long long>().swap(cluster.mvect_positions) ;
+			freeClusters.push_back(clusterNum) ;
+		}
+		if (!haveCurrent)
+			break ;
+
+		if ((position & ProgressTelemetry::PUBLISH_MASK) == 0)
+		{
+			mobj_telemetry.SetItemsProcessed(position) ;
+			mobj_telemetry.AddDistanceEvaluations(numDistanceEvaluations) ;
+			mobj_telemetry.AddMerges(numMerges) ;
+			numDistanceEvaluations = 0 ;
+			numMerges = 0 ;
+		}
+
+		// the links CreateUMCsSinglyLinkedWithAll makes from every lighter peak to this one, in the same direction
+		IsotopePeak &currentPeak = current.mobj_peak ;
+		int currentCluster = -1 ;
+		bool chargeStateMatch = true ;
+		for (int windowNum = 0 ; windowNum < (int) window.size() ; windowNum++)
+		{
+			WindowPeak &windowPeak = window[windowNum] ;
+			if (windowPeak.mint_cluster == currentCluster)
+				continue ;
+
+			double currentDistance = PeakDistance(windowPeak.mobj_peak, currentPeak) ;
+			numDistanceEvaluations++ ;
+			if (mbln_constraint_charge_state)
+				chargeStateMatch = (windowPeak.mobj_peak.mshort_charge == currentPeak.mshort_charge) ;
+			if (!(currentDistance < mdbl_max_distance && chargeStateMatch))
+				continue ;
+
+			if (currentCluster == -1)
+			{
+				currentCluster = windowPeak.mint_cluster ;
+				continue ;
+			}
+
+			// two clusters meet: move the smaller one into the bigger one
+			numMerges++ ;
+			int keepCluster = windowPeak.mint_cluster ;
+			int mergeCluster = currentCluster ;
+			if (clusters[keepCluster].mvect_members.size() < clusters[mergeCluster].mvect_members.size())
+				std::swap(keepCluster, mergeCluster) ;
+			OpenCluster &keep = clusters[keepCluster] ;
+			OpenCluster &merge = clusters[mergeCluster] ;
+			for (int memberNum = 0 ; memberNum < (int) merge.mvect_members.size() ; memberNum++)
+			{
+				long long memberPosition = merge.mvect_positions[memberNum] ;
+				if (memberPosition >= windowStart)
+					window[(size_t) (memberPosition - windowStart)].mint_cluster = keepCluster ;
+				keep.mvect_members.push_back(merge.mvect_members[memberNum]) ;
+				keep.mvect_positions.push_back(memberPosition) ;
+			}
+			keep.mint_num_in_window += merge.mint_num_in_window ;
+			std::vector<IsotopePeak>().swap(merge.mvect_members) ;
+			std::vector<long long>().swap(merge.mvect_positions) ;
+			freeClusters.push_back(mergeCluster) ;
+			currentCluster = keepCluster ;
+		}
+
+		if (currentCluster == -1)
+		{
+			if (freeClusters.empty())
+			{
+				currentCluster = (int) clusters.size() ;
+				clusters.push_back(OpenCluster()) ;
+			}
+			else
+			{
+				currentCluster = freeClusters.back() ;
+				freeClusters.pop_back() ;
+			}
+			clusters[currentCluster].mint_num_in_window = 0 ;
+		}
+		OpenCluster &cluster = clusters[currentCluster] ;
+		cluster.mvect_members.push_back(currentPeak) ;
+		cluster.mvect_positions.push_back(position) ;
+		cluster.mint_num_in_window++ ;
+
+		double massTolerance = mflt_constraint_mono_mass ;
+		if (mbln_constraint_mono_mass_is_ppm)
+			massTolerance *= currentPeak.mdbl_mono_mass / 1000000.0 ;		// Convert from ppm to Da tolerance
+		current.mdbl_max_mass = currentPeak.mdbl_mono_mass + massTolerance ;
+		current.mint_cluster = currentCluster ;
+		window.push_back(current) ;
+		position++ ;
+	}
+	mobj_telemetry.AddDistanceEvaluations(numDistanceEvaluations) ;
+	mobj_telemetry.AddMerges(numMerges) ;
+
+	for (int runNum = 0 ; runNum < numRuns ; runNum++)
+		fclose(readers[runNum].mfile) ;
+	mobj_telemetry.EndStage() ;
+	return numFeatures ;
+}
@@ -0,0 +1,676 @@
+// UMCCreatorParallel.cpp : parts of UMCCreator that run on a WorkStealingPool.
+// Kept apart from UMCCreator.cpp because it needs <atomic>, which cannot be compiled with /clr.
+
+#include "UMCCreator.h"
+#include "MemMappedReader.h"
+#include "WorkStealingPool.h"
+#include "ImsConformerBuilder.h"
+#include <atomic>
+#include <map>
+#include <algorithm>
+
+namespace
+{
+	// Rows of one byte range of an isos file; mint_line_number_in_file of each kept peak is relative to the block
+	struct IsosBlock
+	{
+		__int64 mlng_start ;
+		__int64 mlng_end ;
+		int mint_num_lines ;
+		bool mbln_stopped ;
+		std::vector<IsotopePeak> mvect_peaks ;
+	} ;
+
+	// Scan blocks of a PEK file whose "Filename:" line starts in one byte range
+	struct PekBlock
+	{
+		__int64 mlng_start ;
+		__int64 mlng_end ;
+		__int64 mlng_first_scan_start ;		// where the "Filename:" line of the first scan block starts; -1 if there is none
+		__int64 mlng_last_scan_end ;		// just past the peaks of the last scan block
+		std::vector<IsotopePeak> mvect_peaks ;
+	} ;
+
+	// Peaks of one charge state (or all peaks) for the clustering on the pool, in clustering order
+	struct ChargePartition
+	{
+		std::vector<IsotopePeak> mvect_peaks ;
+		std::vector<int> mvect_sorted_index ;		// position of each peak among the sorted peaks of all charge states
+		std::vector<int> mvect_peak_umc ;			// UMC of each peak, numbered within the partition
+		std::vector<int> mvect_umc_first_peak ;		// position among all sorted peaks of the peak that started each UMC
+	} ;
+
+	// below this a block is not worth a task of its own
+	const __int64 MIN_BLOCK_BYTES = 4 * 1024 * 1024 ;
+
+	char *PEK_FILE_NAME_TAG = "Filename:" ;
+	char *PEK_START_TAG = "CS,  Abundance,   m/z,   Fit,    Average MW, Monoisotopic MW,    Most abundant MW" ;
+	char *PEK_START_TAG_ISOTOPIC_LABELED = "CS,  Abundance,   m/z,   Fit,    Average MW, Monoisotopic MW,    Most abundant MW,   Imono,   I+2" ;
+	char *PEK_STOP_TAG = "Processing stop time:" ;
+}
+
+static void ParseIsosBlock(UMCCreator *creator, char *fileName, __int64 dataStart, IsosBlock &block, std::atomic<long long> &bytesParsed)
+{
+	const int MAX_BUFFER_LEN = 1024 ;
+	char buffer[MAX_BUFFER_LEN] ;
+	char *stopTag = "Blah" ;
+	int stopTagLen = (int)strlen(stopTag) ;
+	ProgressTelemetry &telemetry = creator->GetTelemetry() ;
+
+	MemMappedReader mappedReader ;
+	if (!mappedReader.Load(fileName))
+		throw "Unable to open file" ;
+
+	// a block owns every row that starts inside it, so unless the range starts right after the header
+	// the row running into the range belongs to the previous block
+	if (block.mlng_start > dataStart)
+	{
+		mappedReader.SeekTo(block.mlng_start - 1) ;
+		mappedReader.GetNextLine(buffer, MAX_BUFFER_LEN, "\n", MAX_BUFFER_LEN) ;
+	}
+	else
+		mappedReader.SeekTo(block.mlng_start) ;
+
+	IsotopePeak pk ;
+	pk.mdbl_abundance = 0 ;
+	pk.mdbl_i2_abundance = 0 ;
+	pk.mdbl_average_mass = 0 ;
+	pk.mflt_fit = 0 ;
+	pk.mdbl_max_abundance_mass = 0 ;
+	pk.mdbl_mono_mass = 0 ;
+	pk.mdbl_mz = 0 ;
+	pk.mshort_charge = 0 ;
+	pk.mflt_ims_drift_time = 0 ;
+
+	int numPeaksPublished = 0 ;
+	int numLinesPublished = 0 ;
+	__int64 positionPublished = mappedReader.CurrentPosition() ;
+
+	block.mint_num_lines = 0 ;
+	block.mbln_stopped = false ;
+	while (mappedReader.CurrentPosition() < block.mlng_end && !mappedReader.eof())
+	{
+		if (!mappedReader.GetNextLine(buffer, MAX_BUFFER_LEN, stopTag, stopTagLen))
+		{
+			block.mbln_stopped = true ;
+			break ;
+		}
+
+		if ((block.mint_num_lines & ProgressTelemetry::PUBLISH_MASK) == 0)
+		{
+			long long parsed = bytesParsed += mappedReader.CurrentPosition() - positionPublished ;
+			positionPublished = mappedReader.CurrentPosition() ;
+			telemetry.SetItemsProcessed(parsed) ;
+			telemetry.SetBytesRead(parsed) ;
+			int numPeaks = (int) block.mvect_peaks.size() ;
+			telemetry.AddPeaksKept(numPeaks - numPeaksPublished) ;
+			telemetry.AddPeaksRejected((block.mint_num_lines - numLinesPublished) - (numPeaks - numPeaksPublished)) ;
+			numPeaksPublished = numPeaks ;
+			numLinesPublished = block.mint_num_lines ;
+		}
+
+		creator->ParseIsosLine(buffer, pk) ;
+		if (creator->ConsiderPeak(pk))
+		{
+			pk.mint_line_number_in_file = block.mint_num_lines ;
+			block.mvect_peaks.push_back(pk) ;
+		}
+		block.mint_num_lines++ ;
+	}
+
+	int numPeaks = (int) block.mvect_peaks.size() ;
+	bytesParsed += mappedReader.CurrentPosition() - positionPublished ;
+	telemetry.AddPeaksKept(numPeaks - numPeaksPublished) ;
+	telemetry.AddPeaksRejected((block.mint_num_lines - numLinesPublished) - (numPeaks - numPeaksPublished)) ;
+	mappedReader.Close() ;
+}
+
+int UMCCreator::ReadCSVFileParallel(WorkStealingPool &pool, int numBlocks)
+{
+	char *fileName = mstr_inputFile ;
+	char startTag[1024] ;
+	const int MAX_BUFFER_LEN = 1024 ;
+	char buffer[MAX_BUFFER_LEN] ;
+
+	Reset() ;
+	MemMappedReader mappedReader ;
+	mappedReader.Load(fileName) ;
+	__int64 file_len = mappedReader.FileLength() ;
+	// a compressed file can only be decoded front to back, so its rows cannot be split into byte ranges
+	if (mappedReader.IsCompressed())
+	{
+		mappedReader.Close() ;
+		return ReadCSVFile(fileName) ;
+	}
+
+	mobj_telemetry.BeginStage(STAGE_LOADING, file_len) ;
+	mint_lc_min_scan = INT_MAX ;
+	mint_lc_max_scan = 0 ;
+
+	if (!mappedReader.GetNextLine(buffer, MAX_BUFFER_LEN, "\n", MAX_BUFFER_LEN))
+	{
+		throw "Incorrect header for file" ;
+	}
+	SetIsosLayout(buffer, startTag) ;
+	__int64 dataStart = mappedReader.CurrentPosition() ;
+	mappedReader.Close() ;
+
+	__int64 dataLength = file_len - dataStart ;
+	if (numBlocks > dataLength / MIN_BLOCK_BYTES + 1)
+		numBlocks = (int) (dataLength / MIN_BLOCK_BYTES + 1) ;
+	if (numBlocks < 1)
+		numBlocks = 1 ;
+
+	std::vector<IsosBlock> blocks(numBlocks) ;
+	std::vector<std::function<void()> > tasks ;
+	std::atomic<long long> bytesParsed(dataStart) ;
+	for (int blockNum = 0 ; blockNum < numBlocks ; blockNum++)
+	{
+		IsosBlock &block = blocks[blockNum] ;
+		block.mlng_start = dataStart + (dataLength * blockNum) / numBlocks ;
+		block.mlng_end = dataStart + (dataLength * (blockNum + 1)) / numBlocks ;
+		tasks.push_back([this, fileName, dataStart, &block, &bytesParsed]()
+		{
+			ParseIsosBlock(this, fileName, dataStart, block, bytesParsed) ;
+		}) ;
+	}
+	pool.Run(tasks) ;
+
+	// stitch the blocks together in file order so indices and line numbers match ReadCSVFile
+	int numPeaks = 0 ;
+	int origLineNumber = 0 ;
+	size_t totalPeaks = 0 ;
+	for (int blockNum = 0 ; blockNum < numBlocks ; blockNum++)
+		totalPeaks += blocks[blockNum].mvect_peaks.size() ;
+	mvect_isotope_peaks.reserve(totalPeaks) ;
+
+	for (int blockNum = 0 ; blockNum < numBlocks ; blockNum++)
+	{
+		IsosBlock &block = blocks[blockNum] ;
+		for (int peakNum = 0 ; peakNum < (int) block.mvect_peaks.size() ; peakNum++)
+		{
+			IsotopePeak &pk = block.mvect_peaks[peakNum] ;
+			pk.mint_original_index = numPeaks ;
+			pk.mint_line_number_in_file += origLineNumber ;
+			UpdateScanRange(pk) ;
+			mvect_isotope_peaks.push_back(pk) ;
+			numPeaks++ ;
+		}
+		origLineNumber += block.mint_num_lines ;
+		std::vector<IsotopePeak>().swap(block.mvect_peaks) ;
+
+		// ReadCSVFile stops at the stop tag, so the rows of the later blocks were never there
+		if (block.mbln_stopped)
+			break ;
+	}
+
+	mobj_telemetry.SetBytesRead(bytesParsed.load()) ;
+	mobj_telemetry.EndStage() ;
+	return numPeaks ;
+}
+
+// Moves past the next line starting with tag, like MemMappedReader::SkipToAfterLine, and tells where that line starts
+static bool SkipToAfterPekLine(MemMappedReader &mappedReader, char *tag, char *buffer, int maxLength, __int64 &lineStart)
+{
+	int tagLength = (int)strlen(tag) ;
+	while (!mappedReader.eof())
+	{
+		lineStart = mappedReader.CurrentPosition() ;
+		mappedReader.GetNextLine(buffer, maxLength, "\n", maxLength) ;
+		if (strncmp(buffer, tag, tagLength) == 0)
+			return true ;
+	}
+	return false ;
+}
+
+static void ParsePekBlock(UMCCreator *creator, char *fileName, bool isotopicallyLabeled, bool isFromWiff, PekBlock &block,
+	std::atomic<long long> &bytesParsed)
+{
+	const int MAX_BUFFER_LEN = 1024 ;
+	char buffer[MAX_BUFFER_LEN] ;
+	int startTagLength = (int)strlen(PEK_START_TAG) ;
+	int stopTagLength = (int)strlen(PEK_STOP_TAG) ;
+	ProgressTelemetry &telemetry = creator->GetTelemetry() ;
+
+	MemMappedReader mappedReader ;
+	if (!mappedReader.Load(fileName))
+		throw "Unable to open file" ;
+
+	// as in ParseIsosBlock, the line running into the range belongs to the previous block
+	if (block.mlng_start > 0)
+	{
+		mappedReader.SeekTo(block.mlng_start - 1) ;
+		mappedReader.GetNextLine(buffer, MAX_BUFFER_LEN, "\n", MAX_BUFFER_LEN) ;
+	}
+	else
+		mappedReader.SeekTo(0) ;
+
+	IsotopePeak pk ;
+	pk.mdbl_abundance = 0 ;
+	pk.mdbl_i2_abundance = 0 ;
+	pk.mdbl_average_mass = 0 ;
+	pk.mflt_fit = 0 ;
+	pk.mdbl_max_abundance_mass = 0 ;
+	pk.mdbl_mono_mass = 0 ;
+	pk.mdbl_mz = 0 ;
+	pk.mshort_charge = 0 ;
+	pk.mflt_ims_drift_time = 0 ;
+	pk.mdbl_mono_abundance = 0 ;
+	pk.mint_line_number_in_file = 0 ;
+	pk.mint_ims_scan = 0 ;
+
+	block.mlng_first_scan_start = -1 ;
+	block.mlng_last_scan_end = mappedReader.CurrentPosition() ;
+	__int64 positionPublished = mappedReader.CurrentPosition() ;
+	while (!mappedReader.eof())
+	{
+		// the same steps as ReadPekFileMemoryMapped for every scan block that starts in the range
+		__int64 scanStart ;
+		if (!SkipToAfterPekLine(mappedReader, PEK_FILE_NAME_TAG, buffer, MAX_BUFFER_LEN, scanStart) || scanStart >= block.mlng_end)
+			break ;
+		if (block.mlng_first_scan_start < 0)
+			block.mlng_first_scan_start = scanStart ;
+		pk.mint_lc_scan = creator->ParsePekScanNumber(buffer, false, isFromWiff) ;
+
+		if (!mappedReader.SkipToAfterLine(PEK_START_TAG, startTagLength))
+			break ;
+		while(!mappedReader.eof() && mappedReader.GetNextLine(buffer, MAX_BUFFER_LEN, PEK_STOP_TAG, stopTagLength))
+		{
+			creator->ParsePekLine(buffer, pk, isotopicallyLabeled) ;
+			block.mvect_peaks.push_back(pk) ;
+		}
+		block.mlng_last_scan_end = mappedReader.CurrentPosition() ;
+
+		long long parsed = bytesParsed += mappedReader.CurrentPosition() - positionPublished ;
+		positionPublished = mappedReader.CurrentPosition() ;
+		telemetry.SetItemsProcessed(parsed) ;
+		telemetry.SetBytesRead(parsed) ;
+	}
+	bytesParsed += mappedReader.CurrentPosition() - positionPublished ;
+	telemetry.AddPeaksKept((long long) block.mvect_peaks.size()) ;
+	mappedReader.Close() ;
+}
+
+int UMCCreator::ReadPekFileParallel(char *fileName, WorkStealingPool &pool, int numBlocks)
+{
+	const int MAX_HEADER_BUFFER_LEN = 1024 ;
+	char headerBuffer[MAX_HEADER_BUFFER_LEN] ;
+
+	Reset() ;
+	MemMappedReader mappedReader ;
+	mappedReader.Load(fileName) ;
+	__int64 file_len = mappedReader.FileLength() ;
+	// a compressed file can only be decoded front to back, so its scan blocks cannot be split into byte ranges
+	if (mappedReader.IsCompressed())
+	{
+		mappedReader.Close() ;
+		ReadPekFileMemoryMapped(fileName) ;
+		return (int) mvect_isotope_peaks.size() ;
+	}
+
+	mobj_telemetry.BeginStage(STAGE_LOADING, file_len) ;
+
+	// the first scan block tells whether the file came from a wiff file and whether the peaks are isotopically labeled
+	bool isFromWiff = false ;
+	bool isotopicallyLabeled = false ;
+	bool success = mappedReader.SkipToAfterLine(PEK_FILE_NAME_TAG, headerBuffer, (int)strlen(PEK_FILE_NAME_TAG), MAX_HEADER_BUFFER_LEN) ;
+	if (success)
+	{
+		ParsePekScanNumber(headerBuffer, true, isFromWiff) ;
+		success = mappedReader.SkipToAfterLine(PEK_START_TAG, headerBuffer, (int)strlen(PEK_START_TAG), MAX_HEADER_BUFFER_LEN) ;
+	}
+	if (!success)
+	{
+		mobj_telemetry.SetBytesRead(mappedReader.InputPosition()) ;
+		mobj_telemetry.EndStage() ;
+		mappedReader.Close() ;
+		return 0 ;
+	}
+	isotopicallyLabeled = strncmp(headerBuffer, PEK_START_TAG_ISOTOPIC_LABELED, strlen(PEK_START_TAG_ISOTOPIC_LABELED)) == 0 ;
+	mappedReader.Close() ;
+
+	if (numBlocks > file_len / MIN_BLOCK_BYTES + 1)
+		numBlocks = (int) (file_len / MIN_BLOCK_BYTES + 1) ;
+	if (numBlocks < 1)
+		numBlocks = 1 ;
+
+	std::vector<PekBlock> blocks(numBlocks) ;
+	std::vector<std::function<void()> > tasks ;
+	std::atomic<long long> bytesParsed(0) ;
+	for (int blockNum = 0 ; blockNum < numBlocks ; blockNum++)
+	{
+		PekBlock &block = blocks[blockNum] ;
+		block.mlng_start = (file_len * blockNum) / numBlocks ;
+		block.mlng_end = (file_len * (blockNum + 1)) / numBlocks ;
+		tasks.push_back([this, fileName, isotopicallyLabeled, isFromWiff, &block, &bytesParsed]()
+		{
+			ParsePekBlock(this, fileName, isotopicallyLabeled, isFromWiff, block, bytesParsed) ;
+		}) ;
+	}
+	pool.Run(tasks) ;
+
+	// a scan block without its stop line runs into the next one, whose peaks ReadPekFileMemoryMapped then reads
+	// as part of it; only the serial reader gets such a file right
+	__int64 lastScanEnd = 0 ;
+	size_t totalPeaks = 0 ;
+	for (int blockNum = 0 ; blockNum < numBlocks ; blockNum++)
+	{
+		PekBlock &block = blocks[blockNum] ;
+		if (block.mlng_first_scan_start < 0)
+			continue ;
+		if (block.mlng_first_scan_start < lastScanEnd)
+		{
+			blocks.clear() ;
+			ReadPekFileMemoryMapped(fileName) ;
+			return (int) mvect_isotope_peaks.size() ;
+		}
+		lastScanEnd = block.mlng_last_scan_end ;
+		totalPeaks += block.mvect_peaks.size() ;
+	}
+
+	// stitch the blocks together in file order so indices match ReadPekFileMemoryMapped
+	int numPeaks = 0 ;
+	mvect_isotope_peaks.reserve(totalPeaks) ;
+	for (int blockNum = 0 ; blockNum < numBlocks ; blockNum++)
+	{
+		PekBlock &block = blocks[blockNum] ;
+		for (int peakNum = 0 ; peakNum < (int) block.mvect_peaks.size() ; peakNum++)
+		{
+			IsotopePeak &pk = block.mvect_peaks[peakNum] ;
+			pk.mint_original_index = numPeaks ;
+			mvect_isotope_peaks.push_back(pk) ;
+			numPeaks++ ;
+		}
+		std::vector<IsotopePeak>().swap(block.mvect_peaks) ;
+	}
+
+	mobj_telemetry.SetBytesRead(bytesParsed.load()) ;
+	mobj_telemetry.EndStage() ;
+	return numPeaks ;
+}
+
+void UMCCreator::CollapseImsConformers(WorkStealingPool &pool, std::vector<IsotopePeak> &nodes, std::vector<int> &nodeOfPeak)
+{
+	int numPeaks = (int) mvect_isotope_peaks.size() ;
+	nodeOfPeak.assign(numPeaks, -1) ;
+
+	// the rows of a frame, in file order; isos files are normally written frame by frame already
+	std::vector<int> frameOrder(numPeaks) ;
+	for (int pkNum = 0 ; pkNum < numPeaks ; pkNum++)
+		frameOrder[pkNum] = pkNum ;
+	const std::vector<IsotopePeak> &peaks = mvect_isotope_peaks ;
+	std::stable_sort(frameOrder.begin(), frameOrder.end(), [&peaks](int a, int b)
+	{
+		return peaks[a].mint_lc_scan < peaks[b].mint_lc_scan ;
+	}) ;
+
+	// whole frames per task, a few tasks per thread so that frames of different sizes even out
+	int numTasks = pool.GetNumThreads() * 4 ;
+	int targetPeaks = numPeaks / numTasks + 1 ;
+	std::vector<int> taskStarts(1, 0) ;
+	for (int orderNum = 1 ; orderNum < numPeaks ; orderNum++)
+	{
+		if (orderNum - taskStarts.back() >= targetPeaks && peaks[frameOrder[orderNum]].mint_lc_scan != peaks[frameOrder[orderNum - 1]].mint_lc_scan)
+			taskStarts.push_back(orderNum) ;
+	}
+	taskStarts.push_back(numPeaks) ;
+
+	std::vector<std::vector<IsotopePeak> > taskNodes(taskStarts.size() - 1) ;
+	std::vector<std::function<void()> > tasks ;
+	for (int taskNum = 0 ; taskNum + 1 < (int) taskStarts.size() ; taskNum++)
+	{
+		tasks.push_back([this, taskNum, &taskStarts, &frameOrder, &taskNodes, &nodeOfPeak]()
+		{
+			ImsConformerBuilder builder(mflt_constraint_mono_mass, mbln_constraint_mono_mass_is_ppm) ;
+			int frameStart = taskStarts[taskNum] ;
+			while (frameStart < taskStarts[taskNum + 1])
+			{
+				int frameEnd = frameStart + 1 ;
+				int frame = mvect_isotope_peaks[frameOrder[frameStart]].mint_lc_scan ;
+				while (frameEnd < taskStarts[taskNum + 1] && mvect_isotope_peaks[frameOrder[frameEnd]].mint_lc_scan == frame)
+					frameEnd++ ;
+				builder.AddFrame(mvect_isotope_peaks, &frameOrder[frameStart], frameEnd - frameStart, taskNodes[taskNum], nodeOfPeak) ;
+				frameStart = frameEnd ;
+			}
+		}) ;
+	}
+	pool.Run(tasks) ;
+
+	// put the nodes of the tasks one after the other, in frame order
+	nodes.clear() ;
+	for (int taskNum = 0 ; taskNum < (int) taskNodes.size() ; taskNum++)
+	{
+		int firstNode = (int) nodes.size() ;
+		for (int orderNum = taskStarts[taskNum] ; orderNum < taskStarts[taskNum + 1] ; orderNum++)
+			nodeOfPeak[frameOrder[orderNum]] += firstNode ;
+		nodes.insert(nodes.end(), taskNodes[taskNum].begin(), taskNodes[taskNum].end()) ;
+		std::vector<IsotopePeak>().swap(taskNodes[taskNum]) ;
+	}
+	for (int nodeNum = 0 ; nodeNum < (int) nodes.size() ; nodeNum++)
+	{
+		nodes[nodeNum].mint_original_index = nodeNum ;
+		nodes[nodeNum].mint_umc_index = -1 ;
+	}
+}
+
+int UMCCreator::FindIsolatedPeaks(WorkStealingPool &pool, const std::vector<IsotopePeak> &sortedPeaks, std::vector<char> &isolated)
+{
+	int numSorted = (int) sortedPeaks.size() ;
+	isolated.assign(numSorted, 0) ;
+
+	// each task writes the flags of its own range only
+	int numTasks = pool.GetNumThreads() * 4 ;
+	std::vector<int> numIsolatedOfTask(numTasks, 0) ;
+	std::vector<std::function<void()> > tasks ;
+	for (int taskNum = 0 ; taskNum < numTasks ; taskNum++)
+	{
+		int rangeStart = (int) (((long long) numSorted * taskNum) / numTasks) ;
+		int rangeEnd = (int) (((long long) numSorted * (taskNum + 1)) / numTasks) ;
+		if (rangeStart == rangeEnd)
+			continue ;
+		tasks.push_back([this, rangeStart, rangeEnd, numSorted, taskNum, &sortedPeaks, &isolated, &numIsolatedOfTask]()
+		{
+			IsotopePeak currentPeak ;
+			IsotopePeak otherPeak ;
+			for (int sortedNum = rangeStart ; sortedNum < rangeEnd ; sortedNum++)
+			{
+				currentPeak = sortedPeaks[sortedNum] ;
+				double massTolerance = mflt_constraint_mono_mass ;
+				if (mbln_constraint_mono_mass_is_ppm)
+					massTolerance *= currentPeak.mdbl_mono_mass / 1000000.0 ;
+				double maxMass = currentPeak.mdbl_mono_mass + massTolerance ;
+				bool hasNeighbour = false ;
+
+				// the heavier peaks the sweep tries to link to this one
+				for (int otherNum = sortedNum + 1 ; !hasNeighbour && otherNum < numSorted && sortedPeaks[otherNum].mdbl_mono_mass < maxMass ; otherNum++)
+				{
+					otherPeak = sortedPeaks[otherNum] ;
+					hasNeighbour = (!mbln_constraint_charge_state || currentPeak.mshort_charge == otherPeak.mshort_charge)
+						&& PeakDistance(currentPeak, otherPeak) < mdbl_max_distance ;
+				}
+
+				// the lighter peaks whose own mass window reaches this one; that window is no wider than this peak's, so
+				// none lighter than its mass minus massTolerance qualifies
+				for (int otherNum = sortedNum - 1 ; !hasNeighbour && otherNum >= 0 && sortedPeaks[otherNum].mdbl_mono_mass + massTolerance > currentPeak.mdbl_mono_mass ; otherNum--)
+				{
+					otherPeak = sortedPeaks[otherNum] ;
+					double otherTolerance = mflt_constraint_mono_mass ;
+					if (mbln_constraint_mono_mass_is_ppm)
+						otherTolerance *= otherPeak.mdbl_mono_mass / 1000000.0 ;
+					hasNeighbour = currentPeak.mdbl_mono_mass < otherPeak.mdbl_mono_mass + otherTolerance
+						&& (!mbln_constraint_charge_state || currentPeak.mshort_charge == otherPeak.mshort_charge)
+						&& PeakDistance(otherPeak, currentPeak) < mdbl_max_distance ;
+				}
+
+				if (!hasNeighbour)
+				{
+					isolated[sortedNum] = 1 ;
+					numIsolatedOfTask[taskNum]++ ;
+				}
+			}
+		}) ;
+	}
+	pool.Run(tasks) ;
+
+	int numIsolated = 0 ;
+	for (int taskNum = 0 ; taskNum < numTasks ; taskNum++)
+		numIsolated += numIsolatedOfTask[taskNum] ;
+	return numIsolated ;
+}
+
+void UMCCreator::CreateUMCsSinglyLinkedWithAll(WorkStealingPool &pool)
+{
+	bool collapseConformers = mbln_collapse_ims_conformers && mbln_is_ims_data ;
+	// on a single thread the partitions would only add copies of the peaks
+	bool partitionByCharge = mbln_constraint_charge_state && pool.GetNumThreads() > 1 ;
+	if (!collapseConformers && !partitionByCharge && !mbln_skip_isolated_peaks)
+	{
+		CreateUMCsSinglyLinkedWithAll() ;
+		return ;
+	}
+
+	// the clustering links the sorted peaks, or the sorted conformer nodes of the peaks
+	int numPeaks = (int) mvect_isotope_peaks.size() ;
+	mobj_telemetry.BeginStage(STAGE_SORTING, numPeaks) ;
+	std::vector<IsotopePeak> sortedPeaks ;
+	std::vector<int> nodeOfPeak ;
+	if (collapseConformers)
+	{
+		CollapseImsConformers(pool, sortedPeaks, nodeOfPeak) ;
+		SortForClustering(sortedPeaks) ;
+	}
+	else
+		SortPeaksForClustering(sortedPeaks) ;
+	int numSorted = (int) sortedPeaks.size() ;
+
+	// an isolated peak is a UMC of its own whatever the sweep does, and takes no part in any other UMC, so it is kept
+	// out of the partitions; its sorted position and index are all the numbering below needs
+	std::vector<char> isolated ;
+	std::vector<int> isolatedSortedIndex ;
+	std::vector<int> isolatedOriginalIndex ;
+	mint_num_isolated_peaks = 0 ;
+	if (mbln_skip_isolated_peaks)
+	{
+		mint_num_isolated_peaks = FindIsolatedPeaks(pool, sortedPeaks, isolated) ;
+		isolatedSortedIndex.reserve(mint_num_isolated_peaks) ;
+		isolatedOriginalIndex.reserve(mint_num_isolated_peaks) ;
+		for (int sortedNum = 0 ; sortedNum < numSorted ; sortedNum++)
+		{
+			if (isolated[sortedNum])
+			{
+				isolatedSortedIndex.push_back(sortedNum) ;
+				isolatedOriginalIndex.push_back(sortedPeaks[sortedNum].mint_original_index) ;
+			}
+		}
+	}
+	else
+		isolated.assign(numSorted, 0) ;
+
+	// split the sorted peaks by charge state, or keep them together; each partition keeps the order of the sorted
+	// peaks, so it is swept exactly as the full sweep would visit its peaks
+	std::map<short, int> numPeaksOfPartition ;
+	for (int sortedNum = 0 ; sortedNum < numSorted ; sortedNum++)
+	{
+		if (!isolated[sortedNum])
+			numPeaksOfPartition[partitionByCharge ? sortedPeaks[sortedNum].mshort_charge : 0]++ ;
+	}
+	std::vector<ChargePartition> partitions ;
+	std::map<short, int> partitionOfCharge ;
+	for (std::map<short, int>::iterator iter = numPeaksOfPartition.begin() ; iter != numPeaksOfPartition.end() ; iter++)
+	{
+		partitionOfCharge[(*iter).first] = (int) partitions.size() ;
+		partitions.push_back(ChargePartition()) ;
+		partitions.back().mvect_peaks.reserve((*iter).second) ;
+		partitions.back().mvect_sorted_index.reserve((*iter).second) ;
+	}
+	for (int sortedNum = 0 ; sortedNum < numSorted ; sortedNum++)
+	{
+		if (isolated[sortedNum])
+			continue ;
+		ChargePartition &partition = partitions[partitionOfCharge[partitionByCharge ? sortedPeaks[sortedNum].mshort_charge : 0]] ;
+		partition.mvect_peaks.push_back(sortedPeaks[sortedNum]) ;
+		partition.mvect_sorted_index.push_back(sortedNum) ;
+	}
+	std::vector<IsotopePeak>().swap(sortedPeaks) ;
+	std::vector<char>().swap(isolated) ;
+
+	mmultimap_umc_2_peak_index.clear() ;
+	mvect_umc_num_members.clear() ;
+	mobj_telemetry.BeginStage(STAGE_CLUSTERING, numSorted) ;
+
+	std::atomic<long long> peaksClustered(mint_num_isolated_peaks) ;
+	std::vector<std::function<void()> > tasks ;
+	for (int partitionNum = 0 ; partitionNum < (int) partitions.size() ; partitionNum++)
+	{
+		ChargePartition &partition = partitions[partitionNum] ;
+		tasks.push_back([this, &partition, &peaksClustered]()
+		{
+			int numPartitionPeaks = (int) partition.mvect_peaks.size() ;
+			RunArena arena ;
+			ArenaAllocator<std::pair<const int, int> > allocator(&arena) ;
+			UMCPeakMultimap umcPeaks(std::less<int>(), allocator) ;
+			arena.Reserve(numPartitionPeaks * MAP_NODE_BYTES) ;
+			std::vector<int> vectSortedUmcIndex(numPartitionPeaks, -1) ;
+			std::vector<int> vectUmcFirstPeak ;
+			SweepSortedPeaks(partition.mvect_peaks, vectSortedUmcIndex, umcPeaks, &vectUmcFirstPeak, false) ;
+
+			// number the clusters of the partition in map order, and note where the peak that started each one sits
+			// among all sorted peaks
+			partition.mvect_peak_umc.resize(numPartitionPeaks) ;
+			for (UMCPeakMultimap::iterator iter = umcPeaks.begin() ; iter != umcPeaks.end() ; )
+			{
+				int oldUmcNum = (*iter).first ;
+				int umcNum = (int) partition.mvect_umc_first_peak.size() ;
+				partition.mvect_umc_first_peak.push_back(partition.mvect_sorted_index[vectUmcFirstPeak[oldUmcNum]]) ;
+				for ( ; iter != umcPeaks.end() && (*iter).first == oldUmcNum ; iter++)
+					partition.mvect_peak_umc[(*iter).second] = umcNum ;
+			}
+			umcPeaks.clear() ;
+			mobj_telemetry.SetItemsProcessed(peaksClustered += numPartitionPeaks) ;
+		}) ;
+	}
+	pool.Run(tasks) ;
+
+	// The full sweep numbers its UMCs in the order of the peaks that started them, and every UMC is started by the
+	// same peak in its partition, so numbering the UMCs of all partitions in that order gives the same UMC numbers
+	std::vector<int> umcOfFirstPeak(numSorted, -1) ;
+	for (int partitionNum = 0 ; partitionNum < (int) partitions.size() ; partitionNum++)
+	{
+		ChargePartition &partition = partitions[partitionNum] ;
+		for (int umcNum = 0 ; umcNum < (int) partition.mvect_umc_first_peak.size() ; umcNum++)
+			umcOfFirstPeak[partition.mvect_umc_first_peak[umcNum]] = 0 ;
+	}
+	for (int isolatedNum = 0 ; isolatedNum < mint_num_isolated_peaks ; isolatedNum++)
+		umcOfFirstPeak[isolatedSortedIndex[isolatedNum]] = 0 ;
+	int numUmcs = 0 ;
+	for (int sortedNum = 0 ; sortedNum < numSorted ; sortedNum++)
+	{
+		if (umcOfFirstPeak[sortedNum] == 0)
+			umcOfFirstPeak[sortedNum] = numUmcs++ ;
+	}
+
+	// UMC of every clustered peak or node, by its mint_original_index
+	std::vector<int> umcOfSorted(numSorted) ;
+	for (int partitionNum = 0 ; partitionNum < (int) partitions.size() ; partitionNum++)
+	{
+		ChargePartition &partition = partitions[partitionNum] ;
+		for (int peakNum = 0 ; peakNum < (int) partition.mvect_peaks.size() ; peakNum++)
+			umcOfSorted[partition.mvect_peaks[peakNum].mint_original_index] = umcOfFirstPeak[partition.mvect_umc_first_peak[partition.mvect_peak_umc[peakNum]]] ;
+	}
+	for (int isolatedNum = 0 ; isolatedNum < mint_num_isolated_peaks ; isolatedNum++)
+		umcOfSorted[isolatedOriginalIndex[isolatedNum]] = umcOfFirstPeak[isolatedSortedIndex[isolatedNum]] ;
+	partitions.clear() ;
+
+	// every row goes into the UMC of its node
+	mint_num_conformer_nodes = collapseConformers ? numSorted : 0 ;
+	mvect_umc_num_members.resize(numUmcs, 0) ;
+	for (int pkNum = 0 ; pkNum < numPeaks ; pkNum++)
+	{
+		int umcNum = umcOfSorted[collapseConformers ? nodeOfPeak[pkNum] : pkNum] ;
+		mvect_isotope_peaks[pkNum].mint_umc_index = umcNum ;
+		mvect_umc_num_members[umcNum]++ ;
+	}
+
+	mobj_arena.Reserve(numPeaks * MAP_NODE_BYTES) ;
+	FinishClustering() ;
+}
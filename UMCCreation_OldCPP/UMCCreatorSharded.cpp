@@ -0,0 +1,499 @@
+// UMCCreatorSharded.cpp : sharded mode of UMCCreator, for isos files that one process should not cluster alone.
+//
+// The single linkage clusters do not depend on the order the links are made in, and the sweep of
+// CreateUMCsSinglyLinkedWithAll numbers them in the mass order of the peak that started the number each one ends up
+// with (its anchor). That peak is the same whether the sweep sees all peaks or only those of the cluster, since the
+// peaks of other clusters never change the numbers of this one (the same argument as for the charge partitions of
+// UMCCreatorParallel.cpp) and equal masses are swept in file order; so the anchors order the clusters by mass, then line.
+//
+// PlanMassShards cuts the mass range into shards of about the same number of peaks. Every link is shorter than the
+// mass tolerance, so a shard that loads the tolerance (the overlap) beyond both ends of its core sees every link of
+// every core peak. ClusterMassShard writes each of its clusters with a core peak; one whose peaks all lie further than
+// the tolerance inside the loaded range is whole, and its anchor is known. A cluster that runs off the loaded range
+// shares the peaks of the overlap with the pieces the neighbouring shards found, so MergeMassShards joins the pieces
+// that share peaks, and sweeps the peaks of a joined cluster again for its anchor when no shard saw it whole.
+// Clusters are written in anchor order once no cluster still open can hold an earlier anchor.
+
+#include "UMCCreator.h"
+#include "MassShardPlan.h"
+#include "MemMappedReader.h"
+#include "OutputFileWriter.h"
+#include <algorithm>
+#include <map>
+
+namespace
+{
+	// Start of a shard result file
+	struct ShardResultHeader
+	{
+		char mstr_tag[8] ;
+		int mint_shard_num ;
+		int mint_num_shards ;
+	} ;
+
+	// A cluster in a shard result file, followed by its mint_num_members peaks in file order; a record without
+	// members ends the file
+	struct ShardCluster
+	{
+		int mint_num_members ;
+		int mint_anchor ;		// member that is the anchor of the cluster if the shard saw it whole, else -1
+	} ;
+
+	// Cluster being put together from the pieces of the shards
+	struct JoinedCluster
+	{
+		std::vector<IsotopePeak> mvect_members ;
+		int mint_anchor_line ;		// line of the anchor; -1 until a shard that saw the cluster whole names it
+		double mdbl_max_mass ;
+		std::pair<double, int> mpair_first ;		// mass and line of the lightest member
+	} ;
+
+	// A joined cluster of at least the minimum length, waiting for the clusters with earlier anchors
+	struct FinishedCluster
+	{
+		UMC mobj_umc ;
+		std::vector<int> mvect_lines ;
+	} ;
+
+	const char SHARD_RESULT_TAG[8] = { 'U', 'M', 'C', 'S', 'H', 'R', 'D', '1' } ;
+
+	// the mass tolerance of a link is worked out from the lighter peak; this covers its rounding
+	const double TOLERANCE_MARGIN = 1.00001 ;
+
+	bool SortPeaksByLine(const IsotopePeak &a, const IsotopePeak &b)
+	{
+		return a.mint_line_number_in_file < b.mint_line_number_in_file ;
+	}
+
+	void ReadShardRecord(void *record, size_t size, size_t count, FILE *resultFile)
+	{
+		if (count > 0 && fread(record, size, count, resultFile) != count)
+			throw "A shard result file is incomplete" ;
+	}
+}
+
+void UMCCreator::GetShardResultFileName(const char *tempFilePrefix, int shardNum, char *fileName)
+{
+	sprintf(fileName, "%s_Shard%d.bin", tempFilePrefix, shardNum + 1) ;
+}
+
+int UMCCreator::PlanMassShards(int numShards, MassShardPlan &plan)
+{
+	char startTag[1024] ;
+	char *stopTag = "Blah" ;
+	int stopTagLen = (int)strlen(stopTag) ;
+	const int MAX_BUFFER_LEN = 1024 ;
+	char buffer[MAX_BUFFER_LEN] ;
+
+	Reset() ;
+	MemMappedReader mappedReader ;
+	if (!mappedReader.Load(mstr_inputFile))
+		throw "Unable to open file" ;
+	__int64 file_len = mappedReader.FileLength() ;
+
+	mobj_telemetry.BeginStage(STAGE_LOADING, file_len) ;
+	mint_lc_min_scan = INT_MAX ;
+	mint_lc_max_scan = 0 ;
+
+	if (!mappedReader.GetNextLine(buffer, MAX_BUFFER_LEN, "\n", MAX_BUFFER_LEN))
+	{
+		throw "Incorrect header for file" ;
+	}
+	SetIsosLayout(buffer, startTag) ;
+
+	// peaks per whole Da; the only memory of this pass
+	std::map<int, int> peaksPerDa ;
+	IsotopePeak pk ;
+	pk.mdbl_abundance = 0 ;
+	pk.mdbl_i2_abundance = 0 ;
+	pk.mdbl_average_mass = 0 ;
+	pk.mflt_fit = 0 ;
+	pk.mdbl_max_abundance_mass = 0 ;
+	pk.mdbl_mono_mass = 0 ;
+	pk.mdbl_mz = 0 ;
+	pk.mshort_charge = 0 ;
+	pk.mflt_ims_drift_time = 0 ;
+	int numPeaks = 0 ;
+	int origLineNumber = 0 ;
+	double maxMass = 0 ;
+	while (!mappedReader.eof() && mappedReader.GetNextLine(buffer, MAX_BUFFER_LEN, stopTag, stopTagLen))
+	{
+		if ((origLineNumber & ProgressTelemetry::PUBLISH_MASK) == 0)
+		{
+			mobj_telemetry.SetItemsProcessed(mappedReader.InputPosition()) ;
+			mobj_telemetry.SetBytesRead(mappedReader.InputPosition()) ;
+		}
+
+		ParseIsosLine(buffer, pk) ;
+		pk.mint_line_number_in_file = origLineNumber ;
+		if (ConsiderPeak(pk))
+		{
+			UpdateScanRange(pk) ;
+			peaksPerDa[pk.mdbl_mono_mass > 0 ? (int) pk.mdbl_mono_mass : 0]++ ;
+			if (pk.mdbl_mono_mass > maxMass)
+				maxMass = pk.mdbl_mono_mass ;
+			numPeaks++ ;
+		}
+		origLineNumber++ ;
+	}
+	mobj_telemetry.SetBytesRead(mappedReader.InputPosition()) ;
+	mobj_telemetry.AddPeaksKept(numPeaks) ;
+	mobj_telemetry.AddPeaksRejected(origLineNumber - numPeaks) ;
+	mobj_telemetry.EndStage() ;
+	mappedReader.Close() ;
+
+	// cut at whole Da once each shard has its share of the peaks; a Da holding more than a share makes fewer shards
+	if (numShards < 1)
+		numShards = 1 ;
+	plan.mvect_boundaries.clear() ;
+	plan.mvect_shard_peaks.clear() ;
+	plan.mvect_boundaries.push_back(mflt_mono_mass_start) ;
+	plan.mvect_shard_peaks.push_back(0) ;
+	long long peaksSoFar = 0 ;
+	for (std::map<int, int>::iterator iter = peaksPerDa.begin() ; iter != peaksPerDa.end() ; iter++)
+	{
+		int numSoFar = (int) plan.mvect_boundaries.size() ;
+		float boundary = (float) ((*iter).first) ;
+		if (numSoFar < numShards && peaksSoFar >= (long long) numPeaks * numSoFar / numShards && boundary > plan.mvect_boundaries.back()
+			&& boundary < mflt_mono_mass_end && plan.mvect_shard_peaks.back() > 0)
+		{
+			plan.mvect_boundaries.push_back(boundary) ;
+			plan.mvect_shard_peaks.push_back(0) ;
+		}
+		plan.mvect_shard_peaks.back() += (*iter).second ;
+		peaksSoFar += (*iter).second ;
+	}
+	plan.mvect_boundaries.push_back(mflt_mono_mass_end) ;
+	plan.mint_num_shards = (int) plan.mvect_shard_peaks.size() ;
+
+	double massTolerance = mflt_constraint_mono_mass ;
+	if (mbln_constraint_mono_mass_is_ppm)
+		massTolerance *= maxMass / 1000000.0 ;		// Convert from ppm to Da tolerance
+	plan.mflt_overlap = (float) (ceil(massTolerance * TOLERANCE_MARGIN) + 1) ;
+	if (plan.mflt_overlap < mint_mono_mass_seg_overlap)
+		plan.mflt_overlap = (float) mint_mono_mass_seg_overlap ;
+	plan.mint_num_peaks = numPeaks ;
+	plan.mbln_is_ims_data = mbln_is_ims_data ;
+	plan.mint_lc_min_scan = mint_lc_min_scan ;
+	plan.mint_lc_max_scan = mint_lc_max_scan ;
+	plan.mint_ims_min_scan = mint_ims_min_scan ;
+	plan.mint_ims_max_scan = mint_ims_max_scan ;
+	return numPeaks ;
+}
+
+int UMCCreator::ClusterMassShard(const MassShardPlan &plan, int shardNum, const char *resultFileName)
+{
+	float loadStart, loadEnd ;
+	plan.GetLoadRange(shardNum, loadStart, loadEnd) ;
+	SetMassRange(loadStart, loadEnd) ;
+	ReadCSVFile() ;
+	// distances as in the whole file
+	mint_lc_min_scan = plan.mint_lc_min_scan ;
+	mint_lc_max_scan = plan.mint_lc_max_scan ;
+	mint_ims_min_scan = plan.mint_ims_min_scan ;
+	mint_ims_max_scan = plan.mint_ims_max_scan ;
+
+	int numPeaks = (int) mvect_isotope_peaks.size() ;
+	std::vector<IsotopePeak> sortedPeaks ;
+	mobj_telemetry.BeginStage(STAGE_SORTING, numPeaks) ;
+	SortPeaksForClustering(sortedPeaks) ;
+
+	mmultimap_umc_2_peak_index.clear() ;
+	mobj_arena.Reserve(numPeaks * MAP_NODE_BYTES) ;
+	std::vector<int> vectSortedUmcIndex(numPeaks, -1) ;
+	std::vector<int> vectUmcFirstPeak ;
+	mobj_telemetry.BeginStage(STAGE_CLUSTERING, numPeaks) ;
+	SweepSortedPeaks(sortedPeaks, vectSortedUmcIndex, mmultimap_umc_2_peak_index, &vectUmcFirstPeak, true) ;
+
+	FILE *resultFile = fopen(resultFileName, "wb") ;
+	if (resultFile == NULL)
+		throw "Unable to create a shard result file; check TempDirectory" ;
+	ShardResultHeader header ;
+	memcpy(header.mstr_tag, SHARD_RESULT_TAG, sizeof(header.mstr_tag)) ;
+	header.mint_shard_num = shardNum ;
+	header.mint_num_shards = plan.mint_num_shards ;
+	bool success = fwrite(&header, sizeof(header), 1, resultFile) == 1 ;
+
+	// no peaks lie beyond the ends of the first and last shard, so no link can be missing there
+	bool startOpen = loadStart > plan.mvect_boundaries[0] ;
+	bool endOpen = loadEnd < plan.mvect_boundaries[plan.mint_num_shards] ;
+	mobj_telemetry.BeginStage(STAGE_WRITING, numPeaks) ;
+	int numClusters = 0 ;
+	std::vector<int> members ;
+	std::vector<IsotopePeak> clusterPeaks ;
+	for (UMCPeakMultimap::iterator iter = mmultimap_umc_2_peak_index.begin() ; success && iter != mmultimap_umc_2_peak_index.end() ; )
+	{
+		int oldUmcNum = (*iter).first ;
+		members.clear() ;
+		bool inCore = false ;
+		bool whole = true ;
+		for ( ; iter != mmultimap_umc_2_peak_index.end() && (*iter).first == oldUmcNum ; iter++)
+		{
+			const IsotopePeak &pk = sortedPeaks[(*iter).second] ;
+			members.push_back(pk.mint_original_index) ;
+			if (plan.IsInCore(shardNum, pk.mdbl_mono_mass))
+				inCore = true ;
+
+			double massTolerance = mflt_constraint_mono_mass ;
+			if (mbln_constraint_mono_mass_is_ppm)
+				massTolerance *= pk.mdbl_mono_mass / 1000000.0 ;		// Convert from ppm to Da tolerance
+			massTolerance *= TOLERANCE_MARGIN ;
+			if ((startOpen && !(pk.mdbl_mono_mass - massTolerance > loadStart)) || (endOpen && !(pk.mdbl_mono_mass + massTolerance < loadEnd)))
+				whole = false ;
+		}
+		// a cluster of the overlap alone is written by the shard whose core it is in
+		if (!inCore)
+			continue ;
+
+		std::sort(members.begin(), members.end()) ;
+		ShardCluster cluster ;
+		cluster.mint_num_members = (int) members.size() ;
+		cluster.mint_anchor = -1 ;
+		clusterPeaks.clear() ;
+		int anchorPeak = sortedPeaks[vectUmcFirstPeak[oldUmcNum]].mint_original_index ;
+		for (int memberNum = 0 ; memberNum < (int) members.size() ; memberNum++)
+		{
+			if (whole && members[memberNum] == anchorPeak)
+				cluster.mint_anchor = memberNum ;
+			clusterPeaks.push_back(mvect_isotope_peaks[members[memberNum]]) ;
+		}
+		success = fwrite(&cluster, sizeof(cluster), 1, resultFile) == 1
+			&& fwrite(&clusterPeaks[0], sizeof(IsotopePeak), clusterPeaks.size(), resultFile) == clusterPeaks.size() ;
+		numClusters++ ;
+	}
+	ShardCluster endOfFile ;
+	endOfFile.mint_num_members = 0 ;
+	endOfFile.mint_anchor = -1 ;
+	success = success && fwrite(&endOfFile, sizeof(endOfFile), 1, resultFile) == 1 ;
+	success = fclose(resultFile) == 0 && success ;
+	mobj_telemetry.EndStage() ;
+	if (!success)
+		throw "Unable to write a shard result file; check the free space of TempDirectory" ;
+	return numClusters ;
+}
+
+int UMCCreator::MergeMassShards(const MassShardPlan &plan, const char *tempFilePrefix, char *baseFileName, int min_length)
+{
+	Reset() ;
+	mint_lc_min_scan = plan.mint_lc_min_scan ;
+	mint_lc_max_scan = plan.mint_lc_max_scan ;
+	mint_ims_min_scan = plan.mint_ims_min_scan ;
+	mint_ims_max_scan = plan.mint_ims_max_scan ;
+	mbln_is_ims_data = plan.mbln_is_ims_data ;
+
+	// the feature files of an earlier merge are left alone until every shard is there
+	char fileName[1100] ;
+	for (int shardNum = 0 ; shardNum < plan.mint_num_shards ; shardNum++)
+	{
+		GetShardResultFileName(tempFilePrefix, shardNum, fileName) ;
+		FILE *resultFile = fopen(fileName, "rb") ;
+		if (resultFile == NULL)
+			throw "Unable to open a shard result file" ;
+		fclose(resultFile) ;
+	}
+
+	OutputFileWriter featureFile ;
+	OutputFileWriter mapFile ;
+	if (!OpenOutputFile(featureFile, baseFileName, "_LCMSFeatures.txt") || !OpenOutputFile(mapFile, baseFileName, "_LCMSFeatureToPeakMap.txt"))
+		throw "Unable to create the feature files" ;
+	PrintUMCHeader(featureFile, false) ;
+	mapFile.Printf("Feature_Index\tPeak_Index\n") ;
+
+	std::vector<JoinedCluster> joined ;
+	std::vector<JoinedCluster> stillOpen ;
+	std::map<int, int> clusterOfLine ;		// joined cluster of every peak of the open clusters
+	std::map<std::pair<double, int>, FinishedCluster> finished ;		// by the mass and line of the anchor
+	std::vector<IsotopePeak> pieceMembers ;
+	std::vector<IsotopePeak> sortedMembers ;
+	std::vector<int> memberOrder ;
+	std::vector<double> vect_mass ;
+	std::vector<int> vectSortedUmcIndex ;
+	std::vector<int> vectUmcFirstPeak ;
+	int numFeatures = 0 ;
+
+	mobj_telemetry.BeginStage(STAGE_CLUSTERING, plan.mint_num_shards) ;
+	for (int shardNum = 0 ; shardNum < plan.mint_num_shards ; shardNum++)
+	{
+		mobj_telemetry.SetItemsProcessed(shardNum) ;
+		GetShardResultFileName(tempFilePrefix, shardNum, fileName) ;
+		FILE *resultFile = fopen(fileName, "rb") ;
+		if (resultFile == NULL)
+			throw "Unable to open a shard result file" ;
+		try
+		{
+			ShardResultHeader header ;
+			ReadShardRecord(&header, sizeof(header), 1, resultFile) ;
+			if (memcmp(header.mstr_tag, SHARD_RESULT_TAG, sizeof(header.mstr_tag)) != 0 || header.mint_shard_num != shardNum
+				|| header.mint_num_shards != plan.mint_num_shards)
+				throw "A shard result file does not belong to this plan" ;
+
+			ShardCluster piece ;
+			ReadShardRecord(&piece, sizeof(piece), 1, resultFile) ;
+			while (piece.mint_num_members > 0)
+			{
+				pieceMembers.resize(piece.mint_num_members) ;
+				ReadShardRecord(&pieceMembers[0], sizeof(IsotopePeak), pieceMembers.size(), resultFile) ;
+
+				// the piece joins every open cluster it shares a peak with
+				int target = -1 ;
+				for (int memberNum = 0 ; memberNum < (int) pieceMembers.size() ; memberNum++)
+				{
+					std::map<int, int>::iterator found = clusterOfLine.find(pieceMembers[memberNum].mint_line_number_in_file) ;
+					if (found == clusterOfLine.end() || (*found).second == target)
+						continue ;
+					if (target == -1)
+					{
+						target = (*found).second ;
+						continue ;
+					}
+					int keepNum = target ;
+					int mergeNum = (*found).second ;
+					if (joined[keepNum].mvect_members.size() < joined[mergeNum].mvect_members.size())
+						std::swap(keepNum, mergeNum) ;
+					JoinedCluster &keep = joined[keepNum] ;
+					JoinedCluster &merge = joined[mergeNum] ;
+					for (int mergedNum = 0 ; mergedNum < (int) merge.mvect_members.size() ; mergedNum++)
+					{
+						clusterOfLine[merge.mvect_members[mergedNum].mint_line_number_in_file] = keepNum ;
+						keep.mvect_members.push_back(merge.mvect_members[mergedNum]) ;
+					}
+					if (keep.mint_anchor_line == -1)
+						keep.mint_anchor_line = merge.mint_anchor_line ;
+					if (merge.mdbl_max_mass > keep.mdbl_max_mass)
+						keep.mdbl_max_mass = merge.mdbl_max_mass ;
+					if (merge.mpair_first < keep.mpair_first)
+						keep.mpair_first = merge.mpair_first ;
+					std::vector<IsotopePeak>().swap(merge.mvect_members) ;
+					target = keepNum ;
+				}
+				if (target == -1)
+				{
+					target = (int) joined.size() ;
+					joined.push_back(JoinedCluster()) ;
+					joined[target].mint_anchor_line = -1 ;
+					joined[target].mdbl_max_mass = -1 * DBL_MAX ;
+					joined[target].mpair_first = std::make_pair(DBL_MAX, INT_MAX) ;
+				}
+
+				JoinedCluster &cluster = joined[target] ;
+				for (int memberNum = 0 ; memberNum < (int) pieceMembers.size() ; memberNum++)
+				{
+					IsotopePeak &pk = pieceMembers[memberNum] ;
+					if (!clusterOfLine.insert(std::make_pair(pk.mint_line_number_in_file, target)).second)
+						continue ;
+					cluster.mvect_members.push_back(pk) ;
+					if (pk.mdbl_mono_mass > cluster.mdbl_max_mass)
+						cluster.mdbl_max_mass = pk.mdbl_mono_mass ;
+					std::pair<double, int> key(pk.mdbl_mono_mass, pk.mint_line_number_in_file) ;
+					if (key < cluster.mpair_first)
+						cluster.mpair_first = key ;
+				}
+				if (piece.mint_anchor >= 0)
+					cluster.mint_anchor_line = pieceMembers[piece.mint_anchor].mint_line_number_in_file ;
+
+				ReadShardRecord(&piece, sizeof(piece), 1, resultFile) ;
+			}
+		}
+		catch (...)
+		{
+			fclose(resultFile) ;
+			throw ;
+		}
+		fclose(resultFile) ;
+
+		// a cluster with no peak beyond this core is complete: every later shard only finds pieces with a peak of its core
+		bool lastShard = shardNum == plan.mint_num_shards - 1 ;
+		double coreEnd = plan.mvect_boundaries[shardNum + 1] ;
+		std::pair<double, int> firstOpen(DBL_MAX, INT_MAX) ;
+		stillOpen.clear() ;
+		for (int clusterNum = 0 ; clusterNum < (int) joined.size() ; clusterNum++)
+		{
+			JoinedCluster &cluster = joined[clusterNum] ;
+			int numMembers = (int) cluster.mvect_members.size() ;
+			if (numMembers == 0)
+				continue ;
+			if (!lastShard && cluster.mdbl_max_mass >= coreEnd)
+			{
+				if (cluster.mpair_first < firstOpen)
+					firstOpen = cluster.mpair_first ;
+				stillOpen.push_back(JoinedCluster()) ;
+				std::swap(stillOpen.back(), cluster) ;
+				continue ;
+			}
+			if (numMembers < min_length)
+				continue ;
+
+			std::vector<IsotopePeak> &members = cluster.mvect_members ;
+			std::sort(members.begin(), members.end(), &SortPeaksByLine) ;
+			if (cluster.mint_anchor_line == -1)
+			{
+				// no shard saw the cluster whole: its anchor is that of a sweep over its own peaks
+				sortedMembers = members ;
+				for (int memberNum = 0 ; memberNum < numMembers ; memberNum++)
+					sortedMembers[memberNum].mint_original_index = memberNum ;
+				SortForClustering(sortedMembers) ;
+				RunArena arena ;
+				ArenaAllocator<std::pair<const int, int> > allocator(&arena) ;
+				UMCPeakMultimap umcPeaks(std::less<int>(), allocator) ;
+				vectSortedUmcIndex.assign(numMembers, -1) ;
+				vectUmcFirstPeak.clear() ;
+				SweepSortedPeaks(sortedMembers, vectSortedUmcIndex, umcPeaks, &vectUmcFirstPeak, false) ;
+				int anchorUmcNum = (*umcPeaks.begin()).first ;
+				if ((*umcPeaks.rbegin()).first != anchorUmcNum)
+					throw "The shard results do not fit together" ;
+				cluster.mint_anchor_line = sortedMembers[vectUmcFirstPeak[anchorUmcNum]].mint_line_number_in_file ;
+			}
+
+			memberOrder.resize(numMembers) ;
+			FinishedCluster finishedCluster ;
+			int anchorNum = -1 ;
+			for (int memberNum = 0 ; memberNum < numMembers ; memberNum++)
+			{
+				memberOrder[memberNum] = memberNum ;
+				finishedCluster.mvect_lines.push_back(members[memberNum].mint_line_number_in_file) ;
+				if (members[memberNum].mint_line_number_in_file == cluster.mint_anchor_line)
+					anchorNum = memberNum ;
+			}
+			if (anchorNum == -1)
+				throw "The shard results do not fit together" ;
+			SummarizeMembers(members, &memberOrder[0], numMembers, finishedCluster.mobj_umc, vect_mass) ;
+			std::pair<double, int> anchorKey(members[anchorNum].mdbl_mono_mass, cluster.mint_anchor_line) ;
+			std::swap(finished[anchorKey], finishedCluster) ;
+		}
+		joined.swap(stillOpen) ;
+		clusterOfLine.clear() ;
+		for (int clusterNum = 0 ; clusterNum < (int) joined.size() ; clusterNum++)
+		{
+			std::vector<IsotopePeak> &members = joined[clusterNum].mvect_members ;
+			for (int memberNum = 0 ; memberNum < (int) members.size() ; memberNum++)
+				clusterOfLine[members[memberNum].mint_line_number_in_file] = clusterNum ;
+		}
+
+		// an open cluster cannot have its anchor before its lightest peak
+		while (!finished.empty() && (*finished.begin()).first < firstOpen)
+		{
+			FinishedCluster &cluster = (*finished.begin()).second ;
+			PrintUMCRow(featureFile, cluster.mobj_umc, numFeatures) ;
+			featureFile.Printf("\n") ;
+			for (int lineNum = 0 ; lineNum < (int) cluster.mvect_lines.size() ; lineNum++)
+				mapFile.Printf("%d\t%d\n", numFeatures, cluster.mvect_lines[lineNum]) ;
+			numFeatures++ ;
+			finished.erase(finished.begin()) ;
+		}
+	}
+	mobj_telemetry.SetItemsProcessed(plan.mint_num_shards) ;
+
+	bool success = featureFile.Close() ;
+	success = mapFile.Close() && success ;
+	mobj_telemetry.AddBytesWritten(featureFile.GetBytesWritten() + mapFile.GetBytesWritten()) ;
+	mobj_telemetry.EndStage() ;
+	if (!success)
+		throw "Unable to write the feature files" ;
+
+	for (int shardNum = 0 ; shardNum < plan.mint_num_shards ; shardNum++)
+	{
+		GetShardResultFileName(tempFilePrefix, shardNum, fileName) ;
+		remove(fileName) ;
+	}
+	return numFeatures ;
+}
@@ -0,0 +1,243 @@
+#include "UMCPipeline.h"
+#include "BoundedQueue.h"
+#include "RunReport.h"
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+#include <exception>
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define snprintf _snprintf
+#endif
+
+// A mass bucket travelling between the stages. The creator holds the peaks and UMCs of the bucket.
+struct MassBucketWorkItem
+{
+	MassBucketResult mobj_result ;
+	UMCCreator *mobj_creator ;
+} ;
+
+typedef BoundedQueue<MassBucketWorkItem> MassBucketQueue ;
+
+// Drains whatever is left in a queue after a failure so the creators are not leaked
+static void DiscardBuckets(MassBucketQueue &queue)
+{
+	MassBucketWorkItem item ;
+	while (queue.Pop(item))
+		delete item.mobj_creator ;
+}
+
+UMCPipeline::UMCPipeline(UMCCreator *templateCreator, char *baseFileName, int min_umc_length, int queue_depth, RunReport *report)
+{
+	mobj_report = report ;
+	mobj_template = templateCreator ;
+	strcpy(mstr_base_file_name, baseFileName) ;
+	mint_min_umc_length = min_umc_length ;
+	mint_queue_depth = queue_depth > 0 ? queue_depth : 1 ;
+	mbln_merge_chunk_files = false ;
+	mint_num_duplicates = 0 ;
+}
+
+UMCPipeline::~UMCPipeline(void)
+{
+}
+
+int UMCPipeline::Run(float mono_mass_start, float mono_mass_end, float chunk_size)
+{
+	mvect_results.clear() ;
+	mint_num_duplicates = 0 ;
+	mmap_chunk_end_peaks.clear() ;
+
+	MassBucketQueue loadedQueue(mint_queue_depth) ;
+	MassBucketQueue clusteredQueue(mint_queue_depth) ;
+	MassBucketQueue summarizedQueue(mint_queue_depth) ;
+
+	std::exception_ptr loaderError ;
+	std::exception_ptr clusterError ;
+	std::exception_ptr summaryError ;
+
+	// Loader: one ReadCSVFile per mass bucket, stops at the first empty bucket
+	std::thread loader([&]()
+	{
+		MassBucketWorkItem item ;
+		item.mobj_creator = NULL ;
+		try
+		{
+			double chunkStart = mono_mass_start ;
+			int chunkIndex = 0 ;
+			while (chunkStart + chunk_size <= mono_mass_end)
+			{
+				item.mobj_creator = new UMCCreator(*mobj_template) ;
+				item.mobj_creator->Reset() ;
+				item.mobj_creator->GetTelemetry().SetParent(&mobj_template->GetTelemetry()) ;
+				item.mobj_creator->SetMassRange((float) chunkStart, (float) (chunkStart + chunk_size)) ;
+
+				item.mobj_result.mint_chunk_index = chunkIndex ;
+				item.mobj_result.mflt_mono_mass_start = (float) chunkStart ;
+				item.mobj_result.mflt_mono_mass_end = (float) (chunkStart + chunk_size) ;
+				item.mobj_result.mint_num_umcs = 0 ;
+				item.mobj_result.mint_feature_start_index = 0 ;
+				item.mobj_result.mbln_written = false ;
+
+				chunkStart += chunk_size ;
+
+				item.mobj_result.mint_num_peaks = item.mobj_creator->ReadCSVFile() ;
+				if (item.mobj_result.mint_num_peaks == 0 || !loadedQueue.Push(item))
+				{
+					delete item.mobj_creator ;
+					item.mobj_creator = NULL ;
+					break ;
+				}
+				item.mobj_creator = NULL ;
+				chunkIndex++ ;
+			}
+		}
+		catch (...)
+		{
+			loaderError = std::current_exception() ;
+			delete item.mobj_creator ;
+		}
+		loadedQueue.Close() ;
+	}) ;
+
+	// Clusterer
+	std::thread clusterer([&]()
+	{
+		MassBucketWorkItem item ;
+		item.mobj_creator = NULL ;
+		try
+		{
+			while (loadedQueue.Pop(item))
+			{
+				item.mobj_creator->CreateUMCsSinglyLinkedWithAll() ;
+				if (!clusteredQueue.Push(item))
+					delete item.mobj_creator ;
+				item.mobj_creator = NULL ;
+			}
+		}
+		catch (...)
+		{
+			clusterError = std::current_exception() ;
+			delete item.mobj_creator ;
+			loadedQueue.Close() ;
+			DiscardBuckets(loadedQueue) ;
+		}
+		clusteredQueue.Close() ;
+	}) ;
+
+	// Summarizer
+	std::thread summarizer([&]()
+	{
+		MassBucketWorkItem item ;
+		item.mobj_creator = NULL ;
+		try
+		{
+			while (clusteredQueue.Pop(item))
+			{
+				item.mobj_creator->RemoveShortUMCs(mint_min_umc_length) ;
+				item.mobj_creator->CalculateUMCs() ;
+				item.mobj_result.mint_num_umcs = item.mobj_creator->GetNumUmcs() ;
+				if (!summarizedQueue.Push(item))
+					delete item.mobj_creator ;
+				item.mobj_creator = NULL ;
+			}
+		}
+		catch (...)
+		{
+			summaryError = std::current_exception() ;
+			delete item.mobj_creator ;
+			clusteredQueue.Close() ;
+			DiscardBuckets(clusteredQueue) ;
+		}
+		summarizedQueue.Close() ;
+	}) ;
+
+	// Writer runs here; buckets arrive in chunk order so feature numbering matches the serial loop.
+	// Progress is published on the telemetry of the template, one item per planned bucket.
+	int numBuckets = 0 ;
+	if (chunk_size > 0)
+	{
+		for (double chunkStart = mono_mass_start ; chunkStart + chunk_size <= mono_mass_end ; chunkStart += chunk_size)
+			numBuckets++ ;
+	}
+	ProgressTelemetry &progress = mobj_template->GetTelemetry() ;
+	progress.BeginStage(STAGE_WRITING, numBuckets) ;
+
+	std::exception_ptr writerError ;
+	int numUmcs = 0 ;
+	// room for the base name and the chunk suffix
+	char chunkFileName[1100] ;
+	MassBucketWorkItem item ;
+	item.mobj_creator = NULL ;
+	try
+	{
+		while (summarizedQueue.Pop(item))
+		{
+			snprintf(chunkFileName, sizeof(chunkFileName), "%s_chunk%d", mstr_base_file_name, item.mobj_result.mint_chunk_index) ;
+			item.mobj_result.mint_feature_start_index = numUmcs ;
+			item.mobj_result.mbln_written = item.mobj_creator->CreateFeatureFiles(chunkFileName, numUmcs) ;
+			numUmcs += item.mobj_result.mint_num_umcs ;
+			mvect_results.push_back(item.mobj_result) ;
+			if (mbln_merge_chunk_files)
+				item.mobj_creator->AddChunkEndPeaks(item.mobj_result.mflt_mono_mass_start, item.mobj_result.mflt_mono_mass_end, mmap_chunk_end_peaks) ;
+			if (mobj_report != NULL)
+				mobj_report->AddTelemetry(item.mobj_creator->GetTelemetry()) ;
+			delete item.mobj_creator ;
+			item.mobj_creator = NULL ;
+			progress.SetItemsProcessed((long long) mvect_results.size()) ;
+		}
+	}
+	catch (...)
+	{
+		// closing every queue stops the other stages, which must be joined before the exception leaves Run
+		writerError = std::current_exception() ;
+		delete item.mobj_creator ;
+		loadedQueue.Close() ;
+		clusteredQueue.Close() ;
+		summarizedQueue.Close() ;
+		DiscardBuckets(loadedQueue) ;
+		DiscardBuckets(summarizedQueue) ;
+	}
+
+	loader.join() ;
+	clusterer.join() ;
+	summarizer.join() ;
+
+	if (writerError)
+	{
+		DiscardBuckets(loadedQueue) ;
+		DiscardBuckets(clusteredQueue) ;
+		DiscardBuckets(summarizedQueue) ;
+	}
+	if (loaderError || clusterError || summaryError || writerError)
+		progress.EndStage() ;
+	if (loaderError)
+		std::rethrow_exception(loaderError) ;
+	if (clusterError)
+		std::rethrow_exception(clusterError) ;
+	if (summaryError)
+		std::rethrow_exception(summaryError) ;
+	if (writerError)
+		std::rethrow_exception(writerError) ;
+
+	// a chunk that could not be written leaves its files to look at
+	bool allWritten = true ;
+	std::vector<float> chunkEnds ;
+	for (int chunkNum = 0 ; chunkNum < (int) mvect_results.size() ; chunkNum++)
+	{
+		allWritten = allWritten && mvect_results[chunkNum].mbln_written ;
+		chunkEnds.push_back(mvect_results[chunkNum].mflt_mono_mass_end) ;
+	}
+	if (mbln_merge_chunk_files && allWritten)
+	{
+		UMCCreator merger(*mobj_template) ;
+		merger.GetTelemetry().SetParent(&mobj_template->GetTelemetry()) ;
+		numUmcs = merger.MergeChunkFeatureFiles(mstr_base_file_name, chunkEnds, mmap_chunk_end_peaks, true, mint_num_duplicates) ;
+		mmap_chunk_end_peaks.clear() ;
+		if (mobj_report != NULL)
+			mobj_report->AddTelemetry(merger.GetTelemetry()) ;
+	}
+	progress.EndStage() ;
+
+	return numUmcs ;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include "UMCCreator.h"
+#include <vector>
+#include <map>
+
+class RunReport ;
+
+// Summary of one mass bucket once it has gone through every stage of the pipeline
+struct MassBucketResult
+{
+	int mint_chunk_index ;
+	float mflt_mono_mass_start ;
+	float mflt_mono_mass_end ;
+	int mint_num_peaks ;
+	int mint_num_umcs ;
+	int mint_feature_start_index ;
+	bool mbln_written ;
+} ;
+
+/*
+ * Runs the chunked (mass bucket) feature finding as four concurrent stages:
+ *		loader -> clusterer -> summarizer -> writer
+ * Each stage works on its own UMCCreator copy of the template, and the stages are connected by
+ * bounded queues so that at most queue_depth buckets wait between any two stages.
+ * Chunk N+1 is therefore read while chunk N is being clustered and written, and peak memory
+ * is capped by the queue depth instead of growing with the number of chunks.
+ * The counters of every bucket are added to the telemetry of the template as well (ProgressTelemetry::SetParent),
+ * and the writer reports the written buckets there.
+ *
+ * Output files and feature numbering are identical to processing the chunks one after the other:
+ * the writer runs on the calling thread and receives the buckets in chunk order.
+ */
+class UMCPipeline
+{
+	UMCCreator *mobj_template ;
+	char mstr_base_file_name[1024] ;
+	int mint_min_umc_length ;
+	int mint_queue_depth ;
+	std::vector<MassBucketResult> mvect_results ;
+	RunReport *mobj_report ;
+	bool mbln_merge_chunk_files ;
+	int mint_num_duplicates ;
+	// peaks of the features at the chunk ends, for joining them when the chunk files are merged
+	std::map<int, IsotopePeak> mmap_chunk_end_peaks ;
+
+public:
+	// When report is given, the telemetry of every bucket is folded into it once the bucket has been written
+	UMCPipeline(UMCCreator *templateCreator, char *baseFileName, int min_umc_length, int queue_depth, RunReport *report = NULL) ;
+	~UMCPipeline(void) ;
+
+	// Processes mass buckets of chunk_size Da starting at mono_mass_start until a bucket would go past
+	// mono_mass_end or a bucket has no peaks. Returns the total number of features written.
+	int Run(float mono_mass_start, float mono_mass_end, float chunk_size) ;
+
+	// When set, Run finishes by streaming the files of the chunks into the feature file and peak map of the whole run
+	// (UMCCreator::MergeChunkFeatureFiles) and removes them; the features that meet at a chunk end are joined
+	void SetMergeChunkFiles(bool merge) { mbln_merge_chunk_files = merge ; } ;
+	int GetNumDuplicateFeatures() { return mint_num_duplicates ; } ;
+
+	std::vector<MassBucketResult> & GetResults() { return mvect_results ; } ;
+};
@@ -0,0 +1,261 @@
+#include "WorkStealingPool.h"
+#include "ProcessStats.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <chrono>
+
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define POOL_THREAD_LOCAL __declspec(thread)
+#else
+#define POOL_THREAD_LOCAL thread_local
+#endif
+
+// Pool and queue index of the worker running on this thread; lets Run() tell nested calls from outside calls
+static POOL_THREAD_LOCAL void *gobj_current_pool = 0 ;
+static POOL_THREAD_LOCAL int gint_worker_index = -1 ;
+
+namespace
+{
+	struct TaskGroup
+	{
+		std::mutex mobj_mutex ;
+		std::condition_variable mobj_done ;
+		std::atomic<int> mint_pending ;
+		std::exception_ptr mobj_error ;
+		// thread waiting in Run(), and the CPU seconds the tasks of the group took on the other threads
+		std::thread::id mobj_owner ;
+		double mdbl_cpu_seconds ;
+	} ;
+
+	struct PoolTask
+	{
+		std::function<void()> *mfn_task ;
+		TaskGroup *mobj_group ;
+	} ;
+
+	struct TaskQueue
+	{
+		std::mutex mobj_mutex ;
+		std::deque<PoolTask> mdeque_tasks ;
+	} ;
+}
+
+struct WorkStealingPool::Impl
+{
+	std::vector<TaskQueue*> mvect_queues ;		// one per worker
+	TaskQueue mobj_shared_queue ;				// tasks started from outside the pool
+	std::vector<std::thread> mvect_threads ;
+	std::mutex mobj_wake_mutex ;
+	std::condition_variable mobj_wake ;
+	std::atomic<int> mint_num_queued ;
+	bool mbln_stopping ;
+
+	bool TryTake(int workerIndex, bool includeShared, PoolTask &task) ;
+	void Execute(PoolTask &task) ;
+	void WorkerLoop(int workerIndex) ;
+	void WakeWorkers() ;
+} ;
+
+static bool TakeFront(TaskQueue &queue, PoolTask &task)
+{
+	std::lock_guard<std::mutex> lock(queue.mobj_mutex) ;
+	if (queue.mdeque_tasks.empty())
+		return false ;
+	task = queue.mdeque_tasks.front() ;
+	queue.mdeque_tasks.pop_front() ;
+	return true ;
+}
+
+static bool TakeBack(TaskQueue &queue, PoolTask &task)
+{
+	std::lock_guard<std::mutex> lock(queue.mobj_mutex) ;
+	if (queue.mdeque_tasks.empty())
+		return false ;
+	task = queue.mdeque_tasks.back() ;
+	queue.mdeque_tasks.pop_back() ;
+	return true ;
+}
+
+bool WorkStealingPool::Impl::TryTake(int workerIndex, bool includeShared, PoolTask &task)
+{
+	int numQueues = (int) mvect_queues.size() ;
+	bool found = false ;
+
+	// newest own task first (its data is still in cache), then the oldest task of another worker,
+	// then the next task started from outside
+	if (workerIndex >= 0)
+		found = TakeBack(*mvect_queues[workerIndex], task) ;
+	for (int offset = 1 ; !found && offset <= numQueues ; offset++)
+	{
+		int victim = ((workerIndex < 0 ? 0 : workerIndex) + offset) % numQueues ;
+		if (victim != workerIndex)
+			found = TakeFront(*mvect_queues[victim], task) ;
+	}
+	if (!found && includeShared)
+		found = TakeFront(mobj_shared_queue, task) ;
+
+	if (found)
+		mint_num_queued-- ;
+	return found ;
+}
+
+void WorkStealingPool::Impl::Execute(PoolTask &task)
+{
+	TaskGroup *group = task.mobj_group ;
+	bool ownTask = group->mobj_owner == std::this_thread::get_id() ;
+	double startCpu = ownTask ? 0 : GetThreadWorkCpuSeconds() ;
+	std::exception_ptr error ;
+	try
+	{
+		(*task.mfn_task)() ;
+	}
+	catch (...)
+	{
+		error = std::current_exception() ;
+	}
+
+	// a task of another thread's group is that thread's work: its CPU time (with the pool tasks it waited for)
+	// goes to the group and comes off the work time of this thread
+	double cpuSeconds = 0 ;
+	if (!ownTask)
+	{
+		cpuSeconds = GetThreadWorkCpuSeconds() - startCpu ;
+		AddThreadWorkCpuSeconds(-cpuSeconds) ;
+	}
+
+	// the waiter may free the group as soon as it sees zero, so the count drops under the lock
+	std::lock_guard<std::mutex> lock(group->mobj_mutex) ;
+	if (error && !group->mobj_error)
+		group->mobj_error = error ;
+	group->mdbl_cpu_seconds += cpuSeconds ;
+	if (--group->mint_pending == 0)
+		group->mobj_done.notify_all() ;
+}
+
+void WorkStealingPool::Impl::WorkerLoop(int workerIndex)
+{
+	gobj_current_pool = this ;
+	gint_worker_index = workerIndex ;
+
+	PoolTask task ;
+	while (true)
+	{
+		if (TryTake(workerIndex, true, task))
+		{
+			Execute(task) ;
+			continue ;
+		}
+
+		std::unique_lock<std::mutex> lock(mobj_wake_mutex) ;
+		while (!mbln_stopping && mint_num_queued.load() == 0)
+			mobj_wake.wait(lock) ;
+		if (mbln_stopping && mint_num_queued.load() == 0)
+			return ;
+	}
+}
+
+void WorkStealingPool::Impl::WakeWorkers()
+{
+	std::lock_guard<std::mutex> lock(mobj_wake_mutex) ;
+	mobj_wake.notify_all() ;
+}
+
+WorkStealingPool::WorkStealingPool(int numThreads)
+{
+	if (numThreads <= 0)
+		numThreads = GetHardwareThreads() ;
+
+	mobj_impl = new Impl() ;
+	mobj_impl->mint_num_queued = 0 ;
+	mobj_impl->mbln_stopping = false ;
+	for (int threadNum = 0 ; threadNum < numThreads ; threadNum++)
+		mobj_impl->mvect_queues.push_back(new TaskQueue()) ;
+	for (int threadNum = 0 ; threadNum < numThreads ; threadNum++)
+		mobj_impl->mvect_threads.push_back(std::thread(&Impl::WorkerLoop, mobj_impl, threadNum)) ;
+}
+
+WorkStealingPool::~WorkStealingPool(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(mobj_impl->mobj_wake_mutex) ;
+		mobj_impl->mbln_stopping = true ;
+		mobj_impl->mobj_wake.notify_all() ;
+	}
+	for (int threadNum = 0 ; threadNum < (int) mobj_impl->mvect_threads.size() ; threadNum++)
+		mobj_impl->mvect_threads[threadNum].join() ;
+	for (int queueNum = 0 ; queueNum < (int) mobj_impl->mvect_queues.size() ; queueNum++)
+		delete mobj_impl->mvect_queues[queueNum] ;
+	delete mobj_impl ;
+}
+
+int WorkStealingPool::GetNumThreads() const
+{
+	return (int) mobj_impl->mvect_threads.size() ;
+}
+
+int WorkStealingPool::GetHardwareThreads()
+{
+	int numThreads = (int) std::thread::hardware_concurrency() ;
+	return numThreads > 0 ? numThreads : 1 ;
+}
+
+void WorkStealingPool::Run(std::vector<std::function<void()> > &tasks)
+{
+	if (tasks.empty())
+		return ;
+
+	TaskGroup group ;
+	group.mint_pending = (int) tasks.size() ;
+	group.mobj_owner = std::this_thread::get_id() ;
+	group.mdbl_cpu_seconds = 0 ;
+
+	bool isWorker = gobj_current_pool == mobj_impl ;
+	TaskQueue &queue = isWorker ? *mobj_impl->mvect_queues[gint_worker_index] : mobj_impl->mobj_shared_queue ;
+	mobj_impl->mint_num_queued += (int) tasks.size() ;
+	{
+		std::lock_guard<std::mutex> lock(queue.mobj_mutex) ;
+		for (int taskNum = 0 ; taskNum < (int) tasks.size() ; taskNum++)
+		{
+			PoolTask task ;
+			task.mfn_task = &tasks[taskNum] ;
+			task.mobj_group = &group ;
+			// the owner takes from the back, so push in reverse to start with the first task
+			if (isWorker)
+				queue.mdeque_tasks.push_front(task) ;
+			else
+				queue.mdeque_tasks.push_back(task) ;
+		}
+	}
+	mobj_impl->WakeWorkers() ;
+
+	if (isWorker)
+	{
+		// a worker waiting on its own sub-tasks keeps working instead of blocking a thread; it does not start
+		// new outside work (another dataset) though, which would hold up the group it is waiting for.
+		// With nothing left to take, the rest of the group is running on other workers: it sleeps until the group
+		// is done, looking again now and then for tasks those workers queue meanwhile.
+		PoolTask task ;
+		while (group.mint_pending.load() > 0)
+		{
+			if (mobj_impl->TryTake(gint_worker_index, false, task))
+			{
+				mobj_impl->Execute(task) ;
+				continue ;
+			}
+			std::unique_lock<std::mutex> lock(group.mobj_mutex) ;
+			if (group.mint_pending.load() > 0)
+				group.mobj_done.wait_for(lock, std::chrono::milliseconds(1)) ;
+		}
+	}
+
+	std::unique_lock<std::mutex> lock(group.mobj_mutex) ;
+	while (group.mint_pending.load() > 0)
+		group.mobj_done.wait(lock) ;
+	AddThreadWorkCpuSeconds(group.mdbl_cpu_seconds) ;
+	if (group.mobj_error)
+		std::rethrow_exception(group.mobj_error) ;
+}
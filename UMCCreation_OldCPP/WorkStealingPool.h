@@ -0,0 +1,34 @@
+#pragma once
+#include <functional>
+#include <vector>
+
+/*
+ * Fixed set of worker threads shared by everything a batch runs (dataset loads, clustering, parallel parsing).
+ * Run() takes a group of tasks and returns when all of them have finished. Called from a worker, it works on
+ * pending tasks of the pool while it waits, so a task may itself call Run() (a big dataset splitting its load
+ * into blocks) without tying up a worker; called from any other thread, it blocks until the workers are done.
+ * Tasks started from outside the pool go to a shared FIFO, so they start in the order given; tasks started from
+ * a worker go to that worker's own deque, and idle workers steal from the other end of busy workers' deques.
+ * The first exception thrown by a task of a group is rethrown by Run() once the whole group is done.
+ * The CPU time the tasks of a group take on other threads is added to the thread that called Run()
+ * (GetThreadWorkCpuSeconds), so the telemetry stage that waited for them counts it.
+ * The threading types live in WorkStealingPool.cpp so that the header can be included by /clr code.
+ */
+class WorkStealingPool
+{
+	struct Impl ;
+	Impl *mobj_impl ;
+
+	WorkStealingPool(const WorkStealingPool &) ;
+	WorkStealingPool & operator=(const WorkStealingPool &) ;
+
+public:
+	// numThreads <= 0 uses one thread per hardware thread
+	WorkStealingPool(int numThreads) ;
+	~WorkStealingPool(void) ;
+
+	int GetNumThreads() const ;
+	void Run(std::vector<std::function<void()> > &tasks) ;
+
+	static int GetHardwareThreads() ;
+};
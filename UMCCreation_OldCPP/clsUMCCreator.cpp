@@ -1,534 +1,792 @@
-//This is the main DLL file.
-
-#include "clsUMCCreator.h"
-#include "IniReader.h"
-#using <mscorlib.dll>
-
-namespace UMCCreation
-{
-	void GetStr(System::String *src, char *dest)
-	{
-		if (src == 0 || src == "" || src->get_Length() == 0)
-		{
-			dest[0] = '\0' ; 
-			return ; 
-		}
-
-		int len = src->get_Length() ; 
-		for (int i = 0 ; i < len ; i++)
-		{
-			dest[i] = (char) src->Chars[i] ; 
-		}
-		dest[len] = '\0' ; 
-	}
-
-	clsUMCCreator::clsUMCCreator()
-	{
-		mobj_umc_creator = new UMCCreator() ; 
-	}
-
-
-	clsUMCCreator::~clsUMCCreator()
-	{
-		if (mobj_umc_creator != NULL)
-			delete mobj_umc_creator ; 
-	}
-
-	void clsUMCCreator::ResetStatus()
-	{
-		menm_status = IDLE ; 
-		mobj_umc_creator->Reset() ; 
-	}
-
-	
-
-	bool clsUMCCreator::LoadProgramOptions(){
-		char settings_file[1024];
-		char logText[1024];
-		bool success = false;
-
-		GetStr(mstr_options_name, settings_file);
-		CIniReader iniReader(settings_file);
-
-		//first load incoming and outgoing filenames and folder options
-		char *isos_file = iniReader.ReadString("Files", "InputFileName", "");
-		char *output_dir = iniReader.ReadString("Files", "OutputDirectory", ".");
-		mobj_umc_creator->SetInputFileName(isos_file);
-		mobj_umc_creator->SetOutputDiretory(output_dir);
-
-		mstr_baseFileName = CreateBaseFileName(output_dir, isos_file);
-
-		createLogFile();
-
-		strcpy(logText, "Loading settings from INI file: ");
-		strcat(logText, settings_file);
-		log(logText);
-		
-		//next load data filters
-		float isotopicFit = iniReader.ReadFloat("DataFilters", "MaxIsotopicFit", 1);
-		if ( isotopicFit == 0 ){
-			isotopicFit = 1;
-		}
-
-		int intensityFilter = iniReader.ReadInteger("DataFilters", "MinimumIntensity", 500);
-		mflt_mono_mass_start = iniReader.ReadFloat("DataFilters", "MonoMassStart", 0);
-		mflt_mono_mass_end = iniReader.ReadFloat("DataFilters", "MonoMassEnd", FLT_MAX);
-		mbln_process_chunks = iniReader.ReadBoolean("DataFilters", "ProcessDataInChunks", false);
-
-		//mint_mono_mass_overlap = iniReader.ReadInteger("DataFilters", "MonoMassSegmentOverlapDa", 2);
-		if ( mflt_mono_mass_end == 0){
-			if (mbln_process_chunks){
-				mflt_mono_mass_end = mflt_mono_mass_start + 250;
-			}
-		}
-		
-		int maxPoints = iniReader.ReadInteger("DataFilters", "MaxDataPointsPerChunk", INT_MAX);
-		if ( maxPoints == 0){
-			maxPoints = INT_MAX;
-		}
-
-		int chunkSize = iniReader.ReadInteger("DataFilters", "ChunkSize", 3000);
-		if (chunkSize == 0){
-			chunkSize = 3000;
-		}
-		
-		int imsMinScan = iniReader.ReadInteger("DataFilters", "IMSMinScan", 0);
-
-		int imsMaxScan = iniReader.ReadInteger("DataFilters", "IMSMaxScan", 50000);
-		if (imsMaxScan == 0 ){
-			imsMaxScan = INT_MAX;
-		}
-
-		int lcMinScan = iniReader.ReadInteger("DataFilters", "LCMinScan", 0);
-		int lcMaxScan = iniReader.ReadInteger("DataFilters", "LCMaxScan", 50000);
-		if (lcMaxScan == 0){
-			lcMaxScan = INT_MAX;
-		}
-
-		mobj_umc_creator->SetFilterOptions(isotopicFit, intensityFilter, lcMinScan, lcMaxScan, imsMinScan, imsMaxScan, mflt_mono_mass_start, mflt_mono_mass_end, mbln_process_chunks, maxPoints, mint_mono_mass_overlap, chunkSize);
-
-		//next load the UMC creation options
-		float monoMassWeight = iniReader.ReadFloat("UMCCreationOptions", "MonoMassWeight", 0.01);
-		float monoMassConstraint = iniReader.ReadFloat("UMCCreationOptions", "MonoMassConstraint", 50);
-		bool monoMassPPM = iniReader.ReadBoolean("UMCCreationOptions", "MonoMassConstraintIsPPM", true);
-		float imsDriftWeight = iniReader.ReadFloat("UMCCreationOptions","IMSDriftTimeWeight", 0.1);
-		float logAbundanceWeight = iniReader.ReadFloat("UMCCreationOptions", "LogAbundanceWeight", 0.1);
-		float netWeight = iniReader.ReadFloat("UMCCreationOptions", "NETWeight", 0.01);
-		float fitWeight = iniReader.ReadFloat("UMCCreationOptions", "FitWeight", 0.01);
-		float avgMassWeight = iniReader.ReadFloat("UMCCreationOptions", "AvgMassWeight", 0.01);
-		float avgMassConstr = iniReader.ReadFloat("UMCCreationOptions", "AvgMassConstraint", 10);
-		bool avgMassPPM = iniReader.ReadBoolean("UMCCreationOptions", "AvgMassConstraintIsPPM", true);
-		float scanWeight = iniReader.ReadFloat("UMCCreationOptions", "ScanWeight", 0);
-		float maxDist = iniReader.ReadFloat("UMCCreationOptions", "MaxDistance", 0.1);
-		bool useGeneric = iniReader.ReadBoolean("UMCCreationOptions", "UseGenericNET", true);
-		mint_min_umc_length = iniReader.ReadInteger("UMCCreationOptions", "MinFeatureLengthPoints", 2);
-		bool useCharge = iniReader.ReadBoolean("UMCCreationOptions", "UseCharge", false);
-
-		//this one is not sent over for now
-		bool useWeightedEuclidean = iniReader.ReadBoolean("UMCCreationOptions", "UseWeightedEuclidean", false);
-
-		log("Data Filters - ");
-		log(" Minimum LC scan = ", lcMinScan);
-		log(" Maximum LC scan = ", lcMaxScan);
-		log(" Minimum IMS scan = ", imsMinScan);
-		log(" Maximum IMS scan = ", imsMaxScan);
-		log(" Maximum fit = ", isotopicFit);
-		log(" Minimum intensity = ", intensityFilter);
-		log(" Mono mass start = ", mflt_mono_mass_start);
-		log(" Mono mass end = ", mflt_mono_mass_end);
-		log(" Require matching charge state = ", useCharge);
-
-		//load all the umc creation options
-		mobj_umc_creator->SetOptionsEx(monoMassWeight,monoMassConstraint, monoMassPPM, avgMassWeight,avgMassConstr, avgMassPPM, logAbundanceWeight, scanWeight, netWeight, fitWeight, maxDist, useGeneric, imsDriftWeight, useCharge);
-
-		return success;
-	}
-
-	/**
-	 * Calls methods for creating UMCs and writing them to files
-	 */
-	bool clsUMCCreator::PrintUMCsToFile(){
-		bool success = false;
-
-		char baseFileName[1024];
-
-		GetStr(mstr_baseFileName, baseFileName);
-		success = mobj_umc_creator->CreateFeatureFiles(baseFileName);
-
-		return success;		
-	}
-
-	/**
-	 * This overloaded version of the method is used to support chunking
-	 *		- Chunking was only thought to be necessary because we ran out of memory on 32-bit machines.
-	 *		- Running this program on a 64-bit machine with enough memory will allow it to process very large isos files
-	 */
-	bool clsUMCCreator::PrintUMCsToFile(int chunkIndex, int featureStartIndex){
-		bool success = false;
-		
-		char baseFileName[1024];
-		char chunk[1024];
-
-		itoa(chunkIndex, chunk, 10);
-
-		GetStr(mstr_baseFileName, baseFileName);
-		strcat(baseFileName, "_chunk");
-		strcat(baseFileName, chunk);
-
-		success = mobj_umc_creator->CreateFeatureFiles(baseFileName, featureStartIndex);
-
-		return success;		
-	}
-
-	/**
-	Anuj added this method to load all the necessary details for the LC ms feature finder
-	Program options, data filters and output directories are all loaded here
-	The file is read and data filters applied and finally UMCs are found.
-	*/
-	void clsUMCCreator::LoadFindUMCs(){
-		menm_status = LOADING;
-		LoadProgramOptions();
-
-		if ( mbln_process_chunks )
-		{
-			double mflt_mono_mass_chunk_start = mflt_mono_mass_start;
-			float chunk_size = mobj_umc_creator->GetSegmentSize();
-			
-			bool objectsSerialized = false;
-			log("Processing with Chunks ...");
-			int iChunk = 0;
-			int UMC_count = 0;
-
-			while ( menm_status != COMPLETE ){
-				//here's where you need to read a file process maxPoints and then continue from where you left off
-				menm_status = CHUNKING;
-
-				//here's where we have to figuure out how to laod the isos sqlite database file into the mvect_isotope_peaks
-				//vector using custom reading code. Once we have that information, we can process the rest of the data as is
-				//and write the UMC's out to the final output file. We can create the output file in APPEND mode if necessary
-
-				menm_status = LOADING;
-				if (mflt_mono_mass_chunk_start + chunk_size > mflt_mono_mass_end)
-				{
-					menm_status= COMPLETE;
-					continue;
-				}
-
-				//set the range of mass in which we'll operate
-				mobj_umc_creator->SetMassRange(mflt_mono_mass_chunk_start, mflt_mono_mass_chunk_start + chunk_size);
-				
-				//instead of READCSV, here's where we need to read from the sqLite database and get a list of peaks
-				//also you need to do this read in such a manner that you get close to the maxPoints per segment range
-				//int numPeaks = mobj_umc_creator->LoadPeaksFromDatabase();
-				
-				mflt_mono_mass_chunk_start = mflt_mono_mass_chunk_start + chunk_size;
-				log("Processing one Chunk");
-				int numPeaks = mobj_umc_creator->ReadCSVFile();
-
-				log("Total number of peaks we'll consider = ", numPeaks); 
-				if (numPeaks == 0){
-					menm_status= COMPLETE;
-					log("Nothing read in");
-					continue;
-				}
-
-				//if ( false ){
-				//since mbln_process is true, the file reading will stop when it has loaded maxPoints of peaks that pass filters
-				//so the mono mass of the last peak loaded will be the end mass 
-				menm_status = CLUSTERING;
-				mobj_umc_creator->CreateUMCsSinglyLinkedWithAll();
-				menm_status = SUMMARIZING;
-				
-				mstr_message = new System::String("Filtering out short clusters") ; 
-				mobj_umc_creator->RemoveShortUMCs(mint_min_umc_length) ;
-				mstr_message = new System::String("Calculating UMC statistics") ; 
-				mobj_umc_creator->CalculateUMCs() ;
-
-				//now here's where we'll have to perform some magic of writing to temporary files and reloading those files in 
-				//conjunction with loading data from the original isos files. The isos file data can be directly loaded using ReadCSV
-				//but it'll have to stack the peaks on top of existing UMC peaks. Maybe we could just serialize all objects
-				//to a temporary file and reload from there? Something to consider
-				// mobj_umc_creator->SerializeObjects();
-				// objectsSerialized = true;
-				
-				PrintUMCsToFile(iChunk, UMC_count);
-				UMC_count += mobj_umc_creator->GetNumUmcs();
-				//}
-				iChunk++;
-			}
-
-			// Combine several partial UMC files into one file.
-
-		} 
-		else 
-		{
-			log("Processing without Chunks...");
-			menm_status = LOADING;
-			int numPeaks = mobj_umc_creator->ReadCSVFile();
-			log("Total number of peaks we'll consider = ", numPeaks);
-
-			menm_status = CLUSTERING;
-			log("Creating UMCs...");
-			mobj_umc_creator->CreateUMCsSinglyLinkedWithAll();
-
-			menm_status = SUMMARIZING;
-			log("Filtering out short UMCs...");
-			mobj_umc_creator->RemoveShortUMCs(mint_min_umc_length);
-
-			log("Calculating UMC statistics...");
-			mobj_umc_creator->CalculateUMCs();
-			menm_status = COMPLETE;
-
-			log("Total number of UMCs = ", mobj_umc_creator->GetNumUmcs());
-
-			log("Writing output files...");
-			PrintUMCsToFile();
-		}
-
-		fclose(mfile_logFile);
-	
-	}
-
-	void clsUMCCreator::FindUMCs()
-	{
-		menm_status = CLUSTERING ; 
-		mstr_message = new System::String("Clustering Isotope Peaks") ; 
-		mobj_umc_creator->CreateUMCsSinglyLinkedWithAll(); 
-		menm_status = SUMMARIZING ; 
-		mstr_message = new System::String("Filtering out short clusters") ; 
-		mobj_umc_creator->RemoveShortUMCs(mint_min_umc_length) ;
-		mstr_message = new System::String("Calculating UMC statistics") ; 
-		mobj_umc_creator->CalculateUMCs() ;
-		menm_status = COMPLETE ; 
-	}
-
-	void clsUMCCreator::LoadFindUMCs(bool is_pek_file)
-	{
-		Console::WriteLine(S"Loading UMCs") ; 
-		char file_name[512] ; 
-		
-		GetStr(mstr_file_name, file_name) ; 
-		menm_status = LOADING ;
-
-		if (is_pek_file)
-		{
-			mstr_message = new System::String("Loading PEK file") ; 
-			mobj_umc_creator->ReadPekFileMemoryMapped(file_name) ; 
-		}
-		else
-		{
-			mstr_message = new System::String("Loading CSV file") ; 
-			Console::WriteLine(mstr_message);
-			mobj_umc_creator->ReadCSVFile(file_name) ; 
-		}
-
-		menm_status = CLUSTERING ; 
-		mstr_message = new System::String("Clustering Isotope Peaks") ; 
-		mobj_umc_creator->CreateUMCsSinglyLinkedWithAll() ; 
-		menm_status = SUMMARIZING ; 
-		mstr_message = new System::String("Filtering out short clusters") ; 
-		mobj_umc_creator->RemoveShortUMCs(mint_min_umc_length) ;
-		mstr_message = new System::String("Calculating UMC statistics") ; 
-		mobj_umc_creator->CalculateUMCs() ;
-	}
-
-	void clsUMCCreator::LoadFindUMCsPEK()
-	{
-		LoadFindUMCs(true) ; 
-		menm_status = COMPLETE ; 
-	}
-
-	void clsUMCCreator::LoadFindUMCsCSV()
-	{
-		LoadFindUMCs(false) ; 
-		menm_status = COMPLETE ; 
-	}
-
-	int clsUMCCreator::GetUmcMapping(int (&isotope_peaks_index) __gc[], int (&umc_index) __gc[])
-	{
-		int numMappings = mobj_umc_creator->mmultimap_umc_2_peak_index.size() ; 
-		isotope_peaks_index = new int __gc [numMappings] ; 
-		umc_index = new int __gc [numMappings] ; 
-
-		int mappingNum = 0 ; 
-		for (std::multimap<int,int>::iterator iter = mobj_umc_creator->mmultimap_umc_2_peak_index.begin() ; iter != mobj_umc_creator->mmultimap_umc_2_peak_index.end() ; iter++)
-		{
-			int currentUmcNum = (*iter).first ; 
-			int pkIndex = (*iter).second ; 
-			isotope_peaks_index[mappingNum] = pkIndex ; 
-			umc_index[mappingNum] = currentUmcNum ; 
-			mappingNum++ ; 
-		}
-		return numMappings ; 
-	}
-
-	UMCManipulation::clsUMC* clsUMCCreator::GetUMCs()[]
-	{
-		int numUmcs = mobj_umc_creator->GetNumUmcs(); 
-		UMCManipulation::clsUMC* arr_umcs __gc[] ; 
-		arr_umcs = new UMCManipulation::clsUMC* __gc [numUmcs] ; 
-		
-		for (int umcNum = 0 ; umcNum < numUmcs ; umcNum++)
-		{
-			UMC umc = mobj_umc_creator->mvect_umcs[umcNum] ; 
-			UMCManipulation::clsUMC *newUmc = __gc new UMCManipulation::clsUMC() ;
-			newUmc->mdbl_abundance = umc.mdbl_sum_abundance ; 
-
-			newUmc->mdbl_class_rep_mz = (double) umc.mdbl_class_rep_mz ; 
-			newUmc->mdbl_mono_mass = (double) umc.mdbl_median_mono_mass ; 
-			newUmc->mdbl_mono_mass_calibrated = newUmc->mdbl_mono_mass ; 
-
-			newUmc->mint_scan = umc.mint_max_abundance_scan ; 
-			newUmc->mint_start_scan = umc.mint_start_scan ; 
-			newUmc->mint_end_scan = umc.mint_stop_scan ; 
-
-			newUmc->mdbl_net = (double) umc.mint_max_abundance_scan ; 
-            if (mobj_umc_creator->mint_lc_max_scan > mobj_umc_creator->mint_lc_min_scan) {
-			     // Compute Generic NET value
-			     newUmc->mdbl_net = (double) (umc.mint_max_abundance_scan - mobj_umc_creator->mint_lc_min_scan) * 1.0 / (mobj_umc_creator->mint_lc_max_scan - mobj_umc_creator->mint_lc_min_scan) ; 
-            }
-
-			newUmc->mint_scan_aligned = umc.mint_max_abundance_scan ; 
-
-			newUmc->mint_umc_index = umc.mint_umc_index ; 
-			newUmc->mint_class_rep_charge = (int) umc.mshort_class_rep_charge ; 
-			arr_umcs[umcNum] = newUmc ; 
-		}
-
-		return arr_umcs ; 
-	}
-
-	void clsUMCCreator::SetLCMinMaxScans(int min, int max)
-	{
-		mobj_umc_creator->SetLCMinMaxScan(min, max) ; 
-
-		//if (max <= min)
-			//cout << " Max scan must be greater than min scan" << endl;
-			//throw new exception("Max scan must be greater than min scan");
-	}
-
-	void clsUMCCreator::SetIsotopePeaks(clsIsotopePeak* (&isotope_peaks) __gc[])
-	{
-		int numPeaks = isotope_peaks->Length ; 
-		std::vector<IsotopePeak> vectPeaks ;
-		vectPeaks.reserve(numPeaks) ; 
-
-		clsIsotopePeak *isoPk ; 
-		for (int pkNum = 0 ; pkNum < numPeaks ; pkNum++)
-		{
-			IsotopePeak pk ; 
-			isoPk = isotope_peaks[pkNum] ; 
-
-			pk.mint_original_index = isoPk->mint_original_index ; 
-			pk.mint_umc_index = isoPk->mint_umc_index ; 
-			pk.mint_lc_scan = isoPk->mint_lc_scan ; 
-			pk.mshort_charge = isoPk->mshort_charge ; 
-			pk.mdbl_abundance = isoPk->mdbl_abundance ; 
-			pk.mdbl_mz = isoPk->mdbl_mz ; 
-			pk.mflt_fit = isoPk->mflt_fit ; 
-			pk.mflt_ims_drift_time = isoPk->mflt_ims_drift_time ;
-			pk.mdbl_average_mass = isoPk->mdbl_average_mass ; 
-			pk.mdbl_mono_mass = isoPk->mdbl_mono_mass ; 
-			pk.mdbl_max_abundance_mass = isoPk->mdbl_max_abundance_mass ;
-			pk.mdbl_i2_abundance = isoPk->mdbl_i2_abundance ; 
-
-			vectPeaks.push_back(pk) ; 
-		}
-		mobj_umc_creator->SetPeks(vectPeaks) ; 
-	}
-
-	void clsUMCCreator::SetFilterOptions(float isotopic_fit, int min_intensity, int min_lc_scan, int max_lc_scan, int min_ims_scan, int max_ims_scan, float mono_mass_start, float mono_mass_end, bool process_mass_seg, int maxDataPoints, int monoMassSegOverlap, float segmentSize){
-		mobj_umc_creator->SetFilterOptions(isotopic_fit, min_intensity, min_lc_scan, max_lc_scan, min_ims_scan, max_ims_scan, mono_mass_start, mono_mass_end, process_mass_seg, maxDataPoints, monoMassSegOverlap, segmentSize);
-	}
-	void clsUMCCreator::SetOptions(float wt_mono_mass, float wt_avg_mass, float wt_log_abundance, float wt_scan, float wt_fit,
-			float wt_net, float mono_constraint, float avg_constraint, double max_dist, bool use_net, float wt_ims_drift_time, bool use_cs)
-	{
-		mobj_umc_creator->SetOptions(wt_mono_mass, wt_avg_mass, wt_log_abundance, wt_scan, wt_fit, wt_net, 
-			mono_constraint, avg_constraint, max_dist, use_net, wt_ims_drift_time, use_cs) ; 
-	}
-
-	void clsUMCCreator::SetOptionsEx(
-					float wt_mono_mass, float mono_constraint, bool mono_constraint_is_ppm,
-					float wt_avg_mass, float avg_constraint, bool avg_constraint_is_ppm,
-					float wt_log_abundance, float wt_scan, float wt_net, float wt_fit,
-					double max_dist, bool use_net, float wt_ims_drift_time, bool use_cs)
-	{
-		mobj_umc_creator->SetOptionsEx(
-					wt_mono_mass, mono_constraint, mono_constraint_is_ppm,
-					wt_avg_mass, avg_constraint, avg_constraint_is_ppm,
-					wt_log_abundance, wt_scan, wt_net, wt_fit, 
-					max_dist, use_net, wt_ims_drift_time, use_cs) ;
-	}
-
-	/*
-	 * Creates the baseFileName that will be used for properly naming the output files.
-	 *		- Desired Output format: baseFileName_LCMSFeatures.txt and baseFileName_LCMSFeatureToPeakMap.txt
-	 */
-	char* clsUMCCreator::CreateBaseFileName(char* directoryName, char* inputFileName){
-
-		char baseFileName[1024];
-		char* inputFileNameTok;
-		char* inputFileNameTokHelper;
-
-		// Remove any directory information from the filename
-		inputFileNameTok = strtok(inputFileName, "\\/");
-		inputFileNameTokHelper = inputFileNameTok;
-		while(inputFileNameTokHelper != NULL){
-			inputFileNameTokHelper = strtok(NULL, "\\/");
-			if(inputFileNameTokHelper != NULL){
-				inputFileNameTok = inputFileNameTokHelper;
-			}
-		}
-
-		// Remove the "_isos.csv" file extension
-		char* fileExtension = strstr(inputFileNameTok, "_isos.csv");
-		strcpy(fileExtension, "");
-		
-		// Append the Input File Name to the Output Directory to create the Base File Name
-		strcpy(baseFileName, directoryName);
-		strcat(baseFileName, "\\");
-		strcat(baseFileName, inputFileNameTok);
-
-		return baseFileName;
-
-	}
-
-	void clsUMCCreator::createLogFile(){
-		char logFileName[1024];
-
-		GetStr(mstr_baseFileName, logFileName);
-		strcat(logFileName, "_FeatureFinder_Log.txt");
-
-		mfile_logFile = fopen(logFileName, "w");
-	}
-
-	void clsUMCCreator::log(char* textToLog){
-		time_t now = time(NULL);
-		struct tm *localTime = localtime(&now);
-
-		fprintf(mfile_logFile, "%.2d/%.2d/%.2d %.2d:%.2d:%.2d\t%s\n", localTime->tm_mon+1, localTime->tm_mday, localTime->tm_year+1900, localTime->tm_hour, localTime->tm_min, localTime->tm_sec, textToLog);
-		fflush(mfile_logFile);
-		Console::WriteLine(textToLog);
-	}
-
-	void clsUMCCreator::log(char* textToLog, int numToLog){
-		time_t now = time(NULL);
-		struct tm *localTime = localtime(&now);
-
-		fprintf(mfile_logFile, "%.2d/%.2d/%.2d %.2d:%.2d:%.2d\t%s%d\n", localTime->tm_mon+1, localTime->tm_mday, localTime->tm_year+1900, localTime->tm_hour, localTime->tm_min, localTime->tm_sec, textToLog, numToLog);
-		fflush(mfile_logFile);
-		Console::Write(textToLog);
-		Console::WriteLine(numToLog);
-	}
-
-	void clsUMCCreator::log(char* textToLog, float numToLog){
-		time_t now = time(NULL);
-		struct tm *localTime = localtime(&now);
-
-		fprintf(mfile_logFile, "%.2d/%.2d/%.2d %.2d:%.2d:%.2d\t%s%4.4f\n", localTime->tm_mon+1, localTime->tm_mday, localTime->tm_year+1900, localTime->tm_hour, localTime->tm_min, localTime->tm_sec, textToLog, numToLog);
-		fflush(mfile_logFile);
-		Console::Write(textToLog);
-		Console::WriteLine(numToLog);
-	}
-
-}
+//This is the main DLL file.
+
+#include "clsUMCCreator.h"
+#include "FeatureFinderOptions.h"
+#include "FeatureTable.h"
+#include "UMCPipeline.h"
+#include "RunReport.h"
+#include "BatchRunner.h"
+#include "ParameterSweep.h"
+#include "ShadowVerifier.h"
+#include "WorkStealingPool.h"
+#using <mscorlib.dll>
+
+namespace UMCCreation
+{
+	void GetStr(System::String *src, char *dest)
+	{
+		if (src == 0 || src == "" || src->get_Length() == 0)
+		{
+			dest[0] = '\0' ; 
+			return ; 
+		}
+
+		int len = src->get_Length() ; 
+		for (int i = 0 ; i < len ; i++)
+		{
+			dest[i] = (char) src->Chars[i] ; 
+		}
+		dest[len] = '\0' ; 
+	}
+
+	clsUMCCreator::clsUMCCreator()
+	{
+		mobj_umc_creator = new UMCCreator() ; 
+		mobj_feature_table = new FeatureTable() ; 
+	}
+
+
+	clsUMCCreator::~clsUMCCreator()
+	{
+		if (mobj_umc_creator != NULL)
+			delete mobj_umc_creator ; 
+		if (mobj_feature_table != NULL)
+			delete mobj_feature_table ; 
+	}
+
+	void clsUMCCreator::ResetStatus()
+	{
+		menm_status = IDLE ; 
+		mobj_umc_creator->Reset() ; 
+	}
+
+	
+
+	bool clsUMCCreator::LoadProgramOptions(){
+		char settings_file[1024];
+		char base_file_name[1024];
+		char logText[1024];
+		bool success = false;
+		FeatureFinderOptions options;
+
+		GetStr(mstr_options_name, settings_file);
+		success = options.LoadFromIniFile(settings_file);
+
+		//first load incoming and outgoing filenames and folder options
+		options.GetBaseFileName(base_file_name, sizeof(base_file_name));
+		mstr_baseFileName = new System::String(base_file_name);
+		options.GetTempFilePrefix(base_file_name, sizeof(base_file_name));
+		mstr_tempFilePrefix = new System::String(base_file_name);
+
+		createLogFile();
+
+		strcpy(logText, "Loading settings from INI file: ");
+		strcat(logText, settings_file);
+		log(logText);
+		if (!success){
+			log("Settings file not found; using default settings");
+		}
+		for (int errorNum = 0; errorNum < (int) options.mvect_errors.size(); errorNum++){
+			log("Invalid setting ignored: ", (char*) options.mvect_errors[errorNum].c_str());
+		}
+		
+		//next load data filters
+		mflt_mono_mass_start = options.mflt_mono_mass_start;
+		mflt_mono_mass_end = options.mflt_mono_mass_end;
+		mbln_process_chunks = options.mbln_process_chunks;
+		mbln_merge_chunk_files = options.mbln_merge_chunk_files;
+		mint_mono_mass_overlap = options.mint_mono_mass_overlap;
+		mint_pipeline_queue_depth = options.mint_pipeline_queue_depth;
+		mint_memory_budget_mb = options.mint_memory_budget_mb;
+		mint_min_umc_length = options.mint_min_umc_length;
+
+		log("Data Filters - ");
+		log(" Minimum LC scan = ", options.mint_lc_min_scan);
+		log(" Maximum LC scan = ", options.mint_lc_max_scan);
+		log(" Minimum IMS scan = ", options.mint_ims_min_scan);
+		log(" Maximum IMS scan = ", options.mint_ims_max_scan);
+		log(" Maximum fit = ", options.mflt_isotopic_fit);
+		log(" Minimum intensity = ", options.mint_min_intensity);
+		log(" Mono mass start = ", mflt_mono_mass_start);
+		log(" Mono mass end = ", mflt_mono_mass_end);
+		log(" Require matching charge state = ", options.mbln_use_charge);
+		log(" Collapse IMS conformers = ", options.mbln_collapse_ims_conformers);
+		log(" Skip isolated peaks = ", options.mbln_skip_isolated_peaks);
+		log(" Maximum scan gap = ", options.mint_max_scan_gap);
+		log(" Maximum NET gap = ", options.mflt_max_net_gap);
+		log(" Maximum drift time gap = ", options.mflt_max_drift_time_gap);
+
+		//load all the data filters and umc creation options
+		options.ApplyTo(*mobj_umc_creator);
+
+		return success;
+	}
+
+	/**
+	 * Calls methods for creating UMCs and writing them to files
+	 */
+	bool clsUMCCreator::PrintUMCsToFile(){
+		bool success = false;
+
+		char baseFileName[1024];
+
+		GetStr(mstr_baseFileName, baseFileName);
+		success = mobj_umc_creator->CreateFeatureFiles(baseFileName);
+
+		return success;		
+	}
+
+	/**
+	 * This overloaded version of the method is used to support chunking
+	 *		- Chunking was only thought to be necessary because we ran out of memory on 32-bit machines.
+	 *		- Running this program on a 64-bit machine with enough memory will allow it to process very large isos files
+	 */
+	bool clsUMCCreator::PrintUMCsToFile(int chunkIndex, int featureStartIndex){
+		bool success = false;
+		
+		char baseFileName[1024];
+		char chunk[1024];
+
+		itoa(chunkIndex, chunk, 10);
+
+		GetStr(mstr_baseFileName, baseFileName);
+		strcat(baseFileName, "_chunk");
+		strcat(baseFileName, chunk);
+
+		success = mobj_umc_creator->CreateFeatureFiles(baseFileName, featureStartIndex);
+
+		return success;		
+	}
+
+	/**
+	Anuj added this method to load all the necessary details for the LC ms feature finder
+	Program options, data filters and output directories are all loaded here
+	The file is read and data filters applied and finally UMCs are found.
+	*/
+	void clsUMCCreator::LoadFindUMCs(){
+		RunReport runReport;
+
+		menm_status = LOADING;
+		LoadProgramOptions();
+		runReport.SetInputFileName(mobj_umc_creator->GetInputFileName());
+
+		if ( mint_memory_budget_mb > 0 )
+		{
+			char baseFileName[1024];
+			char tempFilePrefix[1024];
+			int numPeaks = 0;
+
+			log("Processing out of core...");
+			log(" Memory budget (MB) = ", mint_memory_budget_mb);
+			menm_status = CLUSTERING;
+
+			// Sorted runs of the peaks go to TempDirectory and are clustered in one merging pass; see CreateFeatureFilesOutOfCore
+			GetStr(mstr_baseFileName, baseFileName);
+			GetStr(mstr_tempFilePrefix, tempFilePrefix);
+			int UMC_count = mobj_umc_creator->CreateFeatureFilesOutOfCore(baseFileName, mint_min_umc_length, tempFilePrefix,
+				(long long) mint_memory_budget_mb * 1024 * 1024, numPeaks);
+			log("Total number of peaks we'll consider = ", numPeaks);
+			log("Total number of UMCs = ", UMC_count);
+			menm_status = COMPLETE;
+
+			runReport.SetNumFeatures(UMC_count);
+			runReport.AddTelemetry(mobj_umc_creator->GetTelemetry());
+		}
+		else if ( mbln_process_chunks )
+		{
+			char baseFileName[1024];
+			float chunk_size = mobj_umc_creator->GetSegmentSize();
+
+			log("Processing with Chunks ...");
+			log(" Pipeline queue depth = ", mint_pipeline_queue_depth);
+			menm_status = CHUNKING;
+
+			// Loading, clustering, summarizing and writing of the mass chunks overlap; see UMCPipeline
+			GetStr(mstr_baseFileName, baseFileName);
+			UMCPipeline pipeline(mobj_umc_creator, baseFileName, mint_min_umc_length, mint_pipeline_queue_depth, &runReport);
+			// the files of the chunks are combined into one feature file and one peak map at the end of the run
+			pipeline.SetMergeChunkFiles(mbln_merge_chunk_files);
+			mobj_umc_creator->GetTelemetry().Reset();
+			int UMC_count = pipeline.Run(mflt_mono_mass_start, mflt_mono_mass_end, chunk_size);
+			runReport.SetNumFeatures(UMC_count);
+
+			std::vector<MassBucketResult> &chunkResults = pipeline.GetResults();
+			for (int chunkNum = 0; chunkNum < (int) chunkResults.size(); chunkNum++)
+			{
+				log("Processed chunk ", chunkResults[chunkNum].mint_chunk_index);
+				log(" Total number of peaks we'll consider = ", chunkResults[chunkNum].mint_num_peaks);
+				log(" Number of UMCs = ", chunkResults[chunkNum].mint_num_umcs);
+			}
+			if (mbln_merge_chunk_files)
+				log("Duplicate UMCs of the chunk ends = ", pipeline.GetNumDuplicateFeatures());
+			log("Total number of UMCs = ", UMC_count);
+			menm_status = COMPLETE;
+		} 
+		else 
+		{
+			log("Processing without Chunks...");
+			menm_status = LOADING;
+			int numPeaks = mobj_umc_creator->ReadCSVFile();
+			log("Total number of peaks we'll consider = ", numPeaks);
+
+			menm_status = CLUSTERING;
+			log("Creating UMCs...");
+			// with UseCharge every charge state is clustered on a thread of its own
+			WorkStealingPool pool(0);
+			mobj_umc_creator->CreateUMCsSinglyLinkedWithAll(pool);
+			if (mobj_umc_creator->GetNumConformerNodes() > 0)
+				log("Conformer nodes clustered = ", mobj_umc_creator->GetNumConformerNodes());
+			if (mobj_umc_creator->GetNumIsolatedPeaks() > 0)
+				log("Isolated peaks not clustered = ", mobj_umc_creator->GetNumIsolatedPeaks());
+
+			menm_status = SUMMARIZING;
+			log("Filtering out short UMCs...");
+			mobj_umc_creator->RemoveShortUMCs(mint_min_umc_length);
+
+			log("Calculating UMC statistics...");
+			mobj_umc_creator->CalculateUMCs();
+			menm_status = COMPLETE;
+
+			log("Total number of UMCs = ", mobj_umc_creator->GetNumUmcs());
+
+			log("Writing output files...");
+			PrintUMCsToFile();
+
+			runReport.SetNumFeatures(mobj_umc_creator->GetNumUmcs());
+			runReport.AddTelemetry(mobj_umc_creator->GetTelemetry());
+		}
+
+		writeRunReport(runReport);
+		fclose(mfile_logFile);
+	
+	}
+
+	/**
+	 * Batch version of LoadFindUMCs: the settings file is read once and applied to every dataset of the manifest.
+	 * Each dataset writes its own feature files and statistics; this object only writes
+	 * Batch_FeatureFinder_Log.txt and Batch_FeatureFinder_Summary.txt to the output directory.
+	 */
+	int clsUMCCreator::LoadFindUMCsBatch(System::String *manifestFileName, int numThreads){
+		char settings_file[1024];
+		char manifest_file[1024];
+		char base_file_name[1024];
+		char summary_file_name[1024];
+		FeatureFinderOptions options;
+
+		GetStr(mstr_options_name, settings_file);
+		GetStr(manifestFileName, manifest_file);
+		bool success = options.LoadFromIniFile(settings_file);
+
+		options.GetOutputFileName("Batch", base_file_name, sizeof(base_file_name));
+		mstr_baseFileName = new System::String(base_file_name);
+		createLogFile();
+
+		log("Loading settings from INI file: ", settings_file);
+		if (!success){
+			log("Settings file not found; using default settings");
+		}
+		for (int errorNum = 0; errorNum < (int) options.mvect_errors.size(); errorNum++){
+			log("Invalid setting ignored: ", (char*) options.mvect_errors[errorNum].c_str());
+		}
+		log("Manifest file: ", manifest_file);
+
+		BatchRunner batch(options, numThreads);
+		if (!batch.LoadManifest(manifest_file)){
+			log("Unable to read manifest file ", manifest_file);
+			menm_status = FAILED;
+			fclose(mfile_logFile);
+			return -1;
+		}
+		log("Number of datasets = ", batch.GetNumDatasets());
+
+		// BytesRead, PeaksKept, ... sum up the datasets while the batch runs
+		mobj_umc_creator->GetTelemetry().Reset();
+		batch.SetParentTelemetry(&mobj_umc_creator->GetTelemetry());
+		menm_status = LOADING;
+		int numFailed = batch.Run();
+
+		std::vector<BatchDatasetResult> &results = batch.GetResults();
+		for (int datasetNum = 0; datasetNum < (int) results.size(); datasetNum++)
+		{
+			log("Dataset: ", (char*) results[datasetNum].mstr_input_file.c_str());
+			if (results[datasetNum].mbln_success){
+				log(" Total number of peaks we'll consider = ", results[datasetNum].mint_num_peaks);
+				log(" Total number of UMCs = ", results[datasetNum].mint_num_umcs);
+			}
+			else {
+				log(" Error finding features: ", (char*) results[datasetNum].mstr_error.c_str());
+			}
+		}
+
+		options.GetOutputFileName("Batch_FeatureFinder_Summary.txt", summary_file_name, sizeof(summary_file_name));
+		if (batch.WriteSummaryFile(summary_file_name)){
+			log("Batch summary written to ", summary_file_name);
+		}
+		else {
+			log("Unable to write batch summary to ", summary_file_name);
+		}
+
+		log("Datasets that failed = ", numFailed);
+		menm_status = numFailed == 0 ? COMPLETE : FAILED;
+		fclose(mfile_logFile);
+		return numFailed;
+	}
+
+	/**
+	 * Parameter sweep over the input file of OptionsFileName: loaded and sorted once, then clustered for every
+	 * setting of the sweep file. Writes baseFileName_Sweep<N>_* feature files and baseFileName_Sweep_Summary.txt.
+	 */
+	int clsUMCCreator::LoadFindUMCsSweep(System::String *sweepFileName, int numThreads){
+		char settings_file[1024];
+		char sweep_file[1024];
+		char base_file_name[1024];
+		char summary_file_name[1100];
+		FeatureFinderOptions options;
+		std::vector<std::string> errors;
+
+		GetStr(mstr_options_name, settings_file);
+		GetStr(sweepFileName, sweep_file);
+		bool success = options.LoadFromIniFile(settings_file);
+
+		options.GetBaseFileName(base_file_name, sizeof(base_file_name));
+		mstr_baseFileName = new System::String(base_file_name);
+		createLogFile();
+
+		log("Loading settings from INI file: ", settings_file);
+		if (!success){
+			log("Settings file not found; using default settings");
+		}
+		for (int errorNum = 0; errorNum < (int) options.mvect_errors.size(); errorNum++){
+			log("Invalid setting ignored: ", (char*) options.mvect_errors[errorNum].c_str());
+		}
+
+		ParameterSweep sweep(options, numThreads);
+		if (!sweep.LoadFromIniFile(sweep_file, errors)){
+			log("Unable to read sweep file ", sweep_file);
+			menm_status = FAILED;
+			fclose(mfile_logFile);
+			return -1;
+		}
+		for (int errorNum = 0; errorNum < (int) errors.size(); errorNum++){
+			log("Invalid setting ignored: ", (char*) errors[errorNum].c_str());
+		}
+		log("Number of settings = ", sweep.GetNumSettings());
+
+		mobj_umc_creator->GetTelemetry().Reset();
+		sweep.SetParentTelemetry(&mobj_umc_creator->GetTelemetry());
+		menm_status = CLUSTERING;
+		int numFailed = sweep.Run();
+		log("Total number of peaks we'll consider = ", sweep.GetNumPeaks());
+
+		std::vector<SweepSetting> &settings = sweep.GetSettings();
+		for (int settingNum = 0; settingNum < (int) settings.size(); settingNum++)
+		{
+			log("Setting ", settingNum + 1);
+			log(" Mono mass constraint = ", settings[settingNum].mflt_mono_mass_constraint);
+			log(" Max distance = ", settings[settingNum].mflt_max_distance);
+			log(" NET weight = ", settings[settingNum].mflt_net_weight);
+			log(" Log abundance weight = ", settings[settingNum].mflt_log_abundance_weight);
+			if (settings[settingNum].mbln_success){
+				log(" Total number of UMCs = ", settings[settingNum].mint_num_umcs);
+			}
+			else {
+				log(" Error finding features: ", (char*) settings[settingNum].mstr_error.c_str());
+			}
+		}
+
+		sprintf(summary_file_name, "%s_Sweep_Summary.txt", base_file_name);
+		if (sweep.WriteSummaryFile(summary_file_name)){
+			log("Sweep summary written to ", summary_file_name);
+		}
+		else {
+			log("Unable to write sweep summary to ", summary_file_name);
+		}
+
+		log("Settings that failed = ", numFailed);
+		menm_status = numFailed == 0 ? COMPLETE : FAILED;
+		fclose(mfile_logFile);
+		return numFailed;
+	}
+
+	/**
+	 * Shadow verification of the input file of OptionsFileName: clustered by the reference code and by the given
+	 * accelerated path on the same peaks. Writes the differences and both timings to baseFileName_Verification.txt.
+	 */
+	int clsUMCCreator::LoadFindUMCsVerify(System::String *pathName, int numThreads){
+		char settings_file[1024];
+		char path_name[1024];
+		char base_file_name[1024];
+		char report_file_name[1100];
+		FeatureFinderOptions options;
+
+		GetStr(mstr_options_name, settings_file);
+		GetStr(pathName, path_name);
+		bool success = options.LoadFromIniFile(settings_file);
+
+		options.GetBaseFileName(base_file_name, sizeof(base_file_name));
+		mstr_baseFileName = new System::String(base_file_name);
+		createLogFile();
+
+		log("Loading settings from INI file: ", settings_file);
+		if (!success){
+			log("Settings file not found; using default settings");
+		}
+		for (int errorNum = 0; errorNum < (int) options.mvect_errors.size(); errorNum++){
+			log("Invalid setting ignored: ", (char*) options.mvect_errors[errorNum].c_str());
+		}
+
+		ShadowVerifier verifier(options, numThreads);
+		if (!verifier.SetPath(path_name)){
+			log("Unknown path to verify: ", path_name);
+			menm_status = FAILED;
+			fclose(mfile_logFile);
+			return -1;
+		}
+		log("Verifying path ", path_name);
+
+		menm_status = CLUSTERING;
+		int numDifferences = verifier.Run();
+		log("Total number of peaks we'll consider = ", verifier.GetNumPeaks());
+		log(" Reference UMCs = ", verifier.GetNumReferenceUmcs());
+		log(" Reference seconds = ", (float) verifier.GetReferenceSeconds());
+		log(" Verified UMCs = ", verifier.GetNumCandidateUmcs());
+		log(" Verified seconds = ", (float) verifier.GetCandidateSeconds());
+		log("Peaks that differ = ", verifier.GetNumPeakDifferences());
+		log("UMCs that differ = ", verifier.GetNumUmcDifferences());
+
+		sprintf(report_file_name, "%s_Verification.txt", base_file_name);
+		if (verifier.WriteReportFile(report_file_name)){
+			log("Verification report written to ", report_file_name);
+		}
+		else {
+			log("Unable to write verification report to ", report_file_name);
+		}
+
+		menm_status = numDifferences == 0 ? COMPLETE : FAILED;
+		fclose(mfile_logFile);
+		return numDifferences;
+	}
+
+	void clsUMCCreator::FindUMCs()
+	{
+		menm_status = CLUSTERING ; 
+		mstr_message = new System::String("Clustering Isotope Peaks") ; 
+		mobj_umc_creator->CreateUMCsSinglyLinkedWithAll(); 
+		menm_status = SUMMARIZING ; 
+		mstr_message = new System::String("Filtering out short clusters") ; 
+		mobj_umc_creator->RemoveShortUMCs(mint_min_umc_length) ;
+		mstr_message = new System::String("Calculating UMC statistics") ; 
+		mobj_umc_creator->CalculateUMCs() ;
+		menm_status = COMPLETE ; 
+	}
+
+	void clsUMCCreator::RefilterUMCs(int min_length)
+	{
+		mint_min_umc_length = min_length ; 
+		menm_status = SUMMARIZING ; 
+		mstr_message = new System::String("Filtering out short clusters") ; 
+		mobj_umc_creator->RemoveShortUMCs(mint_min_umc_length) ;
+		mstr_message = new System::String("Calculating UMC statistics") ; 
+		mobj_umc_creator->CalculateUMCs() ;
+		menm_status = COMPLETE ; 
+	}
+
+	void clsUMCCreator::LoadFindUMCs(bool is_pek_file)
+	{
+		Console::WriteLine(S"Loading UMCs") ; 
+		char file_name[512] ; 
+		
+		GetStr(mstr_file_name, file_name) ; 
+		menm_status = LOADING ;
+
+		// one thread per core
+		WorkStealingPool pool(0) ; 
+		if (is_pek_file)
+		{
+			mstr_message = new System::String("Loading PEK file") ; 
+			// same peaks as ReadPekFileMemoryMapped
+			mobj_umc_creator->ReadPekFileParallel(file_name, pool, pool.GetNumThreads()) ; 
+		}
+		else
+		{
+			mstr_message = new System::String("Loading CSV file") ; 
+			Console::WriteLine(mstr_message);
+			mobj_umc_creator->ReadCSVFile(file_name) ; 
+		}
+
+		menm_status = CLUSTERING ; 
+		mstr_message = new System::String("Clustering Isotope Peaks") ; 
+		// with UseCharge every charge state is clustered on a thread of its own
+		mobj_umc_creator->CreateUMCsSinglyLinkedWithAll(pool) ; 
+		menm_status = SUMMARIZING ; 
+		mstr_message = new System::String("Filtering out short clusters") ; 
+		mobj_umc_creator->RemoveShortUMCs(mint_min_umc_length) ;
+		mstr_message = new System::String("Calculating UMC statistics") ; 
+		mobj_umc_creator->CalculateUMCs() ;
+	}
+
+	void clsUMCCreator::LoadFindUMCsPEK()
+	{
+		LoadFindUMCs(true) ; 
+		menm_status = COMPLETE ; 
+	}
+
+	void clsUMCCreator::LoadFindUMCsCSV()
+	{
+		LoadFindUMCs(false) ; 
+		menm_status = COMPLETE ; 
+	}
+
+	int clsUMCCreator::GetUmcMapping(int (&isotope_peaks_index) __gc[], int (&umc_index) __gc[])
+	{
+		int numMappings = mobj_umc_creator->mmultimap_umc_2_peak_index.size() ; 
+		isotope_peaks_index = new int __gc [numMappings] ; 
+		umc_index = new int __gc [numMappings] ; 
+
+		int mappingNum = 0 ; 
+		for (UMCPeakMultimap::iterator iter = mobj_umc_creator->mmultimap_umc_2_peak_index.begin() ; iter != mobj_umc_creator->mmultimap_umc_2_peak_index.end() ; iter++)
+		{
+			int currentUmcNum = (*iter).first ; 
+			int pkIndex = (*iter).second ; 
+			isotope_peaks_index[mappingNum] = pkIndex ; 
+			umc_index[mappingNum] = currentUmcNum ; 
+			mappingNum++ ; 
+		}
+		return numMappings ; 
+	}
+
+	UMCManipulation::clsUMC* clsUMCCreator::GetUMCs()[]
+	{
+		int numUmcs = mobj_umc_creator->GetNumUmcs(); 
+		UMCManipulation::clsUMC* arr_umcs __gc[] ; 
+		arr_umcs = new UMCManipulation::clsUMC* __gc [numUmcs] ; 
+		
+		for (int umcNum = 0 ; umcNum < numUmcs ; umcNum++)
+		{
+			UMC umc = mobj_umc_creator->mvect_umcs[umcNum] ; 
+			UMCManipulation::clsUMC *newUmc = __gc new UMCManipulation::clsUMC() ;
+			newUmc->mdbl_abundance = umc.mdbl_sum_abundance ; 
+
+			newUmc->mdbl_class_rep_mz = (double) umc.mdbl_class_rep_mz ; 
+			newUmc->mdbl_mono_mass = (double) umc.mdbl_median_mono_mass ; 
+			newUmc->mdbl_mono_mass_calibrated = newUmc->mdbl_mono_mass ; 
+
+			newUmc->mint_scan = umc.mint_max_abundance_scan ; 
+			newUmc->mint_start_scan = umc.mint_start_scan ; 
+			newUmc->mint_end_scan = umc.mint_stop_scan ; 
+
+			newUmc->mdbl_net = (double) umc.mint_max_abundance_scan ; 
+            if (mobj_umc_creator->mint_lc_max_scan > mobj_umc_creator->mint_lc_min_scan) {
+			     // Compute Generic NET value
+			     newUmc->mdbl_net = (double) (umc.mint_max_abundance_scan - mobj_umc_creator->mint_lc_min_scan) * 1.0 / (mobj_umc_creator->mint_lc_max_scan - mobj_umc_creator->mint_lc_min_scan) ; 
+            }
+
+			newUmc->mint_scan_aligned = umc.mint_max_abundance_scan ; 
+
+			newUmc->mint_umc_index = umc.mint_umc_index ; 
+			newUmc->mint_class_rep_charge = (int) umc.mshort_class_rep_charge ; 
+			arr_umcs[umcNum] = newUmc ; 
+		}
+
+		return arr_umcs ; 
+	}
+
+	System::IntPtr clsUMCCreator::GetFeatureTable()
+	{
+		mobj_feature_table->Build(*mobj_umc_creator) ; 
+		return System::IntPtr((void *) mobj_feature_table->GetTable()) ; 
+	}
+
+	void clsUMCCreator::SetLCMinMaxScans(int min, int max)
+	{
+		mobj_umc_creator->SetLCMinMaxScan(min, max) ; 
+
+		//if (max <= min)
+			//cout << " Max scan must be greater than min scan" << endl;
+			//throw new exception("Max scan must be greater than min scan");
+	}
+
+	void clsUMCCreator::SetIsotopePeaks(clsIsotopePeak* (&isotope_peaks) __gc[])
+	{
+		int numPeaks = isotope_peaks->Length ; 
+		std::vector<IsotopePeak> vectPeaks ;
+		vectPeaks.reserve(numPeaks) ; 
+
+		clsIsotopePeak *isoPk ; 
+		for (int pkNum = 0 ; pkNum < numPeaks ; pkNum++)
+		{
+			IsotopePeak pk ; 
+			isoPk = isotope_peaks[pkNum] ; 
+
+			pk.mint_original_index = isoPk->mint_original_index ; 
+			pk.mint_umc_index = isoPk->mint_umc_index ; 
+			pk.mint_lc_scan = isoPk->mint_lc_scan ; 
+			pk.mshort_charge = isoPk->mshort_charge ; 
+			pk.mdbl_abundance = isoPk->mdbl_abundance ; 
+			pk.mdbl_mz = isoPk->mdbl_mz ; 
+			pk.mflt_fit = isoPk->mflt_fit ; 
+			pk.mflt_ims_drift_time = isoPk->mflt_ims_drift_time ;
+			pk.mdbl_average_mass = isoPk->mdbl_average_mass ; 
+			pk.mdbl_mono_mass = isoPk->mdbl_mono_mass ; 
+			pk.mdbl_max_abundance_mass = isoPk->mdbl_max_abundance_mass ;
+			pk.mdbl_i2_abundance = isoPk->mdbl_i2_abundance ; 
+
+			vectPeaks.push_back(pk) ; 
+		}
+		mobj_umc_creator->AdoptPeaks(vectPeaks) ; 
+	}
+
+	bool clsUMCCreator::SetIsotopePeakColumns(int numPeaks, int originalIndex __gc[], int lcScan __gc[], int charge __gc[],
+		double abundance __gc[], double mz __gc[], float fit __gc[], double averageMass __gc[], double monoMass __gc[],
+		double maxAbundanceMass __gc[], double i2Abundance __gc[], int imsScan __gc[], float imsDriftTime __gc[])
+	{
+		if ((originalIndex != 0 && originalIndex->Length < numPeaks) || (lcScan != 0 && lcScan->Length < numPeaks)
+			|| (charge != 0 && charge->Length < numPeaks) || (abundance != 0 && abundance->Length < numPeaks)
+			|| (mz != 0 && mz->Length < numPeaks) || (fit != 0 && fit->Length < numPeaks)
+			|| (averageMass != 0 && averageMass->Length < numPeaks) || (monoMass != 0 && monoMass->Length < numPeaks)
+			|| (maxAbundanceMass != 0 && maxAbundanceMass->Length < numPeaks) || (i2Abundance != 0 && i2Abundance->Length < numPeaks)
+			|| (imsScan != 0 && imsScan->Length < numPeaks) || (imsDriftTime != 0 && imsDriftTime->Length < numPeaks))
+		{
+			mstr_message = new System::String("A peak column is shorter than the number of peaks") ; 
+			return false ; 
+		}
+
+		// pinned until the end of the call; null arrays stay NULL
+		bool hasPeaks = numPeaks > 0 ; 
+		int __pin *pinnedOriginalIndex = hasPeaks && originalIndex != 0 ? &originalIndex[0] : 0 ; 
+		int __pin *pinnedLcScan = hasPeaks && lcScan != 0 ? &lcScan[0] : 0 ; 
+		int __pin *pinnedCharge = hasPeaks && charge != 0 ? &charge[0] : 0 ; 
+		double __pin *pinnedAbundance = hasPeaks && abundance != 0 ? &abundance[0] : 0 ; 
+		double __pin *pinnedMz = hasPeaks && mz != 0 ? &mz[0] : 0 ; 
+		float __pin *pinnedFit = hasPeaks && fit != 0 ? &fit[0] : 0 ; 
+		double __pin *pinnedAverageMass = hasPeaks && averageMass != 0 ? &averageMass[0] : 0 ; 
+		double __pin *pinnedMonoMass = hasPeaks && monoMass != 0 ? &monoMass[0] : 0 ; 
+		double __pin *pinnedMaxAbundanceMass = hasPeaks && maxAbundanceMass != 0 ? &maxAbundanceMass[0] : 0 ; 
+		double __pin *pinnedI2Abundance = hasPeaks && i2Abundance != 0 ? &i2Abundance[0] : 0 ; 
+		int __pin *pinnedImsScan = hasPeaks && imsScan != 0 ? &imsScan[0] : 0 ; 
+		float __pin *pinnedImsDriftTime = hasPeaks && imsDriftTime != 0 ? &imsDriftTime[0] : 0 ; 
+
+		UMCPeakColumns columns ; 
+		memset(&columns, 0, sizeof(columns)) ; 
+		columns.num_peaks = numPeaks ; 
+		columns.original_index = pinnedOriginalIndex ; 
+		columns.lc_scan = pinnedLcScan ; 
+		columns.charge = pinnedCharge ; 
+		columns.abundance = pinnedAbundance ; 
+		columns.mz = pinnedMz ; 
+		columns.fit = pinnedFit ; 
+		columns.average_mass = pinnedAverageMass ; 
+		columns.mono_mass = pinnedMonoMass ; 
+		columns.max_abundance_mass = pinnedMaxAbundanceMass ; 
+		columns.i2_abundance = pinnedI2Abundance ; 
+		columns.ims_scan = pinnedImsScan ; 
+		columns.ims_drift_time = pinnedImsDriftTime ; 
+
+		std::string error ; 
+		if (!mobj_umc_creator->SetPeaks(columns, error))
+		{
+			mstr_message = new System::String(error.c_str()) ; 
+			return false ; 
+		}
+		return true ; 
+	}
+
+	bool clsUMCCreator::SetIsotopePeakRecords(System::IntPtr records, int numRecords, bool isImsData)
+	{
+		std::string error ; 
+		if (!mobj_umc_creator->SetPeaks((const UMCPeakRecord *) records.ToPointer(), numRecords, isImsData, error))
+		{
+			mstr_message = new System::String(error.c_str()) ; 
+			return false ; 
+		}
+		return true ; 
+	}
+
+	void clsUMCCreator::SetFilterOptions(float isotopic_fit, int min_intensity, int min_lc_scan, int max_lc_scan, int min_ims_scan, int max_ims_scan, float mono_mass_start, float mono_mass_end, bool process_mass_seg, int maxDataPoints, int monoMassSegOverlap, float segmentSize){
+		mobj_umc_creator->SetFilterOptions(isotopic_fit, min_intensity, min_lc_scan, max_lc_scan, min_ims_scan, max_ims_scan, mono_mass_start, mono_mass_end, process_mass_seg, maxDataPoints, monoMassSegOverlap, segmentSize);
+	}
+	void clsUMCCreator::SetOptions(float wt_mono_mass, float wt_avg_mass, float wt_log_abundance, float wt_scan, float wt_fit,
+			float wt_net, float mono_constraint, float avg_constraint, double max_dist, bool use_net, float wt_ims_drift_time, bool use_cs)
+	{
+		mobj_umc_creator->SetOptions(wt_mono_mass, wt_avg_mass, wt_log_abundance, wt_scan, wt_fit, wt_net, 
+			mono_constraint, avg_constraint, max_dist, use_net, wt_ims_drift_time, use_cs) ; 
+	}
+
+	void clsUMCCreator::SetOptionsEx(
+					float wt_mono_mass, float mono_constraint, bool mono_constraint_is_ppm,
+					float wt_avg_mass, float avg_constraint, bool avg_constraint_is_ppm,
+					float wt_log_abundance, float wt_scan, float wt_net, float wt_fit,
+					double max_dist, bool use_net, float wt_ims_drift_time, bool use_cs)
+	{
+		mobj_umc_creator->SetOptionsEx(
+					wt_mono_mass, mono_constraint, mono_constraint_is_ppm,
+					wt_avg_mass, avg_constraint, avg_constraint_is_ppm,
+					wt_log_abundance, wt_scan, wt_net, wt_fit, 
+					max_dist, use_net, wt_ims_drift_time, use_cs) ;
+	}
+
+	/*
+	 * Writes the per-stage timing and memory report as baseFileName_FeatureFinder_Stats.json
+	 */
+	void clsUMCCreator::writeRunReport(RunReport &runReport){
+		char reportFileName[1024];
+
+		GetStr(mstr_baseFileName, reportFileName);
+		strcat(reportFileName, "_FeatureFinder_Stats.json");
+
+		if (runReport.WriteJsonFile(reportFileName)){
+			log("Run statistics written to ", reportFileName);
+		}
+		else {
+			log("Unable to write run statistics to ", reportFileName);
+		}
+	}
+
+	void clsUMCCreator::createLogFile(){
+		char logFileName[1024];
+
+		GetStr(mstr_baseFileName, logFileName);
+		strcat(logFileName, "_FeatureFinder_Log.txt");
+
+		mfile_logFile = fopen(logFileName, "w");
+	}
+
+	void clsUMCCreator::log(char* textToLog){
+		time_t now = time(NULL);
+		struct tm *localTime = localtime(&now);
+
+		fprintf(mfile_logFile, "%.2d/%.2d/%.2d %.2d:%.2d:%.2d\t%s\n", localTime->tm_mon+1, localTime->tm_mday, localTime->tm_year+1900, localTime->tm_hour, localTime->tm_min, localTime->tm_sec, textToLog);
+		fflush(mfile_logFile);
+		Console::WriteLine(textToLog);
+	}
+
+	void clsUMCCreator::log(char* textToLog, int numToLog){
+		time_t now = time(NULL);
+		struct tm *localTime = localtime(&now);
+
+		fprintf(mfile_logFile, "%.2d/%.2d/%.2d %.2d:%.2d:%.2d\t%s%d\n", localTime->tm_mon+1, localTime->tm_mday, localTime->tm_year+1900, localTime->tm_hour, localTime->tm_min, localTime->tm_sec, textToLog, numToLog);
+		fflush(mfile_logFile);
+		Console::Write(textToLog);
+		Console::WriteLine(numToLog);
+	}
+
+	void clsUMCCreator::log(char* textToLog, float numToLog){
+		time_t now = time(NULL);
+		struct tm *localTime = localtime(&now);
+
+		fprintf(mfile_logFile, "%.2d/%.2d/%.2d %.2d:%.2d:%.2d\t%s%4.4f\n", localTime->tm_mon+1, localTime->tm_mday, localTime->tm_year+1900, localTime->tm_hour, localTime->tm_min, localTime->tm_sec, textToLog, numToLog);
+		fflush(mfile_logFile);
+		Console::Write(textToLog);
+		Console::WriteLine(numToLog);
+	}
+
+	void clsUMCCreator::log(char* textToLog, char* textToAppend){
+		time_t now = time(NULL);
+		struct tm *localTime = localtime(&now);
+
+		fprintf(mfile_logFile, "%.2d/%.2d/%.2d %.2d:%.2d:%.2d\t%s%s\n", localTime->tm_mon+1, localTime->tm_mday, localTime->tm_year+1900, localTime->tm_hour, localTime->tm_min, localTime->tm_sec, textToLog, textToAppend);
+		fflush(mfile_logFile);
+		Console::Write(textToLog);
+		Console::WriteLine(textToAppend);
+	}
+
+	System::String* clsUMCCreator::GetChunkingMessage(){
+		TelemetrySnapshot snapshot;
+		char message[128];
+
+		mobj_umc_creator->GetTelemetry().GetSnapshot(snapshot);
+		sprintf(message, "Mass chunks written: %lld of %lld", snapshot.mlng_items_processed, snapshot.mlng_items_total);
+		return new System::String(message);
+	}
+
+}